@@ -11,6 +11,8 @@
 #include <gsl/gsl_fft_halfcomplex.h>
 #include <gsl/gsl_linalg.h>
 #include "matrix/gslmatrix.h"
+#include "matrix/state_io.h"
+#include "matrix/complex_kernels.h"
 
 #include "common/jpython_error.h"
 #include "aec/aec.h"
@@ -184,7 +186,7 @@ BlockKalmanFilterEchoCancellationFeature(const VectorComplexFeatureStreamPtr& pl
      scratch2_(gsl_vector_complex_calloc(sampleN_)),
      scratchMatrix_(gsl_matrix_complex_calloc(sampleN_, sampleN_)),
      scratchMatrix2_(gsl_matrix_complex_calloc(sampleN_, sampleN_)),
-     amp4play_(amp4play),skippedN_(0),maxSkippedN_(30)
+     amp4play_(amp4play),skippedN_(0),maxSkippedN_(30), range_(fftLen_), scheduler_(NULL)
 {
   // Initialize variances
   for (unsigned m = 0; m < fftLen_; m++)
@@ -232,6 +234,20 @@ bool BlockKalmanFilterEchoCancellationFeature::update_(const gsl_vector_complex*
 }
 
 
+// write the output of bin 'm' and return true if it lies outside of 'range_'; such bins are neither cancelled nor adapted
+bool BlockKalmanFilterEchoCancellationFeature::out_of_band_(unsigned m, gsl_complex Ak)
+{
+  if (range_.in_band(m)) return false;
+
+  gsl_complex Ek = (range_.mode() == ZERO_OUT_OF_BAND) ? ComplexZero_ : Ak;
+  gsl_vector_complex_set(vector_, m, Ek);
+  if (m > 0 && m < fftLen2_)
+    gsl_vector_complex_set(vector_, fftLen_ - m, gsl_complex_conjugate(Ek));
+
+  return true;
+}
+
+
 void BlockKalmanFilterEchoCancellationFeature::conjugate_(gsl_vector_complex* dest, const gsl_vector_complex* src) const
 {
   if (src->size != dest->size)
@@ -252,9 +268,11 @@ const gsl_vector_complex* BlockKalmanFilterEchoCancellationFeature::next(int fra
   const gsl_vector_complex* playBlock	= played_->next(frame_no_ + 1);
   const gsl_vector_complex* recordBlock	= recorded_->next(frame_no_ + 1);
   buffer_.next_sample(playBlock,amp4play_);
+  begin_frame_();
 
   for (unsigned m = 0; m <= fftLen2_; m++) {
     gsl_complex         Ak = gsl_vector_complex_get(recordBlock, m);
+    if (out_of_band_(m, Ak)) continue;
     gsl_vector_complex* Rk = filterCoefficient_[m];
     const gsl_vector_complex* Vk = buffer_.get_samples(m);
 
@@ -267,11 +285,12 @@ const gsl_vector_complex* BlockKalmanFilterEchoCancellationFeature::next(int fra
       gsl_vector_complex_set(vector_, fftLen_ - m, gsl_complex_conjugate(Ek));
 
     double Ek2;
-    if (update_(Vk)) {
+    if (adapt_(m) && update_(Vk)) {
 
       // Estimate the observation noise variance
       Ek2      = gsl_complex_abs2(Ek);
-      double sigma2_v = beta_ * gsl_vector_get(sigma2_v_, m) + (1.0 - beta_) * Ek2;
+      double beta     = forgetting_(m);
+      double sigma2_v = beta * gsl_vector_get(sigma2_v_, m) + (1.0 - beta) * Ek2;
       gsl_vector_set(sigma2_v_, m, sigma2_v);
 
       // Calculate the Kalman gain
@@ -290,23 +309,62 @@ const gsl_vector_complex* BlockKalmanFilterEchoCancellationFeature::next(int fra
       gsl_blas_zaxpy(Ek, Gk_, Rk);
 
       // Store the state estimation error variance for next the iteration
+      // scratchMatrix_ = I - Gk Vk^T
       gsl_matrix_complex_set_zero(scratchMatrix_);
       for (unsigned rowX = 0; rowX < sampleN_; rowX++) {
-        for (unsigned colX = 0; colX < sampleN_; colX++) {
-          gsl_complex diagonal = ((rowX == colX) ? ComplexOne_ : ComplexZero_);
-          gsl_complex value    =  gsl_complex_sub(diagonal, gsl_complex_mul(gsl_vector_complex_get(Gk_, rowX), gsl_vector_complex_get(Vk, colX)));
-          gsl_matrix_complex_set(scratchMatrix_, rowX, colX, value);
-        }
+        double* row = ComplexKernels::row(scratchMatrix_, rowX);
+        ComplexKernels::axpy(sampleN_, gsl_complex_negative(gsl_vector_complex_get(Gk_, rowX)), ComplexKernels::data(Vk), row);
+        row[2 * rowX] += 1.0;
       }
       gsl_blas_zgemm(CblasNoTrans, CblasNoTrans, ComplexOne_, scratchMatrix_, K_k_k1_, ComplexZero_, K_k_[m]);
     }
   }
 
+  end_frame_();
   increment_();
   return vector_;
 }
 
 
+void BlockKalmanFilterEchoCancellationFeature::save_state(const String& fileName) const
+{
+  StateWriter writer(state_kind_());
+  write_state_(writer);
+  writer.save(fileName);
+}
+
+void BlockKalmanFilterEchoCancellationFeature::load_state(const String& fileName)
+{
+  StateReader reader(fileName, state_kind_());
+  read_state_(reader);
+  reader.commit();
+}
+
+void BlockKalmanFilterEchoCancellationFeature::write_state_(StateWriter& writer) const
+{
+  writer.write("fftLen", int(fftLen_));
+  writer.write("sampleN", int(sampleN_));
+  writer.write("sigma2_v", sigma2_v_);
+  for (unsigned m = 0; m < fftLen_; m++) {
+    writer.write("filterCoefficient", filterCoefficient_[m]);
+    writer.write("K_k", K_k_[m]);
+    writer.write("Sigma2_u", Sigma2_u_[m]);
+  }
+}
+
+void BlockKalmanFilterEchoCancellationFeature::read_state_(StateReader& reader)
+{
+  reader.check("fftLen", fftLen_);
+  reader.check("sampleN", sampleN_);
+  reader.read("sigma2_v", sigma2_v_);
+  for (unsigned m = 0; m < fftLen_; m++) {
+    reader.read("filterCoefficient", filterCoefficient_[m]);
+    reader.read("K_k", K_k_[m]);
+    reader.read("Sigma2_u", Sigma2_u_[m]);
+  }
+}
+
+
 // ----- methods for class `InformationFilterEchoCancellationFeature' -----
 //
 InformationFilterEchoCancellationFeature::
@@ -349,6 +407,22 @@ InformationFilterEchoCancellationFeature::~InformationFilterEchoCancellationFeat
   gsl_matrix_complex_free(matrixCopy_);
 }
 
+void InformationFilterEchoCancellationFeature::write_state_(StateWriter& writer) const
+{
+  BlockKalmanFilterEchoCancellationFeature::write_state_(writer);
+  writer.write("snr", snr_, fftLen_);
+  writer.write("EkEnergy", EkEnergy_, fftLen_);
+  writer.write("SkEnergy", SkEnergy_, fftLen_);
+}
+
+void InformationFilterEchoCancellationFeature::read_state_(StateReader& reader)
+{
+  BlockKalmanFilterEchoCancellationFeature::read_state_(reader);
+  reader.read("snr", snr_, fftLen_);
+  reader.read("EkEnergy", EkEnergy_, fftLen_);
+  reader.read("SkEnergy", SkEnergy_, fftLen_);
+}
+
 void InformationFilterEchoCancellationFeature::print_matrix_(const gsl_matrix_complex* mat)
 {
   for (unsigned m = 0; m < mat->size1; m++) {
@@ -442,9 +516,11 @@ const gsl_vector_complex* InformationFilterEchoCancellationFeature::next(int fra
   const gsl_vector_complex* playBlock	= played_->next(frame_no_ + 1);
   const gsl_vector_complex* recordBlock	= recorded_->next(frame_no_ + 1);
   buffer_.next_sample(playBlock,amp4play_);
+  begin_frame_();
 
   for (unsigned m = 0; m <= fftLen2_; m++) {
     gsl_complex			Ak = gsl_vector_complex_get(recordBlock, m);
+    if (out_of_band_(m, Ak)) continue;
     gsl_vector_complex*		Rk = filterCoefficient_[m];
     const gsl_vector_complex*	Vk = buffer_.get_samples(m);
 
@@ -460,6 +536,7 @@ const gsl_vector_complex* InformationFilterEchoCancellationFeature::next(int fra
     if (m > 0 && m < fftLen2_)
       gsl_vector_complex_set(vector_, fftLen_ - m, gsl_complex_conjugate(Ek));
 
+    if (adapt_(m) == false) continue;
     if (update_(Vk) == false || update_band_(Ak, Ek, frame_no, m) < 0.0){
       if( skippedN_ >= maxSkippedN_ ){
 	// initialize filter coefficients
@@ -474,7 +551,8 @@ const gsl_vector_complex* InformationFilterEchoCancellationFeature::next(int fra
 
     // Estimate the observation noise variance
     double Ek2		= gsl_complex_abs2(Ek);
-    double sigma2_v	= beta_ * gsl_vector_get(sigma2_v_, m) + (1.0 - beta_) * Ek2;
+    double beta		= forgetting_(m);
+    double sigma2_v	= beta * gsl_vector_get(sigma2_v_, m) + (1.0 - beta) * Ek2;
     gsl_vector_set(sigma2_v_, m, sigma2_v);
 
     // Perform the prediction step; scratch_ = y_{k|k-1}, and inverse_ = Y_{k|k-1}
@@ -488,11 +566,7 @@ const gsl_vector_complex* InformationFilterEchoCancellationFeature::next(int fra
     for (unsigned rowX = 0; rowX < sampleN_; rowX++) {
       gsl_complex value = gsl_complex_mul_real(gsl_complex_conjugate(gsl_vector_complex_get(Vk, rowX)), scale);
       gsl_vector_complex_set(scratch2_, rowX, gsl_complex_mul(value, Ak));
-
-      for (unsigned colX = 0; colX < sampleN_; colX++) {
-        gsl_complex colV = gsl_vector_complex_get(Vk, colX);
-        gsl_matrix_complex_set(scratchMatrix_, rowX, colX, gsl_complex_mul(value, colV));
-      }
+      ComplexKernels::scale(sampleN_, value, ComplexKernels::data(Vk), ComplexKernels::row(scratchMatrix_, rowX));
     }
 
     // now perform the information correction/update step
@@ -512,6 +586,7 @@ const gsl_vector_complex* InformationFilterEchoCancellationFeature::next(int fra
     gsl_blas_zgemv(CblasNoTrans, ComplexOne_, inverse_, scratch_, ComplexZero_, Rk);
   }
 
+  end_frame_();
   increment_();
   return vector_;
 }
@@ -555,6 +630,20 @@ SquareRootInformationFilterEchoCancellationFeature::~SquareRootInformationFilter
   delete[] informationState_;
 }
 
+void SquareRootInformationFilterEchoCancellationFeature::write_state_(StateWriter& writer) const
+{
+  InformationFilterEchoCancellationFeature::write_state_(writer);
+  for (unsigned m = 0; m < fftLen_; m++)
+    writer.write("informationState", informationState_[m]);
+}
+
+void SquareRootInformationFilterEchoCancellationFeature::read_state_(StateReader& reader)
+{
+  InformationFilterEchoCancellationFeature::read_state_(reader);
+  for (unsigned m = 0; m < fftLen_; m++)
+    reader.read("informationState", informationState_[m]);
+}
+
 // calculate the cosine 'c' and sine 's' parameters of Givens
 // rotation that rotates 'v2' into 'v1'
 gsl_complex SquareRootInformationFilterEchoCancellationFeature::
@@ -622,9 +711,11 @@ const gsl_vector_complex* SquareRootInformationFilterEchoCancellationFeature::ne
   const gsl_vector_complex* playBlock	= played_->next(frame_no_ + 1);
   const gsl_vector_complex* recordBlock	= recorded_->next(frame_no_ + 1);
   buffer_.next_sample(playBlock,amp4play_);
+  begin_frame_();
 
   for (unsigned m = 0; m <= fftLen2_; m++) {
     gsl_complex			Ak = gsl_vector_complex_get(recordBlock, m);
+    if (out_of_band_(m, Ak)) continue;
     gsl_vector_complex*		Rk = filterCoefficient_[m];
     const gsl_vector_complex*	Vk = buffer_.get_samples(m);
 
@@ -636,11 +727,13 @@ const gsl_vector_complex* SquareRootInformationFilterEchoCancellationFeature::ne
     if (m > 0 && m < fftLen2_)
       gsl_vector_complex_set(vector_, fftLen_ - m, gsl_complex_conjugate(Ek));
 
+    if (adapt_(m) == false) continue;
     if (update_(Vk) == false || update_band_(Ak, Ek, frame_no, m) < 0.0) continue;
 
     // Estimate the observation noise variance
     double Ek2		= gsl_complex_abs2(Ek);
-    double sigma2_v	= beta_ * gsl_vector_get(sigma2_v_, m) + (1.0 - beta_) * Ek2;
+    double beta		= forgetting_(m);
+    double sigma2_v	= beta * gsl_vector_get(sigma2_v_, m) + (1.0 - beta) * Ek2;
     gsl_vector_set(sigma2_v_, m, sigma2_v);
 
     // perform prediction, correction, and add diagonal loading
@@ -652,6 +745,7 @@ const gsl_vector_complex* SquareRootInformationFilterEchoCancellationFeature::ne
     extract_covariance_state_(K_k_[m], informationState_[m], Rk);
   }
 
+  end_frame_();
   increment_();
   return vector_;
 }
@@ -817,6 +911,22 @@ DTDBlockKalmanFilterEchoCancellationFeature::~DTDBlockKalmanFilterEchoCancellati
   printf("finished.\n");
 }
 
+void DTDBlockKalmanFilterEchoCancellationFeature::write_state_(StateWriter& writer) const
+{
+  BlockKalmanFilterEchoCancellationFeature::write_state_(writer);
+  writer.write("snr", &snr_, 1);
+  writer.write("EkEnergy", &EkEnergy_, 1);
+  writer.write("SkEnergy", &SkEnergy_, 1);
+}
+
+void DTDBlockKalmanFilterEchoCancellationFeature::read_state_(StateReader& reader)
+{
+  BlockKalmanFilterEchoCancellationFeature::read_state_(reader);
+  reader.read("snr", &snr_, 1);
+  reader.read("EkEnergy", &EkEnergy_, 1);
+  reader.read("SkEnergy", &SkEnergy_, 1);
+}
+
 
 double DTDBlockKalmanFilterEchoCancellationFeature::update_band_(const gsl_complex Ak, const gsl_complex Ek, int frame_no)
 {
@@ -873,10 +983,12 @@ const gsl_vector_complex* DTDBlockKalmanFilterEchoCancellationFeature::next(int
   const gsl_vector_complex* playBlock	= played_->next(frame_no_ + 1);
   const gsl_vector_complex* recordBlock	= recorded_->next(frame_no_ + 1);
   buffer_.next_sample(playBlock,amp4play_);
+  begin_frame_();
 
   // Ek is stored in the _vector
   for (unsigned m = 0; m <= fftLen2_; m++) {
     gsl_complex Ak = gsl_vector_complex_get(recordBlock, m);
+    if (out_of_band_(m, Ak)) continue;
     gsl_vector_complex *Rk = filterCoefficient_[m];
     const gsl_vector_complex *Vk = buffer_.get_samples(m);
 
@@ -891,6 +1003,7 @@ const gsl_vector_complex* DTDBlockKalmanFilterEchoCancellationFeature::next(int
 
   for (unsigned m = 0; m <= fftLen2_; m++) {
     gsl_complex Ak = gsl_vector_complex_get(recordBlock, m);
+    if (range_.in_band(m) == false || adapt_(m) == false) continue;
     gsl_vector_complex *Rk = filterCoefficient_[m];
     const gsl_vector_complex *Vk = buffer_.get_samples(m);
 
@@ -906,7 +1019,8 @@ const gsl_vector_complex* DTDBlockKalmanFilterEchoCancellationFeature::next(int
     // Estimate the observation noise variance
     gsl_complex zsf	= gsl_complex_rect(sf, 0.0);
     double Ek2		= gsl_complex_abs2(Ek);
-    double sigma2_v	= beta_ * gsl_vector_get(sigma2_v_, m) + (1.0 - beta_) * Ek2;
+    double beta		= forgetting_(m);
+    double sigma2_v	= beta * gsl_vector_get(sigma2_v_, m) + (1.0 - beta) * Ek2;
     gsl_vector_set(sigma2_v_, m, sigma2_v);
 
     // Calculate the Kalman gain
@@ -937,6 +1051,7 @@ const gsl_vector_complex* DTDBlockKalmanFilterEchoCancellationFeature::next(int
     gsl_blas_zgemm(CblasNoTrans, CblasNoTrans, ComplexOne_, scratchMatrix_, K_k_k1_, ComplexZero_, K_k_[m]);
   }
 
+  end_frame_();
   increment_();
   return vector_;
 }
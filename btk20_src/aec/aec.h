@@ -20,9 +20,14 @@
 #include <gsl/gsl_eigen.h>
 
 #include "stream/stream.h"
+#include "stream/subband_range.h"
+#include "stream/adaptation_scheduler.h"
 #include "btk.h"
 #include "beamformer/tracker.h"
 
+class StateWriter;
+class StateReader;
+
 /**
 * \defgroup NLMSAcousticEchoCancellationFeature NLMS Echo Cancellation Feature
 */
@@ -113,6 +118,18 @@ class BlockKalmanFilterEchoCancellationFeature : public VectorComplexFeatureStre
       played_->reset(); recorded_->reset();
     }
 
+    // checkpoint the filter coefficients, the noise variances and the error covariances; subclasses add their own state
+    virtual void save_state(const String& fileName) const;
+    virtual void load_state(const String& fileName);
+
+    // cancel the echo and adapt the filters only in the bins lower..upper; the other bins pass the recorded signal unless 'mode' is ZERO_OUT_OF_BAND
+    void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND) { range_.set_range(lower, upper, mode); }
+    void set_bin_mask(const gsl_vector* mask) { range_.set_mask(mask); }
+    void clear_bin_range() { range_.clear(); }
+
+    // adapt the filters only in the frames and bins chosen by 'scheduler'; the echo is cancelled in every frame
+    void set_adaptation_scheduler(const AdaptationSchedulerPtr& scheduler) { scheduler_ = scheduler; }
+
   protected:
     class ComplexBuffer_ {
       public:
@@ -194,8 +211,18 @@ class BlockKalmanFilterEchoCancellationFeature : public VectorComplexFeatureStre
   static gsl_complex                             ComplexZero_;
 
   bool update_(const gsl_vector_complex* Vk);
+  bool out_of_band_(unsigned m, gsl_complex Ak);
+  bool adapt_(unsigned m) { return scheduler_.is_null() || scheduler_->adapt(m); }
+  double forgetting_(unsigned m) const { return scheduler_.is_null() ? beta_ : scheduler_->forgetting(beta_, m); }
+  void begin_frame_() { if (scheduler_.is_null() == false) scheduler_->begin_frame(frame_no_ + 1); }
+  void end_frame_() { if (scheduler_.is_null() == false) scheduler_->end_frame(); }
   void conjugate_(gsl_vector_complex* dest, const gsl_vector_complex* src) const;
 
+  // the class name stored in a checkpoint, and the records of a class and its bases
+  virtual const char* state_kind_() const { return "BlockKalmanFilterEchoCancellationFeature"; }
+  virtual void write_state_(StateWriter& writer) const;
+  virtual void read_state_(StateReader& reader);
+
   VectorComplexFeatureStreamPtr                 played_;   // v(n)
   VectorComplexFeatureStreamPtr                 recorded_; // a(n)
 
@@ -222,6 +249,8 @@ class BlockKalmanFilterEchoCancellationFeature : public VectorComplexFeatureStre
   double                                        floorVal_;
   int                                           skippedN_;
   int                                           maxSkippedN_;
+  SubbandRange                                  range_;
+  AdaptationSchedulerPtr                        scheduler_;
 };
 
 
@@ -246,6 +275,10 @@ class InformationFilterEchoCancellationFeature : public BlockKalmanFilterEchoCan
 protected:
   static double _EigenValueThreshold;
 
+  virtual const char* state_kind_() const { return "InformationFilterEchoCancellationFeature"; }
+  virtual void write_state_(StateWriter& writer) const;
+  virtual void read_state_(StateReader& reader);
+
   double update_band_(const gsl_complex Ak, const gsl_complex Ek, int frame_no, unsigned m);
   void invert_(gsl_matrix_complex* matrix);
   static void print_matrix_(const gsl_matrix_complex* mat);
@@ -283,6 +316,11 @@ class SquareRootInformationFilterEchoCancellationFeature : public InformationFil
 
   virtual const gsl_vector_complex* next(int frame_no = -5);
 
+protected:
+  virtual const char* state_kind_() const { return "SquareRootInformationFilterEchoCancellationFeature"; }
+  virtual void write_state_(StateWriter& writer) const;
+  virtual void read_state_(StateReader& reader);
+
 private:
   const gsl_complex load_;
   static gsl_complex calc_givens_rotation_(const gsl_complex& v1, const gsl_complex& v2, gsl_complex& c, gsl_complex& s);
@@ -310,6 +348,11 @@ class DTDBlockKalmanFilterEchoCancellationFeature : public BlockKalmanFilterEcho
 
   virtual const gsl_vector_complex* next(int frame_no = -5);
 
+protected:
+  virtual const char* state_kind_() const { return "DTDBlockKalmanFilterEchoCancellationFeature"; }
+  virtual void write_state_(StateWriter& writer) const;
+  virtual void read_state_(StateReader& reader);
+
 private:
   double update_band_(const gsl_complex Ak, const gsl_complex Ek, int frame_no);
   void conjugate_(gsl_vector_complex* dest, const gsl_vector_complex* src) const;
@@ -143,6 +143,12 @@ public:
 
   const gsl_vector_complex* next(int frame_no = -5) const;
   void reset();
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
+  void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND);
+  void set_bin_mask(const gsl_vector* mask);
+  void clear_bin_range();
+  void set_adaptation_scheduler(const AdaptationSchedulerPtr& scheduler);
 };
 
 class BlockKalmanFilterEchoCancellationFeaturePtr : public VectorComplexFeatureStreamPtr {
@@ -10,6 +10,9 @@
 #include <matrix/blas1_c.h>
 #include <matrix/linpack_c.h>
 #include "postfilter/postfilter.h"
+#include "matrix/state_io.h"
+#include "matrix/aligned_pool.h"
+#include "matrix/complex_kernels.h"
 
 //float  sspeed = 343740.0;
 
@@ -38,6 +41,19 @@ SnapShotArray::~SnapShotArray()
   delete[] snapshots_;
 }
 
+void SnapShotArray::memory_buffers_(MemoryUsage& usage) const
+{
+  size_t bytes = 0;
+  for (unsigned i = 0; i < nChan_; i++)
+    bytes += MemoryUsage::bytes(samples_[i]);
+  usage.add("samples", bytes);
+
+  bytes = 0;
+  for (unsigned i = 0; i < fftLen_; i++)
+    bytes += MemoryUsage::bytes(snapshots_[i]);
+  usage.add("snapshots", bytes);
+}
+
 void SnapShotArray::zero()
 {
   for (unsigned i = 0; i < nChan_; i++)
@@ -97,7 +113,7 @@ void SnapShotArray::set_snapshots(const gsl_vector_complex* snapshots, unsigned
 SpectralMatrixArray::SpectralMatrixArray(unsigned fftLn, unsigned nChn,
 					 float forgetFact)
   : SnapShotArray(fftLn, nChn),
-    mu_(gsl_complex_rect(forgetFact, 0))
+    mu_(gsl_complex_rect(forgetFact, 0)), scheduler_(NULL), frame_no_(-1), forgets_(fftLn / 2 + 1, forgetFact)
 {
   matrices_ = new gsl_matrix_complex*[fftLen_];
   for (unsigned i = 0; i < fftLen_; i++)
@@ -111,35 +127,83 @@ SpectralMatrixArray::~SpectralMatrixArray()
   delete[] matrices_;
 }
 
+void SpectralMatrixArray::memory_buffers_(MemoryUsage& usage) const
+{
+  SnapShotArray::memory_buffers_(usage);
+  size_t bytes = 0;
+  for (unsigned i = 0; i < fftLen_; i++)
+    bytes += MemoryUsage::bytes(matrices_[i]);
+  usage.add("matrices", bytes);
+}
+
 void SpectralMatrixArray::zero()
 {
   SnapShotArray::zero();
+  frame_no_ = -1;
 
   for (unsigned i = 0; i < fftLen_; i++)
     gsl_matrix_complex_set_zero(matrices_[i]);
 }
 
+void SpectralMatrixArray::save_state(const String& fileName) const
+{
+  StateWriter writer("SpectralMatrixArray");
+  writer.write("fftLen", int(fftLen_));
+  writer.write("chanN", int(nChan_));
+  for (unsigned i = 0; i < fftLen_; i++)
+    writer.write("matrix", matrices_[i]);
+  writer.save(fileName);
+}
+
+void SpectralMatrixArray::load_state(const String& fileName)
+{
+  StateReader reader(fileName, "SpectralMatrixArray");
+  reader.check("fftLen", fftLen_);
+  reader.check("chanN", nChan_);
+  for (unsigned i = 0; i < fftLen_; i++)
+    reader.read("matrix", matrices_[i]);
+  reader.commit();
+}
+
+// decide the bins to be updated in the current frame
+void SpectralMatrixArray::schedule_()
+{
+  unsigned fftLen2 = fftLen_ / 2;
+  double   mu      = GSL_REAL(mu_);
+
+  if (scheduler_.is_null()) {
+    for (unsigned fbinX = 0; fbinX <= fftLen2; fbinX++)
+      forgets_[fbinX] = mu;
+    return;
+  }
+
+  scheduler_->begin_frame(++frame_no_);
+  for (unsigned fbinX = 0; fbinX <= fftLen2; fbinX++)
+    forgets_[fbinX] = scheduler_->adapt(fbinX) ? scheduler_->forgetting(mu, fbinX) : -1.0;
+}
+
 void SpectralMatrixArray::update()
 {
   SnapShotArray::update();
+  schedule_();
 
   for (unsigned ifft = 0; ifft < fftLen_; ifft++) {
+    double mu = forgets_[(ifft <= fftLen_ / 2) ? ifft : fftLen_ - ifft];
+    if (mu < 0.0) continue;
+
     gsl_matrix_complex* smat = matrices_[ifft];
-    gsl_matrix_complex_scale(smat, mu_);
+    gsl_matrix_complex_scale(smat, gsl_complex_rect(mu, 0.0));
 
+    // row irow += (1 - mu) x_irow x
     for (unsigned irow = 0; irow < nChan_; irow++) {
       gsl_complex rowVal = gsl_vector_complex_get(snapshots_[ifft], irow);
-      for (unsigned icol = 0; icol < nChan_; icol++) {
-	gsl_complex colVal = gsl_vector_complex_get(snapshots_[ifft], icol);
-	gsl_complex newVal = gsl_complex_mul(rowVal, colVal);
-	gsl_complex oldVal = gsl_matrix_complex_get(smat, irow, icol);
-	gsl_complex alpha  = gsl_complex_sub( gsl_complex_rect( 1.0, 0 ), mu_ );
-	newVal =  gsl_complex_mul( alpha, newVal );
-	gsl_matrix_complex_set(smat, irow, icol,
-			       gsl_complex_add(oldVal, newVal));
-      }
+      gsl_complex alpha  = gsl_complex_mul_real(rowVal, 1.0 - mu);
+      ComplexKernels::axpy(nChan_, alpha, ComplexKernels::data(snapshots_[ifft]), ComplexKernels::row(smat, irow));
     }
   }
+
+  if (scheduler_.is_null() == false)
+    scheduler_->end_frame();
 }
 
 // ----- members for class `FBSpectralMatrixArray' -----
@@ -154,10 +218,14 @@ FBSpectralMatrixArray::~FBSpectralMatrixArray()
 void FBSpectralMatrixArray::update()
 {
   SnapShotArray::update();
+  schedule_();
 
   for (unsigned ifft = 0; ifft < fftLen_; ifft++) {
+    double mu = forgets_[(ifft <= fftLen_ / 2) ? ifft : fftLen_ - ifft];
+    if (mu < 0.0) continue;
+
     gsl_matrix_complex* smat = matrices_[ifft];
-    gsl_matrix_complex_scale(smat, mu_);
+    gsl_matrix_complex_scale(smat, gsl_complex_rect(mu, 0.0));
 
     for (unsigned irow = 0; irow < nChan_; irow++) {
       gsl_complex rowVal = gsl_vector_complex_get(snapshots_[ifft], irow);
@@ -170,6 +238,9 @@ void FBSpectralMatrixArray::update()
       }
     }
   }
+
+  if (scheduler_.is_null() == false)
+    scheduler_->end_frame();
 }
 
 /**
@@ -972,7 +1043,8 @@ SubbandBeamformer::SubbandBeamformer(unsigned fftLen, bool halfBandShift, const
     snapshot_array_(NULL),
     fftLen_(fftLen),
     fftLen2_(fftLen/2),
-    halfBandShift_(halfBandShift)
+    halfBandShift_(halfBandShift),
+    range_(fftLen)
 {}
 
 SubbandBeamformer::~SubbandBeamformer()
@@ -1091,6 +1163,29 @@ void SubbandDS::alloc_bfweight_( int nSource, int NC )
   this->alloc_image_();
 }
 
+/**
+   @brief output of a bin outside of 'range_'
+   @param const gsl_vector_complex* wq_f[in] quiescent weights used for DS_OUT_OF_BAND
+ */
+gsl_complex SubbandDS::out_of_band_(unsigned fbinX, const gsl_vector_complex* snapShot_f, const gsl_vector_complex* wq_f) const
+{
+  gsl_complex val;
+
+  switch (range_.mode()) {
+  case ZERO_OUT_OF_BAND:
+    val = gsl_complex_rect(0.0, 0.0);
+    break;
+  case DS_OUT_OF_BAND:
+    gsl_blas_zdotc(wq_f, snapShot_f, &val);
+    break;
+  default:
+    val = gsl_vector_complex_get(snapShot_f, 0);
+    break;
+  }
+
+  return val;
+}
+
 #define MINFRAMES 0 // the number of frames for estimating CSDs.
 const gsl_vector_complex* SubbandDS::next(int frame_no)
 {
@@ -1117,7 +1212,10 @@ const gsl_vector_complex* SubbandDS::next(int frame_no)
     for (unsigned fbinX = 0; fbinX < fftLen; fbinX++) {
       snapShot_f      = snapshot_array_->snapshot(fbinX);
       arrayManifold_f = bfweight_vec_[0]->wq_f(fbinX);
-      gsl_blas_zdotc(arrayManifold_f, snapShot_f, &val);
+      if (range_.in_band(fbinX))
+	gsl_blas_zdotc(arrayManifold_f, snapShot_f, &val);
+      else
+	val = out_of_band_(fbinX, snapShot_f, arrayManifold_f);
       gsl_vector_complex_set(vector_, fbinX, val);
 #ifdef  _MYDEBUG_
       if ( fbinX % 100 == 0 ){
@@ -1135,14 +1233,20 @@ const gsl_vector_complex* SubbandDS::next(int frame_no)
     // calculate a direct component.
     snapShot_f      = snapshot_array_->snapshot(0);
     arrayManifold_f = bfweight_vec_[0]->wq_f(0);
-    gsl_blas_zdotc(arrayManifold_f, snapShot_f, &val);
+    if (range_.in_band(0))
+      gsl_blas_zdotc(arrayManifold_f, snapShot_f, &val);
+    else
+      val = out_of_band_(0, snapShot_f, arrayManifold_f);
     gsl_vector_complex_set(vector_, 0, val);
 
     // calculate outputs from bin 1 to fftLen - 1 by using the property of the symmetry.
     for (unsigned fbinX = 1; fbinX <= fftLen2; fbinX++) {
       snapShot_f      = snapshot_array_->snapshot(fbinX);
       arrayManifold_f = bfweight_vec_[0]->wq_f(fbinX);
-      gsl_blas_zdotc(arrayManifold_f, snapShot_f, &val);
+      if (range_.in_band(fbinX))
+	gsl_blas_zdotc(arrayManifold_f, snapShot_f, &val);
+      else
+	val = out_of_band_(fbinX, snapShot_f, arrayManifold_f);
       if( fbinX < fftLen2 ){
 	gsl_vector_complex_set(vector_, fbinX, val);
 	gsl_vector_complex_set(vector_, fftLen_ - fbinX, gsl_complex_conjugate(val) );
@@ -1211,11 +1315,12 @@ void calc_gsc_output( const gsl_vector_complex* snapShot,
 {
   unsigned chanN = wq_f->size;
   gsl_complex wq_fn, wl_fn;
-  gsl_vector_complex *myWq_f = gsl_vector_complex_alloc( chanN );
 
   if( wq_f->size != wl_f->size ){
     throw  j_error("calc_gsc_output:The lengths of weight vectors must be the same.\n");
   }
+  // called for every bin of every frame
+  gsl_vector_complex *myWq_f = gsl_vector_complex_aligned_alloc( chanN );
 
   // calculate wq(f) - B(f) wa(f)
   //gsl_vector_complex_sub( wq_f, wl_f );
@@ -1239,7 +1344,7 @@ void calc_gsc_output( const gsl_vector_complex* snapShot,
 
   // calculate  ( wq(f) - B(f) wa(f) )^H * X(f)
   gsl_blas_zdotc( myWq_f, snapShot, pYf );
-  gsl_vector_complex_free( myWq_f );
+  gsl_vector_complex_aligned_free( myWq_f );
 }
 
 SubbandGSC::~SubbandGSC()
@@ -1277,7 +1382,10 @@ const gsl_vector_complex* SubbandGSC::next(int frame_no)
       wq_f = bfweight_vec_[0]->wq_f(fbinX);
       wl_f = bfweight_vec_[0]->wl_f(fbinX);
 
-      calc_gsc_output( snapShot_f, wl_f,  wq_f, &val, normalize_weight_ );
+      if (range_.in_band(fbinX))
+        calc_gsc_output( snapShot_f, wl_f,  wq_f, &val, normalize_weight_ );
+      else
+        val = out_of_band_(fbinX, snapShot_f, wq_f);
       gsl_vector_complex_set(vector_, fbinX, val);
     }
   }
@@ -1287,7 +1395,10 @@ const gsl_vector_complex* SubbandGSC::next(int frame_no)
     // calculate a direct component.
     snapShot_f = snapshot_array_->snapshot(0);
     wq_f       = bfweight_vec_[0]->wq_f(0);
-    gsl_blas_zdotc( wq_f, snapShot_f, &val);
+    if (range_.in_band(0))
+      gsl_blas_zdotc( wq_f, snapShot_f, &val);
+    else
+      val = out_of_band_(0, snapShot_f, wq_f);
     gsl_vector_complex_set(vector_, 0, val);
     //wq_f = _bfWeights->wq_f(0);
     //wl_f = _bfWeights->wl_f(0);
@@ -1300,7 +1411,10 @@ const gsl_vector_complex* SubbandGSC::next(int frame_no)
       wq_f = bfweight_vec_[0]->wq_f(fbinX);
       wl_f = bfweight_vec_[0]->wl_f(fbinX);
 
-      calc_gsc_output( snapShot_f, wl_f, wq_f, &val, normalize_weight_ );
+      if (range_.in_band(fbinX))
+        calc_gsc_output( snapShot_f, wl_f, wq_f, &val, normalize_weight_ );
+      else
+        val = out_of_band_(fbinX, snapShot_f, wq_f);
       if( fbinX < fftLen2 ){
         gsl_vector_complex_set(vector_, fbinX,           val);
         gsl_vector_complex_set(vector_, fftLen_ - fbinX, gsl_complex_conjugate(val) );
@@ -1451,7 +1565,8 @@ SubbandGSCRLS::SubbandGSCRLS(unsigned fftLen, bool halfBandShift, float mu, floa
   mu_(mu),
   alpha_(-1.0),
   qctype_(NO_QUADRATIC_CONSTRAINT),
-  is_wa_updated_(true)
+  is_wa_updated_(true),
+  scheduler_(NULL)
 {
   gz_ = new gsl_vector_complex*[fftLen];
   Pz_ = new gsl_matrix_complex*[fftLen];
@@ -1502,6 +1617,60 @@ void SubbandGSCRLS::set_precision_matrix( unsigned fbinX, gsl_matrix_complex *Pz
   }
 }
 
+void SubbandGSCRLS::save_state(const String& fileName) const
+{
+  if( 0 == bfweight_vec_.size() )
+    throw  j_error("call calc_gsc_weights_x() once\n");
+  if( NULL == Zf_ )
+    throw  j_error("set the precision matrix with init_precision_matrix() or set_precision_matrix()\n");
+
+  gsl_vector_complex** wa = bfweight_vec_[0]->wa();
+  StateWriter writer("SubbandGSCRLS");
+  writer.write("fftLen", int(fftLen_));
+  writer.write("chanN", int(chanN()));
+  writer.write("NC", int(bfweight_vec_[0]->NC()));
+  for (unsigned fbinX = 0; fbinX < fftLen_; fbinX++) {
+    writer.write("Pz", Pz_[fbinX]);
+    writer.write("wa", wa[fbinX]);
+  }
+  writer.save(fileName);
+}
+
+void SubbandGSCRLS::load_state(const String& fileName)
+{
+  if( 0 == bfweight_vec_.size() )
+    throw  j_error("call calc_gsc_weights_x() once\n");
+
+  StateReader reader(fileName, "SubbandGSCRLS");
+  reader.check("fftLen", fftLen_);
+  reader.check("chanN", chanN());
+  reader.check("NC", bfweight_vec_[0]->NC());
+
+  // the precision matrices may not be allocated yet: read them into temporaries
+  unsigned nz = chanN() - bfweight_vec_[0]->NC();
+  vector<gsl_matrix_complex*> Pz(fftLen_, (gsl_matrix_complex*) NULL);
+  gsl_vector_complex** wa = bfweight_vec_[0]->wa();
+  try {
+    for (unsigned fbinX = 0; fbinX < fftLen_; fbinX++) {
+      Pz[fbinX] = gsl_matrix_complex_alloc( nz, nz );
+      reader.read("Pz", Pz[fbinX]);
+      reader.read("wa", wa[fbinX]);
+    }
+    reader.commit();
+  } catch (...) {
+    for (unsigned fbinX = 0; fbinX < fftLen_; fbinX++)
+      if( NULL != Pz[fbinX] ) gsl_matrix_complex_free( Pz[fbinX] );
+    throw;
+  }
+
+  if( NULL == Zf_ )
+    alloc_subbandGSCRLS_image_();
+  for (unsigned fbinX = 0; fbinX < fftLen_; fbinX++) {
+    gsl_matrix_complex_memcpy( Pz_[fbinX], Pz[fbinX] );
+    gsl_matrix_complex_free( Pz[fbinX] );
+  }
+}
+
 const gsl_vector_complex* SubbandGSCRLS::next(int frame_no)
 {
   if (frame_no == frame_no_) return vector_;
@@ -1517,6 +1686,8 @@ const gsl_vector_complex* SubbandGSCRLS::next(int frame_no)
   if( NULL == Zf_ )
     throw  j_error("set the precision matrix with init_precision_matrix() or set_precision_matrix()\n");
 
+  if( false == scheduler_.is_null() )
+    scheduler_->begin_frame( frame_no_ + 1 );
   this->alloc_image_();
   for (ChannelIterator_ itr = channelList_.begin(); itr != channelList_.end(); itr++) {
     const gsl_vector_complex* samp = (*itr)->next(frame_no);
@@ -1534,7 +1705,10 @@ const gsl_vector_complex* SubbandGSCRLS::next(int frame_no)
     // calculate a direct component.
     snapShot_f = snapshot_array_->snapshot(0);
     wq_f       = bfweight_vec_[0]->wq_f(0);
-    gsl_blas_zdotc( wq_f, snapShot_f, &val);
+    if (range_.in_band(0))
+      gsl_blas_zdotc( wq_f, snapShot_f, &val);
+    else
+      val = out_of_band_(0, snapShot_f, wq_f);
     gsl_vector_complex_set(vector_, 0, val);
 
     // calculate outputs from bin 1 to fftLen-1 by using the property of the symmetry.
@@ -1543,7 +1717,10 @@ const gsl_vector_complex* SubbandGSCRLS::next(int frame_no)
       wq_f = bfweight_vec_[0]->wq_f(fbinX);
       wl_f = bfweight_vec_[0]->wl_f(fbinX);
 
-      calc_gsc_output( snapShot_f, wl_f, wq_f, &val, normalize_weight_ );
+      if (range_.in_band(fbinX))
+        calc_gsc_output( snapShot_f, wl_f, wq_f, &val, normalize_weight_ );
+      else
+        val = out_of_band_(fbinX, snapShot_f, wq_f);
       if( fbinX < fftLen2 ){
         gsl_vector_complex_set(vector_, fbinX,           val);
         gsl_vector_complex_set(vector_, fftLen_ - fbinX, gsl_complex_conjugate(val) );
@@ -1555,6 +1732,8 @@ const gsl_vector_complex* SubbandGSCRLS::next(int frame_no)
     this->update_active_weight_vector2_( frame_no );
   }
 
+  if( false == scheduler_.is_null() )
+    scheduler_->end_frame();
   increment_();
 
   return vector_;
@@ -1584,6 +1763,9 @@ void SubbandGSCRLS::update_active_weight_vector2_( int frame_no )
   gsl_vector_complex** old_wa = bfweight_vec_[0]->wa();
 
   for (unsigned fbinX = 1; fbinX <= fftLen_/2; fbinX++){
+    if (range_.in_band(fbinX) == false) continue;	// keep the active weights and the precision matrix of bins not processed
+    if (false == scheduler_.is_null() && false == scheduler_->adapt(fbinX)) continue;
+    float mu = scheduler_.is_null() ? mu_ : scheduler_->forgetting(mu_, fbinX);
     const gsl_vector_complex *Xf = snapshot_array_->snapshot(fbinX);
     gsl_complex nu, de;
 
@@ -1592,9 +1774,9 @@ void SubbandGSCRLS::update_active_weight_vector2_( int frame_no )
 
     // calc. the gain vector 
     gsl_blas_zgemv( CblasConjTrans, gsl_complex_rect(1.0,0.0), Pz_[fbinX], Zf_, gsl_complex_rect(0.0,0.0), PzH_Z_ );
-    gsl_blas_zgemv( CblasNoTrans,   gsl_complex_rect(1.0/mu_,0.0), Pz_[fbinX], Zf_, gsl_complex_rect(0.0,0.0), gz_[fbinX] );
+    gsl_blas_zgemv( CblasNoTrans,   gsl_complex_rect(1.0/mu,0.0), Pz_[fbinX], Zf_, gsl_complex_rect(0.0,0.0), gz_[fbinX] );
     gsl_blas_zdotc( PzH_Z_, Zf_, &de );
-    de = gsl_complex_add_real( gsl_complex_mul_real( de, 1.0/mu_ ), 1.0 );
+    de = gsl_complex_add_real( gsl_complex_mul_real( de, 1.0/mu ), 1.0 );
     for(unsigned chanX =0;chanX<nChan-NC;chanX++){
       gsl_complex val;
       nu = gsl_vector_complex_get( gz_[fbinX], chanX );      
@@ -1604,13 +1786,9 @@ void SubbandGSCRLS::update_active_weight_vector2_( int frame_no )
 
     // calc. the precision matrix
     for(unsigned chanX=0;chanX<nChan-NC;chanX++){
-      for(unsigned chanY=0;chanY<nChan-NC;chanY++){
-	gsl_complex oldPz, val1, val2;
-	oldPz = gsl_matrix_complex_get( Pz_[fbinX], chanX, chanY );
-	val1  = gsl_complex_mul( gsl_vector_complex_get( gz_[fbinX], chanX ), gsl_complex_conjugate( gsl_vector_complex_get( PzH_Z_, chanY ) ) );
-	val2  = gsl_complex_mul_real( gsl_complex_sub( oldPz, val1 ),  1.0/mu_ );
-	gsl_matrix_complex_set( Pz_[fbinX], chanX, chanY, val2 );
-      }
+      double* row = ComplexKernels::row( Pz_[fbinX], chanX );
+      ComplexKernels::axpy_conj( nChan-NC, gsl_complex_negative( gsl_vector_complex_get( gz_[fbinX], chanX ) ), ComplexKernels::data(PzH_Z_), row );
+      ComplexKernels::scale_real( nChan-NC, 1.0/mu, row, row );
     }
 
     { // update the active weight vecotr
@@ -1620,22 +1798,15 @@ void SubbandGSCRLS::update_active_weight_vector2_( int frame_no )
       gsl_matrix_complex_scale(  mat1_, gsl_complex_rect( - diagonal_weights_[fbinX], 0.0 ) );
       gsl_matrix_complex_add( mat1_, _I );
       gsl_blas_zgemv( CblasNoTrans, gsl_complex_rect(1.0,0.0), mat1_, old_wa[fbinX], gsl_complex_rect(0.0,0.0), wa_ );
-      for(unsigned chanX=0;chanX<nChan-NC;chanX++){
-	gsl_complex val1 = gsl_vector_complex_get( wa_, chanX );
-	gsl_complex val2 = gsl_complex_mul( gsl_vector_complex_get( gz_[fbinX], chanX ), epA );
-	gsl_vector_complex_set( wa_, chanX, gsl_complex_add( val1, val2 ) );
-      }
+      ComplexKernels::axpy( nChan-NC, epA, ComplexKernels::data(gz_[fbinX]), ComplexKernels::data(wa_) );
       if( qctype_ == CONSTANT_NORM ){
 	double nrmwa = gsl_blas_dznrm2( wa_ );
-	for(unsigned chanX=0;chanX<nChan-NC;chanX++)
-	  gsl_vector_complex_set( wa_, chanX, gsl_complex_mul_real( gsl_vector_complex_get( wa_, chanX), alpha_/nrmwa ) );
+	ComplexKernels::scale_real( nChan-NC, alpha_/nrmwa, ComplexKernels::data(wa_), ComplexKernels::data(wa_) );
       }
       else if( qctype_ == THRESHOLD_LIMITATION ){
 	double nrmwa = gsl_blas_dznrm2( wa_ );
-	if( ( nrmwa * nrmwa ) >= alpha_ ){
-	  for(unsigned chanX=0;chanX<nChan-NC;chanX++)
-	    gsl_vector_complex_set( wa_, chanX, gsl_complex_mul_real( gsl_vector_complex_get( wa_, chanX), alpha_/nrmwa ) );
-	}
+	if( ( nrmwa * nrmwa ) >= alpha_ )
+	  ComplexKernels::scale_real( nChan-NC, alpha_/nrmwa, ComplexKernels::data(wa_), ComplexKernels::data(wa_) );
       }
       //fprintf( stderr, "%d: %e\n", frame_no, gsl_blas_dznrm2 ( wa_ ) );
       bfweight_vec_[0]->calcSidelobeCancellerU_f( fbinX, wa_ );
@@ -2373,6 +2544,10 @@ bool SubbandMVDR::calc_mvdr_weights( float samplerate, float dThreshold, bool ca
     gsl_complex norm;
     const gsl_vector_complex* arrayManifold_f = bfweight_vec_[0]->wq_f(fbinX);
 
+    // bins outside of the range are not beamformed with these weights
+    if( false == range_.in_band(fbinX) )
+      continue;
+
     if( NULL == invR_[fbinX] )
       invR_[fbinX] = gsl_matrix_complex_alloc( nChan, nChan );
 
@@ -2566,13 +2741,22 @@ const gsl_vector_complex* SubbandMVDR::next(int frame_no)
 
      // calculate a direct component.
      snapShot_f = snapshot_array_->snapshot(0);
-     gsl_blas_zdotc( wmvdr_[0], snapShot_f, &val );
+     if( range_.in_band(0) )
+       gsl_blas_zdotc( wmvdr_[0], snapShot_f, &val );
+     else
+       val = out_of_band_( 0, snapShot_f, bfweight_vec_[0]->wq_f(0) );
      gsl_vector_complex_set(vector_, 0, val);
 
      // calculate outputs from bin 1 to fftLen - 1 by using the property of the symmetry.
      for (unsigned fbinX = 1; fbinX <= fftLen2; fbinX++) {
        snapShot_f = snapshot_array_->snapshot(fbinX);
-       gsl_blas_zdotc( wmvdr_[fbinX], snapShot_f, &val );
+       if( range_.in_band(fbinX) ){
+	 if( NULL == wmvdr_[fbinX] )
+	   throw j_error("no MVDR weights for bin %d; call calc_mvdr_weights() after extending the bin range\n", fbinX);
+	 gsl_blas_zdotc( wmvdr_[fbinX], snapShot_f, &val );
+       }
+       else
+	 val = out_of_band_( fbinX, snapShot_f, bfweight_vec_[0]->wq_f(fbinX) );
        if( fbinX < fftLen2 ){
 	 gsl_vector_complex_set(vector_, fbinX, val);
 	 gsl_vector_complex_set(vector_, fftLen_ - fbinX, gsl_complex_conjugate(val) );
@@ -2662,6 +2846,8 @@ bool SubbandMVDRGSC::calc_blocking_matrix2()
     unsigned fftLen2 = fftLen_/2;
 
     for (unsigned fbinX = 1; fbinX <= fftLen2; fbinX++) {
+      if( NULL == wmvdr_[fbinX] ) // outside of the bin range
+	continue;
       gsl_vector_complex* destWq = bfweight_vec_[0]->wq_f(fbinX);
       gsl_vector_complex_memcpy( destWq, wmvdr_[fbinX] );
       bfweight_vec_[0]->calcBlockingMatrix( fbinX );
@@ -2750,15 +2936,24 @@ const gsl_vector_complex* SubbandMVDRGSC::next(int frame_no)
 
      // calculate a direct component.
      snapShot_f = snapshot_array_->snapshot(0);
-     gsl_blas_zdotc( wmvdr_[0], snapShot_f, &val );
+     if( range_.in_band(0) )
+       gsl_blas_zdotc( wmvdr_[0], snapShot_f, &val );
+     else
+       val = out_of_band_( 0, snapShot_f, bfweight_vec_[0]->wq_f(0) );
      gsl_vector_complex_set(vector_, 0, val);
 
      // calculate outputs from bin 1 to fftLen - 1 by using the property of the symmetry.
      for (unsigned fbinX = 1; fbinX <= fftLen2; fbinX++) {
        snapShot_f = snapshot_array_->snapshot(fbinX);
        wl_f = bfweight_vec_[0]->wl_f(fbinX);
-      
-       calc_gsc_output( snapShot_f, wl_f, wmvdr_[fbinX], &val, normalize_weight_ );
+
+       if( range_.in_band(fbinX) ){
+	 if( NULL == wmvdr_[fbinX] )
+	   throw j_error("no MVDR weights for bin %d; call calc_mvdr_weights() after extending the bin range\n", fbinX);
+	 calc_gsc_output( snapShot_f, wl_f, wmvdr_[fbinX], &val, normalize_weight_ );
+       }
+       else
+	 val = out_of_band_( fbinX, snapShot_f, bfweight_vec_[0]->wq_f(fbinX) );
        if( fbinX < fftLen2 ){
 	 gsl_vector_complex_set(vector_, fbinX, val);
 	 gsl_vector_complex_set(vector_, fftLen_ - fbinX, gsl_complex_conjugate(val) );
@@ -2888,7 +3083,10 @@ DOAEstimatorSRPBase::DOAEstimatorSRPBase( unsigned nBest, unsigned fbinMax ):
   table_initialized_(false),
   accRPs_(NULL),
   rpMat_(NULL),
-  engery_threshold_(0.0)
+  engery_threshold_(0.0),
+  deadline_(NULL),
+  deadlineX_(0),
+  coarseStep_(1)
 {
   nBestRPs_   = gsl_vector_calloc( nBest_ );
   argMaxDOAs_ = gsl_matrix_calloc( nBest_, 2 );
@@ -2996,6 +3194,62 @@ void DOAEstimatorSRPBase::init_accs_()
   }
 }
 
+void DOAEstimatorSRPBase::set_deadline_scheduler(const DeadlineSchedulerPtr& sched, unsigned coarseStep, const String& nm)
+{
+  if (coarseStep == 0)
+    throw jparameter_error("The step of the coarse search must be positive.");
+
+  deadline_   = sched;
+  deadlineX_  = deadline_->add_stage(nm);
+  coarseStep_ = coarseStep;
+}
+
+bool DOAEstimatorSRPBase::begin_search_()
+{
+  if (deadline_.is_null()) return false;
+
+  if (deadline_->fallback(deadlineX_) == false) return false;
+  frameRPs_.resize(nTheta_ * nPhi_);
+  return true;
+}
+
+void DOAEstimatorSRPBase::end_search_()
+{
+  if (deadline_.is_null()) return;
+
+  deadline_->done(deadlineX_);
+}
+
+// the searched neighbours 'lo' and 'hi' of direction 'idx' and the weight of 'hi'
+static void coarse_neighbours_(unsigned idx, unsigned n, unsigned step, unsigned& lo, unsigned& hi, double& w)
+{
+  lo = idx - idx % step;
+  hi = lo + step;
+  w  = double(idx % step) / step;
+  if (hi >= n) { hi = lo; w = 0.0; }
+}
+
+void DOAEstimatorSRPBase::accumulate_skipped_directions_()
+{
+  for (unsigned thetaIdx = 0; thetaIdx < nTheta_; thetaIdx++) {
+    unsigned thetaLo, thetaHi;
+    double   wTheta;
+    coarse_neighbours_(thetaIdx, nTheta_, coarseStep_, thetaLo, thetaHi, wTheta);
+    for (unsigned phiIdx = 0; phiIdx < nPhi_; phiIdx++) {
+      if (skip_direction_(true, thetaIdx) == false && skip_direction_(true, phiIdx) == false) continue;
+
+      unsigned phiLo, phiHi;
+      double   wPhi;
+      coarse_neighbours_(phiIdx, nPhi_, coarseStep_, phiLo, phiHi, wPhi);
+      double rp =
+	(1.0 - wTheta) * ((1.0 - wPhi) * frameRPs_[thetaLo * nPhi_ + phiLo] + wPhi * frameRPs_[thetaLo * nPhi_ + phiHi]) +
+	wTheta         * ((1.0 - wPhi) * frameRPs_[thetaHi * nPhi_ + phiLo] + wPhi * frameRPs_[thetaHi * nPhi_ + phiHi]);
+      unsigned unitX = thetaIdx * nPhi_ + phiIdx;
+      gsl_vector_set(accRPs_, unitX, gsl_vector_get(accRPs_, unitX) + rp);
+    }
+  }
+}
+
 void DOAEstimatorSRPBase::set_search_param(float minTheta, float maxTheta, float minPhi, float maxPhi,
                                            float widthTheta, float widthPhi)
 {
@@ -3154,12 +3408,15 @@ const gsl_vector_complex* DOAEstimatorSRPDSBLA::next( int frame_no )
     return vector_;
   }
 
+  bool coarse = begin_search_();
   unsigned unitX = 0;
   unsigned thetaIdx = 0;
   for(double theta=minTheta_;thetaIdx<nTheta_;theta+=widthTheta_,thetaIdx++){
+    if( skip_direction_( coarse, thetaIdx ) ){ unitX++; continue; }
       //set_look_direction_( theta, phi );
     rp = calc_response_power_( unitX );
     gsl_vector_set( accRPs_, unitX, gsl_vector_get( accRPs_, unitX ) + rp );
+    keep_response_power_( coarse, unitX, rp );
     unitX++;
 #ifdef __MBDEBUG__
     gsl_matrix_set( rpMat_, thetaIdx, 0, rp);
@@ -3185,6 +3442,8 @@ const gsl_vector_complex* DOAEstimatorSRPDSBLA::next( int frame_no )
       // for(unsinged n1=0;n1<nBest_-1;n1++)
     }
   }
+  if( coarse ) accumulate_skipped_directions_();
+  end_search_();
 
   increment_();
   return vector_;
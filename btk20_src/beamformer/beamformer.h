@@ -20,6 +20,9 @@
 #include "common/jexception.h"
 
 #include "stream/stream.h"
+#include "stream/subband_range.h"
+#include "stream/adaptation_scheduler.h"
+#include "stream/deadline_scheduler.h"
 #include "beamformer/spectralinfoarray.h"
 #include "modulated/modulated.h"
 
@@ -105,6 +108,17 @@ class SubbandBeamformer : public VectorComplexFeatureStream {
   void         set_channel(VectorComplexFeatureStreamPtr& chan);
   virtual void clear_channel();
 
+  /**
+     @brief adapt and beamform only the bins lower..upper (see 'SubbandRange')
+     @param int mode[in] PASS_OUT_OF_BAND passes the first channel, ZERO_OUT_OF_BAND outputs zero and
+                         DS_OUT_OF_BAND applies the quiescent (delay-and-sum) weights to the other bins
+   */
+  void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND) { range_.set_range(lower, upper, mode); }
+  // additionally skip the bins whose entry in 'mask' is zero; NULL clears the mask
+  void set_bin_mask(const gsl_vector* mask) { range_.set_mask(mask); }
+  void clear_bin_range() { range_.clear(); }
+  const SubbandRange& bin_range() const { return range_; }
+
 #ifdef ENABLE_LEGACY_BTK_API
   bool isEnd() { return is_end(); }
   const gsl_vector_complex* snapShotArray_f(unsigned fbinX){ return snapshot_array_f(fbinX); }
@@ -122,6 +136,7 @@ protected:
   unsigned					fftLen2_;
   bool						halfBandShift_;
   ChannelList_					channelList_;
+  SubbandRange					range_;
 };
 
 // ----- definition for class `SubbandDS' -----
@@ -160,6 +175,7 @@ class SubbandDS : public SubbandBeamformer {
 protected:
   void alloc_image_();
   void alloc_bfweight_(int nSrc, int NC);
+  gsl_complex out_of_band_(unsigned fbinX, const gsl_vector_complex* snapShot_f, const gsl_vector_complex* wq_f) const;
 
   vector<BeamformerWeights *>                   bfweight_vec_; // weights of a beamformer per source.
 };
@@ -233,6 +249,12 @@ class SubbandGSCRLS : public SubbandGSC {
   void set_precision_matrix(unsigned fbinX, gsl_matrix_complex *Pz);
   void update_active_weight_vecotrs(bool flag){ is_wa_updated_ = flag; }
   void set_quadratic_constraint(float alpha, int qctype=1){ alpha_=alpha; qctype_=(QuadraticConstraintType)qctype; }
+  // adapt the active weight vectors only in the frames and bins chosen by 'scheduler'
+  void set_adaptation_scheduler(const AdaptationSchedulerPtr& scheduler){ scheduler_ = scheduler; }
+
+  // checkpoint the precision matrices and the active weight vectors; both require calc_gsc_weights_x() first
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
 
 #ifdef ENABLE_LEGACY_BTK_API
   void initPrecisionMatrix(float sigma2 = 0.01){ init_precision_matrix(sigma2); }
@@ -255,6 +277,7 @@ private:
   float  alpha_;            /* Weight for the quadratic constraint*/
   QuadraticConstraintType qctype_;
   bool is_wa_updated_;
+  AdaptationSchedulerPtr scheduler_;
 
   /* work space for updating active weight vectors */
   gsl_vector_complex* PzH_Z_;
@@ -479,6 +502,11 @@ public:
   void  set_search_param(float minTheta=-M_PI/2, float maxTheta=M_PI/2,
                          float minPhi=-M_PI/2,   float maxPhi=M_PI/2,
                          float widthTheta=0.1,   float widthPhi=0.1);
+  /**
+     @brief search only every 'coarseStep'-th direction in the frames in which 'sched' reports the deadline at risk;
+            the skipped directions accumulate the response power interpolated from the searched ones in those frames
+  */
+  void  set_deadline_scheduler(const DeadlineSchedulerPtr& sched, unsigned coarseStep = 4, const String& nm = "SRP");
 
 #ifdef ENABLE_LEGACY_BTK_API
   const gsl_vector *getNBestRPs(){ return nbest_rps(); }
@@ -501,6 +529,14 @@ protected:
   void clear_table_();
   virtual void get_nbest_hypotheses_from_accrp_();
   virtual void init_accs_();
+  // true if the search of the current frame is coarse
+  bool begin_search_();
+  void end_search_();
+  bool skip_direction_(bool coarse, unsigned idx) const { return coarse && (idx % coarseStep_ != 0); }
+  // keep the response power of a searched direction for 'accumulate_skipped_directions_()'
+  void keep_response_power_(bool coarse, unsigned unitX, double rp) { if (coarse) frameRPs_[unitX] = rp; }
+  // after a coarse search, accumulate the bilinear interpolation of the searched directions for the skipped ones
+  void accumulate_skipped_directions_();
 
   float widthTheta_;
   float widthPhi_;
@@ -524,6 +560,11 @@ protected:
   float engery_threshold_;
   float energy_;
 
+  DeadlineSchedulerPtr deadline_;
+  unsigned deadlineX_;
+  unsigned coarseStep_;
+  vector<double> frameRPs_;	// response powers of the directions searched in the current frame
+
 #ifdef  __MBDEBUG__
   void allocDebugWorkSapce();
 #endif /* #ifdef __MBDEBUG__ */
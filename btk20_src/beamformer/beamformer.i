@@ -8,9 +8,14 @@
 
 %{
 #include "beamformer/beamformer.h"
+#include "beamformer/channel_selection.h"
 #include "beamformer/taylorseries.h"
 #include "beamformer/modalbeamformer.h"
 #include "beamformer/tracker.h"
+#include "beamformer/beampattern.h"
+#include "beamformer/weight_cache.h"
+#include "beamformer/tfmask.h"
+#include "beamformer/fractional_delay.h"
 #include <numpy/arrayobject.h>
 #include "stream/pyStream.h"
 #include "postfilter/postfilter.h"
@@ -61,6 +66,7 @@ class SnapShotArray {
   unsigned nChan()  const;
   virtual void update();
   virtual void zero();
+  const MemoryUsage& memory_usage() const;
 
 #ifdef ENABLE_LEGACY_BTK_API
   const gsl_vector_complex* getSnapShot(unsigned fbinX);
@@ -95,6 +101,9 @@ public:
   gsl_matrix_complex* matrix_f(unsigned idx) const;
   virtual void update();
   virtual void zero();
+  void set_adaptation_scheduler(const AdaptationSchedulerPtr& scheduler);
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
 
 #ifdef ENABLE_LEGACY_BTK_API
   gsl_matrix_complex* getSpecMatrix(unsigned idx);
@@ -139,6 +148,9 @@ class SubbandBeamformer : public VectorComplexFeatureStream {
   virtual unsigned dim();
   unsigned fftLen();
   unsigned chanN();
+  void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND);
+  void set_bin_mask(const gsl_vector* mask);
+  void clear_bin_range();
 
 #ifdef ENABLE_LEGACY_BTK_API
   bool isEnd();
@@ -313,6 +325,9 @@ class SubbandGSCRLS : public SubbandGSC {
   void set_precision_matrix(unsigned fbinX, gsl_matrix_complex *Pz);
   void update_active_weight_vecotrs(bool flag);
   void set_quadratic_constraint(float alpha, int qctype=1);
+  void set_adaptation_scheduler(const AdaptationSchedulerPtr& scheduler);
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
 
 #ifdef ENABLE_LEGACY_BTK_API
   void initPrecisionMatrix(float sigma2 = 0.01);
@@ -605,6 +620,7 @@ class EigenBeamformer : public  SubbandDS {
   %feature("kwargs") set_look_direction;
   %feature("kwargs") array_geometry;
   %feature("kwargs") beampattern;
+  %feature("kwargs") channel_weights;
   %feature("kwargs") blocking_matrix;
 #ifdef ENABLE_LEGACY_BTK_API
   %feature("kwargs") setSigma2;
@@ -633,6 +649,8 @@ public:
                                   double minTheta=-M_PI, double maxTheta=M_PI,
                                   double minPhi=-M_PI, double maxPhi=M_PI,
                                   double widthTheta=0.1, double widthPhi=0.1 );
+  const gsl_matrix *array_positions();
+  const gsl_matrix_complex *channel_weights( unsigned unitX = 0 );
   virtual SnapShotArrayPtr snapshot_array() const;
   virtual SnapShotArrayPtr snapshot_array2() const;
   const gsl_matrix_complex *blocking_matrix(unsigned fbinX, unsigned unitX=0 ) const;
@@ -671,12 +689,80 @@ public:
   EigenBeamformer* operator->();
 };
 
+// ----- definition for class `BeampatternEvaluator' -----
+//
+%ignore BeampatternEvaluator;
+class BeampatternEvaluator {
+  %feature("kwargs") set_grid;
+  %feature("kwargs") set_directions;
+  %feature("kwargs") evaluate;
+  %feature("kwargs") beampattern;
+public:
+  BeampatternEvaluator(const gsl_matrix* positions, unsigned samplerate, unsigned fftLen, double sspeed = SSPEED,
+		       unsigned threadsN = 0);
+  ~BeampatternEvaluator();
+
+  unsigned chanN() const;
+  unsigned fbinN() const;
+  unsigned directionN() const;
+  unsigned thetaN() const;
+  unsigned phiN() const;
+
+  void set_grid(double minTheta = -M_PI, double maxTheta = M_PI, double minPhi = -M_PI, double maxPhi = M_PI,
+		double widthTheta = 0.1, double widthPhi = 0.1);
+  void set_directions(const gsl_matrix* directions);
+  void evaluate(const gsl_matrix_complex* weights, double theta, double phi);
+
+  const gsl_matrix* response() const;
+  const gsl_matrix* beampattern(unsigned fbinX);
+  const gsl_vector* directivity_index() const;
+  const gsl_vector* white_noise_gain() const;
+};
+
+class BeampatternEvaluatorPtr {
+  %feature("kwargs") BeampatternEvaluatorPtr;
+public:
+  %extend {
+    BeampatternEvaluatorPtr(const gsl_matrix* positions, unsigned samplerate, unsigned fftLen, double sspeed = SSPEED,
+			    unsigned threadsN = 0) {
+      return new BeampatternEvaluatorPtr(new BeampatternEvaluator(positions, samplerate, fftLen, sspeed, threadsN));
+    }
+  }
+  BeampatternEvaluator* operator->();
+};
+
+// ----- definition for class `SphericalWeightCache' -----
+//
+class SphericalWeightCache {
+  %feature("kwargs") set_max_bytes;
+public:
+  static void   set_max_bytes(size_t maxBytes);
+  static size_t max_bytes();
+  static bool   enabled();
+
+  static size_t   bytes();
+  static unsigned entryN();
+  static unsigned long hits();
+  static unsigned long misses();
+  static unsigned long evictions();
+  static double   hit_rate();
+
+  static void clear();
+  static void reset_statistics();
+  static void report();
+
+private:
+  SphericalWeightCache();
+  ~SphericalWeightCache();
+};
+
 // ----- definition for class `DOAEstimatorSRPBase' -----
 //
 %ignore DOAEstimatorSRPBase;
 class DOAEstimatorSRPBase {
   %feature("kwargs") set_energy_threshold;
   %feature("kwargs") set_frequency_range;
+  %feature("kwargs") set_deadline_scheduler;
 #ifdef ENABLE_LEGACY_BTK_API
   %feature("kwargs") setEnergyThreshold;
   %feature("kwargs") setFrequencyRange;
@@ -694,6 +780,7 @@ public:
   void  set_energy_threshold(float engeryThreshold);
   void  set_frequency_range(unsigned fbinMin, unsigned fbinMax);
   void  init_accs();
+  void  set_deadline_scheduler(const DeadlineSchedulerPtr& sched, unsigned coarseStep = 4, const String& nm = "SRP");
 
 #ifdef ENABLE_LEGACY_BTK_API
   const gsl_vector *getNBestRPs();
@@ -762,12 +849,15 @@ public:
 class DOAEstimatorSRPEB : public EigenBeamformer {
   %feature("kwargs") next;
   %feature("kwargs") reset;
+  %feature("kwargs") set_sh_domain_search;
 public:
   DOAEstimatorSRPEB( unsigned nBest, unsigned samplerate, unsigned fftlen, bool half_band_shift = false, unsigned NC=1, unsigned maxOrder=8, bool normalizeWeight=false, const String& nm = "DirectionEstimatorSRPMB");
   ~DOAEstimatorSRPEB();
 
   const gsl_vector_complex* next(int frame_no = -5);
   void reset();
+  void set_sh_domain_search( bool flag = true );
+  bool sh_domain_search() const;
 };
 
 class DOAEstimatorSRPEBPtr : public EigenBeamformerPtr {
@@ -1447,3 +1537,214 @@ public:
 
   SphericalSpatialHWNCBeamformer* operator->();
 };
+
+
+// ----- definition for class `ChannelSelector' -----
+//
+%ignore ChannelSelector;
+class ChannelSelector {
+  %feature("kwargs") add_channel;
+  %feature("kwargs") selected;
+ public:
+  ChannelSelector(unsigned select_num, unsigned interval = 50, double forget_fact = 0.95, unsigned bin_step = 4,
+		  double dead_db = -30.0, double distortion_db = 10.0, double hysteresis = 0.05, bool auto_commit = true,
+		  const String& nm = "ChannelSelector");
+  ~ChannelSelector();
+
+  void add_channel(const VectorComplexFeatureStreamPtr& chan);
+  const String& name() const;
+  unsigned size() const;
+  unsigned chanN() const;
+  unsigned selectN() const;
+  unsigned selected(unsigned slotX) const;
+  unsigned selection_no() const;
+  bool commit();
+  double energy_db(unsigned chanX) const;
+  double distortion_db(unsigned chanX) const;
+  double coherence(unsigned chanX) const;
+  double score(unsigned chanX) const;
+  void reset_statistics();
+};
+
+class ChannelSelectorPtr {
+  %feature("kwargs") ChannelSelectorPtr;
+ public:
+  %extend {
+    ChannelSelectorPtr(unsigned select_num, unsigned interval = 50, double forget_fact = 0.95, unsigned bin_step = 4,
+		       double dead_db = -30.0, double distortion_db = 10.0, double hysteresis = 0.05, bool auto_commit = true,
+		       const String& nm = "ChannelSelector") {
+      return new ChannelSelectorPtr(new ChannelSelector(select_num, interval, forget_fact, bin_step, dead_db, distortion_db, hysteresis, auto_commit, nm));
+    }
+  }
+
+  ChannelSelector* operator->();
+};
+
+
+// ----- definition for class `SelectedChannelFeature' -----
+//
+%ignore SelectedChannelFeature;
+class SelectedChannelFeature : public VectorComplexFeatureStream {
+ public:
+  SelectedChannelFeature(const ChannelSelectorPtr& selector, unsigned slotX, const String& nm = "SelectedChannelFeature");
+
+  virtual const gsl_vector_complex* next(int frame_no = -5);
+  virtual void reset();
+  unsigned slot() const;
+};
+
+class SelectedChannelFeaturePtr : public VectorComplexFeatureStreamPtr {
+  %feature("kwargs") SelectedChannelFeaturePtr;
+ public:
+  %extend {
+    SelectedChannelFeaturePtr(const ChannelSelectorPtr& selector, unsigned slotX, const String& nm = "SelectedChannelFeature") {
+      return new SelectedChannelFeaturePtr(new SelectedChannelFeature(selector, slotX, nm));
+    }
+
+    SelectedChannelFeaturePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  SelectedChannelFeature* operator->();
+};
+
+
+// ----- definition for class `TFMaskWriter' -----
+//
+%ignore TFMaskWriter;
+class TFMaskWriter {
+  %feature("kwargs") write;
+  %feature("kwargs") write_frames;
+ public:
+  TFMaskWriter(const String& fileName, unsigned binN, const String& encoding = "uint8");
+  ~TFMaskWriter();
+
+  unsigned binN() const;
+  unsigned long frameN() const;
+  void write(const gsl_vector_float* mask);
+  void write_frames(const gsl_matrix* mask);
+  void close();
+};
+
+class TFMaskWriterPtr {
+  %feature("kwargs") TFMaskWriterPtr;
+ public:
+  %extend {
+    TFMaskWriterPtr(const String& file_name, unsigned bin_num, const String& encoding = "uint8") {
+      return new TFMaskWriterPtr(new TFMaskWriter(file_name, bin_num, encoding));
+    }
+  }
+
+  TFMaskWriter* operator->();
+};
+
+
+// ----- definition for class `TFMaskFeature' -----
+//
+%ignore TFMaskFeature;
+class TFMaskFeature : public VectorFloatFeatureStream {
+ public:
+  TFMaskFeature(const String& fileName, bool memoryMap = true, const String& nm = "TF Mask Feature");
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+  unsigned long frameN() const;
+  const char* encoding() const;
+  const gsl_matrix* load();
+};
+
+class TFMaskFeaturePtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") TFMaskFeaturePtr;
+ public:
+  %extend {
+    TFMaskFeaturePtr(const String& file_name, bool memory_map = true, const String& nm = "TF Mask Feature") {
+      return new TFMaskFeaturePtr(new TFMaskFeature(file_name, memory_map, nm));
+    }
+
+    TFMaskFeaturePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  TFMaskFeature* operator->();
+};
+
+
+// ----- definition for class `MaskedSOSAccumulator' -----
+//
+%ignore MaskedSOSAccumulator;
+class MaskedSOSAccumulator {
+  %feature("kwargs") accumulate;
+  %feature("kwargs") target_covariance;
+  %feature("kwargs") noise_covariance;
+ public:
+  MaskedSOSAccumulator(const SnapShotArrayPtr& snapshots, float threshold = 0.0);
+  ~MaskedSOSAccumulator();
+
+  unsigned fbinN() const;
+  unsigned chanN() const;
+  void accumulate(const gsl_vector_float* maskT, const gsl_vector_float* maskN);
+  const gsl_matrix_complex* target_covariance(unsigned fbinX);
+  const gsl_matrix_complex* noise_covariance(unsigned fbinX);
+  const gsl_vector* target_weights() const;
+  const gsl_vector* noise_weights() const;
+  unsigned long frameN() const;
+  unsigned long skipped_bins() const;
+  void reset();
+  const MemoryUsage& memory_usage() const;
+};
+
+class MaskedSOSAccumulatorPtr {
+  %feature("kwargs") MaskedSOSAccumulatorPtr;
+ public:
+  %extend {
+    MaskedSOSAccumulatorPtr(const SnapShotArrayPtr& snapshot_array, float threshold = 0.0) {
+      return new MaskedSOSAccumulatorPtr(new MaskedSOSAccumulator(snapshot_array, threshold));
+    }
+  }
+
+  MaskedSOSAccumulator* operator->();
+};
+
+
+// ----- definition for class `TimeDomainDS' -----
+//
+%ignore TimeDomainDS;
+class TimeDomainDS : public VectorFloatFeatureStream {
+  %feature("kwargs") next;
+  %feature("kwargs") set_channel;
+  %feature("kwargs") set_delays;
+  %feature("kwargs") delay;
+  %feature("kwargs") target_delay;
+ public:
+  TimeDomainDS(unsigned blockLen, unsigned order = 3, const String& nm = "TimeDomainDS");
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+  void set_channel(VectorFloatFeatureStreamPtr& chan);
+  void clear_channel();
+  unsigned chanN() const;
+  unsigned order() const;
+  void set_delays(float samplerate, const gsl_vector* delays, unsigned ramp_len = 0);
+  double delay(unsigned chanX) const;
+  double target_delay(unsigned chanX) const;
+  unsigned ramp_remaining() const;
+  unsigned latency() const;
+};
+
+class TimeDomainDSPtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") TimeDomainDSPtr;
+ public:
+  %extend {
+    TimeDomainDSPtr(unsigned block_len, unsigned order = 3, const String& nm = "TimeDomainDS") {
+      return new TimeDomainDSPtr(new TimeDomainDS(block_len, order, nm));
+    }
+
+    TimeDomainDSPtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  TimeDomainDS* operator->();
+};
@@ -0,0 +1,245 @@
+/**
+ * @file beampattern.cc
+ * @brief Batch evaluation of beam patterns, directivity indices and white noise gains.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+#include <gsl/gsl_complex.h>
+#include <gsl/gsl_complex_math.h>
+#include <gsl/gsl_blas.h>
+#include "beamformer/beampattern.h"
+
+
+// ----- definition for class `BeampatternEvaluator::Worker_' -----
+//
+class BeampatternEvaluator::Worker_ {
+ public:
+  Worker_(BeampatternEvaluator* evaluator, unsigned workerX)
+    : evaluator_(evaluator), workerX_(workerX),
+      steering_(gsl_matrix_complex_alloc(evaluator->chanN(), evaluator->directionN())),
+      weights_(gsl_vector_complex_alloc(evaluator->chanN())),
+      response_(gsl_vector_complex_alloc(evaluator->directionN())) { }
+
+  ~Worker_() {
+    gsl_matrix_complex_free(steering_);
+    gsl_vector_complex_free(weights_);
+    gsl_vector_complex_free(response_);
+  }
+
+  BeampatternEvaluator*				evaluator_;
+  const unsigned				workerX_;
+  gsl_matrix_complex*				steering_;	// chanN x directionN
+  gsl_vector_complex*				weights_;	// conjugate weights of the bin
+  gsl_vector_complex*				response_;
+};
+
+
+// ----- methods for class `BeampatternEvaluator' -----
+//
+BeampatternEvaluator::
+BeampatternEvaluator(const gsl_matrix* positions, unsigned samplerate, unsigned fftLen, double sspeed, unsigned threadsN)
+  : samplerate_(samplerate), fftLen_(fftLen), sspeed_(sspeed), threadsN_(threadsN),
+    positions_(NULL), directions_(NULL), phases_(NULL), quadrature_(NULL), thetaN_(0), phiN_(0),
+    weights_(NULL), lookTheta_(0.0), lookPhi_(0.0),
+    response_(NULL), pattern_(NULL), directivity_(gsl_vector_calloc(fftLen / 2 + 1)), wng_(gsl_vector_calloc(fftLen / 2 + 1))
+{
+  if (positions->size2 != 3)
+    throw jdimension_error("Microphone positions must have 3 columns (%d).", positions->size2);
+
+  positions_ = gsl_matrix_alloc(positions->size1, 3);
+  gsl_matrix_memcpy(positions_, positions);
+
+  if (threadsN_ == 0) {
+    long procN = sysconf(_SC_NPROCESSORS_ONLN);
+    threadsN_ = (procN > 0) ? unsigned(procN) : 1;
+  }
+}
+
+BeampatternEvaluator::~BeampatternEvaluator()
+{
+  gsl_matrix_free(positions_);
+  if (directions_ != NULL)  gsl_matrix_free(directions_);
+  if (phases_ != NULL)      gsl_matrix_free(phases_);
+  if (quadrature_ != NULL)  gsl_vector_free(quadrature_);
+  if (response_ != NULL)    gsl_matrix_free(response_);
+  if (pattern_ != NULL)     gsl_matrix_free(pattern_);
+  gsl_vector_free(directivity_);
+  gsl_vector_free(wng_);
+}
+
+void BeampatternEvaluator::set_grid(double minTheta, double maxTheta, double minPhi, double maxPhi,
+				    double widthTheta, double widthPhi)
+{
+  // the same number of points and accumulation of the angles as 'EigenBeamformer::beampattern()'
+  float nTheta = ( maxTheta - minTheta ) / widthTheta + 0.5 + 1;
+  float nPhi   = ( maxPhi - minPhi ) / widthPhi + 0.5 + 1;
+  if ((int) nTheta <= 0 || (int) nPhi <= 0)
+    throw jparameter_error("Empty direction grid.");
+  unsigned thetaN = (int) nTheta, phiN = (int) nPhi;
+
+  gsl_matrix* directions = gsl_matrix_alloc(thetaN * phiN, 2);
+  unsigned dirX = 0;
+  unsigned thetaIdx = 0;
+  for (double theta = minTheta; thetaIdx < thetaN; theta += widthTheta, thetaIdx++) {
+    unsigned phiIdx = 0;
+    for (double phi = minPhi; phiIdx < phiN; phi += widthPhi, phiIdx++) {
+      gsl_matrix_set(directions, dirX, 0, theta);
+      gsl_matrix_set(directions, dirX, 1, phi);
+      dirX++;
+    }
+  }
+
+  set_directions(directions);
+  gsl_matrix_free(directions);
+  thetaN_ = thetaN;  phiN_ = phiN;
+}
+
+void BeampatternEvaluator::set_directions(const gsl_matrix* directions)
+{
+  if (directions->size2 != 2 || directions->size1 == 0)
+    throw jdimension_error("Directions must be given as (theta, phi) rows.");
+
+  if (directions_ != NULL) gsl_matrix_free(directions_);
+  directions_ = gsl_matrix_alloc(directions->size1, 2);
+  gsl_matrix_memcpy(directions_, directions);
+  thetaN_ = phiN_ = 0;
+
+  set_phases_();
+}
+
+void BeampatternEvaluator::set_phases_()
+{
+  unsigned chanN = positions_->size1;
+  unsigned dirN  = directions_->size1;
+
+  if (phases_ != NULL) gsl_matrix_free(phases_);
+  if (quadrature_ != NULL) gsl_vector_free(quadrature_);
+  if (response_ != NULL) gsl_matrix_free(response_);
+  phases_     = gsl_matrix_alloc(chanN, dirN);
+  quadrature_ = gsl_vector_alloc(dirN);
+  response_   = gsl_matrix_calloc(fbinN(), dirN);
+
+  for (unsigned dirX = 0; dirX < dirN; dirX++) {
+    double theta = gsl_matrix_get(directions_, dirX, 0);
+    double phi   = gsl_matrix_get(directions_, dirX, 1);
+    double ux = sin(theta) * cos(phi), uy = sin(theta) * sin(phi), uz = cos(theta);
+    for (unsigned chanX = 0; chanX < chanN; chanX++) {
+      double dot = gsl_matrix_get(positions_, chanX, 0) * ux + gsl_matrix_get(positions_, chanX, 1) * uy
+	+ gsl_matrix_get(positions_, chanX, 2) * uz;
+      gsl_matrix_set(phases_, chanX, dirX, dot / sspeed_);
+    }
+    gsl_vector_set(quadrature_, dirX, fabs(sin(theta)));
+  }
+
+  // a grid on a single ring of the poles: weight the directions equally
+  if (gsl_vector_max(quadrature_) <= 0.0)
+    gsl_vector_set_all(quadrature_, 1.0);
+}
+
+void BeampatternEvaluator::evaluate_bin_(unsigned fbinX, Worker_& worker)
+{
+  unsigned chanN = positions_->size1;
+  unsigned dirN  = directions_->size1;
+  double   omega = 2.0 * M_PI * fbinX * samplerate_ / fftLen_;
+
+  // steering matrix of the bin
+  for (unsigned chanX = 0; chanX < chanN; chanX++)
+    for (unsigned dirX = 0; dirX < dirN; dirX++)
+      gsl_matrix_complex_set(worker.steering_, chanX, dirX, gsl_complex_polar(1.0, omega * gsl_matrix_get(phases_, chanX, dirX)));
+
+  double wn = 0.0;
+  for (unsigned chanX = 0; chanX < chanN; chanX++) {
+    gsl_complex w = gsl_matrix_complex_get(weights_, fbinX, chanX);
+    gsl_vector_complex_set(worker.weights_, chanX, gsl_complex_conjugate(w));
+    wn += gsl_complex_abs2(w);
+  }
+
+  // w^H a(d) for all directions at once
+  gsl_blas_zgemv(CblasTrans, gsl_complex_rect(1.0, 0.0), worker.steering_, worker.weights_,
+		 gsl_complex_rect(0.0, 0.0), worker.response_);
+
+  double power = 0.0, norm = 0.0;
+  for (unsigned dirX = 0; dirX < dirN; dirX++) {
+    double mag = gsl_complex_abs(gsl_vector_complex_get(worker.response_, dirX));
+    double q   = gsl_vector_get(quadrature_, dirX);
+    gsl_matrix_set(response_, fbinX, dirX, mag);
+    power += q * mag * mag;  norm += q;
+  }
+
+  // response towards the look direction
+  double ux = sin(lookTheta_) * cos(lookPhi_), uy = sin(lookTheta_) * sin(lookPhi_), uz = cos(lookTheta_);
+  gsl_complex look = gsl_complex_rect(0.0, 0.0);
+  for (unsigned chanX = 0; chanX < chanN; chanX++) {
+    double dot = gsl_matrix_get(positions_, chanX, 0) * ux + gsl_matrix_get(positions_, chanX, 1) * uy
+      + gsl_matrix_get(positions_, chanX, 2) * uz;
+    look = gsl_complex_add(look, gsl_complex_mul(gsl_vector_complex_get(worker.weights_, chanX),
+						 gsl_complex_polar(1.0, omega * dot / sspeed_)));
+  }
+  double lookPower = gsl_complex_abs2(look);
+
+  double meanPower = (norm > 0.0) ? power / norm : 0.0;
+  gsl_vector_set(directivity_, fbinX, (lookPower > 0.0 && meanPower > 0.0) ? 10.0 * log10(lookPower / meanPower) : 0.0);
+  gsl_vector_set(wng_, fbinX, (wn > 0.0) ? lookPower / wn : 0.0);
+}
+
+void* BeampatternEvaluator::work_(void* arg)
+{
+  Worker_* worker = (Worker_*) arg;
+  BeampatternEvaluator* self = worker->evaluator_;
+
+  for (unsigned fbinX = worker->workerX_; fbinX < self->fbinN(); fbinX += self->threadsN_)
+    self->evaluate_bin_(fbinX, *worker);
+
+  return NULL;
+}
+
+void BeampatternEvaluator::evaluate(const gsl_matrix_complex* weights, double theta, double phi)
+{
+  if (directions_ == NULL)
+    throw jinitialization_error("Call set_grid() or set_directions() before evaluate().");
+  if (weights->size1 != fbinN() || weights->size2 != chanN())
+    throw jdimension_error("Weights must be %d x %d, not %d x %d.", fbinN(), chanN(), weights->size1, weights->size2);
+
+  weights_   = weights;
+  lookTheta_ = theta;  lookPhi_ = phi;
+
+  unsigned threadsN = (threadsN_ < fbinN()) ? threadsN_ : fbinN();
+  std::vector<Worker_*> workers(threadsN);
+  for (unsigned workerX = 0; workerX < threadsN; workerX++)
+    workers[workerX] = new Worker_(this, workerX);
+
+  std::vector<pthread_t> threads(threadsN);
+  unsigned startedN = 1;
+  for (unsigned workerX = 1; workerX < threadsN; workerX++, startedN++)
+    if (pthread_create(&threads[workerX], NULL, work_, workers[workerX]) != 0) break;
+  work_(workers[0]);
+  for (unsigned workerX = 1; workerX < startedN; workerX++)
+    pthread_join(threads[workerX], NULL);
+  // bins of workers that could not be started
+  for (unsigned workerX = startedN; workerX < threadsN; workerX++)
+    work_(workers[workerX]);
+
+  for (unsigned workerX = 0; workerX < threadsN; workerX++)
+    delete workers[workerX];
+  weights_ = NULL;
+}
+
+const gsl_matrix* BeampatternEvaluator::beampattern(unsigned fbinX)
+{
+  if (thetaN_ == 0)
+    throw jinitialization_error("The directions were not set with set_grid().");
+  if (fbinX >= fbinN())
+    throw jindex_error("Bin %d out of range (%d).", fbinX, fbinN());
+
+  if (pattern_ == NULL || pattern_->size1 != thetaN_ || pattern_->size2 != phiN_) {
+    if (pattern_ != NULL) gsl_matrix_free(pattern_);
+    pattern_ = gsl_matrix_alloc(thetaN_, phiN_);
+  }
+  for (unsigned thetaX = 0; thetaX < thetaN_; thetaX++)
+    for (unsigned phiX = 0; phiX < phiN_; phiX++)
+      gsl_matrix_set(pattern_, thetaX, phiX, gsl_matrix_get(response_, fbinX, thetaX * phiN_ + phiX));
+
+  return pattern_;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file beampattern.h
+ * @brief Batch evaluation of beam patterns, directivity indices and white noise gains.
+ */
+
+#ifndef BEAMPATTERN_H
+#define BEAMPATTERN_H
+
+#include <math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include "common/refcount.h"
+#include "common/jexception.h"
+
+#ifndef SSPEED
+#define SSPEED 343740.0
+#endif
+
+/**
+* \defgroup BeampatternEvaluator Beampattern Evaluator
+* 'EigenBeamformer::beampattern()' rebuilds the plane wave and its spherical
+* harmonics transformation for every direction and bin, which makes design
+* sweeps over many directions and configurations slow. A
+* 'BeampatternEvaluator' computes the response of all bins to all directions
+* of a grid in one call:
+*
+*   - the phases (p_c . u_d) / c of the plane waves at the microphones are
+*     computed once per grid,
+*   - the steering matrix of a bin, exp(j omega (p_c . u_d) / c) for all
+*     microphones c and directions d, is built once and multiplied with the
+*     weights of the bin,
+*   - the bins are spread over 'threadsN' threads.
+*
+* The weights are given in the microphone domain, one row per bin, such that
+* the response of bin f to direction d is w_f^H a_f(d); for an
+* 'EigenBeamformer' they are returned by 'channel_weights()'. Besides the
+* magnitude response, the evaluator yields the directivity index, the ratio
+* in dB of the power towards the look direction to the mean power over the
+* grid weighted by sin(theta), and the white noise gain
+* |w_f^H a_f(look)|^2 / (w_f^H w_f).
+*
+* The grid follows 'EigenBeamformer::beampattern()': theta is the polar and
+* phi the azimuth angle, and direction d = thetaX * phiN + phiX.
+*/
+/*@{*/
+
+// ----- definition for class `BeampatternEvaluator' -----
+//
+class BeampatternEvaluator {
+ public:
+  /**
+     @param const gsl_matrix* positions[in] microphone positions in mm (chanN x 3)
+     @param unsigned threadsN[in] number of threads; as many as processors if 0
+   */
+  BeampatternEvaluator(const gsl_matrix* positions, unsigned samplerate, unsigned fftLen, double sspeed = SSPEED,
+		       unsigned threadsN = 0);
+  ~BeampatternEvaluator();
+
+  unsigned chanN() const { return positions_->size1; }
+  unsigned fbinN() const { return fftLen_ / 2 + 1; }
+  unsigned directionN() const { return (directions_ == NULL) ? 0 : directions_->size1; }
+  unsigned thetaN() const { return thetaN_; }
+  unsigned phiN() const { return phiN_; }
+
+  void set_grid(double minTheta = -M_PI, double maxTheta = M_PI, double minPhi = -M_PI, double maxPhi = M_PI,
+		double widthTheta = 0.1, double widthPhi = 0.1);
+  // arbitrary directions, one (theta, phi) pair per row
+  void set_directions(const gsl_matrix* directions);
+
+  /**
+     @brief evaluate all bins and directions
+     @param const gsl_matrix_complex* weights[in] weights in the microphone domain (fbinN x chanN)
+     @param double theta[in] look direction for the directivity index and the white noise gain
+     @param double phi[in] look direction
+   */
+  void evaluate(const gsl_matrix_complex* weights, double theta, double phi);
+
+  // magnitude response (fbinN x directionN)
+  const gsl_matrix* response() const { return response_; }
+  // magnitude response of bin 'fbinX' over the grid of 'set_grid()' (thetaN x phiN)
+  const gsl_matrix* beampattern(unsigned fbinX);
+  // in dB (fbinN)
+  const gsl_vector* directivity_index() const { return directivity_; }
+  const gsl_vector* white_noise_gain() const { return wng_; }
+
+ private:
+  class Worker_;
+  static void* work_(void* arg);
+  void set_phases_();
+  void evaluate_bin_(unsigned fbinX, Worker_& worker);
+
+  const unsigned				samplerate_;
+  const unsigned				fftLen_;
+  const double					sspeed_;
+  unsigned					threadsN_;
+
+  gsl_matrix*					positions_;	// chanN x 3
+  gsl_matrix*					directions_;	// directionN x 2
+  gsl_matrix*					phases_;	// chanN x directionN, (p_c . u_d) / c
+  gsl_vector*					quadrature_;	// sin(theta) of each direction
+  unsigned					thetaN_;
+  unsigned					phiN_;
+
+  const gsl_matrix_complex*			weights_;
+  double					lookTheta_;
+  double					lookPhi_;
+  gsl_matrix*					response_;
+  gsl_matrix*					pattern_;
+  gsl_vector*					directivity_;
+  gsl_vector*					wng_;
+};
+
+typedef refcount_ptr<BeampatternEvaluator> BeampatternEvaluatorPtr;
+
+/*@}*/
+
+#endif
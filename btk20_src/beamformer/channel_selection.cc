@@ -0,0 +1,317 @@
+/**
+ * @file channel_selection.cc
+ * @brief Selection of the best microphones of a large array before beamforming.
+ */
+
+#include <math.h>
+#include <algorithm>
+#include <gsl/gsl_complex_math.h>
+#include "beamformer/channel_selection.h"
+
+static const double ChannelTiny = 1.0E-20;
+
+static double median_(std::vector<double> values)
+{
+  std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+  return values[values.size() / 2];
+}
+
+
+// ----- methods for class `ChannelSelector' -----
+//
+ChannelSelector::ChannelSelector(unsigned selectN, unsigned interval, double forgetFact, unsigned binStep,
+				 double deadDb, double distortionDb, double hysteresis, bool autoCommit, const String& nm)
+  : selectN_(selectN), interval_(interval), forgetFact_(forgetFact), binStep_(binStep),
+    deadDb_(deadDb), distortionDb_(distortionDb), hysteresis_(hysteresis), autoCommit_(autoCommit), name_(nm),
+    fftLen_(0), isPending_(false), selectionNo_(0), frameX_(-1), accumulatedN_(0),
+    energy_(NULL), highEnergy_(NULL), scores_(NULL), auto_(NULL), autoRef_(NULL), cross_(NULL), gains_(NULL)
+{
+  if (selectN_ == 0)
+    throw jparameter_error("Channel selector '%s' must select at least one channel.", nm.c_str());
+  if (interval_ == 0 || binStep_ == 0)
+    throw jparameter_error("Channel selector '%s': the interval (%d) and the bin step (%d) must be positive.", nm.c_str(), interval_, binStep_);
+  if (forgetFact_ < 0.0 || forgetFact_ >= 1.0)
+    throw jparameter_error("Channel selector '%s': the forgetting factor %f must lie in [0, 1).", nm.c_str(), forgetFact_);
+}
+
+ChannelSelector::~ChannelSelector()
+{
+  if (energy_     != NULL) gsl_vector_free(energy_);
+  if (highEnergy_ != NULL) gsl_vector_free(highEnergy_);
+  if (scores_     != NULL) gsl_vector_free(scores_);
+  if (auto_       != NULL) gsl_matrix_free(auto_);
+  if (cross_      != NULL) gsl_matrix_complex_free(cross_);
+  if (autoRef_    != NULL) gsl_matrix_free(autoRef_);
+  if (gains_      != NULL) gsl_vector_free(gains_);
+}
+
+void ChannelSelector::add_channel(const VectorComplexFeatureStreamPtr& chan)
+{
+  if (energy_ != NULL)
+    throw jconsistency_error("Channel selector '%s': channels must be added before the first frame.", name_.c_str());
+  if (candidates_.size() > 0 && chan->size() != fftLen_)
+    throw jdimension_error("Channel selector '%s': channel has %d subbands; expected %d.", name_.c_str(), chan->size(), fftLen_);
+
+  fftLen_ = chan->size();
+  candidates_.push_back(chan);
+  frames_.push_back(NULL);
+  if (selected_.size() < selectN_)
+    selected_.push_back(candidates_.size() - 1);
+}
+
+void ChannelSelector::alloc_()
+{
+  unsigned chanN = candidates_.size();
+  if (chanN < selectN_)
+    throw jdimension_error("Channel selector '%s' has %d channels to select %d from.", name_.c_str(), chanN, selectN_);
+
+  for (unsigned fbinX = 1; fbinX <= fftLen_ / 2; fbinX += binStep_)
+    bins_.push_back(fbinX);
+
+  energy_     = gsl_vector_calloc(chanN);
+  highEnergy_ = gsl_vector_calloc(chanN);
+  scores_     = gsl_vector_calloc(chanN);
+  auto_       = gsl_matrix_calloc(chanN, bins_.size());
+  cross_      = gsl_matrix_complex_calloc(chanN, bins_.size());
+  autoRef_    = gsl_matrix_calloc(chanN, bins_.size());
+  gains_      = gsl_vector_calloc(chanN);
+}
+
+void ChannelSelector::check_channel_(unsigned chanX) const
+{
+  if (chanX >= candidates_.size())
+    throw jindex_error("Channel selector '%s' has no channel %d.", name_.c_str(), chanX);
+}
+
+unsigned ChannelSelector::selected(unsigned slotX) const
+{
+  if (slotX >= selected_.size())
+    throw jindex_error("Channel selector '%s' has no slot %d.", name_.c_str(), slotX);
+  return selected_[slotX];
+}
+
+bool ChannelSelector::commit()
+{
+  if (isPending_ == false) return false;
+
+  selected_  = pending_;
+  isPending_ = false;
+  selectionNo_++;
+  return true;
+}
+
+void ChannelSelector::select(const std::vector<unsigned>& chanX)
+{
+  if (chanX.size() != selectN_)
+    throw jdimension_error("Channel selector '%s' routes %d channels, not %d.", name_.c_str(), selectN_, chanX.size());
+  for (unsigned slotX = 0; slotX < chanX.size(); slotX++) {
+    check_channel_(chanX[slotX]);
+    if (std::find(chanX.begin(), chanX.begin() + slotX, chanX[slotX]) != chanX.begin() + slotX)
+      throw jparameter_error("Channel selector '%s': channel %d is selected twice.", name_.c_str(), chanX[slotX]);
+  }
+
+  selected_  = chanX;
+  isPending_ = false;
+  selectionNo_++;
+}
+
+double ChannelSelector::energy_db(unsigned chanX) const
+{
+  check_channel_(chanX);
+  if (energy_ == NULL) return 0.0;
+  return 10.0 * log10(gsl_vector_get(energy_, chanX) + ChannelTiny);
+}
+
+double ChannelSelector::distortion_db(unsigned chanX) const
+{
+  check_channel_(chanX);
+  if (energy_ == NULL) return 0.0;
+  return 10.0 * log10((gsl_vector_get(highEnergy_, chanX) + ChannelTiny) / (gsl_vector_get(energy_, chanX) + ChannelTiny));
+}
+
+double ChannelSelector::coherence(unsigned chanX) const
+{
+  check_channel_(chanX);
+  if (energy_ == NULL) return 0.0;
+
+  double sum = 0.0;
+  for (unsigned binX = 0; binX < bins_.size(); binX++) {
+    double de = gsl_matrix_get(auto_, chanX, binX) * gsl_matrix_get(autoRef_, chanX, binX);
+    sum += gsl_complex_abs2(gsl_matrix_complex_get(cross_, chanX, binX)) / (de + ChannelTiny);
+  }
+  return sum / bins_.size();
+}
+
+double ChannelSelector::score(unsigned chanX) const
+{
+  check_channel_(chanX);
+  if (scores_ == NULL) return 0.0;
+  return gsl_vector_get(scores_, chanX);
+}
+
+void ChannelSelector::reset_statistics()
+{
+  accumulatedN_ = 0;
+  if (energy_ == NULL) return;
+
+  gsl_vector_set_zero(energy_);
+  gsl_vector_set_zero(highEnergy_);
+  gsl_vector_set_zero(scores_);
+  gsl_matrix_set_zero(auto_);
+  gsl_matrix_complex_set_zero(cross_);
+  gsl_matrix_set_zero(autoRef_);
+}
+
+// update the smoothed statistics with the current frame of all candidates
+void ChannelSelector::accumulate_()
+{
+  unsigned chanN  = candidates_.size();
+  unsigned highX  = fftLen_ / 4;
+  double   alpha  = (accumulatedN_ == 0) ? 0.0 : forgetFact_;
+  double   beta   = 1.0 - alpha;
+
+  // energies
+  gsl_vector_scale(energy_, alpha);
+  gsl_vector_scale(highEnergy_, alpha);
+  for (unsigned chanX = 0; chanX < chanN; chanX++) {
+    for (unsigned binX = 0; binX < bins_.size(); binX++) {
+      double x2 = gsl_complex_abs2(gsl_vector_complex_get(frames_[chanX], bins_[binX]));
+      *gsl_vector_ptr(energy_, chanX) += beta * x2;
+      if (bins_[binX] > highX)
+	*gsl_vector_ptr(highEnergy_, chanX) += beta * x2;
+    }
+    // normalize the channels to unit power, so that loud noisy channels do not dominate the reference; leave out dead channels
+    double gain = (gsl_vector_get(scores_, chanX) <= -1.0) ? 0.0 : 1.0 / sqrt(gsl_vector_get(energy_, chanX) + ChannelTiny);
+    gsl_vector_set(gains_, chanX, gain);
+  }
+
+  // coherence of each channel with the normalized sum of the other channels
+  for (unsigned binX = 0; binX < bins_.size(); binX++) {
+    unsigned    fbinX = bins_[binX];
+    gsl_complex sum   = gsl_complex_rect(0.0, 0.0);
+    for (unsigned chanX = 0; chanX < chanN; chanX++)
+      sum = gsl_complex_add(sum, gsl_complex_mul_real(gsl_vector_complex_get(frames_[chanX], fbinX), gsl_vector_get(gains_, chanX)));
+
+    for (unsigned chanX = 0; chanX < chanN; chanX++) {
+      gsl_complex x   = gsl_vector_complex_get(frames_[chanX], fbinX);
+      gsl_complex ref = gsl_complex_sub(sum, gsl_complex_mul_real(x, gsl_vector_get(gains_, chanX)));
+
+      gsl_matrix_set(auto_, chanX, binX, alpha * gsl_matrix_get(auto_, chanX, binX) + beta * gsl_complex_abs2(x));
+      gsl_matrix_set(autoRef_, chanX, binX, alpha * gsl_matrix_get(autoRef_, chanX, binX) + beta * gsl_complex_abs2(ref));
+      gsl_matrix_complex_set(cross_, chanX, binX,
+			     gsl_complex_add(gsl_complex_mul_real(gsl_matrix_complex_get(cross_, chanX, binX), alpha),
+					     gsl_complex_mul_real(gsl_complex_mul(x, gsl_complex_conjugate(ref)), beta)));
+    }
+  }
+  accumulatedN_++;
+}
+
+// score the candidates and replace selected channels that are clearly worse
+void ChannelSelector::evaluate_()
+{
+  unsigned chanN = candidates_.size();
+  std::vector<double> energyDb(chanN), distortionDb(chanN);
+  for (unsigned chanX = 0; chanX < chanN; chanX++) {
+    energyDb[chanX]     = energy_db(chanX);
+    distortionDb[chanX] = distortion_db(chanX);
+  }
+  double medianEnergy     = median_(energyDb);
+  double medianDistortion = median_(distortionDb);
+
+  for (unsigned chanX = 0; chanX < chanN; chanX++) {
+    double s = coherence(chanX);
+    if (distortionDb[chanX] > medianDistortion + distortionDb_) s -= 1.0;
+    if (energyDb[chanX] < medianEnergy + deadDb_) s = -1.0;
+    gsl_vector_set(scores_, chanX, s);
+  }
+
+  std::vector<unsigned> next(isPending_ ? pending_ : selected_);
+  while (true) {
+    unsigned worstX = 0;
+    for (unsigned slotX = 1; slotX < selectN_; slotX++)
+      if (gsl_vector_get(scores_, next[slotX]) < gsl_vector_get(scores_, next[worstX])) worstX = slotX;
+
+    int bestX = -1;
+    for (unsigned chanX = 0; chanX < chanN; chanX++) {
+      if (std::find(next.begin(), next.end(), chanX) != next.end()) continue;
+      if (bestX < 0 || gsl_vector_get(scores_, chanX) > gsl_vector_get(scores_, bestX)) bestX = chanX;
+    }
+
+    if (bestX < 0 || gsl_vector_get(scores_, bestX) <= gsl_vector_get(scores_, next[worstX]) + hysteresis_) break;
+    next[worstX] = bestX;
+  }
+
+  if (next != selected_) {
+    pending_   = next;
+    isPending_ = true;
+  } else
+    isPending_ = false;
+}
+
+const gsl_vector_complex* ChannelSelector::frame_(unsigned slotX, int frameX)
+{
+  if (frameX != frameX_) {
+    if (frameX != frameX_ + 1)
+      throw jindex_error("Channel selector '%s': frame %d requested after frame %d.", name_.c_str(), frameX, frameX_);
+
+    if (energy_ == NULL) alloc_();
+    if (autoCommit_) commit();
+
+    for (unsigned chanX = 0; chanX < candidates_.size(); chanX++)
+      frames_[chanX] = candidates_[chanX]->next(frameX);
+    frameX_ = frameX;
+
+    accumulate_();
+    if (accumulatedN_ % interval_ == 0)
+      evaluate_();
+  }
+
+  return frames_[selected_[slotX]];
+}
+
+void ChannelSelector::reset_()
+{
+  if (frameX_ < 0) return;
+
+  for (unsigned chanX = 0; chanX < candidates_.size(); chanX++)
+    candidates_[chanX]->reset();
+  frameX_ = -1;
+}
+
+
+// ----- methods for class `SelectedChannelFeature' -----
+//
+SelectedChannelFeature::SelectedChannelFeature(const ChannelSelectorPtr& selector, unsigned slotX, const String& nm)
+  : VectorComplexFeatureStream(selector->size(), nm), selector_(selector), slotX_(slotX)
+{
+  if (selector_->chanN() == 0)
+    throw jinitialization_error("Add the channels to selector '%s' before its outputs.", selector_->name().c_str());
+  if (slotX_ >= selector_->selectN())
+    throw jindex_error("Channel selector '%s' has no slot %d.", selector_->name().c_str(), slotX_);
+}
+
+const gsl_vector_complex* SelectedChannelFeature::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  if (frame_no >= 0 && frame_no != frame_no_ + 1)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
+
+  const gsl_vector_complex* block;
+  try {
+    block = selector_->frame_(slotX_, frame_no_ + 1);
+  } catch (j_error& e) {
+    if (e.getCode() == JITERATOR) is_end_ = true;
+    throw;
+  }
+  gsl_vector_complex_memcpy(vector_, block);
+
+  increment_();
+  return vector_;
+}
+
+void SelectedChannelFeature::reset()
+{
+  selector_->reset_();
+  VectorComplexFeatureStream::reset();
+}
@@ -0,0 +1,154 @@
+/**
+ * @file channel_selection.h
+ * @brief Selection of the best microphones of a large array before beamforming.
+ */
+
+#ifndef CHANNEL_SELECTION_H
+#define CHANNEL_SELECTION_H
+
+#include <vector>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_complex.h>
+#include "common/refcount.h"
+#include "common/jexception.h"
+#include "stream/stream.h"
+
+/**
+* \defgroup ChannelSelector Channel Selector
+* A 'ChannelSelector' monitors the subband outputs of all microphones of an
+* array and routes the best 'selectN' of them to the beamformer. The beamformer
+* is built once on 'selectN' 'SelectedChannelFeature' streams, so that the
+* snapshots, the spatial spectral matrices and the weights only have the
+* dimension of the selected channels, and a different channel set is
+* switched in without rebuilding the stream graph.
+*
+* The quality of each channel is measured from every 'binStep'-th bin of the
+* analysis outputs:
+*
+*   - the smoothed energy; a channel more than 'deadDb' below the median
+*     energy of the array is dead,
+*   - the ratio of the energy in the upper half of the band to the total
+*     energy; clipping and electrical faults spread energy to high frequencies,
+*     so a ratio more than 'distortionDb' above the median marks the channel
+*     as distorted,
+*   - the magnitude squared coherence with the sum of the other channels,
+*     each normalized to unit power, which is low for channels dominated by
+*     local noise.
+*
+* The score of a channel is its coherence, less one if it is distorted and
+* set to -1 if it is dead. Every 'interval' frames a channel that is not
+* selected replaces the worst selected one if its score is higher by more
+* than 'hysteresis'. The new set takes effect with the next frame, or with
+* 'commit()' if 'autoCommit' is false; in either case 'selection_no()' is
+* incremented, so that the owner can recompute the weights of the beamformer
+* for the new geometry.
+*/
+/*@{*/
+
+class SelectedChannelFeature;
+
+// ----- definition for class `ChannelSelector' -----
+//
+class ChannelSelector {
+  friend class SelectedChannelFeature;
+
+ public:
+  /**
+     @param unsigned selectN[in] number of channels passed to the beamformer
+     @param unsigned interval[in] number of frames between the selections
+     @param double forgetFact[in] forgetting factor of the statistics
+     @param unsigned binStep[in] the statistics use every binStep-th bin
+   */
+  ChannelSelector(unsigned selectN, unsigned interval = 50, double forgetFact = 0.95, unsigned binStep = 4,
+		  double deadDb = -30.0, double distortionDb = 10.0, double hysteresis = 0.05, bool autoCommit = true,
+		  const String& nm = "ChannelSelector");
+  ~ChannelSelector();
+
+  // add a candidate; all candidates must be added before the first frame
+  void add_channel(const VectorComplexFeatureStreamPtr& chan);
+
+  const String& name() const { return name_; }
+  unsigned size() const { return fftLen_; }
+  unsigned chanN() const { return candidates_.size(); }
+  unsigned selectN() const { return selectN_; }
+
+  // candidate routed to 'slotX'
+  unsigned selected(unsigned slotX) const;
+  // incremented whenever the selected channels change
+  unsigned selection_no() const { return selectionNo_; }
+  // apply a pending selection; returns true if the selected channels changed
+  bool commit();
+  // route the candidates 'chanX' to the slots in that order
+  void select(const std::vector<unsigned>& chanX);
+
+  double energy_db(unsigned chanX) const;
+  double distortion_db(unsigned chanX) const;
+  double coherence(unsigned chanX) const;
+  double score(unsigned chanX) const;
+
+  // forget the statistics of all channels
+  void reset_statistics();
+
+ private:
+  const gsl_vector_complex* frame_(unsigned slotX, int frameX);
+  void reset_();
+  void alloc_();
+  void accumulate_();
+  void evaluate_();
+  void check_channel_(unsigned chanX) const;
+
+  const unsigned				selectN_;
+  const unsigned				interval_;
+  const double					forgetFact_;
+  const unsigned				binStep_;
+  const double					deadDb_;
+  const double					distortionDb_;
+  const double					hysteresis_;
+  const bool					autoCommit_;
+  const String					name_;
+
+  unsigned					fftLen_;
+  std::vector<VectorComplexFeatureStreamPtr>	candidates_;
+  std::vector<const gsl_vector_complex*>	frames_;	// current output of each candidate
+  std::vector<unsigned>				selected_;
+  std::vector<unsigned>				pending_;
+  bool						isPending_;
+  unsigned					selectionNo_;
+  int						frameX_;
+  unsigned					accumulatedN_;
+
+  std::vector<unsigned>				bins_;		// bins used for the statistics
+  gsl_vector*					energy_;
+  gsl_vector*					highEnergy_;
+  gsl_vector*					scores_;
+  gsl_matrix*					auto_;		// chanN x bins
+  gsl_matrix*					autoRef_;	// chanN x bins, of the reference of each channel
+  gsl_matrix_complex*				cross_;		// chanN x bins, of each channel with its reference
+  gsl_vector*					gains_;
+};
+
+typedef refcount_ptr<ChannelSelector> ChannelSelectorPtr;
+
+
+// ----- definition for class `SelectedChannelFeature' -----
+//
+class SelectedChannelFeature : public VectorComplexFeatureStream {
+ public:
+  SelectedChannelFeature(const ChannelSelectorPtr& selector, unsigned slotX, const String& nm = "SelectedChannelFeature");
+
+  virtual const gsl_vector_complex* next(int frame_no = -5);
+  virtual void reset();
+
+  unsigned slot() const { return slotX_; }
+
+ private:
+  ChannelSelectorPtr				selector_;
+  const unsigned				slotX_;
+};
+
+typedef Inherit<SelectedChannelFeature, VectorComplexFeatureStreamPtr> SelectedChannelFeaturePtr;
+
+/*@}*/
+
+#endif
@@ -0,0 +1,362 @@
+/**
+ * @file fractional_delay.cc
+ * @brief Time-domain delay-and-sum beamforming with Lagrange fractional-delay filters.
+ *
+ * Must be compiled with -ffp-contract=off for the same reason as
+ * 'complex_kernels.cc': the vector kernels agree with the scalar one bit
+ * for bit only if no multiply-add is fused.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include "matrix/complex_kernels.h"
+#include "beamformer/fractional_delay.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BTK_FD_X86
+#include <immintrin.h>
+#define BTK_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#if defined(__aarch64__)
+#define BTK_FD_NEON
+#include <arm_neon.h>
+#endif
+
+
+// ----- FIR kernels -----
+//
+// y[n] = y[n] + sum_k h[k] x[n - k] for n = 0, ..., len - 1; 'x' points at
+// the current sample of a history buffer. Every output sample sums the taps
+// in the same order in all implementations.
+//
+typedef void (*FIRKernel_)(unsigned len, const float* x, const float* h, unsigned tapsN, float* y);
+
+static void fir_scalar_(unsigned len, const float* x, const float* h, unsigned tapsN, float* y)
+{
+  for (unsigned n = 0; n < len; n++) {
+    float acc = 0.0f;
+    for (unsigned k = 0; k < tapsN; k++)
+      acc = acc + h[k] * x[(int) n - (int) k];
+    y[n] = y[n] + acc;
+  }
+}
+
+#ifdef BTK_FD_X86
+
+BTK_TARGET("sse") static void fir_sse_(unsigned len, const float* x, const float* h, unsigned tapsN, float* y)
+{
+  unsigned n = 0;
+  for (; n + 4 <= len; n += 4) {
+    __m128 acc = _mm_setzero_ps();
+    for (unsigned k = 0; k < tapsN; k++)
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(h[k]), _mm_loadu_ps(x + (int) n - (int) k)));
+    _mm_storeu_ps(y + n, _mm_add_ps(_mm_loadu_ps(y + n), acc));
+  }
+  fir_scalar_(len - n, x + n, h, tapsN, y + n);
+}
+
+BTK_TARGET("avx") static void fir_avx_(unsigned len, const float* x, const float* h, unsigned tapsN, float* y)
+{
+  unsigned n = 0;
+  for (; n + 8 <= len; n += 8) {
+    __m256 acc = _mm256_setzero_ps();
+    for (unsigned k = 0; k < tapsN; k++)
+      acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(h[k]), _mm256_loadu_ps(x + (int) n - (int) k)));
+    _mm256_storeu_ps(y + n, _mm256_add_ps(_mm256_loadu_ps(y + n), acc));
+  }
+  fir_sse_(len - n, x + n, h, tapsN, y + n);
+}
+
+#endif /* BTK_FD_X86 */
+
+#ifdef BTK_FD_NEON
+
+static void fir_neon_(unsigned len, const float* x, const float* h, unsigned tapsN, float* y)
+{
+  unsigned n = 0;
+  for (; n + 4 <= len; n += 4) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (unsigned k = 0; k < tapsN; k++)
+      acc = vaddq_f32(acc, vmulq_f32(vdupq_n_f32(h[k]), vld1q_f32(x + (int) n - (int) k)));
+    vst1q_f32(y + n, vaddq_f32(vld1q_f32(y + n), acc));
+  }
+  fir_scalar_(len - n, x + n, h, tapsN, y + n);
+}
+
+#endif /* BTK_FD_NEON */
+
+// follow the instruction set of 'ComplexKernels', which honours BTK20_SIMD
+static FIRKernel_ fir_kernel_()
+{
+  switch (ComplexKernels::isa()) {
+#ifdef BTK_FD_X86
+  case ComplexKernels::SSE2:   return fir_sse_;
+  case ComplexKernels::AVX2:
+  case ComplexKernels::AVX512: return fir_avx_;
+#endif
+#ifdef BTK_FD_NEON
+  case ComplexKernels::NEON:   return fir_neon_;
+#endif
+  default:                     return fir_scalar_;
+  }
+}
+
+
+// ----- methods for class `LagrangeFarrow' -----
+//
+// The Lagrange tap h_k(D) = prod_{j != k} (D - j) / (k - j) is expanded as
+// a polynomial in mu = D - offset().
+//
+LagrangeFarrow::LagrangeFarrow(unsigned order)
+  : order_(order), farrow_((order + 1) * (order + 1), 0.0)
+{
+  if (order_ < 1 || order_ > 15)
+    throw jparameter_error("Interpolator order %d is not in [1, 15].", order_);
+
+  unsigned tapsN = order_ + 1;
+  for (unsigned k = 0; k < tapsN; k++) {
+    std::vector<double> poly(1, 1.0);
+    for (unsigned j = 0; j < tapsN; j++) {
+      if (j == k) continue;
+      // multiply by (mu + offset - j) / (k - j)
+      double c     = (double) offset() - (double) j;
+      double scale = 1.0 / ((double) k - (double) j);
+      std::vector<double> next(poly.size() + 1, 0.0);
+      for (unsigned m = 0; m < poly.size(); m++) {
+	next[m]     += c * scale * poly[m];
+	next[m + 1] += scale * poly[m];
+      }
+      poly.swap(next);
+    }
+    for (unsigned m = 0; m < tapsN; m++)
+      farrow_[k * tapsN + m] = poly[m];
+  }
+}
+
+unsigned LagrangeFarrow::taps(double delay, float gain, float* h) const
+{
+  if (delay < offset()) delay = offset();
+  double whole = floor(delay);
+  double mu    = delay - whole;
+  unsigned tapsN = order_ + 1;
+  for (unsigned k = 0; k < tapsN; k++) {
+    const double* c = &farrow_[k * tapsN];
+    double val = c[order_];
+    for (int m = order_ - 1; m >= 0; m--)
+      val = val * mu + c[m];
+    h[k] = (float) (gain * val);
+  }
+
+  return (unsigned) whole - offset();
+}
+
+
+// ----- methods for class `TimeDomainDS' -----
+//
+TimeDomainDS::TimeDomainDS(unsigned blockLen, unsigned order, const String& nm)
+  : VectorFloatFeatureStream(blockLen, nm),
+    farrow_(order), historyN_(order), rampLeft_(0), steered_(false), taps_(order + 1)
+{
+}
+
+TimeDomainDS::~TimeDomainDS()
+{
+}
+
+void TimeDomainDS::set_channel(VectorFloatFeatureStreamPtr& chan)
+{
+  if (chan->size() != size())
+    throw jdimension_error("Channel '%s' has blocks of %d samples instead of %d.", chan->name().c_str(), chan->size(), size());
+
+  channels_.push_back(chan);
+  history_.push_back(std::vector<float>(historyN_ + size(), 0.0f));
+  delay_.push_back(farrow_.offset());
+  target_.push_back(farrow_.offset());
+  step_.push_back(0.0);
+  steered_ = false;
+}
+
+void TimeDomainDS::clear_channel()
+{
+  channels_.clear();
+  history_.clear();
+  delay_.clear();
+  target_.clear();
+  step_.clear();
+  rampLeft_ = 0;
+  steered_  = false;
+}
+
+void TimeDomainDS::check_channel_(unsigned chanX) const
+{
+  if (chanX >= chanN())
+    throw jindex_error("Channel index %d is out of range [0, %d).", chanX, chanN());
+}
+
+double TimeDomainDS::delay(unsigned chanX) const
+{
+  check_channel_(chanX);
+  return delay_[chanX];
+}
+
+double TimeDomainDS::target_delay(unsigned chanX) const
+{
+  check_channel_(chanX);
+  return target_[chanX];
+}
+
+/**
+   @brief the channel arriving last gets the smallest delay, 'latency()', and every
+          other one the difference of the arrival times on top of it
+ */
+void TimeDomainDS::set_delays(float samplerate, const gsl_vector* delays, unsigned rampLen)
+{
+  if (delays->size != chanN())
+    throw jdimension_error("Number of delays (%d) does not match number of channels (%d).", (int) delays->size, chanN());
+
+  double latest = gsl_vector_max(delays);
+  unsigned historyN = historyN_;
+  for (unsigned chanX = 0; chanX < chanN(); chanX++) {
+    target_[chanX] = farrow_.offset() + (latest - gsl_vector_get(delays, chanX)) * samplerate;
+    // whole samples of shift plus the taps, for the target and for the glide towards it
+    unsigned needed = (unsigned) floor(target_[chanX]) - farrow_.offset() + farrow_.order();
+    if (needed > historyN) historyN = needed;
+  }
+  alloc_history_(historyN);
+
+  if (steered_ == false) rampLen = 0;
+  else if (rampLen == 0) rampLen = size();
+  steered_  = true;
+  rampLeft_ = rampLen;
+  for (unsigned chanX = 0; chanX < chanN(); chanX++) {
+    if (rampLen == 0) {
+      delay_[chanX] = target_[chanX];
+      step_[chanX]  = 0.0;
+    } else {
+      step_[chanX]  = (target_[chanX] - delay_[chanX]) / rampLen;
+    }
+  }
+}
+
+// grow the history of every channel, keeping the most recent samples
+void TimeDomainDS::alloc_history_(unsigned historyN)
+{
+  if (historyN <= historyN_) return;
+
+  unsigned extra = historyN - historyN_;
+  for (unsigned chanX = 0; chanX < chanN(); chanX++) {
+    std::vector<float> history(historyN + size(), 0.0f);
+    memcpy(&history[extra], &history_[chanX][0], historyN_ * sizeof(float));
+    history_[chanX].swap(history);
+  }
+  historyN_ = historyN;
+}
+
+// the delay is constant over the block: fixed taps through the vector kernel
+void TimeDomainDS::filter_fixed_(unsigned chanX, float gain)
+{
+  unsigned     shift = farrow_.taps(delay_[chanX], gain, &taps_[0]);
+  const float* x     = &history_[chanX][historyN_] - shift;
+  fir_kernel_()(size(), x, &taps_[0], farrow_.tapsN(), vector_->data);
+}
+
+// the delay glides: new taps for every sample
+void TimeDomainDS::filter_ramp_(unsigned chanX, float gain)
+{
+  const float* x     = &history_[chanX][historyN_];
+  float*       y     = vector_->data;
+  unsigned     tapsN = farrow_.tapsN();
+  for (unsigned n = 0; n < size(); n++) {
+    double   delay = (n + 1 < rampLeft_) ? delay_[chanX] + (n + 1) * step_[chanX] : target_[chanX];
+    unsigned shift = farrow_.taps(delay, gain, &taps_[0]);
+    // rounding in the glide must not reach beyond the history
+    if (shift + farrow_.order() > historyN_) shift = historyN_ - farrow_.order();
+    int      pos   = (int) n - (int) shift;
+    float  acc   = 0.0f;
+    for (unsigned k = 0; k < tapsN; k++)
+      acc = acc + taps_[k] * x[pos - (int) k];
+    y[n] = y[n] + acc;
+  }
+}
+
+const gsl_vector_float* TimeDomainDS::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  if (frame_no >= 0 && frame_no - 1 != frame_no_)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
+  if (chanN() == 0)
+    throw jconsistency_error("No channels were set for '%s'.", name().c_str());
+  if (steered_ == false)
+    throw jconsistency_error("Call set_delays() before next().");
+
+  for (unsigned chanX = 0; chanX < chanN(); chanX++) {
+    const gsl_vector_float* block = channels_[chanX]->next(frame_no_ + 1);
+    if (channels_[chanX]->is_end()) is_end_ = true;
+    float* current = &history_[chanX][historyN_];
+    for (unsigned n = 0; n < size(); n++)
+      current[n] = gsl_vector_float_get(block, n);
+  }
+  increment_();
+
+  gsl_vector_float_set_zero(vector_);
+  float gain = 1.0f / chanN();
+  for (unsigned chanX = 0; chanX < chanN(); chanX++) {
+    if (rampLeft_ > 0)
+      filter_ramp_(chanX, gain);
+    else
+      filter_fixed_(chanX, gain);
+
+    std::vector<float>& history(history_[chanX]);
+    memmove(&history[0], &history[size()], historyN_ * sizeof(float));
+  }
+
+  if (rampLeft_ > 0) {
+    unsigned rampN = (rampLeft_ < size()) ? rampLeft_ : size();
+    for (unsigned chanX = 0; chanX < chanN(); chanX++)
+      delay_[chanX] = (rampN == rampLeft_) ? target_[chanX] : delay_[chanX] + rampN * step_[chanX];
+    rampLeft_ -= rampN;
+  }
+
+  return vector_;
+}
+
+void TimeDomainDS::reset()
+{
+  for (unsigned chanX = 0; chanX < chanN(); chanX++) {
+    channels_[chanX]->reset();
+    std::fill(history_[chanX].begin(), history_[chanX].end(), 0.0f);
+    delay_[chanX] = target_[chanX];
+  }
+  rampLeft_ = 0;
+
+  VectorFloatFeatureStream::reset();
+  is_end_ = false;
+}
+
+void TimeDomainDS::describe(StreamInfo& info) const
+{
+  for (unsigned chanX = 0; chanX < chanN(); chanX++)
+    info.sources.push_back(channels_[chanX].operator->());
+  // the steering changes at run time, so the stream is never shared
+  info.flops = 2.0 * chanN() * size() * farrow_.tapsN();
+  info.bytes = chanN() * (historyN_ + size()) * sizeof(float);
+}
+
+void TimeDomainDS::set_source(unsigned srcX, Countable* src)
+{
+  check_channel_(srcX);
+  rewire_source(channels_[srcX], src);
+}
+
+void TimeDomainDS::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorFloatFeatureStream::memory_buffers_(usage);
+  size_t history = 0;
+  for (unsigned chanX = 0; chanX < chanN(); chanX++)
+    history += history_[chanX].capacity() * sizeof(float);
+  usage.add("history", history);
+}
@@ -0,0 +1,125 @@
+/**
+ * @file fractional_delay.h
+ * @brief Time-domain delay-and-sum beamforming with Lagrange fractional-delay filters.
+ */
+
+#ifndef FRACTIONAL_DELAY_H
+#define FRACTIONAL_DELAY_H
+
+#include <vector>
+#include <gsl/gsl_vector.h>
+#include "common/refcount.h"
+#include "common/jexception.h"
+#include "stream/stream.h"
+
+/**
+* \defgroup FractionalDelay Fractional-Delay Beamforming
+* 'TimeDomainDS' aligns the sample blocks of the microphones with
+* fractional-delay FIR filters and averages them. Unlike the subband chain
+* 'OverSampledDFTAnalysisBank' -> 'SubbandDS' -> 'OverSampledDFTSynthesisBank',
+* whose filter banks delay the output by several frames, it adds only the
+* delay of the interpolator, 'latency()' samples, to that of the last
+* arriving channel: one sample for the default cubic interpolator.
+*
+* The interpolator of order N is the Lagrange FIR with N + 1 taps in Farrow
+* form: each tap is a polynomial in the fractional part mu of the delay,
+*
+*   h_k(mu) = sum_m C[k][m] mu^m,   D = floor(D) + mu,
+*
+* so that taps for any delay D >= N / 2 follow from one Horner evaluation.
+* While the steering holds still, each block is filtered with fixed taps by
+* an SSE, AVX or NEON kernel, whichever 'ComplexKernels' has selected.
+* After 'set_delays()' the delays glide linearly to their new values and the
+* taps are evaluated for every sample, so that a tracker can re-steer the
+* beam at any block without clicks. The kernels perform the same operations
+* in the same order as the scalar code, so the output does not depend on
+* the instruction set.
+*/
+/*@{*/
+
+// ----- definition for class `LagrangeFarrow' -----
+//
+class LagrangeFarrow {
+ public:
+  LagrangeFarrow(unsigned order = 3);
+
+  unsigned order() const { return order_; }
+  unsigned tapsN() const { return order_ + 1; }
+  // smallest delay in samples; the fractional part then lies between the middle taps
+  unsigned offset() const { return order_ / 2; }
+
+  // C[k][m] of tap k and power m of the fractional delay
+  double coefficient(unsigned tapX, unsigned powerX) const { return farrow_[tapX * tapsN() + powerX]; }
+
+  /**
+     @brief the taps for a delay of 'delay' >= offset() samples, scaled by 'gain'
+     @return the whole samples by which the taps must be shifted
+  */
+  unsigned taps(double delay, float gain, float* h) const;
+
+ private:
+  const unsigned				order_;
+  std::vector<double>				farrow_;
+};
+
+
+// ----- definition for class `TimeDomainDS' -----
+//
+class TimeDomainDS : public VectorFloatFeatureStream {
+ public:
+  TimeDomainDS(unsigned blockLen, unsigned order = 3, const String& nm = "TimeDomainDS");
+  ~TimeDomainDS();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
+
+  void set_channel(VectorFloatFeatureStreamPtr& chan);
+  void clear_channel();
+  unsigned chanN() const { return channels_.size(); }
+  unsigned order() const { return farrow_.order(); }
+
+  /**
+     @brief steer to the arrival delays of 'SubbandDS::calc_array_manifold_vectors()'
+     @param float samplerate[in]
+     @param const gsl_vector* delays[in] delays[chanN] in seconds
+     @param unsigned rampLen[in] samples over which the delays glide to the new values, 0 for one block;
+                                 the first steering takes effect at once
+  */
+  void set_delays(float samplerate, const gsl_vector* delays, unsigned rampLen = 0);
+
+  // delay of a channel in samples, now and at the end of the glide
+  double delay(unsigned chanX) const;
+  double target_delay(unsigned chanX) const;
+  // samples left until the delays reach their targets
+  unsigned ramp_remaining() const { return rampLeft_; }
+  // delay of the output behind the last arriving channel, in samples
+  unsigned latency() const { return farrow_.offset(); }
+
+ protected:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
+ private:
+  void check_channel_(unsigned chanX) const;
+  void alloc_history_(unsigned historyN);
+  void filter_fixed_(unsigned chanX, float gain);
+  void filter_ramp_(unsigned chanX, float gain);
+
+  const LagrangeFarrow				farrow_;
+  std::vector<VectorFloatFeatureStreamPtr>	channels_;
+  std::vector<std::vector<float> >		history_;	// historyN_ past samples followed by the current block
+  unsigned					historyN_;
+  std::vector<double>				delay_;
+  std::vector<double>				target_;
+  std::vector<double>				step_;
+  unsigned					rampLeft_;
+  bool						steered_;
+  std::vector<float>				taps_;
+};
+
+typedef Inherit<TimeDomainDS, VectorFloatFeatureStreamPtr> TimeDomainDSPtr;
+
+/*@}*/
+
+#endif
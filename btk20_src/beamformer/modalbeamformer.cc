@@ -4,6 +4,7 @@
  * @author Kenichi Kumatani
  */
 #include "beamformer/modalbeamformer.h"
+#include <typeinfo>
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_sf_trig.h>
 #include <gsl/gsl_sf_bessel.h>
@@ -283,7 +284,9 @@ EigenBeamformer::EigenBeamformer( unsigned sampleRate, unsigned fftLen, bool hal
      beampattern_(NULL),
      WNG_(NULL),
      wgain_(1.0),
-     sigma2_(0.0)
+     sigma2_(0.0),
+     positions_(NULL),
+     channel_weights_(NULL)
 {
   bfweight_vec_.resize(1); // the steering vector
   bfweight_vec_[0] = NULL;
@@ -320,26 +323,26 @@ EigenBeamformer::~EigenBeamformer()
     gsl_matrix_free( beampattern_ );
   if( NULL != WNG_ )
     gsl_vector_free(WNG_ );
+  if( NULL != positions_ )
+    gsl_matrix_free( positions_ );
+  if( NULL != channel_weights_ )
+    gsl_matrix_complex_free( channel_weights_ );
 }
 
 /**
-   @brief compute the output of the eigenbeamformer
+   @brief compute the weights of each order that multiply the conjugate spherical harmonics of the look direction
    @param unsigned fbinX[in]
-   @param gsl_matrix_complex *bMat[in] mode amplitudes 
-   @param double theta[in] the steering direction
-   @param double phi[in] the steering direction
-   @param gsl_vector_complex *weights[out]
+   @param gsl_vector_complex *orderWeights[out] [maxOrder_]
 */
-void EigenBeamformer::calc_weights_( unsigned fbinX, gsl_vector_complex *weights )
+void EigenBeamformer::calc_order_weights_( unsigned fbinX, gsl_vector_complex *orderWeights )
 {
   unsigned norm = dim_ * (unsigned)phi_s_->size;
 
-  for(int n=0,idx=0;n<maxOrder_;n++){/* order */
+  for(unsigned n=0;n<maxOrder_;n++){/* order */
     gsl_complex bn = gsl_matrix_complex_get( mode_mplitudes_, fbinX, n ); //bn = modeAmplitude( order, ka );
     double      bn2 = gsl_complex_abs2( bn ) + sigma2_;
     double      de  = norm * bn2;
     gsl_complex in;
-    gsl_complex inbn;
 
     if( 0 == ( n % 4 ) ){
       in = gsl_complex_rect(1,0);
@@ -354,19 +357,37 @@ void EigenBeamformer::calc_weights_( unsigned fbinX, gsl_vector_complex *weights
       in = gsl_complex_rect(0,-1);
     }
 
-    inbn = gsl_complex_mul( in, bn );
+    // HMDI beamfomrer; see S Yan's paper
+    gsl_vector_complex_set( orderWeights, n, gsl_complex_div_real( gsl_complex_mul_real( gsl_complex_mul( in, bn ), 4 * M_PI ), de ) );
+  }
+}
+
+/**
+   @brief compute the output of the eigenbeamformer
+   @param unsigned fbinX[in]
+   @param gsl_matrix_complex *bMat[in] mode amplitudes 
+   @param double theta[in] the steering direction
+   @param double phi[in] the steering direction
+   @param gsl_vector_complex *weights[out]
+*/
+void EigenBeamformer::calc_weights_( unsigned fbinX, gsl_vector_complex *weights )
+{
+  gsl_vector_complex *orderWeights = gsl_vector_complex_alloc( maxOrder_ );
+
+  calc_order_weights_( fbinX, orderWeights );
+  for(int n=0,idx=0;n<(int)maxOrder_;n++){/* order */
+    gsl_complex inbn = gsl_vector_complex_get( orderWeights, n );
     for( int m=-n;m<=n;m++){/* degree */
-      gsl_complex weight;
       gsl_complex YmnA = gsl_complex_conjugate(sphericalHarmonic( m, n, theta_, phi_ ));
 
       //weight = gsl_complex_div( sphericalHarmonic( m, n, theta_, phi_ ), gsl_complex_mul_real( gsl_complex_mul( in, bn ), 4 * M_PI ) ); // follow Rafaely's paper
       //gsl_vector_complex_set( weights, idx, gsl_complex_conjugate(weight) ); 
-      weight = gsl_complex_div_real( gsl_complex_mul( gsl_complex_mul_real( YmnA, 4 * M_PI ), inbn ), de ); // HMDI beamfomrer; see S Yan's paper
-      gsl_vector_complex_set( weights, idx, weight ); 
+      gsl_vector_complex_set( weights, idx, gsl_complex_mul( YmnA, inbn ) );
       idx++;
     }
   }
-  
+  gsl_vector_complex_free( orderWeights );
+
   if( true==weights_normalized_ )
     normalize_weights_( weights, wgain_ );
 
@@ -743,20 +764,64 @@ bool EigenBeamformer::calc_steering_unit_( int unitX, bool isGSC )
   weights = bfweight_vec_[unitX]->wq_f(0); 
   calcDCWeights( maxOrder_, weights );
 
+  String weightKey = weight_cache_key_();
+  bool   useCache  = ( weightKey != "" && SphericalWeightCache::enabled() );
   for(unsigned fbinX=1;fbinX<=fftLen2_;fbinX++){
     //fprintf(stderr, "calc_weights_(%d)\n", fbinX);
     weights = bfweight_vec_[unitX]->wq_f(fbinX); 
+    gsl_matrix_complex *B = ( true == isGSC ) ? bfweight_vec_[unitX]->B()[fbinX] : NULL;
+    String key;
+
+    if( true == useCache ){
+      key = ( geometry_cache_key_( weightKey ) << theta_ << phi_ << fbinX << unsigned(isGSC) ).str();
+      const SphericalWeightCache::Entry* entry = SphericalWeightCache::find( key );
+      if( NULL != entry ){
+        gsl_vector_complex_const_view wq = gsl_matrix_complex_const_row( entry->matrix(0), 0 );
+        gsl_vector_complex_memcpy( weights, &wq.vector );
+        if( NULL != B )
+          gsl_matrix_complex_memcpy( B, entry->matrix(1) );
+        SphericalWeightCache::release( entry );
+        continue;
+      }
+    }
+
     calc_weights_( fbinX, weights );
 
     if( true == isGSC ){// calculate a blocking matrix for each frequency bin.
       bfweight_vec_[unitX]->calcBlockingMatrix( fbinX );
     }
+
+    if( true == useCache ){
+      vector<gsl_matrix_complex*> matrices( ( NULL != B ) ? 2 : 1 );
+      matrices[0] = gsl_matrix_complex_alloc( 1, weights->size );
+      gsl_matrix_complex_set_row( matrices[0], 0, weights );
+      if( NULL != B ){
+        matrices[1] = gsl_matrix_complex_alloc( B->size1, B->size2 );
+        gsl_matrix_complex_memcpy( matrices[1], B );
+      }
+      SphericalWeightCache::release( SphericalWeightCache::insert( key, matrices ) );
+    }
   }
   bfweight_vec_[unitX]->setTimeAlignment();
 
   return true;
 }
 
+/**
+   @brief the key of the weights of this class and array in 'SphericalWeightCache'
+   @param const String& tag[in] the parameters specific to the weights
+ */
+WeightCacheKey EigenBeamformer::geometry_cache_key_( const String& tag ) const
+{
+  WeightCacheKey key( typeid(*this).name() );
+
+  key << tag << samplerate_ << fftLen_ << maxOrder_ << NC_ << a_ << double(sigma2_);
+  if( NULL != theta_s_ )
+    key << theta_s_ << phi_s_;
+
+  return key;
+}
+
 
 void planeWaveOnSphericalAperture( double ka, double theta, double phi, 
 				   gsl_vector *theta_s, gsl_vector *phi_s, gsl_vector_complex *p )
@@ -810,19 +875,163 @@ gsl_matrix *EigenBeamformer::beampattern( unsigned fbinX, double theta, double p
   return beampattern_;
 }
 
+const gsl_matrix *EigenBeamformer::array_positions()
+{
+  if( NULL == theta_s_ )
+    throw jinitialization_error("Set the array geometry first\n");
+
+  unsigned nChan = theta_s_->size;
+  if( NULL == positions_ || positions_->size1 != nChan ){
+    if( NULL != positions_ )
+      gsl_matrix_free( positions_ );
+    positions_ = gsl_matrix_alloc( nChan, 3 );
+  }
+  for(unsigned chanX=0;chanX<nChan;chanX++){
+    double theta_sn = gsl_vector_get( theta_s_, chanX );
+    double phi_sn   = gsl_vector_get( phi_s_,   chanX );
+    gsl_matrix_set( positions_, chanX, 0, a_ * sin(theta_sn) * cos(phi_sn) );
+    gsl_matrix_set( positions_, chanX, 1, a_ * sin(theta_sn) * sin(phi_sn) );
+    gsl_matrix_set( positions_, chanX, 2, a_ * cos(theta_sn) );
+  }
+
+  return positions_;
+}
+
+/**
+   @brief map the weights to the microphone domain
+   @note F_n = sum_c p_c Y_n(c), so w^H F = sum_c p_c sum_n w_n^* Y_n(c) = sum_c h_c^* p_c with the weight of microphone c h_c = sum_n w_n Y_n^*(c)
+ */
+const gsl_matrix_complex *EigenBeamformer::channel_weights( unsigned unitX )
+{
+  if( NULL == theta_s_ || NULL == sh_s_ )
+    throw jinitialization_error("Set the array geometry first\n");
+  if( unitX >= bfweight_vec_.size() || NULL == bfweight_vec_[unitX] )
+    throw jinitialization_error("Set the look direction first\n");
+
+  unsigned nChan = theta_s_->size;
+  if( NULL == channel_weights_ || channel_weights_->size2 != nChan ){
+    if( NULL != channel_weights_ )
+      gsl_matrix_complex_free( channel_weights_ );
+    channel_weights_ = gsl_matrix_complex_alloc( fftLen2_ + 1, nChan );
+  }
+  for(unsigned fbinX=0;fbinX<=fftLen2_;fbinX++){
+    const gsl_vector_complex *weights = bfweight_vec_[unitX]->wq_f(fbinX);
+    for(unsigned chanX=0;chanX<nChan;chanX++){
+      gsl_complex val = gsl_complex_rect( 0, 0 );
+      for(unsigned idx=0;idx<dim_;idx++)
+        val = gsl_complex_add( val, gsl_complex_mul( gsl_vector_complex_get( weights, idx ),
+                                                     gsl_complex_conjugate( gsl_vector_complex_get( sh_s_[idx], chanX ) ) ) );
+      gsl_matrix_complex_set( channel_weights_, fbinX, chanX, val );
+    }
+  }
+
+  return channel_weights_;
+}
+
 
 // ----- definition for class DOAEstimatorSRPEB' -----
 // 
 
 DOAEstimatorSRPEB::DOAEstimatorSRPEB( unsigned nBest, unsigned sampleRate, unsigned fftLen, bool halfBandShift, unsigned NC, unsigned maxOrder, bool normalizeWeight, const String& nm ):
   DOAEstimatorSRPBase( nBest, fftLen/2 ),
-  EigenBeamformer( sampleRate, fftLen, halfBandShift, NC, maxOrder, normalizeWeight, nm )
+  EigenBeamformer( sampleRate, fftLen, halfBandShift, NC, maxOrder, normalizeWeight, nm ),
+  shDomain_(false),
+  shY_(NULL),
+  shOrderWeights_(NULL),
+  shG_(NULL),
+  shR_(NULL),
+  shFbinMin_(0),
+  shFbinMax_(0)
 {
   //_beamformer = new EigenBeamformer( sampleRate, fftLen, halfBandShift, NC, maxOrder, nm );
 }
 
 DOAEstimatorSRPEB::~DOAEstimatorSRPEB()
 {
+  free_sh_table_();
+}
+
+void DOAEstimatorSRPEB::free_sh_table_()
+{
+  if( NULL != shY_ ){
+    gsl_matrix_complex_free( shY_ );
+    shY_ = NULL;
+  }
+  if( NULL != shOrderWeights_ ){
+    gsl_matrix_complex_free( shOrderWeights_ );
+    shOrderWeights_ = NULL;
+  }
+  if( NULL != shG_ ){
+    gsl_matrix_complex_free( shG_ );
+    shG_ = NULL;
+  }
+  if( NULL != shR_ ){
+    gsl_matrix_complex_free( shR_ );
+    shR_ = NULL;
+  }
+}
+
+/**
+   @brief compute the order weights of the bins in the frequency range
+   @note The weights of direction u are w_{nm} = Y_n^{m*}(u) c_n, and the output w^H F = sum_{nm} Y_n^m(u) c_n^* F_{nm}.
+         If the weights are normalized, the norm of w is sqrt( sum_n |c_n|^2 (2n+1) / 4pi ) by the addition theorem,
+         the same for all the directions.
+ */
+void DOAEstimatorSRPEB::calc_sh_order_weights_()
+{
+  unsigned fbinN = fbinMax_ - fbinMin_ + 1;
+  gsl_vector_complex *orderWeights = gsl_vector_complex_alloc( maxOrder_ );
+
+  if( NULL != shOrderWeights_ )
+    gsl_matrix_complex_free( shOrderWeights_ );
+  if( NULL != shG_ )
+    gsl_matrix_complex_free( shG_ );
+  if( NULL != shR_ )
+    gsl_matrix_complex_free( shR_ );
+  shOrderWeights_ = gsl_matrix_complex_alloc( dim_, fbinN );
+  shG_            = gsl_matrix_complex_alloc( dim_, fbinN );
+  shR_            = gsl_matrix_complex_alloc( shY_->size1, fbinN );
+
+  for (unsigned fbinX = fbinMin_; fbinX <= fbinMax_; fbinX++) {
+    calc_order_weights_( fbinX, orderWeights );
+
+    double scale = 1.0;
+    if( true == weights_normalized_ ){
+      double nrm2 = 0.0;
+      for(unsigned n=0;n<maxOrder_;n++)
+	nrm2 += gsl_complex_abs2( gsl_vector_complex_get( orderWeights, n ) ) * ( 2 * n + 1 ) / ( 4 * M_PI );
+      scale = wgain_ / sqrt( nrm2 );
+    }
+
+    for(unsigned n=0,idx=0;n<maxOrder_;n++){/* order */
+      gsl_complex cn = gsl_complex_mul_real( gsl_complex_conjugate( gsl_vector_complex_get( orderWeights, n ) ), scale );
+      for(unsigned m=0;m<2*n+1;m++,idx++)/* degree */
+	gsl_matrix_complex_set( shOrderWeights_, idx, fbinX - fbinMin_, cn );
+    }
+  }
+  gsl_vector_complex_free( orderWeights );
+
+  shFbinMin_ = fbinMin_;
+  shFbinMax_ = fbinMax_;
+}
+
+/**
+   @brief compute the outputs of all the directions and bins at the current frame with one matrix product
+ */
+void DOAEstimatorSRPEB::calc_sh_response_powers_()
+{
+  if( NULL == shOrderWeights_ || shFbinMin_ != fbinMin_ || shFbinMax_ != fbinMax_ )
+    calc_sh_order_weights_();
+
+  for (unsigned fbinX = fbinMin_; fbinX <= fbinMax_; fbinX++) {
+    const gsl_vector_complex* F = st_snapshot_array_->snapshot(fbinX);
+    for(unsigned idx=0;idx<dim_;idx++)
+      gsl_matrix_complex_set( shG_, idx, fbinX - fbinMin_,
+			      gsl_complex_mul( gsl_matrix_complex_get( shOrderWeights_, idx, fbinX - fbinMin_ ),
+					       gsl_vector_complex_get( F, idx ) ) );
+  }
+
+  gsl_blas_zgemm( CblasNoTrans, CblasNoTrans, gsl_complex_rect( 1.0, 0.0 ), shY_, shG_, gsl_complex_rect( 0.0, 0.0 ), shR_ );
 }
 
 void DOAEstimatorSRPEB::calc_steering_unit_table_()
@@ -838,6 +1047,35 @@ void DOAEstimatorSRPEB::calc_steering_unit_table_()
   nPhi_   = (unsigned)( ( maxPhi_ - minPhi_ ) / widthPhi_ + 0.5 );
   int maxUnit  = nTheta_ * nPhi_;
 
+  if( true == shDomain_ ){
+    free_sh_table_();
+    shY_ = gsl_matrix_complex_alloc( maxUnit, dim_ );
+
+    if( NULL != accRPs_ )
+      gsl_vector_free( accRPs_ );
+    accRPs_ = gsl_vector_calloc( maxUnit );
+
+    unsigned unitX = 0;
+    unsigned thetaIdx = 0;
+    for(double theta=minTheta_;thetaIdx<nTheta_;theta+=widthTheta_,thetaIdx++){
+      unsigned phiIdx = 0;
+      for(double phi=minPhi_;phiIdx<nPhi_;phi+=widthPhi_,phiIdx++){
+	for(int n=0,idx=0;n<(int)maxOrder_;n++)/* order */
+	  for(int m=-n;m<=n;m++,idx++)/* degree */
+	    gsl_matrix_complex_set( shY_, unitX, idx, sphericalHarmonic( m, n, theta, phi ) );
+	unitX++;
+      }
+    }
+    calc_sh_order_weights_();
+
+#ifdef __MBDEBUG__
+    allocDebugWorkSapce();
+#endif /* #ifdef __MBDEBUG__ */
+
+    table_initialized_ = true;
+    return;
+  }
+
   svTbl_.resize(maxUnit);
 
   for(unsigned i=0;i<maxUnit;i++){
@@ -892,9 +1130,14 @@ float DOAEstimatorSRPEB::calc_response_power_( unsigned unitX )
 
     // calculate outputs from bin 1 to fftLen - 1 by using the property of the symmetry.
     for (unsigned fbinX = fbinMin_; fbinX <= fbinMax_; fbinX++) {
-      F = st_snapshot_array_->snapshot(fbinX);
-      weights = svTbl_[unitX][fbinX];
-      gsl_blas_zdotc( weights, F, &val ); // x^H y
+      if( true == shDomain_ ){
+	val = gsl_matrix_complex_get( shR_, unitX, fbinX - fbinMin_ );
+      }
+      else{
+	F = st_snapshot_array_->snapshot(fbinX);
+	weights = svTbl_[unitX][fbinX];
+	gsl_blas_zdotc( weights, F, &val ); // x^H y
+      }
 
       if( fbinX < fftLen2_ ){
 	gsl_vector_complex_set(vector_, fbinX, val);
@@ -956,14 +1199,19 @@ const gsl_vector_complex* DOAEstimatorSRPEB::next( int frame_no )
     }
   }
 
+  bool coarse = begin_search_();
+  if( true == shDomain_ )
+    calc_sh_response_powers_();
   unsigned unitX = 0;
   unsigned thetaIdx = 0;
   for(double theta=minTheta_;thetaIdx<nTheta_;theta+=widthTheta_,thetaIdx++){
     unsigned phiIdx = 0;
     for(double phi=minPhi_;phiIdx<nPhi_;phi+=widthPhi_,phiIdx++){
+      if( skip_direction_( coarse, thetaIdx ) || skip_direction_( coarse, phiIdx ) ){ unitX++; continue; }
       //set_look_direction( theta, phi );
       rp = calc_response_power_( unitX );
       gsl_vector_set( accRPs_, unitX, gsl_vector_get( accRPs_, unitX ) + rp );
+      keep_response_power_( coarse, unitX, rp );
       unitX++;
 #ifdef __MBDEBUG__
       gsl_matrix_set( rpMat_, thetaIdx, phiIdx, rp);
@@ -990,6 +1238,8 @@ const gsl_vector_complex* DOAEstimatorSRPEB::next( int frame_no )
       }
     }
   }
+  if( coarse ) accumulate_skipped_directions_();
+  end_search_();
 
   increment_();
   return vector_;
@@ -1350,14 +1600,17 @@ const gsl_vector_complex* DOAEstimatorSRPSphDSB::next( int frame_no )
     }
   }
 
+  bool coarse = begin_search_();
   unsigned unitX = 0;
   unsigned thetaIdx = 0;
   for(double theta=minTheta_;thetaIdx<nTheta_;theta+=widthTheta_,thetaIdx++){
     unsigned phiIdx = 0;
     for(double phi=minPhi_;phiIdx<nPhi_;phi+=widthPhi_,phiIdx++){
+      if( skip_direction_( coarse, thetaIdx ) || skip_direction_( coarse, phiIdx ) ){ unitX++; continue; }
       //set_look_direction( theta, phi );
       rp = calc_response_power_( unitX );
       gsl_vector_set( accRPs_, unitX, gsl_vector_get( accRPs_, unitX ) + rp );
+      keep_response_power_( coarse, unitX, rp );
       unitX++;
 #ifdef __MBDEBUG__
       gsl_matrix_set( rpMat_, thetaIdx, phiIdx, rp);
@@ -1384,6 +1637,8 @@ const gsl_vector_complex* DOAEstimatorSRPSphDSB::next( int frame_no )
       }
     }
   }
+  if( coarse ) accumulate_skipped_directions_();
+  end_search_();
 
   increment_();
   return vector_;
@@ -1824,9 +2079,10 @@ SphericalMOENBeamformer::SphericalMOENBeamformer( unsigned sampleRate, unsigned
   CN_ = 2.0 / ( maxOrder * maxOrder ); // maxOrder = N + 1
   bf_order_ = maxOrder;
 
-  A_      = (gsl_matrix_complex** )malloc( (fftLen/2+1) * sizeof(gsl_matrix_complex*) );
-  fixedW_ = (gsl_matrix_complex** )malloc( (fftLen/2+1) * sizeof(gsl_matrix_complex*) );
-  if( A_ == NULL || fixedW_ == NULL ){
+  A_      = (const gsl_matrix_complex** )malloc( (fftLen/2+1) * sizeof(gsl_matrix_complex*) );
+  fixedW_ = (const gsl_matrix_complex** )malloc( (fftLen/2+1) * sizeof(gsl_matrix_complex*) );
+  fixed_terms_ = (const SphericalWeightCache::Entry** )malloc( (fftLen/2+1) * sizeof(SphericalWeightCache::Entry*) );
+  if( A_ == NULL || fixedW_ == NULL || fixed_terms_ == NULL ){
     throw jallocation_error("SphericalMOENBeamformer: gsl_matrix_complex_alloc failed\n");
   }
 
@@ -1843,6 +2099,7 @@ SphericalMOENBeamformer::SphericalMOENBeamformer( unsigned sampleRate, unsigned
   for( unsigned fbinX=0;fbinX<=fftLen/2;fbinX++){
     A_[fbinX]       = NULL;
     fixedW_[fbinX]  = NULL;
+    fixed_terms_[fbinX] = NULL;
     BN_[fbinX]      = NULL;
     diagonal_weights_[fbinX] = 0.0;
   }
@@ -1854,15 +2111,13 @@ SphericalMOENBeamformer::~SphericalMOENBeamformer()
   unsigned fftLen2 = fftLen_ / 2;
 
   for( unsigned fbinX=0;fbinX<=fftLen2;fbinX++){
-    if( A_[fbinX] != NULL )
-      gsl_matrix_complex_free( A_[fbinX] );
-    if( fixedW_[fbinX] != NULL )
-      gsl_matrix_complex_free( fixedW_[fbinX] );
+    SphericalWeightCache::release( fixed_terms_[fbinX] );
     if( BN_[fbinX] != NULL )
       gsl_vector_complex_free( BN_[fbinX] );
   }
   free(A_);
   free(fixedW_);
+  free(fixed_terms_);
   free(BN_);
   free(diagonal_weights_);
 }
@@ -1945,44 +2200,16 @@ void SphericalMOENBeamformer::set_diagonal_looading( unsigned fbinX, float diago
  */
 void SphericalMOENBeamformer::calc_weights_( unsigned fbinX, gsl_vector_complex *weights )
 {
-  unsigned nChan = theta_s_->size;
-
-  if( A_[fbinX] == NULL ){
-    A_[fbinX]  = gsl_matrix_complex_alloc( dim_, nChan );
+  if( BN_[fbinX] == NULL )
     BN_[fbinX] = gsl_vector_complex_calloc( dim_ );
-  }
   else
     gsl_vector_complex_set_zero( BN_[fbinX] );
   
   for(int n=0,idx=0;n<maxOrder_;n++){/* order */
-    gsl_complex bn = gsl_matrix_complex_get( mode_mplitudes_, fbinX, n ); //bn = modeAmplitude( order, ka );
-    gsl_complex in;
-    
-    if( 0 == ( n % 4 ) ){
-      in = gsl_complex_rect(1,0);
-    }
-    else if( 1 == ( n % 4 ) ){
-      in = gsl_complex_rect(0,1);
-    }
-    else if( 2 == ( n % 4 ) ){
-      in = gsl_complex_rect(-1,0);
-    }
-    else{
-      in = gsl_complex_rect(0,-1);
-    }
-
     for( int m=-n;m<=n;m++){/* degree */
-      for(int chanX=0;chanX<nChan;chanX++){
-        if( false == is_term_fixed_ ) {
-          gsl_complex YAmn_s = gsl_vector_complex_get( sh_s_[idx], chanX );
-          gsl_complex val = gsl_complex_mul( YAmn_s, gsl_complex_mul( in, bn ) );
-          //gsl_complex val = gsl_complex_div( gsl_complex_conjugate(YAmn_s), gsl_complex_mul( in, bn ) );
-          gsl_matrix_complex_set( A_[fbinX], idx, chanX, gsl_complex_mul_real( val, 4 * M_PI ) );
-        }
-        if( n < bf_order_ ){
-	  //gsl_vector_complex_set( BN_[fbinX], idx, gsl_complex_mul_real( sphericalHarmonic( m, n, theta_, phi_ ), 2 * M_PI ) );
-          gsl_vector_complex_set( BN_[fbinX], idx, gsl_complex_mul_real( gsl_complex_conjugate( sphericalHarmonic( m, n, theta_, phi_ ) ), 2 * M_PI ) );
-        }
+      if( n < (int)bf_order_ ){
+        //gsl_vector_complex_set( BN_[fbinX], idx, gsl_complex_mul_real( sphericalHarmonic( m, n, theta_, phi_ ), 2 * M_PI ) );
+        gsl_vector_complex_set( BN_[fbinX], idx, gsl_complex_mul_real( gsl_complex_conjugate( sphericalHarmonic( m, n, theta_, phi_ ) ), 2 * M_PI ) );
       }
       idx++;
     }
@@ -1993,28 +2220,55 @@ void SphericalMOENBeamformer::calc_weights_( unsigned fbinX, gsl_vector_complex
   return;
 }
 
-
-bool SphericalMOENBeamformer::calc_moen_weights_( unsigned fbinX, gsl_vector_complex *weights, double dThreshold, bool calcFixedTerm, unsigned unitX )
+/*
+  @brief set A_ and fixedW_ of the bin to the matrices in 'SphericalWeightCache', computing them if they are not there.
+  @note the matrices do not depend on the look direction, hence all the instances with the same array,
+        order and diagonal loading share them.
+ */
+void SphericalMOENBeamformer::acquire_fixed_terms_( unsigned fbinX, double dThreshold )
 {
   unsigned nChan = theta_s_->size;
-  
-  if( NULL != fixedW_[fbinX] ){
-    gsl_matrix_complex_free( fixedW_[fbinX] );
-  }
-  fixedW_[fbinX] = gsl_matrix_complex_calloc( nChan, dim_ );
-  
-#if 0
-  for(unsigned chanX=0;chanX<weights->size;chanX++)
-    gsl_vector_complex_set( weights, chanX, gsl_complex_rect( 1.0, 0.0 ) );
-#endif
+  String key = ( geometry_cache_key_( "MOEN" ) << double(diagonal_weights_[fbinX]) << dThreshold << fbinX ).str();
+
+  const SphericalWeightCache::Entry* entry = SphericalWeightCache::find( key );
+  if( NULL == entry ){
+    gsl_matrix_complex* A      = gsl_matrix_complex_alloc( dim_, nChan );
+    gsl_matrix_complex* fixedW = gsl_matrix_complex_calloc( nChan, dim_ );
+
+    for(int n=0,idx=0;n<(int)maxOrder_;n++){/* order */
+      gsl_complex bn = gsl_matrix_complex_get( mode_mplitudes_, fbinX, n ); //bn = modeAmplitude( order, ka );
+      gsl_complex in;
+
+      if( 0 == ( n % 4 ) ){
+        in = gsl_complex_rect(1,0);
+      }
+      else if( 1 == ( n % 4 ) ){
+        in = gsl_complex_rect(0,1);
+      }
+      else if( 2 == ( n % 4 ) ){
+        in = gsl_complex_rect(-1,0);
+      }
+      else{
+        in = gsl_complex_rect(0,-1);
+      }
+
+      for( int m=-n;m<=n;m++){/* degree */
+        for(unsigned chanX=0;chanX<nChan;chanX++){
+          gsl_complex YAmn_s = gsl_vector_complex_get( sh_s_[idx], chanX );
+          gsl_complex val = gsl_complex_mul( YAmn_s, gsl_complex_mul( in, bn ) );
+          //gsl_complex val = gsl_complex_div( gsl_complex_conjugate(YAmn_s), gsl_complex_mul( in, bn ) );
+          gsl_matrix_complex_set( A, idx, chanX, gsl_complex_mul_real( val, 4 * M_PI ) );
+        }
+        idx++;
+      }
+    }
 
-  if( false == calcFixedTerm ){
     gsl_matrix_complex* tmp = gsl_matrix_complex_calloc( nChan, nChan );
     //gsl_matrix_complex* AH  = gsl_matrix_complex_calloc( nChan, dim_ );
     for(unsigned chanX=0;chanX<nChan;chanX++)
       gsl_matrix_complex_set( tmp, chanX, chanX, gsl_complex_rect( 1.0, 0.0 ) );
 
-    gsl_blas_zherk( CblasUpper, CblasConjTrans, 1.0, A_[fbinX], diagonal_weights_[fbinX], tmp ); // A^H A + l^2 I
+    gsl_blas_zherk( CblasUpper, CblasConjTrans, 1.0, A, diagonal_weights_[fbinX], tmp ); // A^H A + l^2 I
     // can be implemented in the faster way
     for(unsigned chanX=0;chanX<nChan;chanX++)
       for(unsigned chanY=chanX;chanY<nChan;chanY++)
@@ -2031,14 +2285,36 @@ bool SphericalMOENBeamformer::calc_moen_weights_( unsigned fbinX, gsl_vector_com
 #endif
     }
 
-    gsl_blas_zgemm( CblasNoTrans, CblasConjTrans, gsl_complex_rect( 1.0, 0.0 ), tmp, A_[fbinX], gsl_complex_rect( 0.0, 0.0 ), fixedW_[fbinX] ); //( A^H A + l^2 I )^{-1} A^H
-    gsl_blas_zgemv( CblasNoTrans, gsl_complex_rect( CN_, 0.0 ), (const gsl_matrix_complex*)fixedW_[fbinX], (const gsl_vector_complex*)BN_[fbinX], gsl_complex_rect( 0.0, 0.0 ), weights );// ( A^H A + l^2 I )^{-1} A^H BN
+    gsl_blas_zgemm( CblasNoTrans, CblasConjTrans, gsl_complex_rect( 1.0, 0.0 ), tmp, A, gsl_complex_rect( 0.0, 0.0 ), fixedW ); //( A^H A + l^2 I )^{-1} A^H
     gsl_matrix_complex_free( tmp );
+
+    vector<gsl_matrix_complex*> matrices( 2 );
+    matrices[0] = A;
+    matrices[1] = fixedW;
+    entry = SphericalWeightCache::insert( key, matrices );
   }
-  else{
-    //gsl_blas_zhemv( CblasUpper, gsl_complex_rect( CN_, 0.0 ), (const gsl_matrix_complex*)fixedW_[fbinX], (const gsl_matrix_complex*)BN_[fbinX], gsl_complex_rect( 0.0, 0.0 ), weights );
-    gsl_blas_zgemv( CblasNoTrans, gsl_complex_rect( CN_, 0.0 ), (const gsl_matrix_complex*)fixedW_[fbinX], (const gsl_vector_complex*)BN_[fbinX], gsl_complex_rect( 0.0, 0.0 ), weights );// ( A^H A + l^2 I )^{-1} A^H BN
-  }
+
+  SphericalWeightCache::release( fixed_terms_[fbinX] );
+  fixed_terms_[fbinX] = entry;
+  A_[fbinX]           = entry->matrix(0);
+  fixedW_[fbinX]      = entry->matrix(1);
+}
+
+/*
+  @note the matrices A_ and fixedW_ computed before are used if 'calcFixedTerm' is set.
+ */
+bool SphericalMOENBeamformer::calc_moen_weights_( unsigned fbinX, gsl_vector_complex *weights, double dThreshold, bool calcFixedTerm, unsigned unitX )
+{
+#if 0
+  for(unsigned chanX=0;chanX<weights->size;chanX++)
+    gsl_vector_complex_set( weights, chanX, gsl_complex_rect( 1.0, 0.0 ) );
+#endif
+
+  if( false == calcFixedTerm || NULL == fixed_terms_[fbinX] )
+    acquire_fixed_terms_( fbinX, dThreshold );
+
+  //gsl_blas_zhemv( CblasUpper, gsl_complex_rect( CN_, 0.0 ), (const gsl_matrix_complex*)fixedW_[fbinX], (const gsl_matrix_complex*)BN_[fbinX], gsl_complex_rect( 0.0, 0.0 ), weights );
+  gsl_blas_zgemv( CblasNoTrans, gsl_complex_rect( CN_, 0.0 ), fixedW_[fbinX], (const gsl_vector_complex*)BN_[fbinX], gsl_complex_rect( 0.0, 0.0 ), weights );// ( A^H A + l^2 I )^{-1} A^H BN
 
   if( true==weights_normalized_ )
     normalize_weights_( weights, wgain_ );
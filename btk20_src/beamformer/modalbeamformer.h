@@ -24,6 +24,7 @@
 #include "beamformer/spectralinfoarray.h"
 #include "modulated/modulated.h"
 #include "beamformer/beamformer.h"
+#include "beamformer/weight_cache.h"
 
 
 // ----- definition for class `ModeAmplitudeCalculator' -----
@@ -80,6 +81,15 @@ public:
                                   double minTheta=-M_PI, double maxTheta=M_PI,
                                   double minPhi=-M_PI, double maxPhi=M_PI,
                                   double widthTheta=0.1, double widthPhi=0.1 );
+  /**
+     @brief microphone positions in mm (chanN x 3) for a 'BeampatternEvaluator'
+   */
+  const gsl_matrix *array_positions();
+  /**
+     @brief the weights mapped from the spherical harmonics to the microphone domain (fftLen/2+1 x chanN),
+            such that the response to the plane wave p is the inner product with p; for a 'BeampatternEvaluator'
+   */
+  const gsl_matrix_complex *channel_weights( unsigned unitX = 0 );
   /**
      @brief obtain the spherical transformation coefficients at each frame
      @return spherical harmonics transformation coefficients at the current frame
@@ -114,11 +124,19 @@ public:
 
  protected:
   virtual void calc_weights_( unsigned fbinX, gsl_vector_complex *weights );
+  void calc_order_weights_( unsigned fbinX, gsl_vector_complex *orderWeights );
   virtual bool calc_spherical_harmonics_at_each_position_( gsl_vector *theta_s, gsl_vector *phi_s ); // need to be tested!!
   virtual bool calc_steering_unit_(  int unitX=0, bool isGSC=false );
   virtual bool alloc_steering_unit_( int unitN=1 );
   void alloc_image_( bool flag=true );
   bool calc_mode_amplitudes_();
+  /**
+     @brief the parameters of 'calc_weights_()' beyond the geometry, order and look direction;
+            the weights and blocking matrices computed by 'calc_steering_unit_()' are shared through
+            'SphericalWeightCache' only if this is not empty
+  */
+  virtual String weight_cache_key_() const { return ""; }
+  WeightCacheKey geometry_cache_key_( const String& tag ) const;
 
   unsigned samplerate_;
   unsigned NC_;
@@ -140,6 +158,8 @@ public:
   gsl_vector *WNG_; // white noise gain
   float wgain_; //
   float sigma2_; // dialog loading
+  gsl_matrix *positions_; // cartesian sensor positions
+  gsl_matrix_complex *channel_weights_; // weights in the microphone domain
 };
 
 typedef Inherit<EigenBeamformer,  SubbandDSPtr> EigenBeamformerPtr;
@@ -157,6 +177,12 @@ typedef Inherit<EigenBeamformer,  SubbandDSPtr> EigenBeamformerPtr;
    4) get the N-best hypotheses at the current instantaneous frame through doaEstimator.nbest_doas()
    5) do doaEstimator.getFinalNBestHypotheses() after a static segment is processed.
       You can then obtain the averaged N-best hypotheses of the static segment with doaEstimator.nbest_doas().
+   @note With set_sh_domain_search(True), the steered response powers of all the directions are computed from
+         the spherical harmonics coefficients of each frame with one matrix product,
+         Y [directions x maxOrder^2] * G [maxOrder^2 x bins], where Y holds the spherical harmonics of the
+         directions and G the coefficients weighted with the order weights of each bin.
+         No steering vector is kept for each direction and bin, and the search cost of a frame no longer
+         grows with the cost of the per-direction beamformer.
 */
 class DOAEstimatorSRPEB :
   public DOAEstimatorSRPBase, public EigenBeamformer {
@@ -167,9 +193,25 @@ class DOAEstimatorSRPEB :
   const gsl_vector_complex* next(int frame_no = -5);
   void reset();
 
+  void set_sh_domain_search( bool flag = true ){ shDomain_ = flag; clear_table_(); }
+  bool sh_domain_search() const { return shDomain_; }
+
 protected:
   virtual void  calc_steering_unit_table_();
   virtual float calc_response_power_( unsigned uttX );
+
+private:
+  void  free_sh_table_();
+  void  calc_sh_order_weights_();
+  void  calc_sh_response_powers_();
+
+  bool shDomain_;
+  gsl_matrix_complex *shY_;            // spherical harmonics of the search directions [nTheta_*nPhi_][dim_]
+  gsl_matrix_complex *shOrderWeights_; // conjugate order weights of each bin [dim_][fbinMax_-fbinMin_+1]
+  gsl_matrix_complex *shG_;            // weighted coefficients of the current frame [dim_][fbinMax_-fbinMin_+1]
+  gsl_matrix_complex *shR_;            // beamformer outputs [nTheta_*nPhi_][fbinMax_-fbinMin_+1]
+  unsigned shFbinMin_;
+  unsigned shFbinMax_;
 };
 
 typedef Inherit<DOAEstimatorSRPEB, EigenBeamformerPtr> DOAEstimatorSRPEBPtr;
@@ -282,6 +324,7 @@ public:
 
 protected:
   virtual void calc_weights_( unsigned fbinX, gsl_vector_complex *weights );
+  virtual String weight_cache_key_() const { return ( WeightCacheKey("HWNC") << double(ratio_) ).str(); }
 
 protected:
   float ratio_;
@@ -317,6 +360,11 @@ public:
   void setLookDirection(double theta, double phi){ set_look_direction(theta, phi); }
   void setActiveWeights_f( unsigned fbinX, const gsl_vector* packedWeight ){ set_active_weights_f(fbinX, packedWeight); }
 #endif
+
+protected:
+  virtual String weight_cache_key_() const {
+    return ( WeightCacheKey("GSC") << unsigned(weights_normalized_) << double(wgain_) ).str();
+  }
 };
 
 typedef Inherit<SphericalGSCBeamformer, SphericalDSBeamformerPtr> SphericalGSCBeamformerPtr;
@@ -380,6 +428,8 @@ public:
 protected:
   virtual void calc_weights_( unsigned fbinX, gsl_vector_complex *weights );
   virtual bool alloc_steering_unit_( int unitN=1 );
+  // 'calc_weights_()' also steers the normal D&S beamformer
+  virtual String weight_cache_key_() const { return ""; }
 
   vector<BeamformerWeights *>                   bfweight_vec2_; // weights of a normal D&S beamformer.
 };
@@ -431,11 +481,14 @@ protected:
   bool calc_moen_weights_( unsigned fbinX, gsl_vector_complex *weights, double dThreshold = 1.0E-8, bool calcInverseMatrix = true, unsigned unitX=0 );
 
 private:
+  void acquire_fixed_terms_( unsigned fbinX, double dThreshold );
+
   // maxOrder_ == Neff in the Li's paper.
   unsigned             bf_order_; // N in the Li's paper.
   float                CN_;
-  gsl_matrix_complex** A_; /* A_[fftLen2+1][dim_][nChan]; Coeffcients of the spherical harmonics expansion; See Eq. (31) & (32) */
-  gsl_matrix_complex** fixedW_; /* _fixedW[fftLen2+1][nChan][dim_]; [ A^H A + l^2 I ]^{-1} A^H */
+  const gsl_matrix_complex** A_; /* A_[fftLen2+1][dim_][nChan]; Coeffcients of the spherical harmonics expansion; See Eq. (31) & (32) */
+  const gsl_matrix_complex** fixedW_; /* _fixedW[fftLen2+1][nChan][dim_]; [ A^H A + l^2 I ]^{-1} A^H */
+  const SphericalWeightCache::Entry** fixed_terms_; // [fftLen2+1]; shared A_ and fixedW_
   gsl_vector_complex** BN_;     // _BN[fftLen2+1][dim_]
   float*               diagonal_weights_;
   bool                 is_term_fixed_;
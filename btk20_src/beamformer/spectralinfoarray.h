@@ -1,6 +1,10 @@
 #ifndef SPECTRALINFOARRAY_H
 #define SPECTRALINFOARRAY_H
 
+#include <vector>
+#include "stream/adaptation_scheduler.h"
+#include "stream/memory_usage.h"
+
 // ----- definition for class `SnapShotArray' -----
 // 
 class SnapShotArray {
@@ -22,17 +26,25 @@ class SnapShotArray {
   virtual void update();
   virtual void zero();
 
+  // bytes held by the samples, snapshots and matrices, now and at most over the calls
+  const MemoryUsage& memory_usage() const { memory_.begin();  memory_buffers_(memory_);  return memory_; }
+
 #ifdef ENABLE_LEGACY_BTK_API
   const gsl_vector_complex* getSnapShot(unsigned fbinX){ return snapshot(fbinX); }
   void newSample(const gsl_vector_complex* samp, unsigned chanX){ set_samples(samp, chanX); }
 #endif
 
  protected:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   const unsigned	fftLen_;
   const unsigned	nChan_;
 
   mutable gsl_vector_complex**	samples_;
   mutable gsl_vector_complex**	snapshots_;
+
+ private:
+  mutable MemoryUsage	memory_;
 };
 
 typedef refcount_ptr<SnapShotArray> 	SnapShotArrayPtr;
@@ -53,13 +65,26 @@ class SpectralMatrixArray : public SnapShotArray {
   virtual void update();
   virtual void zero();
 
+  // update the matrices only in the frames and bins chosen by 'scheduler'
+  void set_adaptation_scheduler(const AdaptationSchedulerPtr& scheduler) { scheduler_ = scheduler; }
+
+  // checkpoint the spatial spectral matrices
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
+
 #ifdef ENABLE_LEGACY_BTK_API
   gsl_matrix_complex* getSpecMatrix(unsigned idx){ return matrix_f(idx); }
 #endif
 
  protected:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+  void schedule_();
+
   const gsl_complex	mu_; // forgetting factor
   gsl_matrix_complex**	matrices_; // multi-channel spectrums [fftLen_][nChan_][nChan_]
+  AdaptationSchedulerPtr	scheduler_;
+  int			frame_no_;
+  std::vector<double>	forgets_; // forgetting factor of each bin in the current frame; negative if the bin is not updated
 };
 
 typedef refcount_ptr<SpectralMatrixArray> 	SpectralMatrixArrayPtr;
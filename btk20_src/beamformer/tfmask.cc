@@ -0,0 +1,512 @@
+/**
+ * @file tfmask.cc
+ * @brief Binary time-frequency mask files and mask-weighted accumulation of spatial covariance matrices.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <gsl/gsl_complex_math.h>
+#include "beamformer/tfmask.h"
+#include "matrix/complex_kernels.h"
+
+static const char     TFMaskMagic[8]  = { 'B', 'T', 'K', 'T', 'F', 'M', 'S', 'K' };
+static const uint32_t TFMaskVersion   = 1;
+static const uint32_t TFMaskByteOrder = 0x01020304;
+
+struct TFMaskHeader_ {
+  char						magic[8];
+  uint32_t					version;
+  uint32_t					byteOrder;
+  uint32_t					encoding;
+  uint32_t					binN;
+  uint64_t					frameN;
+};
+
+
+// ----- half precision -----
+//
+static uint16_t float_to_half_(float value)
+{
+  uint32_t x;
+  memcpy(&x, &value, sizeof(x));
+
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t fexp = (x >> 23) & 0xFF;
+  uint32_t mant = x & 0x7FFFFF;
+
+  if (fexp == 0xFF)					// infinity or NaN
+    return sign | 0x7C00 | (mant ? 0x200 : 0);
+
+  int exp = (int) fexp - 127 + 15;
+  if (exp >= 31)					// overflow
+    return sign | 0x7C00;
+
+  if (exp <= 0) {					// subnormal or zero
+    if (exp < -10) return sign;
+    mant |= 0x800000;
+    unsigned shift = 14 - exp;
+    uint32_t half  = mant >> shift;
+    uint32_t rem   = mant & ((1u << shift) - 1);
+    uint32_t mid   = 1u << (shift - 1);
+    if (rem > mid || (rem == mid && (half & 1))) half++;
+    return sign | half;
+  }
+
+  uint32_t half = sign | (exp << 10) | (mant >> 13);
+  uint32_t rem  = mant & 0x1FFF;
+  if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) half++;	// a carry into the exponent is correct
+  return half;
+}
+
+static float half_to_float_(uint16_t half)
+{
+  uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+  uint32_t exp  = (half >> 10) & 0x1F;
+  uint32_t mant = half & 0x3FF;
+
+  if (exp == 0) {
+    float value = ldexpf((float) mant, -24);
+    return sign ? -value : value;
+  }
+
+  uint32_t x = (exp == 31) ? (sign | 0x7F800000 | (mant << 13)) : (sign | ((exp + 112) << 23) | (mant << 13));
+  float value;
+  memcpy(&value, &x, sizeof(value));
+  return value;
+}
+
+
+// values of the "uint8" encoding
+struct UInt8Table_ {
+  UInt8Table_() { for (unsigned i = 0; i < 256; i++) values[i] = i / 255.0f; }
+  float						values[256];
+};
+
+
+// ----- methods for class `TFMaskFile' -----
+//
+TFMaskFile::Encoding TFMaskFile::encoding(const String& name)
+{
+  if (name == "float32") return Float32;
+  if (name == "float16") return Float16;
+  if (name == "uint8")   return UInt8;
+  throw jparameter_error("Unknown TF-mask encoding '%s'; use 'float32', 'float16' or 'uint8'.", name.c_str());
+}
+
+const char* TFMaskFile::encoding_name(Encoding encoding)
+{
+  switch (encoding) {
+  case Float32: return "float32";
+  case Float16: return "float16";
+  default:      return "uint8";
+  }
+}
+
+size_t TFMaskFile::value_bytes(Encoding encoding)
+{
+  switch (encoding) {
+  case Float32: return sizeof(float);
+  case Float16: return sizeof(uint16_t);
+  default:      return sizeof(uint8_t);
+  }
+}
+
+void TFMaskFile::encode(Encoding encoding, const float* values, unsigned binN, void* row)
+{
+  switch (encoding) {
+  case Float32:
+    memcpy(row, values, binN * sizeof(float));
+    break;
+  case Float16:
+    for (unsigned binX = 0; binX < binN; binX++) {
+      uint16_t half = float_to_half_(values[binX]);
+      memcpy((char*) row + binX * sizeof(half), &half, sizeof(half));
+    }
+    break;
+  default:
+    for (unsigned binX = 0; binX < binN; binX++) {
+      float value = values[binX];
+      if (value != value || value < 0.0f) value = 0.0f;
+      if (value > 1.0f) value = 1.0f;
+      ((uint8_t*) row)[binX] = (uint8_t) lrintf(255.0f * value);
+    }
+  }
+}
+
+void TFMaskFile::decode(Encoding encoding, const void* row, unsigned binN, float* values)
+{
+  switch (encoding) {
+  case Float32:
+    memcpy(values, row, binN * sizeof(float));
+    break;
+  case Float16:
+    for (unsigned binX = 0; binX < binN; binX++) {
+      uint16_t half;
+      memcpy(&half, (const char*) row + binX * sizeof(half), sizeof(half));
+      values[binX] = half_to_float_(half);
+    }
+    break;
+  default:
+    {
+      static const UInt8Table_ table;
+      for (unsigned binX = 0; binX < binN; binX++)
+	values[binX] = table.values[((const uint8_t*) row)[binX]];
+    }
+  }
+}
+
+
+// ----- methods for class `TFMaskWriter' -----
+//
+TFMaskWriter::TFMaskWriter(const String& fileName, unsigned binN, const String& encoding)
+  : fileName_(fileName), binN_(binN), encoding_(TFMaskFile::encoding(encoding)), fp_(NULL), frameN_(0),
+    values_(binN), row_(binN * TFMaskFile::value_bytes(encoding_))
+{
+  if (binN_ == 0)
+    throw jparameter_error("A TF mask needs at least one bin.");
+
+  fp_ = fopen(fileName_.c_str(), "wb");
+  if (fp_ == NULL)
+    throw jio_error("Could not open TF-mask file '%s' for writing.", fileName_.c_str());
+
+  // the number of frames is written by 'close()'
+  TFMaskHeader_ header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TFMaskMagic, sizeof(TFMaskMagic));
+  header.version   = TFMaskVersion;
+  header.byteOrder = TFMaskByteOrder;
+  header.encoding  = encoding_;
+  header.binN      = binN_;
+  if (fwrite(&header, sizeof(header), 1, fp_) != 1) {
+    fclose(fp_);  fp_ = NULL;
+    throw jio_error("Could not write TF-mask file '%s'.", fileName_.c_str());
+  }
+}
+
+TFMaskWriter::~TFMaskWriter()
+{
+  if (fp_ != NULL) {
+    try {
+      close();
+    } catch (j_error& e) {
+      fprintf(stderr, "%s\n", e.what());
+    }
+  }
+}
+
+void TFMaskWriter::write_row_(const float* values)
+{
+  if (fp_ == NULL)
+    throw jio_error("TF-mask file '%s' is already closed.", fileName_.c_str());
+
+  TFMaskFile::encode(encoding_, values, binN_, &row_[0]);
+  if (fwrite(&row_[0], row_.size(), 1, fp_) != 1)
+    throw jio_error("Could not write TF-mask file '%s'.", fileName_.c_str());
+  frameN_++;
+}
+
+void TFMaskWriter::write(const gsl_vector_float* mask)
+{
+  if (mask->size != binN_)
+    throw jdimension_error("TF mask has %lu bins; expected %u.", (unsigned long) mask->size, binN_);
+
+  for (unsigned binX = 0; binX < binN_; binX++)
+    values_[binX] = gsl_vector_float_get(mask, binX);
+  write_row_(&values_[0]);
+}
+
+void TFMaskWriter::write_frames(const gsl_matrix* mask)
+{
+  if (mask->size2 != binN_)
+    throw jdimension_error("TF mask has %lu bins; expected %u.", (unsigned long) mask->size2, binN_);
+
+  for (size_t frameX = 0; frameX < mask->size1; frameX++) {
+    for (unsigned binX = 0; binX < binN_; binX++)
+      values_[binX] = gsl_matrix_get(mask, frameX, binX);
+    write_row_(&values_[0]);
+  }
+}
+
+void TFMaskWriter::close()
+{
+  if (fp_ == NULL) return;
+
+  uint64_t frameN = frameN_;
+  bool     failed = (fseek(fp_, offsetof(TFMaskHeader_, frameN), SEEK_SET) != 0) || (fwrite(&frameN, sizeof(frameN), 1, fp_) != 1);
+  failed = (fclose(fp_) != 0) || failed;
+  fp_ = NULL;
+
+  if (failed)
+    throw jio_error("Could not write TF-mask file '%s'.", fileName_.c_str());
+}
+
+
+// ----- methods for class `TFMaskFeature' -----
+//
+static TFMaskHeader_ read_tfmask_header_(const String& fileName, FILE* fp, long fileBytes)
+{
+  TFMaskHeader_ header;
+  if (fileBytes < (long) sizeof(header) || fread(&header, sizeof(header), 1, fp) != 1)
+    throw jconsistency_error("'%s' is not a TF-mask file.", fileName.c_str());
+  if (memcmp(header.magic, TFMaskMagic, sizeof(TFMaskMagic)) != 0)
+    throw jconsistency_error("'%s' is not a TF-mask file.", fileName.c_str());
+  if (header.byteOrder != TFMaskByteOrder)
+    throw jconsistency_error("TF-mask file '%s' was written with a different byte order.", fileName.c_str());
+  if (header.version != TFMaskVersion)
+    throw jconsistency_error("TF-mask file '%s' has version %d; expected %d.", fileName.c_str(), header.version, TFMaskVersion);
+  if (header.encoding > TFMaskFile::UInt8 || header.binN == 0)
+    throw jconsistency_error("TF-mask file '%s' is corrupted.", fileName.c_str());
+
+  // 'frameN' is untrusted: divide rather than multiply, which could wrap around
+  uint64_t rowBytes = uint64_t(header.binN) * TFMaskFile::value_bytes((TFMaskFile::Encoding) header.encoding);
+  if (header.frameN > (uint64_t) (fileBytes - sizeof(header)) / rowBytes)
+    throw jconsistency_error("TF-mask file '%s' is truncated.", fileName.c_str());
+
+  return header;
+}
+
+static unsigned tfmask_bins_(const String& fileName)
+{
+  FILE* fp = fopen(fileName.c_str(), "rb");
+  if (fp == NULL)
+    throw jio_error("Could not open TF-mask file '%s'.", fileName.c_str());
+
+  unsigned binN = 0;
+  try {
+    fseek(fp, 0, SEEK_END);
+    long fileBytes = ftell(fp);
+    rewind(fp);
+    binN = read_tfmask_header_(fileName, fp, fileBytes).binN;
+  } catch (...) {
+    fclose(fp);
+    throw;
+  }
+  fclose(fp);
+
+  return binN;
+}
+
+TFMaskFeature::TFMaskFeature(const String& fileName, bool memoryMap, const String& nm)
+  : VectorFloatFeatureStream(tfmask_bins_(fileName), nm), fileName_(fileName),
+    fp_(NULL), map_(NULL), mapBytes_(0), all_(NULL)
+{
+  fp_ = fopen(fileName_.c_str(), "rb");
+  if (fp_ == NULL)
+    throw jio_error("Could not open TF-mask file '%s'.", fileName_.c_str());
+
+  fseek(fp_, 0, SEEK_END);
+  long fileBytes = ftell(fp_);
+  rewind(fp_);
+  TFMaskHeader_ header;
+  try {
+    header = read_tfmask_header_(fileName_, fp_, fileBytes);
+  } catch (...) {
+    fclose(fp_);
+    throw;
+  }
+
+  encoding_ = (TFMaskFile::Encoding) header.encoding;
+  frameN_   = header.frameN;
+  rowBytes_ = size() * TFMaskFile::value_bytes(encoding_);
+  row_.resize(rowBytes_);
+
+  if (memoryMap && frameN_ > 0) {
+    mapBytes_ = TFMaskFile::HeaderBytes + frameN_ * rowBytes_;
+    void* map = mmap(NULL, mapBytes_, PROT_READ, MAP_PRIVATE, fileno(fp_), 0);
+    if (map == MAP_FAILED) {
+      fclose(fp_);
+      throw jio_error("Could not map TF-mask file '%s' into memory.", fileName_.c_str());
+    }
+    map_ = (const unsigned char*) map;
+    fclose(fp_);  fp_ = NULL;
+  }
+}
+
+TFMaskFeature::~TFMaskFeature()
+{
+  if (map_ != NULL) munmap((void*) map_, mapBytes_);
+  if (fp_ != NULL)  fclose(fp_);
+  if (all_ != NULL) gsl_matrix_free(all_);
+}
+
+// the memory map counts the mapped pages of the file, not all of which need to be resident
+void TFMaskFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorFloatFeatureStream::memory_buffers_(usage);
+  usage.add("row", row_.capacity());
+  usage.add("map", (map_ == NULL) ? 0 : mapBytes_);
+  usage.add("all frames", MemoryUsage::bytes(all_));
+}
+
+void TFMaskFeature::read_row_(unsigned long frameX, float* values)
+{
+  const unsigned char* row;
+  if (map_ != NULL) {
+    row = map_ + TFMaskFile::HeaderBytes + frameX * rowBytes_;
+  } else {
+    if (fseeko(fp_, (off_t) (TFMaskFile::HeaderBytes + frameX * rowBytes_), SEEK_SET) != 0 ||
+	fread(&row_[0], rowBytes_, 1, fp_) != 1)
+      throw jio_error("Could not read frame %lu of TF-mask file '%s'.", frameX, fileName_.c_str());
+    row = &row_[0];
+  }
+  TFMaskFile::decode(encoding_, row, size(), values);
+}
+
+const gsl_vector_float* TFMaskFeature::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  if (frame_no >= 0 && frame_no != frame_no_ + 1)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
+
+  if ((unsigned long) (frame_no_ + 1) >= frameN_) {
+    is_end_ = true;
+    throw jiterator_error("end of samples!");
+  }
+
+  read_row_(frame_no_ + 1, vector_->data);
+  increment_();
+  return vector_;
+}
+
+void TFMaskFeature::reset()
+{
+  VectorFloatFeatureStream::reset();
+}
+
+const gsl_matrix* TFMaskFeature::load()
+{
+  if (all_ == NULL) {
+    if (frameN_ == 0)
+      throw jconsistency_error("TF-mask file '%s' holds no frames.", fileName_.c_str());
+    all_ = gsl_matrix_alloc(frameN_, size());
+    std::vector<float> values(size());
+    for (unsigned long frameX = 0; frameX < frameN_; frameX++) {
+      read_row_(frameX, &values[0]);
+      for (unsigned binX = 0; binX < size(); binX++)
+	gsl_matrix_set(all_, frameX, binX, values[binX]);
+    }
+  }
+
+  return all_;
+}
+
+
+// ----- methods for class `MaskedSOSAccumulator' -----
+//
+MaskedSOSAccumulator::MaskedSOSAccumulator(const SnapShotArrayPtr& snapshots, float threshold)
+  : snapshots_(snapshots), fbinN_(snapshots->fftLen() / 2 + 1), chanN_(snapshots->nChan()), threshold_(threshold),
+    targetR_(fbinN_), noiseR_(fbinN_),
+    targetWeights_(gsl_vector_calloc(fbinN_)), noiseWeights_(gsl_vector_calloc(fbinN_)),
+    frameN_(0), skippedN_(0)
+{
+  for (unsigned fbinX = 0; fbinX < fbinN_; fbinX++) {
+    targetR_[fbinX] = gsl_matrix_complex_calloc(chanN_, chanN_);
+    noiseR_[fbinX]  = gsl_matrix_complex_calloc(chanN_, chanN_);
+  }
+}
+
+MaskedSOSAccumulator::~MaskedSOSAccumulator()
+{
+  for (unsigned fbinX = 0; fbinX < fbinN_; fbinX++) {
+    gsl_matrix_complex_free(targetR_[fbinX]);
+    gsl_matrix_complex_free(noiseR_[fbinX]);
+  }
+  gsl_vector_free(targetWeights_);
+  gsl_vector_free(noiseWeights_);
+}
+
+const MemoryUsage& MaskedSOSAccumulator::memory_usage() const
+{
+  memory_.begin();
+  size_t target = 0, noise = 0;
+  for (unsigned fbinX = 0; fbinX < fbinN_; fbinX++) {
+    target += MemoryUsage::bytes(targetR_[fbinX]);
+    noise  += MemoryUsage::bytes(noiseR_[fbinX]);
+  }
+  memory_.add("target covariance", target);
+  memory_.add("noise covariance", noise);
+  memory_.add("weights", MemoryUsage::bytes(targetWeights_) + MemoryUsage::bytes(noiseWeights_));
+
+  return memory_;
+}
+
+void MaskedSOSAccumulator::check_mask_(const gsl_vector_float* mask, const char* which) const
+{
+  if (mask != NULL && mask->size != fbinN_)
+    throw jdimension_error("%s mask has %lu bins; expected %u.", which, (unsigned long) mask->size, fbinN_);
+}
+
+// lower triangle of R += weight X X^H
+void MaskedSOSAccumulator::update_(gsl_matrix_complex* R, const gsl_vector_complex* X, double weight)
+{
+  for (unsigned rowX = 0; rowX < chanN_; rowX++) {
+    gsl_complex alpha = gsl_complex_mul_real(gsl_vector_complex_get(X, rowX), weight);
+    ComplexKernels::axpy_conj(rowX + 1, alpha, ComplexKernels::data(X), ComplexKernels::row(R, rowX));
+  }
+}
+
+void MaskedSOSAccumulator::accumulate(const gsl_vector_float* maskT, const gsl_vector_float* maskN)
+{
+  check_mask_(maskT, "Target");
+  check_mask_(maskN, "Noise");
+
+  for (unsigned fbinX = 0; fbinX < fbinN_; fbinX++) {
+    float mt = (maskT == NULL) ? 0.0 : gsl_vector_float_get(maskT, fbinX);
+    float mn = (maskN == NULL) ? 0.0 : gsl_vector_float_get(maskN, fbinX);
+    if (mt <= threshold_ && mn <= threshold_) { skippedN_++; continue; }
+
+    const gsl_vector_complex* X = snapshots_->snapshot(fbinX);
+    if (mt > threshold_) {
+      update_(targetR_[fbinX], X, mt);
+      gsl_vector_set(targetWeights_, fbinX, gsl_vector_get(targetWeights_, fbinX) + mt);
+    }
+    if (mn > threshold_) {
+      update_(noiseR_[fbinX], X, mn);
+      gsl_vector_set(noiseWeights_, fbinX, gsl_vector_get(noiseWeights_, fbinX) + mn);
+    }
+  }
+  frameN_++;
+}
+
+// fill the upper triangle from the lower one
+const gsl_matrix_complex* MaskedSOSAccumulator::hermitian_(gsl_matrix_complex* R)
+{
+  for (unsigned rowX = 0; rowX < chanN_; rowX++) {
+    gsl_complex diagonal = gsl_matrix_complex_get(R, rowX, rowX);
+    gsl_matrix_complex_set(R, rowX, rowX, gsl_complex_rect(GSL_REAL(diagonal), 0.0));
+    for (unsigned colX = rowX + 1; colX < chanN_; colX++)
+      gsl_matrix_complex_set(R, rowX, colX, gsl_complex_conjugate(gsl_matrix_complex_get(R, colX, rowX)));
+  }
+  return R;
+}
+
+const gsl_matrix_complex* MaskedSOSAccumulator::target_covariance(unsigned fbinX)
+{
+  if (fbinX >= fbinN_)
+    throw jindex_error("Bin %u is out of range; there are %u.", fbinX, fbinN_);
+  return hermitian_(targetR_[fbinX]);
+}
+
+const gsl_matrix_complex* MaskedSOSAccumulator::noise_covariance(unsigned fbinX)
+{
+  if (fbinX >= fbinN_)
+    throw jindex_error("Bin %u is out of range; there are %u.", fbinX, fbinN_);
+  return hermitian_(noiseR_[fbinX]);
+}
+
+void MaskedSOSAccumulator::reset()
+{
+  for (unsigned fbinX = 0; fbinX < fbinN_; fbinX++) {
+    gsl_matrix_complex_set_zero(targetR_[fbinX]);
+    gsl_matrix_complex_set_zero(noiseR_[fbinX]);
+  }
+  gsl_vector_set_zero(targetWeights_);
+  gsl_vector_set_zero(noiseWeights_);
+  frameN_ = skippedN_ = 0;
+}
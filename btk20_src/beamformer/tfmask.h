@@ -0,0 +1,199 @@
+/**
+ * @file tfmask.h
+ * @brief Binary time-frequency mask files and mask-weighted accumulation of spatial covariance matrices.
+ */
+
+#ifndef TFMASK_H
+#define TFMASK_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include "common/refcount.h"
+#include "common/jexception.h"
+#include "stream/stream.h"
+#include "beamformer/spectralinfoarray.h"
+
+/**
+* \defgroup TFMask Time-Frequency Masks
+* A TF-mask file holds one row of mask values per frame and one value per
+* frequency bin after a fixed header of 32 bytes:
+*
+*   "BTKTFMSK" | version | byte order mark | encoding | binN | frameN
+*   row 0 | row 1 | ... | row frameN-1
+*
+* The integers are 32 bits in host byte order except 'frameN', which has 64.
+* The values of a row are stored as
+*
+*   - "float32": IEEE single precision, 4 bytes per value,
+*   - "float16": IEEE half precision rounded to nearest even, 2 bytes,
+*   - "uint8":   round(255 v) of a value v clipped to [0, 1], 1 byte.
+*
+* 'TFMaskWriter' writes a file frame by frame or all at once;
+* 'TFMaskFeature' reads it back as a 'VectorFloatFeatureStream', either
+* through a memory map or with one read per frame.
+*
+* 'MaskedSOSAccumulator' accumulates the mask-weighted spatial covariance
+* matrices of a target and a noise source,
+*
+*   R_t(f) = sum_k m_t(k, f) x_k(f) x_k(f)^H,   w_t(f) = sum_k m_t(k, f),
+*
+* and likewise for the noise, from the snapshots of a 'SnapShotArray', for
+* all bins of a frame in one call. Bins whose masks are both at or below
+* the sparsity threshold are skipped, and only the lower triangles are
+* updated; the upper ones are filled in when a matrix is read.
+*/
+/*@{*/
+
+// ----- definition for class `TFMaskFile' -----
+//
+class TFMaskFile {
+ public:
+  enum Encoding { Float32 = 0, Float16 = 1, UInt8 = 2 };
+
+  static const unsigned HeaderBytes = 32;
+
+  // "float32", "float16" or "uint8"
+  static Encoding encoding(const String& name);
+  static const char* encoding_name(Encoding encoding);
+  static size_t value_bytes(Encoding encoding);
+
+  // convert one row between floats and the encoded values
+  static void encode(Encoding encoding, const float* values, unsigned binN, void* row);
+  static void decode(Encoding encoding, const void* row, unsigned binN, float* values);
+};
+
+
+// ----- definition for class `TFMaskWriter' -----
+//
+class TFMaskWriter {
+ public:
+  TFMaskWriter(const String& fileName, unsigned binN, const String& encoding = "uint8");
+  ~TFMaskWriter();
+
+  unsigned binN() const { return binN_; }
+  unsigned long frameN() const { return frameN_; }
+
+  // append one frame
+  void write(const gsl_vector_float* mask);
+  // append all rows of 'mask' (frameN x binN)
+  void write_frames(const gsl_matrix* mask);
+
+  // write the number of frames into the header and close the file
+  void close();
+
+ private:
+  void write_row_(const float* values);
+
+  const String					fileName_;
+  const unsigned				binN_;
+  const TFMaskFile::Encoding			encoding_;
+  FILE*						fp_;
+  unsigned long					frameN_;
+  std::vector<float>				values_;
+  std::vector<unsigned char>			row_;
+};
+
+typedef refcount_ptr<TFMaskWriter> TFMaskWriterPtr;
+
+
+// ----- definition for class `TFMaskFeature' -----
+//
+class TFMaskFeature : public VectorFloatFeatureStream {
+ public:
+  /**
+     @param const String& fileName[in] TF-mask file
+     @param bool memoryMap[in] map the file into memory rather than read it frame by frame
+   */
+  TFMaskFeature(const String& fileName, bool memoryMap = true, const String& nm = "TF Mask Feature");
+  virtual ~TFMaskFeature();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+
+  unsigned long frameN() const { return frameN_; }
+  const char* encoding() const { return TFMaskFile::encoding_name(encoding_); }
+
+  // all frames at once (frameN x binN)
+  const gsl_matrix* load();
+
+ private:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+  void read_row_(unsigned long frameX, float* values);
+
+  const String					fileName_;
+  TFMaskFile::Encoding				encoding_;
+  unsigned long					frameN_;
+  size_t					rowBytes_;
+  FILE*						fp_;
+  const unsigned char*				map_;
+  size_t					mapBytes_;
+  std::vector<unsigned char>			row_;
+  gsl_matrix*					all_;
+};
+
+typedef Inherit<TFMaskFeature, VectorFloatFeatureStreamPtr> TFMaskFeaturePtr;
+
+
+// ----- definition for class `MaskedSOSAccumulator' -----
+//
+class MaskedSOSAccumulator {
+ public:
+  /**
+     @param const SnapShotArrayPtr& snapshots[in] array whose current snapshots are accumulated
+     @param float threshold[in] bins whose masks are both at or below 'threshold' are skipped
+   */
+  MaskedSOSAccumulator(const SnapShotArrayPtr& snapshots, float threshold = 0.0);
+  ~MaskedSOSAccumulator();
+
+  unsigned fbinN() const { return fbinN_; }
+  unsigned chanN() const { return chanN_; }
+
+  /**
+     @brief accumulate the current snapshots of all bins
+     @param const gsl_vector_float* maskT[in] target mask of the frame (fbinN); None if there is none
+     @param const gsl_vector_float* maskN[in] noise mask of the frame (fbinN); None if there is none
+   */
+  void accumulate(const gsl_vector_float* maskT, const gsl_vector_float* maskN);
+
+  // accumulated covariance matrices (chanN x chanN) of bin 'fbinX'
+  const gsl_matrix_complex* target_covariance(unsigned fbinX);
+  const gsl_matrix_complex* noise_covariance(unsigned fbinX);
+  // accumulated mask values (fbinN)
+  const gsl_vector* target_weights() const { return targetWeights_; }
+  const gsl_vector* noise_weights() const { return noiseWeights_; }
+
+  unsigned long frameN() const { return frameN_; }
+  // bins skipped by the sparsity threshold
+  unsigned long skipped_bins() const { return skippedN_; }
+
+  void reset();
+
+  // bytes held by the covariance matrices and weights
+  const MemoryUsage& memory_usage() const;
+
+ private:
+  void check_mask_(const gsl_vector_float* mask, const char* which) const;
+  void update_(gsl_matrix_complex* R, const gsl_vector_complex* X, double weight);
+  const gsl_matrix_complex* hermitian_(gsl_matrix_complex* R);
+
+  SnapShotArrayPtr				snapshots_;
+  const unsigned				fbinN_;
+  const unsigned				chanN_;
+  const float					threshold_;
+  std::vector<gsl_matrix_complex*>		targetR_;
+  std::vector<gsl_matrix_complex*>		noiseR_;
+  gsl_vector*					targetWeights_;
+  gsl_vector*					noiseWeights_;
+  unsigned long					frameN_;
+  unsigned long					skippedN_;
+  mutable MemoryUsage				memory_;
+};
+
+typedef refcount_ptr<MaskedSOSAccumulator> MaskedSOSAccumulatorPtr;
+
+/*@}*/
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * @file weight_cache.cc
+ * @brief Process-wide cache of the fixed weights and blocking matrices of the spherical beamformers.
+ */
+
+#include "beamformer/weight_cache.h"
+
+
+// ----- methods for class `WeightCacheKey' -----
+//
+WeightCacheKey& WeightCacheKey::operator<<(double val)
+{
+  char buf[64];
+  snprintf(buf, sizeof(buf), ":%a", val);
+  key_ += buf;
+  return *this;
+}
+
+WeightCacheKey& WeightCacheKey::operator<<(unsigned val)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), ":%u", val);
+  key_ += buf;
+  return *this;
+}
+
+WeightCacheKey& WeightCacheKey::operator<<(const gsl_vector* vec)
+{
+  *this << unsigned(vec->size);
+  for (unsigned i = 0; i < vec->size; i++)
+    *this << gsl_vector_get(vec, i);
+  return *this;
+}
+
+WeightCacheKey& WeightCacheKey::operator<<(const String& str)
+{
+  key_ += ":";
+  key_ += str;
+  return *this;
+}
+
+
+// ----- methods for class `SphericalWeightCache::Entry' -----
+//
+SphericalWeightCache::Entry::Entry(const String& key, const std::vector<gsl_matrix_complex*>& matrices)
+  : key_(key), matrices_(matrices), bytes_(0), usersN_(0)
+{
+  for (unsigned matrixX = 0; matrixX < matrices_.size(); matrixX++)
+    if (matrices_[matrixX] != NULL)
+      bytes_ += 2 * sizeof(double) * matrices_[matrixX]->size1 * matrices_[matrixX]->size2;
+}
+
+SphericalWeightCache::Entry::~Entry()
+{
+  for (unsigned matrixX = 0; matrixX < matrices_.size(); matrixX++)
+    if (matrices_[matrixX] != NULL)
+      gsl_matrix_complex_free(matrices_[matrixX]);
+}
+
+
+// ----- methods for class `SphericalWeightCache' -----
+//
+SphericalWeightCache::SphericalWeightCache()
+  : maxBytes_(64 * 1024 * 1024), bytes_(0), hits_(0), misses_(0), evictions_(0)
+{
+  pthread_mutex_init(&mutex_, NULL);
+}
+
+SphericalWeightCache::~SphericalWeightCache()
+{
+  for (EntryMap_::iterator itr = entries_.begin(); itr != entries_.end(); itr++)
+    delete itr->second;
+  pthread_mutex_destroy(&mutex_);
+}
+
+SphericalWeightCache& SphericalWeightCache::instance_()
+{
+  static SphericalWeightCache cache;
+  return cache;
+}
+
+// remove the least recently used entries not in use until the bound holds; the mutex must be held
+void SphericalWeightCache::evict_()
+{
+  std::list<Entry*>::iterator itr = lru_.end();
+  while (bytes_ > maxBytes_ && itr != lru_.begin()) {
+    itr--;
+    Entry* entry = *itr;
+    if (entry->usersN_ > 0) continue;
+
+    itr = lru_.erase(itr);
+    entries_.erase(entry->key_);
+    bytes_ -= entry->bytes_;
+    evictions_++;
+    delete entry;
+  }
+}
+
+const SphericalWeightCache::Entry* SphericalWeightCache::find(const String& key)
+{
+  SphericalWeightCache& self = instance_();
+  Entry* entry = NULL;
+
+  pthread_mutex_lock(&self.mutex_);
+  if (self.maxBytes_ > 0) {
+    EntryMap_::iterator itr = self.entries_.find(key);
+    if (itr == self.entries_.end()) {
+      self.misses_++;
+    } else {
+      entry = itr->second;
+      entry->usersN_++;
+      self.lru_.splice(self.lru_.begin(), self.lru_, entry->lru_);
+      self.hits_++;
+    }
+  }
+  pthread_mutex_unlock(&self.mutex_);
+
+  return entry;
+}
+
+const SphericalWeightCache::Entry* SphericalWeightCache::insert(const String& key, const std::vector<gsl_matrix_complex*>& matrices)
+{
+  SphericalWeightCache& self = instance_();
+  Entry* entry = new Entry(key, matrices);
+
+  pthread_mutex_lock(&self.mutex_);
+  EntryMap_::iterator itr = self.entries_.find(key);
+  if (itr != self.entries_.end()) {
+    // computed by another instance meanwhile
+    delete entry;
+    entry = itr->second;
+    self.lru_.splice(self.lru_.begin(), self.lru_, entry->lru_);
+  } else {
+    self.entries_[key] = entry;
+    self.lru_.push_front(entry);
+    entry->lru_ = self.lru_.begin();
+    self.bytes_ += entry->bytes_;
+  }
+  entry->usersN_++;
+  pthread_mutex_unlock(&self.mutex_);
+
+  return entry;
+}
+
+void SphericalWeightCache::release(const Entry* entry)
+{
+  if (entry == NULL) return;
+
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  Entry* ent = const_cast<Entry*>(entry);
+  if (ent->usersN_ == 0) {
+    pthread_mutex_unlock(&self.mutex_);
+    throw j_error("Entry '%s' of the weight cache released more often than used.", ent->key_.c_str());
+  }
+  ent->usersN_--;
+  self.evict_();
+  pthread_mutex_unlock(&self.mutex_);
+}
+
+void SphericalWeightCache::set_max_bytes(size_t maxBytes)
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  self.maxBytes_ = maxBytes;
+  self.evict_();
+  pthread_mutex_unlock(&self.mutex_);
+}
+
+size_t SphericalWeightCache::max_bytes()
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  size_t maxBytes = self.maxBytes_;
+  pthread_mutex_unlock(&self.mutex_);
+
+  return maxBytes;
+}
+
+size_t SphericalWeightCache::bytes()
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  size_t bytes = self.bytes_;
+  pthread_mutex_unlock(&self.mutex_);
+
+  return bytes;
+}
+
+unsigned SphericalWeightCache::entryN()
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  unsigned entryN = self.entries_.size();
+  pthread_mutex_unlock(&self.mutex_);
+
+  return entryN;
+}
+
+unsigned long SphericalWeightCache::hits()
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  unsigned long hits = self.hits_;
+  pthread_mutex_unlock(&self.mutex_);
+
+  return hits;
+}
+
+unsigned long SphericalWeightCache::misses()
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  unsigned long misses = self.misses_;
+  pthread_mutex_unlock(&self.mutex_);
+
+  return misses;
+}
+
+unsigned long SphericalWeightCache::evictions()
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  unsigned long evictions = self.evictions_;
+  pthread_mutex_unlock(&self.mutex_);
+
+  return evictions;
+}
+
+double SphericalWeightCache::hit_rate()
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  unsigned long total = self.hits_ + self.misses_;
+  double rate = (total == 0) ? 0.0 : double(self.hits_) / total;
+  pthread_mutex_unlock(&self.mutex_);
+
+  return rate;
+}
+
+// remove the entries not in use
+void SphericalWeightCache::clear()
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  size_t maxBytes = self.maxBytes_;
+  self.maxBytes_ = 0;
+  self.evict_();
+  self.maxBytes_ = maxBytes;
+  pthread_mutex_unlock(&self.mutex_);
+}
+
+void SphericalWeightCache::reset_statistics()
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  self.hits_ = self.misses_ = self.evictions_ = 0;
+  pthread_mutex_unlock(&self.mutex_);
+}
+
+void SphericalWeightCache::report(FILE* fp)
+{
+  SphericalWeightCache& self = instance_();
+
+  pthread_mutex_lock(&self.mutex_);
+  unsigned long total = self.hits_ + self.misses_;
+  unsigned inUseN = 0;
+  for (EntryMap_::const_iterator itr = self.entries_.begin(); itr != self.entries_.end(); itr++)
+    if (itr->second->usersN_ > 0) inUseN++;
+  fprintf(fp, "Spherical weight cache: %lu entries (%u in use), %0.2f of %0.2f MB, %lu hits, %lu misses (hit rate %0.2f %%), %lu evictions\n",
+	  (unsigned long) self.entries_.size(), inUseN, self.bytes_ / 1048576.0, self.maxBytes_ / 1048576.0,
+	  self.hits_, self.misses_, (total == 0) ? 0.0 : 100.0 * self.hits_ / total, self.evictions_);
+  pthread_mutex_unlock(&self.mutex_);
+}
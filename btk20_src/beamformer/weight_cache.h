@@ -0,0 +1,120 @@
+/**
+ * @file weight_cache.h
+ * @brief Process-wide cache of the fixed weights and blocking matrices of the spherical beamformers.
+ */
+
+#ifndef WEIGHT_CACHE_H
+#define WEIGHT_CACHE_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include <list>
+#include <map>
+#include <vector>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include "common/mlist.h"
+#include "common/jexception.h"
+
+/**
+* \defgroup SphericalWeightCache Spherical Weight Cache
+* The spherical beamformers compute their quiescent weights, blocking
+* matrices and, for 'SphericalMOENBeamformer', the regularized inverses
+* [ A^H A + l^2 I ]^{-1} A^H of every bin whenever they are steered. A
+* server that creates many instances for the same array, order and look
+* direction repeats this work for each of them.
+*
+* 'SphericalWeightCache' keeps these matrices once per process, keyed on the
+* geometry, order, bin, look direction and regularization that determine
+* them. An entry is read-only; it stays alive while an instance uses it and
+* is evicted, least recently used first, when the unused entries exceed
+* 'max_bytes()'. All the members are static and thread-safe.
+*/
+/*@{*/
+
+// ----- definition for class `WeightCacheKey' -----
+//
+class WeightCacheKey {
+ public:
+  WeightCacheKey(const String& tag) : key_(tag) { }
+
+  // the exact binary value, so that nearly equal parameters never share an entry
+  WeightCacheKey& operator<<(double val);
+  WeightCacheKey& operator<<(unsigned val);
+  WeightCacheKey& operator<<(const gsl_vector* vec);
+  WeightCacheKey& operator<<(const String& str);
+
+  const String& str() const { return key_; }
+
+ private:
+  String					key_;
+};
+
+
+// ----- definition for class `SphericalWeightCache' -----
+//
+class SphericalWeightCache {
+ public:
+  class Entry {
+    friend class SphericalWeightCache;
+  public:
+    unsigned matrixN() const { return matrices_.size(); }
+    const gsl_matrix_complex* matrix(unsigned matrixX) const { return matrices_[matrixX]; }
+    size_t bytes() const { return bytes_; }
+
+  private:
+    Entry(const String& key, const std::vector<gsl_matrix_complex*>& matrices);
+    ~Entry();
+
+    const String				key_;
+    std::vector<gsl_matrix_complex*>		matrices_;
+    size_t					bytes_;
+    unsigned					usersN_;
+    std::list<Entry*>::iterator			lru_;
+  };
+
+  // the entry of 'key' for use until 'release()'; NULL if there is none
+  static const Entry* find(const String& key);
+  // cache 'matrices', which are owned by the cache from now on, and use the entry until 'release()';
+  // the entry of another instance is returned if it was stored first
+  static const Entry* insert(const String& key, const std::vector<gsl_matrix_complex*>& matrices);
+  static void release(const Entry* entry);
+
+  // bound on the memory of the entries not in use; 0 disables the cache
+  static void   set_max_bytes(size_t maxBytes);
+  static size_t max_bytes();
+  static bool   enabled() { return max_bytes() > 0; }
+
+  static size_t   bytes();
+  static unsigned entryN();
+  static unsigned long hits();
+  static unsigned long misses();
+  static unsigned long evictions();
+  static double   hit_rate();
+
+  static void clear();
+  static void reset_statistics();
+  static void report(FILE* fp = stdout);
+
+ private:
+  typedef std::map<String, Entry*>		EntryMap_;
+
+  SphericalWeightCache();
+  ~SphericalWeightCache();
+
+  static SphericalWeightCache& instance_();
+  void evict_();
+
+  EntryMap_					entries_;
+  std::list<Entry*>				lru_;		// most recently used first
+  size_t					maxBytes_;
+  size_t					bytes_;
+  unsigned long					hits_;
+  unsigned long					misses_;
+  unsigned long					evictions_;
+  pthread_mutex_t				mutex_;
+};
+
+/*@}*/
+
+#endif
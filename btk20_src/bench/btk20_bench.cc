@@ -0,0 +1,941 @@
+/**
+ * @file btk20_bench.cc
+ * @brief Benchmark of the hot subsystems on synthetic multichannel signals.
+ *
+ * Every target is built from in-memory 'SampleFeature' sources, so no audio
+ * files or filter prototypes are needed. For each target, channel count and
+ * FFT length the program reports the time per frame, the real-time factor
+ * (processing time / signal duration) and the number of heap allocations
+ * per frame. Use '-o json' or '-o csv' for regression tracking, and
+ * '-p system,pooled' to compare the allocation modes of 'GSLAlignedPool'.
+ *
+ * Targets whose output is a time signal also report their latency: the
+ * delay in samples of the peak of their response to an impulse behind the
+ * arrival of the impulse at the last microphone. It excludes the buffering
+ * of one block, which all targets share.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <sys/time.h>
+#include <new>
+#include <vector>
+
+#include "common/jexception.h"
+#include "matrix/aligned_pool.h"
+#include "feature/feature.h"
+#include "modulated/modulated.h"
+#include "beamformer/beamformer.h"
+#include "beamformer/modalbeamformer.h"
+#include "beamformer/fractional_delay.h"
+#include "postfilter/postfilter.h"
+#include "dereverberation/dereverberation.h"
+#include "aec/aec.h"
+#include "localization/localization.h"
+#include "sad/sad.h"
+
+
+// ----- allocation counting -----
+//
+// With glibc every malloc() of the libraries, GSL included, goes through here;
+// elsewhere only C++ allocations are counted.
+//
+static unsigned long allocsN_ = 0;
+static unsigned long allocBytes_ = 0;
+
+static inline void count_alloc_(size_t bytes)
+{
+  __sync_fetch_and_add(&allocsN_, 1);
+  __sync_fetch_and_add(&allocBytes_, bytes);
+}
+
+#ifdef __GLIBC__
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void  __libc_free(void* ptr);
+
+void* malloc(size_t size) { count_alloc_(size); return __libc_malloc(size); }
+void* calloc(size_t n, size_t size) { count_alloc_(n * size); return __libc_calloc(n, size); }
+void* realloc(void* ptr, size_t size) { count_alloc_(size); return __libc_realloc(ptr, size); }
+int   posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+  count_alloc_(size);
+  *ptr = __libc_memalign(alignment, size);
+  return (*ptr == NULL) ? ENOMEM : 0;
+}
+void  free(void* ptr) { __libc_free(ptr); }
+}
+#else
+void* operator new(size_t size) { count_alloc_(size); void* p = malloc(size); if (p == NULL) throw std::bad_alloc(); return p; }
+void* operator new[](size_t size) { count_alloc_(size); void* p = malloc(size); if (p == NULL) throw std::bad_alloc(); return p; }
+void  operator delete(void* p) throw() { free(p); }
+void  operator delete[](void* p) throw() { free(p); }
+#endif
+
+static double now_sec_()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1.0E-06;
+}
+
+
+// ----- synthetic signals -----
+//
+// A harmonic source with a slowly varying envelope arrives at a uniform linear
+// array with one sample of delay between neighbouring microphones; every
+// channel also gets independent white noise.
+//
+static const double SampleRate   = 16000.0;
+static const double MicSpacingMM = 21.4375;	// one sample at 16 kHz for end-fire arrival
+
+class SyntheticArray_ {
+ public:
+  // a noise-free impulse at source sample 'impulseX' instead if that is positive
+  SyntheticArray_(unsigned chanN, unsigned samplesN, unsigned seed = 1, unsigned impulseX = 0)
+    : chanN_(chanN), samplesN_(samplesN)
+  {
+    srand(seed);
+    vector<double> source(samplesN_ + chanN_);
+    for (unsigned n = 0; n < source.size(); n++) {
+      if (impulseX > 0) {
+	source[n] = (n == impulseX) ? 10000.0 : 0.0;
+	continue;
+      }
+      double env = 0.5 + 0.5 * sin(2.0 * M_PI * 3.0 * n / SampleRate);
+      double val = 0.0;
+      for (unsigned h = 1; h <= 8; h++)
+	val += sin(2.0 * M_PI * 150.0 * h * n / SampleRate + h) / h;
+      source[n] = 4000.0 * env * val;
+    }
+
+    for (unsigned chanX = 0; chanX < chanN_; chanX++) {
+      gsl_vector* ch = gsl_vector_alloc(samplesN_);
+      for (unsigned n = 0; n < samplesN_; n++)
+	gsl_vector_set(ch, n, source[n + chanN_ - chanX] + ((impulseX > 0) ? 0 : rand() % 201 - 100));
+      channels_.push_back(ch);
+    }
+  }
+
+  // sample at which an impulse at source sample 'impulseX' reaches the last microphone
+  unsigned last_arrival(unsigned impulseX) const { return impulseX - 1; }
+
+  ~SyntheticArray_()
+  {
+    for (unsigned chanX = 0; chanX < chanN_; chanX++)
+      gsl_vector_free(channels_[chanX]);
+  }
+
+  SampleFeaturePtr sample_feature(unsigned chanX, unsigned blockLen, unsigned shiftLen) const
+  {
+    SampleFeaturePtr samp(new SampleFeature("", blockLen, shiftLen, /* padZeros= */ true));
+    samp->setSamples(channels_[chanX], unsigned(SampleRate));
+    return samp;
+  }
+
+  // arrival delays in seconds relative to the first channel
+  gsl_vector* delays() const
+  {
+    gsl_vector* delays = gsl_vector_alloc(chanN_);
+    for (unsigned chanX = 0; chanX < chanN_; chanX++)
+      gsl_vector_set(delays, chanX, chanX / SampleRate);
+    return delays;
+  }
+
+  // microphone positions in mm, one row per microphone
+  gsl_matrix* positions() const
+  {
+    gsl_matrix* pos = gsl_matrix_calloc(chanN_, 3);
+    for (unsigned chanX = 0; chanX < chanN_; chanX++)
+      gsl_matrix_set(pos, chanX, 0, chanX * MicSpacingMM);
+    return pos;
+  }
+
+ private:
+  const unsigned				chanN_;
+  const unsigned				samplesN_;
+  vector<gsl_vector*>				channels_;
+};
+
+// windowed-sinc lowpass of length M * m; good enough to exercise the filter banks
+static gsl_vector* make_prototype_(unsigned M, unsigned m)
+{
+  unsigned    N     = M * m;
+  gsl_vector* proto = gsl_vector_alloc(N);
+  for (unsigned n = 0; n < N; n++) {
+    double t   = (n - (N - 1) / 2.0) / M;
+    double val = (fabs(t) < 1.0E-12) ? 1.0 : sin(M_PI * t) / (M_PI * t);
+    gsl_vector_set(proto, n, val * (0.54 - 0.46 * cos(2.0 * M_PI * n / (N - 1))) / M);
+  }
+  return proto;
+}
+
+
+// ----- definition for class `BenchTarget' -----
+//
+class BenchTarget {
+ public:
+  BenchTarget(unsigned shiftLen) : shiftLen_(shiftLen) { }
+  virtual ~BenchTarget() { }
+
+  unsigned shiftLen() const { return shiftLen_; }
+
+  // untimed; allocates images and lazily built tables
+  virtual void warmup() { step(0); }
+  // process frames 1, ..., framesN; returns the number processed
+  virtual unsigned batch(unsigned framesN)
+  {
+    for (unsigned frameX = 1; frameX <= framesN; frameX++)
+      step(frameX);
+    return framesN;
+  }
+
+ protected:
+  virtual void step(int frame_no) = 0;
+
+  const unsigned				shiftLen_;
+};
+
+// all targets that pull one complex or float stream per frame
+class StreamTarget : public BenchTarget {
+ public:
+  StreamTarget(unsigned shiftLen, bool timeOutput = false) : BenchTarget(shiftLen), timeOutput_(timeOutput) { }
+
+  VectorComplexFeatureStreamPtr			complex_;
+  VectorFloatFeatureStreamPtr			float_;
+  vector<VectorComplexFeatureStreamPtr>		extra_;	// additional outputs pulled in lockstep
+  const bool					timeOutput_;	// 'float_' is a time signal with one block per frame
+
+ protected:
+  virtual void step(int frame_no)
+  {
+    if (complex_.is_null() == false) complex_->next(frame_no);
+    if (float_.is_null() == false) float_->next(frame_no);
+    for (unsigned i = 0; i < extra_.size(); i++) extra_[i]->next(frame_no);
+  }
+};
+
+static const unsigned FilterBankM = 4;	// prototype length factor
+static const unsigned FilterBankR = 1;	// D = M / 2
+
+static vector<VectorComplexFeatureStreamPtr>
+analysis_banks_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen, gsl_vector* proto)
+{
+  unsigned D = fftLen >> FilterBankR;
+  vector<VectorComplexFeatureStreamPtr> banks;
+  for (unsigned chanX = 0; chanX < chanN; chanX++) {
+    VectorFloatFeatureStreamPtr samp(array.sample_feature(chanX, D, D));
+    banks.push_back(VectorComplexFeatureStreamPtr(new OverSampledDFTAnalysisBank(samp, proto, fftLen, FilterBankM, FilterBankR, 0)));
+  }
+  return banks;
+}
+
+
+// ----- targets -----
+//
+static BenchTarget* make_analysis_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  gsl_vector*   proto  = make_prototype_(fftLen, FilterBankM);
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR);
+  target->extra_ = analysis_banks_(array, chanN, fftLen, proto);
+  gsl_vector_free(proto);
+  return target;
+}
+
+static BenchTarget* make_analysis_synthesis_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  gsl_vector*   proto  = make_prototype_(fftLen, FilterBankM);
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR, /* timeOutput= */ true);
+  vector<VectorComplexFeatureStreamPtr> banks(analysis_banks_(array, 1, fftLen, proto));
+  target->float_ = new OverSampledDFTSynthesisBank(banks[0], proto, fftLen, FilterBankM, FilterBankR, 0);
+  gsl_vector_free(proto);
+  return target;
+}
+
+template <class Beamformer>
+static Beamformer* connect_beamformer_(Beamformer* bf, const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  gsl_vector* proto = make_prototype_(fftLen, FilterBankM);
+  vector<VectorComplexFeatureStreamPtr> banks(analysis_banks_(array, chanN, fftLen, proto));
+  for (unsigned chanX = 0; chanX < chanN; chanX++)
+    bf->set_channel(banks[chanX]);
+  gsl_vector_free(proto);
+  return bf;
+}
+
+static BenchTarget* make_ds_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR);
+  SubbandDS*    bf     = connect_beamformer_(new SubbandDS(fftLen), array, chanN, fftLen);
+  gsl_vector*   delays = array.delays();
+  bf->calc_array_manifold_vectors(SampleRate, delays);
+  gsl_vector_free(delays);
+  target->complex_ = bf;
+  return target;
+}
+
+// the complete subband chain from microphones to a time signal
+static BenchTarget* make_ds_synthesis_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR, /* timeOutput= */ true);
+  SubbandDS*    bf     = connect_beamformer_(new SubbandDS(fftLen), array, chanN, fftLen);
+  gsl_vector*   delays = array.delays();
+  gsl_vector*   proto  = make_prototype_(fftLen, FilterBankM);
+  bf->calc_array_manifold_vectors(SampleRate, delays);
+  VectorComplexFeatureStreamPtr beam(bf);
+  target->float_ = new OverSampledDFTSynthesisBank(beam, proto, fftLen, FilterBankM, FilterBankR, 0);
+  gsl_vector_free(delays);  gsl_vector_free(proto);
+  return target;
+}
+
+// time-domain delay-and-sum on blocks of the shift of the subband targets
+static TimeDomainDS* connect_time_domain_ds_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  unsigned      D  = fftLen >> FilterBankR;
+  TimeDomainDS* bf = new TimeDomainDS(D);
+  for (unsigned chanX = 0; chanX < chanN; chanX++) {
+    VectorFloatFeatureStreamPtr samp(array.sample_feature(chanX, D, D));
+    bf->set_channel(samp);
+  }
+  gsl_vector* delays = array.delays();
+  bf->set_delays(SampleRate, delays);
+  gsl_vector_free(delays);
+  return bf;
+}
+
+static BenchTarget* make_td_ds_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR, /* timeOutput= */ true);
+  target->float_ = connect_time_domain_ds_(array, chanN, fftLen);
+  return target;
+}
+
+// a tracker re-steers before every block, so every sample gets its own taps
+class TimeDomainDSSteeringTarget : public StreamTarget {
+ public:
+  TimeDomainDSSteeringTarget(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+    : StreamTarget(fftLen >> FilterBankR, /* timeOutput= */ true),
+      bf_(connect_time_domain_ds_(array, chanN, fftLen)), delays_(array.delays())
+  {
+    float_ = bf_;
+  }
+  ~TimeDomainDSSteeringTarget() { gsl_vector_free(delays_); }
+
+ protected:
+  virtual void step(int frame_no)
+  {
+    gsl_vector_scale(delays_, (frame_no % 2 == 0) ? 1.05 : 1.0 / 1.05);
+    bf_->set_delays(SampleRate, delays_);
+    StreamTarget::step(frame_no);
+  }
+
+ private:
+  TimeDomainDSPtr				bf_;
+  gsl_vector*					delays_;
+};
+
+static BenchTarget* make_td_ds_steering_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  return new TimeDomainDSSteeringTarget(array, chanN, fftLen);
+}
+
+static BenchTarget* make_gsc_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR);
+  SubbandGSC*   bf     = connect_beamformer_(new SubbandGSC(fftLen), array, chanN, fftLen);
+  gsl_vector*   delays = array.delays();
+  bf->calc_gsc_weights(SampleRate, delays);
+  gsl_vector_free(delays);
+  target->complex_ = bf;
+  return target;
+}
+
+static BenchTarget* make_gscrls_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget*  target = new StreamTarget(fftLen >> FilterBankR);
+  SubbandGSCRLS* bf     = connect_beamformer_(new SubbandGSCRLS(fftLen), array, chanN, fftLen);
+  gsl_vector*    delays = array.delays();
+  bf->calc_gsc_weights(SampleRate, delays);
+  bf->init_precision_matrix(0.01);
+  gsl_vector_free(delays);
+  target->complex_ = bf;
+  return target;
+}
+
+static BenchTarget* make_mvdr_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR);
+  SubbandMVDR*  bf     = connect_beamformer_(new SubbandMVDR(fftLen), array, chanN, fftLen);
+  gsl_vector*   delays = array.delays();
+  gsl_matrix*   pos    = array.positions();
+  bf->calc_array_manifold_vectors(SampleRate, delays);
+  bf->set_diffuse_noise_model(pos, SampleRate);
+  bf->set_all_diagonal_loading(0.01);
+  bf->calc_mvdr_weights(SampleRate);
+  gsl_vector_free(delays);  gsl_matrix_free(pos);
+  target->complex_ = bf;
+  return target;
+}
+
+// one null toward an interference arriving at half the end-fire delay
+static BenchTarget* make_lcmv_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget* target  = new StreamTarget(fftLen >> FilterBankR);
+  SubbandGSC*   bf      = connect_beamformer_(new SubbandGSC(fftLen), array, chanN, fftLen);
+  gsl_vector*   delaysT = array.delays();
+  gsl_matrix*   delaysJ = gsl_matrix_alloc(1, chanN);
+  for (unsigned chanX = 0; chanX < chanN; chanX++)
+    gsl_matrix_set(delaysJ, 0, chanX, 0.5 * gsl_vector_get(delaysT, chanX));
+  bf->calc_gsc_weights_n(SampleRate, delaysT, delaysJ, 2);
+  bf->zero_active_weights();
+  gsl_vector_free(delaysT);  gsl_matrix_free(delaysJ);
+  target->complex_ = bf;
+  return target;
+}
+
+// the GSC form of the MVDR beamformer under the diffuse noise model, as the pipelines build it
+static BenchTarget* make_superdirective_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget*   target = new StreamTarget(fftLen >> FilterBankR);
+  SubbandMVDRGSC* bf     = connect_beamformer_(new SubbandMVDRGSC(fftLen), array, chanN, fftLen);
+  gsl_vector*     delays = array.delays();
+  gsl_matrix*     pos    = array.positions();
+  bf->calc_array_manifold_vectors(SampleRate, delays);
+  bf->set_diffuse_noise_model(pos, SampleRate);
+  bf->set_all_diagonal_loading(0.01);
+  bf->calc_mvdr_weights(SampleRate);
+  bf->zero_active_weights();
+  gsl_vector_free(delays);  gsl_matrix_free(pos);
+  target->complex_ = bf;
+  return target;
+}
+
+// the 32 channels of an Eigenmike steered to theta = pi / 2; the signals are those of the linear array
+template <class Beamformer>
+static BenchTarget* make_spherical_(Beamformer* bf, const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR);
+  connect_beamformer_(bf, array, chanN, fftLen);
+  bf->set_eigenmike_geometry();
+  bf->set_look_direction(M_PI / 2.0, 0.0);
+  target->complex_ = bf;
+  return target;
+}
+
+static BenchTarget* make_eigen_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  return make_spherical_(new EigenBeamformer(unsigned(SampleRate), fftLen), array, chanN, fftLen);
+}
+
+static BenchTarget* make_spherical_ds_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  return make_spherical_(new SphericalDSBeamformer(unsigned(SampleRate), fftLen), array, chanN, fftLen);
+}
+
+static BenchTarget* make_spherical_hwnc_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  return make_spherical_(new SphericalHWNCBeamformer(unsigned(SampleRate), fftLen), array, chanN, fftLen);
+}
+
+// post-filters behind a delay-and-sum beamformer in its GSC form, as the pipelines build them
+static BenchTarget* make_postfilter_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen, int type)
+{
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR);
+  SubbandGSCPtr bf(connect_beamformer_(new SubbandGSC(fftLen), array, chanN, fftLen));
+  gsl_vector*   delays = array.delays();
+  gsl_matrix*   pos    = array.positions();
+  bf->calc_gsc_weights(SampleRate, delays);
+  bf->zero_active_weights();
+
+  VectorComplexFeatureStreamPtr output(bf);
+  SubbandDSPtr                  ds(bf);
+  if (type == 0) {
+    ZelinskiPostFilterPtr pf(new ZelinskiPostFilter(output, fftLen, 0.6, 2));
+    pf->set_beamformer(ds);
+    target->complex_ = pf;
+  } else if (type == 1) {
+    McCowanPostFilterPtr pf(new McCowanPostFilter(output, fftLen, 0.6, 2));
+    pf->set_diffuse_noise_model(pos, SampleRate);
+    pf->set_all_diagonal_loading(0.01);
+    pf->set_beamformer(ds);
+    target->complex_ = pf;
+  } else {
+    LefkimmiatisPostFilterPtr pf(new LefkimmiatisPostFilter(output, fftLen, 1.0E-8, fftLen / 2, 0.8, 2));
+    pf->set_diffuse_noise_model(pos, SampleRate);
+    pf->set_all_diagonal_loading(0.1);
+    pf->calc_inverse_noise_spatial_spectral_matrix();
+    pf->set_beamformer(ds);
+    target->complex_ = pf;
+  }
+  gsl_vector_free(delays);  gsl_matrix_free(pos);
+  return target;
+}
+
+static BenchTarget* make_zelinski_(const SyntheticArray_& a, unsigned c, unsigned f)     { return make_postfilter_(a, c, f, 0); }
+static BenchTarget* make_mccowan_(const SyntheticArray_& a, unsigned c, unsigned f)      { return make_postfilter_(a, c, f, 1); }
+static BenchTarget* make_lefkimmiatis_(const SyntheticArray_& a, unsigned c, unsigned f) { return make_postfilter_(a, c, f, 2); }
+
+// WPE is a batch algorithm: the timed part is filter estimation plus filtering
+class WPETarget : public BenchTarget {
+ public:
+  WPETarget(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+    : BenchTarget(fftLen >> FilterBankR),
+      wpe_(new MultiChannelWPEDereverberation(fftLen, chanN, /* lowerN= */ 0, /* upperN= */ 8))
+  {
+    gsl_vector* proto = make_prototype_(fftLen, FilterBankM);
+    banks_ = analysis_banks_(array, chanN, fftLen, proto);
+    for (unsigned chanX = 0; chanX < chanN; chanX++)
+      wpe_->set_input(banks_[chanX]);
+    output_ = new MultiChannelWPEDereverberationFeature(wpe_, 0);
+    gsl_vector_free(proto);
+  }
+
+  virtual void warmup() { }
+  virtual unsigned batch(unsigned framesN)
+  {
+    wpe_->estimate_filter(0, framesN);
+    for (unsigned frameX = 0; frameX < framesN; frameX++)
+      output_->next(frameX);
+    return framesN;
+  }
+
+ protected:
+  virtual void step(int frame_no) { }
+
+ private:
+  vector<VectorComplexFeatureStreamPtr>		banks_;
+  MultiChannelWPEDereverberationPtr		wpe_;
+  VectorComplexFeatureStreamPtr			output_;
+};
+
+static BenchTarget* make_wpe_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  return new WPETarget(array, chanN, fftLen);
+}
+
+// echo cancellers see channel 0 as the far end and channel 1 as the microphone
+static BenchTarget* make_aec_(const SyntheticArray_& array, unsigned fftLen, int type)
+{
+  gsl_vector*   proto  = make_prototype_(fftLen, FilterBankM);
+  StreamTarget* target = new StreamTarget(fftLen >> FilterBankR);
+  vector<VectorComplexFeatureStreamPtr> banks(analysis_banks_(array, 2, fftLen, proto));
+  gsl_vector_free(proto);
+
+  switch (type) {
+  case 0: target->complex_ = new NLMSAcousticEchoCancellationFeature(banks[0], banks[1]);  break;
+  case 1: target->complex_ = new KalmanFilterEchoCancellationFeature(banks[0], banks[1]);  break;
+  case 2: target->complex_ = new BlockKalmanFilterEchoCancellationFeature(banks[0], banks[1], 2);  break;
+  case 3: target->complex_ = new InformationFilterEchoCancellationFeature(banks[0], banks[1], 2);  break;
+  case 4: target->complex_ = new SquareRootInformationFilterEchoCancellationFeature(banks[0], banks[1], 2);  break;
+  default: target->complex_ = new DTDBlockKalmanFilterEchoCancellationFeature(banks[0], banks[1], 2);  break;
+  }
+  return target;
+}
+
+static BenchTarget* make_aec_nlms_(const SyntheticArray_& a, unsigned, unsigned f)    { return make_aec_(a, f, 0); }
+static BenchTarget* make_aec_kalman_(const SyntheticArray_& a, unsigned, unsigned f)  { return make_aec_(a, f, 1); }
+static BenchTarget* make_aec_bkalman_(const SyntheticArray_& a, unsigned, unsigned f) { return make_aec_(a, f, 2); }
+static BenchTarget* make_aec_info_(const SyntheticArray_& a, unsigned, unsigned f)    { return make_aec_(a, f, 3); }
+static BenchTarget* make_aec_srinfo_(const SyntheticArray_& a, unsigned, unsigned f)  { return make_aec_(a, f, 4); }
+static BenchTarget* make_aec_dtd_(const SyntheticArray_& a, unsigned, unsigned f)     { return make_aec_(a, f, 5); }
+
+static BenchTarget* make_srp_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  StreamTarget*         target = new StreamTarget(fftLen >> FilterBankR);
+  DOAEstimatorSRPDSBLA* srp    = connect_beamformer_(new DOAEstimatorSRPDSBLA(1, unsigned(SampleRate), fftLen), array, chanN, fftLen);
+  gsl_vector*           pos    = gsl_vector_alloc(chanN);
+  for (unsigned chanX = 0; chanX < chanN; chanX++)
+    gsl_vector_set(pos, chanX, chanX * MicSpacingMM);
+  srp->set_array_geometry(pos);
+  srp->set_energy_threshold(-1.0);
+  gsl_vector_free(pos);
+  target->complex_ = srp;
+  return target;
+}
+
+// GCC-PHAT between neighbouring microphones
+class GCCTarget : public BenchTarget {
+ public:
+  GCCTarget(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+    : BenchTarget(fftLen / 2), gcc_(SampleRate, fftLen, chanN, (chanN > 1) ? chanN - 1 : 1)
+  {
+    for (unsigned chanX = 0; chanX < chanN; chanX++) {
+      VectorFloatFeatureStreamPtr samp(array.sample_feature(chanX, fftLen, fftLen / 2));
+      VectorFloatFeatureStreamPtr hamming(new HammingFeature(samp));
+      ffts_.push_back(VectorComplexFeatureStreamPtr(new FFTFeature(hamming, fftLen)));
+    }
+  }
+
+ protected:
+  virtual void step(int frame_no)
+  {
+    for (unsigned chanX = 0; chanX < ffts_.size(); chanX++)
+      ffts_[chanX]->next(frame_no);
+    for (unsigned pairX = 0; pairX + 1 < ffts_.size(); pairX++) {
+      gcc_.calculate(ffts_[pairX]->next(frame_no), pairX, ffts_[pairX + 1]->next(frame_no), pairX + 1, pairX, frame_no);
+      gcc_.findMaximum();
+    }
+  }
+
+ private:
+  vector<VectorComplexFeatureStreamPtr>		ffts_;
+  GCCPhat					gcc_;
+};
+
+static BenchTarget* make_gcc_(const SyntheticArray_& array, unsigned chanN, unsigned fftLen)
+{
+  return new GCCTarget(array, chanN, fftLen);
+}
+
+// energy and power spectrum VAD metrics on the first two channels
+class VADTarget : public BenchTarget {
+ public:
+  VADTarget(const SyntheticArray_& array, unsigned fftLen)
+    : BenchTarget(fftLen / 2)
+  {
+    VectorFloatFeatureStreamPtr samp0(array.sample_feature(0, fftLen, fftLen / 2));
+    VectorFloatFeatureStreamPtr samp1(array.sample_feature(1, fftLen, fftLen / 2));
+    VectorFloatFeatureStreamPtr samp2(array.sample_feature(0, fftLen, fftLen / 2));
+    VectorFloatFeatureStreamPtr hamming0(new HammingFeature(samp0));
+    VectorFloatFeatureStreamPtr hamming1(new HammingFeature(samp1));
+    VectorComplexFeatureStreamPtr fft0(new FFTFeature(hamming0, fftLen));
+    VectorComplexFeatureStreamPtr fft1(new FFTFeature(hamming1, fftLen));
+    VectorFloatFeatureStreamPtr power0(new SpectralPowerFloatFeature(fft0));
+    VectorFloatFeatureStreamPtr power1(new SpectralPowerFloatFeature(fft1));
+
+    energy_   = new EnergyVADMetric(samp2);
+    spectrum_ = new PowerSpectrumVADMetric(power0, power1, SampleRate);
+  }
+
+ protected:
+  virtual void step(int frame_no)
+  {
+    energy_->next(frame_no);
+    spectrum_->next(frame_no);
+  }
+
+ private:
+  EnergyVADMetricPtr				energy_;
+  PowerSpectrumVADMetricPtr			spectrum_;
+};
+
+static BenchTarget* make_vad_(const SyntheticArray_& array, unsigned, unsigned fftLen)
+{
+  return new VADTarget(array, fftLen);
+}
+
+// Hamming -> FFT -> power -> mel -> log -> cepstrum on the first channel
+static BenchTarget* make_mfcc_(const SyntheticArray_& array, unsigned, unsigned fftLen)
+{
+  StreamTarget* target = new StreamTarget(fftLen / 2);
+  unsigned      powN   = fftLen / 2 + 1;
+
+  VectorFloatFeatureStreamPtr   samp(array.sample_feature(0, fftLen, fftLen / 2));
+  VectorFloatFeatureStreamPtr   hamming(new HammingFeature(samp));
+  VectorComplexFeatureStreamPtr fft(new FFTFeature(hamming, fftLen));
+  VectorFeatureStreamPtr        power(new SpectralPowerFeature(fft, powN));
+  VectorFeatureStreamPtr        mel(new MelFeature(power, powN, SampleRate, 100.0, 6800.0, 30, 2));
+  VectorFloatFeatureStreamPtr   logMel(new LogFeature(mel));
+  target->float_ = new CepstralFeature(logMel, 13);
+  return target;
+}
+
+
+// ----- benchmark table -----
+//
+typedef BenchTarget* (*BenchFactory)(const SyntheticArray_& array, unsigned chanN, unsigned fftLen);
+
+struct BenchEntry {
+  const char*		name;
+  BenchFactory		factory;
+  bool			multichannel;	// false: run once per FFT length with the minimum channels
+  unsigned		minChanN;
+};
+
+static const BenchEntry Benches[] = {
+  { "analysis",           make_analysis_,           true,  1 },
+  { "analysis-synthesis", make_analysis_synthesis_, false, 1 },
+  { "subband-ds",         make_ds_,                 true,  2 },
+  { "subband-ds-synthesis", make_ds_synthesis_,     true,  2 },
+  { "timedomain-ds",      make_td_ds_,              true,  2 },
+  { "timedomain-ds-steering", make_td_ds_steering_, true,  2 },
+  { "subband-gsc",        make_gsc_,                true,  2 },
+  { "subband-gsc-rls",    make_gscrls_,             true,  2 },
+  { "subband-mvdr",       make_mvdr_,               true,  2 },
+  { "subband-lcmv",       make_lcmv_,               true,  3 },
+  { "subband-superdirective", make_superdirective_, true,  2 },
+  { "eigen",              make_eigen_,              false, 32 },
+  { "spherical-ds",       make_spherical_ds_,       false, 32 },
+  { "spherical-hwnc",     make_spherical_hwnc_,     false, 32 },
+  { "postfilter-zelinski", make_zelinski_,          true,  2 },
+  { "postfilter-mccowan", make_mccowan_,            true,  2 },
+  { "postfilter-lefkimmiatis", make_lefkimmiatis_,  true,  2 },
+  { "wpe",                make_wpe_,                true,  1 },
+  { "aec-nlms",           make_aec_nlms_,           false, 2 },
+  { "aec-kalman",         make_aec_kalman_,         false, 2 },
+  { "aec-block-kalman",   make_aec_bkalman_,        false, 2 },
+  { "aec-information",    make_aec_info_,           false, 2 },
+  { "aec-sqrt-information", make_aec_srinfo_,       false, 2 },
+  { "aec-dtd",            make_aec_dtd_,            false, 2 },
+  { "srp-doa",            make_srp_,                true,  2 },
+  { "gcc-phat",           make_gcc_,                true,  2 },
+  { "vad-metrics",        make_vad_,                false, 2 },
+  { "mfcc",               make_mfcc_,               false, 1 },
+};
+
+struct BenchResult {
+  String		name;
+  String		pool;		// allocation mode of 'GSLAlignedPool'
+  unsigned		chanN;
+  unsigned		fftLen;
+  unsigned		framesN;
+  double		seconds;
+  double		nsPerFrame;
+  double		rtf;
+  double		allocsPerFrame;
+  double		bytesPerFrame;
+  int			latency;	// samples; -1 if the output is no time signal
+  String		error;
+};
+
+// run the target on an impulse and find the peak of its output
+static int measure_latency_(const BenchEntry& entry, unsigned chanN, unsigned fftLen)
+{
+  unsigned        impulseX = 4 * fftLen + chanN;
+  SyntheticArray_ array(chanN, 16 * fftLen, 1, impulseX);
+  BenchTarget*    target   = entry.factory(array, chanN, fftLen);
+  StreamTarget*   stream   = dynamic_cast<StreamTarget*>(target);
+  if (stream == NULL || stream->timeOutput_ == false) {
+    delete target;
+    return -1;
+  }
+
+  long     peakX = -1;
+  double   peak  = 0.0;
+  unsigned blockLen = stream->float_->size();
+  for (unsigned frameX = 0; (frameX + 1) * blockLen < 12 * fftLen; frameX++) {
+    const gsl_vector_float* block = stream->float_->next(frameX);
+    for (unsigned n = 0; n < blockLen; n++) {
+      double val = fabs(gsl_vector_float_get(block, n));
+      if (val > peak) { peak = val; peakX = long(frameX) * blockLen + n; }
+    }
+  }
+  delete target;
+
+  return (peakX < 0) ? -1 : int(peakX - long(array.last_arrival(impulseX)));
+}
+
+static BenchResult run_bench_(const BenchEntry& entry, unsigned chanN, unsigned fftLen, unsigned framesN, GSLAlignedPool::Mode pool)
+{
+  BenchResult result;
+  result.name    = entry.name;
+  result.pool    = GSLAlignedPool::mode_name(pool);
+  result.chanN   = chanN;
+  result.fftLen  = fftLen;
+  result.framesN = 0;
+  result.seconds = result.nsPerFrame = result.rtf = result.allocsPerFrame = result.bytesPerFrame = 0.0;
+  result.latency = -1;
+
+  // enough samples for the frames plus the filter bank latency
+  SyntheticArray_ array((chanN < entry.minChanN) ? entry.minChanN : chanN, (framesN + 2 * FilterBankM + 4) * fftLen);
+
+  BenchTarget* target = NULL;
+  try {
+    GSLAlignedPool::set_mode(pool);
+    target = entry.factory(array, chanN, fftLen);
+    target->warmup();
+
+    unsigned long allocs0 = allocsN_, bytes0 = allocBytes_;
+    double        t0      = now_sec_();
+    result.framesN = target->batch(framesN);
+    result.seconds = now_sec_() - t0;
+    unsigned long allocs  = allocsN_ - allocs0, bytes = allocBytes_ - bytes0;
+
+    result.nsPerFrame     = result.seconds * 1.0E+09 / result.framesN;
+    result.rtf            = result.seconds / (result.framesN * target->shiftLen() / SampleRate);
+    result.allocsPerFrame = double(allocs) / result.framesN;
+    result.bytesPerFrame  = double(bytes) / result.framesN;
+
+    result.latency = measure_latency_(entry, chanN, fftLen);
+  } catch (exception& e) {
+    result.error = e.what();
+  }
+  delete target;
+
+  return result;
+}
+
+
+// ----- output -----
+//
+static void print_text_(const vector<BenchResult>& results)
+{
+  printf("%-22s %-7s %5s %6s %7s %12s %10s %12s %12s %8s\n",
+	 "target", "pool", "chans", "fftlen", "frames", "ns/frame", "rtf", "allocs/fr", "bytes/fr", "latency");
+  for (unsigned i = 0; i < results.size(); i++) {
+    const BenchResult& r = results[i];
+    if (r.error != "") {
+      printf("%-22s %-7s %5u %6u  error: %s\n", r.name.c_str(), r.pool.c_str(), r.chanN, r.fftLen, r.error.c_str());
+      continue;
+    }
+    printf("%-22s %-7s %5u %6u %7u %12.1f %10.5f %12.2f %12.1f ",
+	   r.name.c_str(), r.pool.c_str(), r.chanN, r.fftLen, r.framesN, r.nsPerFrame, r.rtf, r.allocsPerFrame, r.bytesPerFrame);
+    if (r.latency < 0) printf("%8s\n", "-");
+    else printf("%8d\n", r.latency);
+  }
+}
+
+static void print_csv_(const vector<BenchResult>& results)
+{
+  printf("target,pool,channels,fft_len,frames,seconds,ns_per_frame,rtf,allocs_per_frame,bytes_per_frame,latency,error\n");
+  for (unsigned i = 0; i < results.size(); i++) {
+    const BenchResult& r = results[i];
+    printf("%s,%s,%u,%u,%u,%.9f,%.3f,%.6f,%.3f,%.1f,%d,\"%s\"\n",
+	   r.name.c_str(), r.pool.c_str(), r.chanN, r.fftLen, r.framesN, r.seconds, r.nsPerFrame, r.rtf,
+	   r.allocsPerFrame, r.bytesPerFrame, r.latency, r.error.c_str());
+  }
+}
+
+static String json_escape_(const String& str)
+{
+  String out;
+  for (unsigned i = 0; i < str.size(); i++) {
+    char c = str[i];
+    if (c == '"' || c == '\\') { out += '\\'; out += c; }
+    else if (c == '\n') out += "\\n";
+    else if ((unsigned char) c >= 0x20) out += c;
+  }
+  return out;
+}
+
+static void print_json_(const vector<BenchResult>& results, unsigned framesN)
+{
+  printf("{\n  \"sample_rate\": %.1f,\n  \"frames\": %u,\n  \"results\": [\n", SampleRate, framesN);
+  for (unsigned i = 0; i < results.size(); i++) {
+    const BenchResult& r = results[i];
+    printf("    {\"target\": \"%s\", \"pool\": \"%s\", \"channels\": %u, \"fft_len\": %u, \"frames\": %u, "
+	   "\"seconds\": %.9f, \"ns_per_frame\": %.3f, \"rtf\": %.6f, "
+	   "\"allocs_per_frame\": %.3f, \"bytes_per_frame\": %.1f",
+	   r.name.c_str(), r.pool.c_str(), r.chanN, r.fftLen, r.framesN, r.seconds, r.nsPerFrame, r.rtf,
+	   r.allocsPerFrame, r.bytesPerFrame);
+    if (r.latency >= 0)
+      printf(", \"latency\": %d", r.latency);
+    if (r.error != "")
+      printf(", \"error\": \"%s\"", json_escape_(r.error).c_str());
+    printf("}%s\n", (i + 1 < results.size()) ? "," : "");
+  }
+  printf("  ]\n}\n");
+}
+
+static vector<unsigned> parse_list_(const char* arg)
+{
+  vector<unsigned> list;
+  char* copy = strdup(arg);
+  for (char* tok = strtok(copy, ","); tok != NULL; tok = strtok(NULL, ","))
+    list.push_back(atoi(tok));
+  free(copy);
+  return list;
+}
+
+// allocation modes of 'GSLAlignedPool', e.g. "system,pooled"
+static bool parse_pools_(const char* arg, vector<GSLAlignedPool::Mode>& pools)
+{
+  pools.clear();
+  char* copy = strdup(arg);
+  bool  ok   = true;
+  for (char* tok = strtok(copy, ","); tok != NULL; tok = strtok(NULL, ",")) {
+    try {
+      GSLAlignedPool::set_mode(String(tok));
+      pools.push_back(GSLAlignedPool::mode());
+    } catch (j_error& e) {
+      ok = false;
+    }
+  }
+  free(copy);
+  return ok && pools.size() > 0;
+}
+
+static void usage_(const char* prog)
+{
+  fprintf(stderr,
+	  "usage: %s [-c channel-counts] [-f fft-lengths] [-n frames] [-t target-substring] [-p pool-modes] [-o text|json|csv] [-l]\n"
+	  "  defaults: -c 2,4,8 -f 256,512,1024 -n 500 -o text, and the pool mode of BTK20_GSL_POOL\n"
+	  "  pool modes: system (GSL allocators), aligned, pooled; '-p system,pooled' shows both\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+  vector<unsigned> chanNs  = parse_list_("2,4,8");
+  vector<unsigned> fftLens = parse_list_("256,512,1024");
+  unsigned         framesN = 500;
+  String           filter  = "";
+  String           format  = "text";
+  vector<GSLAlignedPool::Mode> pools(1, GSLAlignedPool::mode());
+  int opt;
+
+  while ((opt = getopt(argc, argv, "c:f:n:t:p:o:lh")) != -1) {
+    switch (opt) {
+    case 'c': chanNs  = parse_list_(optarg); break;
+    case 'f': fftLens = parse_list_(optarg); break;
+    case 'n': framesN = atoi(optarg); break;
+    case 't': filter  = optarg; break;
+    case 'p':
+      if (parse_pools_(optarg, pools) == false) {
+	usage_(argv[0]);
+	return 1;
+      }
+      break;
+    case 'o': format  = optarg; break;
+    case 'l':
+      for (unsigned i = 0; i < sizeof(Benches) / sizeof(Benches[0]); i++)
+	printf("%s\n", Benches[i].name);
+      return 0;
+    default:
+      usage_(argv[0]);
+      return 1;
+    }
+  }
+  if (framesN == 0 || chanNs.size() == 0 || fftLens.size() == 0 ||
+      (format != "text" && format != "json" && format != "csv")) {
+    usage_(argv[0]);
+    return 1;
+  }
+
+  vector<BenchResult> results;
+  for (unsigned i = 0; i < sizeof(Benches) / sizeof(Benches[0]); i++) {
+    const BenchEntry& entry = Benches[i];
+    if (filter != "" && String(entry.name).find(filter) == String::npos) continue;
+
+    for (unsigned f = 0; f < fftLens.size(); f++) {
+      for (unsigned p = 0; p < pools.size(); p++) {
+	if (entry.multichannel) {
+	  for (unsigned c = 0; c < chanNs.size(); c++)
+	    if (chanNs[c] >= entry.minChanN)
+	      results.push_back(run_bench_(entry, chanNs[c], fftLens[f], framesN, pools[p]));
+	} else {
+	  results.push_back(run_bench_(entry, entry.minChanN, fftLens[f], framesN, pools[p]));
+	}
+      }
+      if (format == "text")
+	fprintf(stderr, "done: %s (fft %u)\n", entry.name, fftLens[f]);
+    }
+  }
+
+  if (format == "json")
+    print_json_(results, framesN);
+  else if (format == "csv")
+    print_csv_(results);
+  else
+    print_text_(results);
+
+  for (unsigned i = 0; i < results.size(); i++)
+    if (results[i].error != "") return 2;
+
+  return 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file btk20_frame_feature_bench.cc
+ * @brief Compare the scalar and SIMD kernels behind ZeroCrossingRateHammingFeature,
+ *        SignalPowerFeature and ThresholdFeature on synthetic frames.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <math.h>
+#include <sys/time.h>
+#include "feature/frame_kernels.h"
+
+static double now_sec()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1.0E-06;
+}
+
+static void print_result(const char* name, double scalarT, double simdT, unsigned framesN, double maxErr)
+{
+  printf("%-24s scalar %8.1f ns/frame  simd %8.1f ns/frame  speedup %5.2f  max-err %e\n",
+	 name, scalarT * 1.0E+09 / framesN, simdT * 1.0E+09 / framesN, scalarT / simdT, maxErr);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned frameLen = 400;
+  unsigned framesN  = 100000;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "l:n:h")) != -1) {
+    switch (opt) {
+    case 'l': frameLen = atoi(optarg); break;
+    case 'n': framesN  = atoi(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-l frame-length] [-n number-of-frames]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // a bank of noisy sinusoids, replayed cyclically
+  const unsigned bankN = 64;
+  float*  samples = new float[bankN * frameLen];
+  float*  output  = new float[frameLen];
+  float*  outputS = new float[frameLen];
+  double* window  = new double[frameLen];
+  float*  windowF = new float[frameLen];
+  srand(0);
+  for (unsigned n = 0; n < bankN * frameLen; n++)
+    samples[n] = 8000.0 * sin(2.0 * M_PI * 0.013 * n) + (rand() % 2001 - 1000);
+  for (unsigned i = 0; i < frameLen; i++) {
+    window[i]  = 0.54 - 0.46 * cos(2.0 * M_PI * i / (frameLen - 1));
+    windowF[i] = window[i];
+  }
+
+  double t0, scalarT, simdT, maxErr;
+  volatile double sink = 0.0;
+
+  // zero crossing rate
+  maxErr = 0.0;
+  t0 = now_sec();
+  for (unsigned f = 0; f < framesN; f++)
+    sink += zero_crossing_rate_hamming_scalar(samples + (f % bankN) * frameLen, window, frameLen);
+  scalarT = now_sec() - t0;
+  t0 = now_sec();
+  for (unsigned f = 0; f < framesN; f++)
+    sink += zero_crossing_rate_hamming(samples + (f % bankN) * frameLen, windowF, frameLen);
+  simdT = now_sec() - t0;
+  for (unsigned f = 0; f < bankN; f++) {
+    double err = fabs(zero_crossing_rate_hamming_scalar(samples + f * frameLen, window, frameLen)
+		      - zero_crossing_rate_hamming(samples + f * frameLen, windowF, frameLen));
+    if (err > maxErr) maxErr = err;
+  }
+  print_result("ZeroCrossingRateHamming", scalarT, simdT, framesN, maxErr);
+
+  // signal power
+  maxErr = 0.0;
+  t0 = now_sec();
+  for (unsigned f = 0; f < framesN; f++)
+    sink += signal_power_scalar(samples + (f % bankN) * frameLen, frameLen);
+  scalarT = now_sec() - t0;
+  t0 = now_sec();
+  for (unsigned f = 0; f < framesN; f++)
+    sink += signal_power(samples + (f % bankN) * frameLen, frameLen);
+  simdT = now_sec() - t0;
+  for (unsigned f = 0; f < bankN; f++) {
+    double p   = signal_power_scalar(samples + f * frameLen, frameLen);
+    double err = fabs(p - signal_power(samples + f * frameLen, frameLen)) / p;
+    if (err > maxErr) maxErr = err;
+  }
+  print_result("SignalPower", scalarT, simdT, framesN, maxErr);
+
+  // threshold in 'both' mode
+  maxErr = 0.0;
+  t0 = now_sec();
+  for (unsigned f = 0; f < framesN; f++) {
+    threshold_samples_scalar(output, samples + (f % bankN) * frameLen, frameLen, 0, 1000.0, 4000.0);
+    sink += output[f % frameLen];
+  }
+  scalarT = now_sec() - t0;
+  t0 = now_sec();
+  for (unsigned f = 0; f < framesN; f++) {
+    threshold_samples(output, samples + (f % bankN) * frameLen, frameLen, 0, 1000.0, 4000.0);
+    sink += output[f % frameLen];
+  }
+  simdT = now_sec() - t0;
+  for (unsigned f = 0; f < bankN; f++) {
+    threshold_samples_scalar(outputS, samples + f * frameLen, frameLen, 0, 1000.0, 4000.0);
+    threshold_samples(output, samples + f * frameLen, frameLen, 0, 1000.0, 4000.0);
+    for (unsigned i = 0; i < frameLen; i++)
+      if (fabs(output[i] - outputS[i]) > maxErr) maxErr = fabs(output[i] - outputS[i]);
+  }
+  print_result("Threshold", scalarT, simdT, framesN, maxErr);
+
+  delete[] samples;  delete[] output;  delete[] outputS;  delete[] window;  delete[] windowF;
+
+  return 0;
+}
@@ -12,6 +12,9 @@
 
 #include "common/jpython_error.h"
 #include "dereverberation/dereverberation.h"
+#include "matrix/state_io.h"
+#include "matrix/aligned_pool.h"
+#include "matrix/complex_kernels.h"
 
 #ifdef HAVE_CONFIG_H
 #include <btk.h>
@@ -27,10 +30,10 @@ SingleChannelWPEDereverberationFeature::
 SingleChannelWPEDereverberationFeature(VectorComplexFeatureStreamPtr& samples, unsigned lowerN, unsigned upperN, unsigned iterationsN, double loadDb, double bandWidth, double sampleRate, const String& nm)
   : VectorComplexFeatureStream(samples->size(), nm), samples_(samples),
     lowerN_(lowerN), upperN_(upperN), predictionN_(upperN_ - lowerN_ + 1), iterationsN_(iterationsN), estimated_(false), framesN_(0), load_factor_(pow(10.0, loadDb / 10.0)),
-    lower_bandWidthN_(set_band_width_(bandWidth, sampleRate)), upper_bandWidthN_(size() - lower_bandWidthN_),
+    lower_bandWidthN_(set_band_width_(bandWidth, sampleRate)), upper_bandWidthN_(size() - lower_bandWidthN_), range_(size()),
     thetan_(NULL), gn_(new gsl_vector_complex*[size()]), R_(gsl_matrix_complex_alloc(predictionN_, predictionN_)), r_(gsl_vector_complex_alloc(predictionN_)),
     lag_samples_(gsl_vector_complex_alloc(predictionN_)),
-    printing_subbandX_(-1)
+    printing_subbandX_(-1), deadline_(NULL), deadlineX_(0)
 {
   // allocate prediction vectors
   for (unsigned n = 0; n < size(); n++)
@@ -49,10 +52,27 @@ SingleChannelWPEDereverberationFeature::~SingleChannelWPEDereverberationFeature(
   gsl_vector_complex_free(r_);
 
   for (SamplesIterator_ itr = yn_.begin(); itr != yn_.end(); itr++)
-    gsl_vector_complex_free(*itr);
+    gsl_vector_complex_aligned_free(*itr);
   yn_.clear();
 }
 
+void SingleChannelWPEDereverberationFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorComplexFeatureStream::memory_buffers_(usage);
+
+  size_t bytes = 0;
+  for (unsigned frameX = 0; frameX < yn_.size(); frameX++)
+    bytes += MemoryUsage::bytes(yn_[frameX]);
+  usage.add("observations", bytes);
+  usage.add("weights", MemoryUsage::bytes(thetan_));
+
+  bytes = 0;
+  for (unsigned n = 0; n < size(); n++)
+    bytes += MemoryUsage::bytes(gn_[n]);
+  usage.add("filters", bytes);
+  usage.add("correlation", MemoryUsage::bytes(R_) + MemoryUsage::bytes(r_) + MemoryUsage::bytes(lag_samples_));
+}
+
 const gsl_vector_complex* SingleChannelWPEDereverberationFeature::get_lags_(unsigned subbandX, unsigned sampleX)
 {
   static const gsl_complex zero_ = gsl_complex_rect(0.0, 0.0);
@@ -83,7 +103,7 @@ void SingleChannelWPEDereverberationFeature::fill_buffer_(int start_frame_no, in
       } catch (jiterator_error& e) {
         break;
       }
-      gsl_vector_complex* sample = gsl_vector_complex_alloc(size());
+      gsl_vector_complex* sample = gsl_vector_complex_aligned_alloc(size());
       gsl_vector_complex_memcpy(sample, block);
       yn_.push_back(sample);
     }
@@ -103,13 +123,8 @@ void SingleChannelWPEDereverberationFeature::calc_Rr_(unsigned subbandX)
     double thetan = gsl_matrix_get(thetan_, sampleX, subbandX);
     const gsl_vector_complex* lags = get_lags_(subbandX, sampleX - lowerN_);
     for (unsigned rowX = 0; rowX < predictionN_; rowX++) {
-      gsl_complex rowS = gsl_vector_complex_get(lags, rowX);
-      for (unsigned colX = 0; colX <= rowX; colX++) {
-        gsl_complex colS = gsl_vector_complex_get(lags, colX);
-        gsl_complex val = gsl_matrix_complex_get(R_, rowX, colX);
-        val = gsl_complex_add(val, gsl_complex_div_real(gsl_complex_mul(rowS, gsl_complex_conjugate(colS)), thetan));
-        gsl_matrix_complex_set(R_, rowX, colX, val);
-      }
+      gsl_complex rowS = gsl_complex_div_real(gsl_vector_complex_get(lags, rowX), thetan);
+      ComplexKernels::axpy_conj(rowX + 1, rowS, ComplexKernels::data(lags), ComplexKernels::row(R_, rowX));
     }
   }
 
@@ -128,11 +143,7 @@ void SingleChannelWPEDereverberationFeature::calc_Rr_(unsigned subbandX)
     double dist = gsl_complex_abs(diff);
     optimization += dist * dist / thetan + log(thetan);
 
-    for (unsigned lagX = 0; lagX < predictionN_; lagX++) {
-      gsl_complex val = gsl_vector_complex_get(r_, lagX);
-      val = gsl_complex_add(val, gsl_complex_div_real(gsl_complex_mul(gsl_complex_conjugate(current), gsl_vector_complex_get(lags, lagX)), thetan));
-      gsl_vector_complex_set(r_, lagX, val);
-    }
+    ComplexKernels::axpy(predictionN_, gsl_complex_div_real(gsl_complex_conjugate(current), thetan), ComplexKernels::data(lags), ComplexKernels::data(r_));
     sampleX++;
   }
 
@@ -190,6 +201,7 @@ void SingleChannelWPEDereverberationFeature::estimate_Gn_()
     for (unsigned subbandX = 0; subbandX < size(); subbandX++) {
 
       if ((subbandX > lower_bandWidthN_) && (subbandX < upper_bandWidthN_)) continue;
+      if (range_.in_band(subbandX) == false) continue;
 
       calc_Rr_(subbandX);
       load_R_();
@@ -215,9 +227,11 @@ unsigned SingleChannelWPEDereverberationFeature::estimate_filter(int start_frame
   fill_buffer_(start_frame_no, end_frame_no);
   estimate_Gn_();
   samples_->reset();
+  // record the peak of the observation buffer
+  memory_usage();
   // clear the observation buffer (will be used for testing in next())
   for (SamplesIterator_ itr = yn_.begin(); itr != yn_.end(); itr++)
-    gsl_vector_complex_free(*itr);
+    gsl_vector_complex_aligned_free(*itr);
   yn_.clear();
   estimated_ = true;
 
@@ -245,11 +259,11 @@ const gsl_vector_complex* SingleChannelWPEDereverberationFeature::next(int frame
     throw jiterator_error("end of samples!");
   }
 
-  gsl_vector_complex* current = gsl_vector_complex_alloc(size());
+  gsl_vector_complex* current = gsl_vector_complex_aligned_alloc(size());
   gsl_vector_complex_memcpy(current, block);
   // push the current frame to the buffer
   if (yn_.size() >= predictionN_) {
-    gsl_vector_complex_free(yn_.front()); // free the old frame to keep the buffer size minimum
+    gsl_vector_complex_aligned_free(yn_.front()); // free the old frame to keep the buffer size minimum
     for (unsigned lagX = 1; lagX < predictionN_; lagX++)
       yn_[lagX - 1] = yn_[lagX];
     yn_[predictionN_ - 1] = current;
@@ -257,9 +271,13 @@ const gsl_vector_complex* SingleChannelWPEDereverberationFeature::next(int frame
   else
     yn_.push_back(current);
 
+  bool skip = (deadline_.is_null() == false) && deadline_->fallback(deadlineX_);
   for (unsigned subbandX = 0; subbandX <= size()/2; subbandX++) {
     gsl_complex cur = gsl_vector_complex_get(current, subbandX);
-    if ((frame_no_ >= lowerN_) && ((subbandX <= lower_bandWidthN_) || (subbandX >= upper_bandWidthN_))) {
+    if (range_.in_band(subbandX) == false) {
+      if (range_.mode() == ZERO_OUT_OF_BAND) cur = gsl_complex_rect(0.0, 0.0);
+    }
+    else if ((skip == false) && (frame_no_ >= lowerN_) && ((subbandX <= lower_bandWidthN_) || (subbandX >= upper_bandWidthN_))) {
       gsl_complex dereverb;
       const gsl_vector_complex* lags = get_lags_(subbandX, yn_.size() - 1 - lowerN_);
       gsl_blas_zdotc(gn_[subbandX], lags, &dereverb);
@@ -270,6 +288,7 @@ const gsl_vector_complex* SingleChannelWPEDereverberationFeature::next(int frame
     if ( subbandX > 0 && subbandX < size()/2 )
       gsl_vector_complex_set(vector_, size() - subbandX, gsl_complex_conjugate(cur));
   }
+  if (deadline_.is_null() == false) deadline_->done(deadlineX_);
 
   return vector_;
 }
@@ -289,7 +308,7 @@ void SingleChannelWPEDereverberationFeature::reset()
   samples_->reset();  VectorComplexFeatureStream::reset();
 
   for (SamplesIterator_ itr = yn_.begin(); itr != yn_.end(); itr++)
-    gsl_vector_complex_free(*itr);
+    gsl_vector_complex_aligned_free(*itr);
   yn_.clear();
 }
 
@@ -306,6 +325,31 @@ void SingleChannelWPEDereverberationFeature::next_speaker()
     gsl_vector_complex_set_zero(gn_[n]);
 }
 
+void SingleChannelWPEDereverberationFeature::save_state(const String& fileName) const
+{
+  StateWriter writer("SingleChannelWPEDereverberationFeature");
+  writer.write("subbandsN", int(size()));
+  writer.write("lowerN", int(lowerN_));
+  writer.write("upperN", int(upperN_));
+  writer.write("estimated", int(estimated_));
+  for (unsigned n = 0; n < size(); n++)
+    writer.write("gn", gn_[n]);
+  writer.save(fileName);
+}
+
+void SingleChannelWPEDereverberationFeature::load_state(const String& fileName)
+{
+  StateReader reader(fileName, "SingleChannelWPEDereverberationFeature");
+  reader.check("subbandsN", size());
+  reader.check("lowerN", lowerN_);
+  reader.check("upperN", upperN_);
+  bool estimated = reader.read_int("estimated");
+  for (unsigned n = 0; n < size(); n++)
+    reader.read("gn", gn_[n]);
+  reader.commit();
+  estimated_ = estimated;
+}
+
 
 // ----- methods for class `MultiChannelWPEDereverberation' -----
 //
@@ -313,12 +357,12 @@ MultiChannelWPEDereverberation::MultiChannelWPEDereverberation(unsigned subbands
   : sources_(0), subbandsN_(subbandsN), channelsN_(channelsN),
     lowerN_(lowerN), upperN_(upperN), predictionN_(upperN_ - lowerN_ + 1), iterationsN_(iterationsN), totalPredictionN_(predictionN_ * channelsN_),
     estimated_(false), framesN_(0), load_factor_(pow(10.0, loadDb / 10.0)),
-    lower_bandWidthN_(set_band_width_(bandWidth, sampleRate)), upper_bandWidthN_(size() - lower_bandWidthN_),
+    lower_bandWidthN_(set_band_width_(bandWidth, sampleRate)), upper_bandWidthN_(size() - lower_bandWidthN_), range_(size()),
     thetan_(new gsl_matrix*[channelsN_]), Gn_(new gsl_vector_complex**[channelsN]),
     R_(new gsl_matrix_complex*[channelsN_]), r_(new gsl_vector_complex*[channelsN_]), lag_samples_(gsl_vector_complex_alloc(totalPredictionN_)),
     output_(new gsl_vector_complex*[channelsN]), initial_frame_no_(-1), frame_no_(initial_frame_no_),
     diagonal_bias_(diagonal_bias),
-    printing_subbandX_(-1)
+    printing_subbandX_(-1), deadline_(NULL), deadlineX_(0)
 {
   for (unsigned channelX = 0; channelX < channelsN_; channelX++) {
     thetan_[channelX] = NULL;
@@ -358,6 +402,32 @@ MultiChannelWPEDereverberation::~MultiChannelWPEDereverberation()
   gsl_vector_complex_free(lag_samples_);
 }
 
+const MemoryUsage& MultiChannelWPEDereverberation::memory_usage() const
+{
+  memory_.begin();
+
+  size_t bytes = 0;
+  for (unsigned lagX = 0; lagX < frames_.size(); lagX++)
+    for (unsigned channelX = 0; channelX < frames_[lagX].size(); channelX++)
+      bytes += MemoryUsage::bytes(frames_[lagX][channelX]);
+  memory_.add("frames", bytes);
+
+  size_t weights = 0, filters = 0, correlation = MemoryUsage::bytes(lag_samples_), output = 0;
+  for (unsigned channelX = 0; channelX < channelsN_; channelX++) {
+    weights     += MemoryUsage::bytes(thetan_[channelX]);
+    for (unsigned subbandX = 0; subbandX < subbandsN_; subbandX++)
+      filters   += MemoryUsage::bytes(Gn_[channelX][subbandX]);
+    correlation += MemoryUsage::bytes(R_[channelX]) + MemoryUsage::bytes(r_[channelX]);
+    output      += MemoryUsage::bytes(output_[channelX]);
+  }
+  memory_.add("weights", weights);
+  memory_.add("filters", filters);
+  memory_.add("correlation", correlation);
+  memory_.add("output", output);
+
+  return memory_;
+}
+
 unsigned MultiChannelWPEDereverberation::set_band_width_(double bandWidth, double sampleRate)
 {
   if (bandWidth == 0.0) return (size() / 2);
@@ -378,7 +448,7 @@ void MultiChannelWPEDereverberation::reset()
   for (FrameBraceListIterator_ itr = frames_.begin(); itr != frames_.end(); itr++) {
     FrameBrace_& fbrace(*itr);
     for (FrameBraceIterator_ fitr = fbrace.begin(); fitr != fbrace.end(); fitr++) {
-      gsl_vector_complex_free(*fitr);
+      gsl_vector_complex_aligned_free(*fitr);
     }
   }
   frames_.clear();
@@ -392,7 +462,7 @@ void MultiChannelWPEDereverberation::reset_filter()
   for (FrameBraceListIterator_ itr = frames_.begin(); itr != frames_.end(); itr++) {
     FrameBrace_& fbrace(*itr);
     for (FrameBraceIterator_ fitr = fbrace.begin(); fitr != fbrace.end(); fitr++) {
-      gsl_vector_complex_free(*fitr);
+      gsl_vector_complex_aligned_free(*fitr);
     }
   }
   frames_.clear();
@@ -417,11 +487,13 @@ unsigned MultiChannelWPEDereverberation::estimate_filter(int start_frame_no, int
   // reset the input feature
   for (SourceListIterator_ itr = sources_.begin(); itr != sources_.end(); itr++)
     (*itr)->reset();
+  // record the peak of the observation buffer
+  memory_usage();
   // clear the observation buffer (will be used for testing in next())
   for (FrameBraceListIterator_ itr = frames_.begin(); itr != frames_.end(); itr++) {
     FrameBrace_& fbrace(*itr);
     for (FrameBraceIterator_ fitr = fbrace.begin(); fitr != fbrace.end(); fitr++) {
-      gsl_vector_complex_free(*fitr);
+      gsl_vector_complex_aligned_free(*fitr);
     }
   }
   frames_.clear();
@@ -462,7 +534,7 @@ gsl_vector_complex** MultiChannelWPEDereverberation::calc_every_channel_output(i
     } catch (jiterator_error& e) {
       throw jiterator_error("end of samples!");
     }
-    gsl_vector_complex* samples = gsl_vector_complex_alloc(size());
+    gsl_vector_complex* samples = gsl_vector_complex_aligned_alloc(size());
     gsl_vector_complex_memcpy(samples, block);
     fbrace[channelsX] = samples;
   }
@@ -472,7 +544,7 @@ gsl_vector_complex** MultiChannelWPEDereverberation::calc_every_channel_output(i
     // free the old frame to keep the buffer size minimum
     FrameBrace_& hook(frames_.front());
     for (FrameBraceIterator_ fitr = hook.begin(); fitr != hook.end(); fitr++)
-      gsl_vector_complex_free(*fitr);
+      gsl_vector_complex_aligned_free(*fitr);
     for (unsigned lagX = 1; lagX < predictionN_; lagX++)
       frames_[lagX - 1] = frames_[lagX];
     frames_[predictionN_ - 1] = fbrace;
@@ -481,11 +553,15 @@ gsl_vector_complex** MultiChannelWPEDereverberation::calc_every_channel_output(i
     frames_.push_back(fbrace);
 
   // generate dereverberated output for *all* channels
+  bool skip = (deadline_.is_null() == false) && deadline_->fallback(deadlineX_);
   for (unsigned channelsX = 0; channelsX < channelsN_; channelsX++ ) {
     const gsl_vector_complex* current = fbrace[channelsX];
     for (unsigned subbandX = 0; subbandX <= size()/2; subbandX++) {
       gsl_complex cur = gsl_vector_complex_get(current, subbandX);
-      if ((frame_no_ >= lowerN_) && ((subbandX <= lower_bandWidthN_) || (subbandX >= upper_bandWidthN_))) {
+      if (range_.in_band(subbandX) == false) {
+        if (range_.mode() == ZERO_OUT_OF_BAND) cur = gsl_complex_rect(0.0, 0.0);
+      }
+      else if ((skip == false) && (frame_no_ >= lowerN_) && ((subbandX <= lower_bandWidthN_) || (subbandX >= upper_bandWidthN_))) {
         gsl_complex dereverb;
         const gsl_vector_complex* lags = get_lags_(subbandX, frames_.size() - 1 - lowerN_);
         gsl_blas_zdotc(Gn_[channelsX][subbandX], lags, &dereverb);
@@ -496,6 +572,7 @@ gsl_vector_complex** MultiChannelWPEDereverberation::calc_every_channel_output(i
          gsl_vector_complex_set(output_[channelsX], size() - subbandX, gsl_complex_conjugate(cur));
     }
   }
+  if (deadline_.is_null() == false) deadline_->done(deadlineX_);
 
   return output_;
 }
@@ -519,7 +596,7 @@ void MultiChannelWPEDereverberation::fill_buffer_(int start_frame_no, int end_fr
           end_frame_no = 0; // break the frame buffering loop
           goto MCWPED_fill_buffer_endloop;
         }
-        gsl_vector_complex* sample = gsl_vector_complex_alloc(size());
+        gsl_vector_complex* sample = gsl_vector_complex_aligned_alloc(size());
         gsl_vector_complex_memcpy(sample, block);
         fbrace[channelX] = sample;
       }
@@ -564,13 +641,8 @@ void MultiChannelWPEDereverberation::calc_Rr_(unsigned subbandX)
       double thetan = gsl_matrix_get(thetan_[channelX], sampleX, subbandX);
       const gsl_vector_complex* lags = get_lags_(subbandX, sampleX - lowerN_);
       for (unsigned rowX = 0; rowX < totalPredictionN_; rowX++) {
-        gsl_complex rowS = gsl_vector_complex_get(lags, rowX);
-        for (unsigned colX = 0; colX <= rowX; colX++) {
-          gsl_complex colS = gsl_vector_complex_get(lags, colX);
-          gsl_complex val = gsl_matrix_complex_get(R, rowX, colX);
-          val = gsl_complex_add(val, gsl_complex_div_real(gsl_complex_mul(rowS, gsl_complex_conjugate(colS)), thetan));
-          gsl_matrix_complex_set(R, rowX, colX, val);
-        }
+        gsl_complex rowS = gsl_complex_div_real(gsl_vector_complex_get(lags, rowX), thetan);
+        ComplexKernels::axpy_conj(rowX + 1, rowS, ComplexKernels::data(lags), ComplexKernels::row(R, rowX));
       }
     }
     // adding the diagonal bias to avoid the invertible matrix
@@ -600,11 +672,7 @@ void MultiChannelWPEDereverberation::calc_Rr_(unsigned subbandX)
       double dist = gsl_complex_abs(diff);
       optimization += dist * dist / thetan + log(thetan);
 
-      for (unsigned lagX = 0; lagX < totalPredictionN_; lagX++) {
-        gsl_complex val = gsl_vector_complex_get(r, lagX);
-        val = gsl_complex_add(val, gsl_complex_div_real(gsl_complex_mul(gsl_complex_conjugate(current), gsl_vector_complex_get(lags, lagX)), thetan));
-        gsl_vector_complex_set(r, lagX, val);
-      }
+      ComplexKernels::axpy(totalPredictionN_, gsl_complex_div_real(gsl_complex_conjugate(current), thetan), ComplexKernels::data(lags), ComplexKernels::data(r));
       sampleX++;
     }
 
@@ -669,6 +737,7 @@ void MultiChannelWPEDereverberation::estimate_Gn_()
     for (unsigned subbandX = 0; subbandX < size(); subbandX++) {
 
       if ((subbandX > lower_bandWidthN_) && (subbandX < upper_bandWidthN_)) continue;
+      if (range_.in_band(subbandX) == false) continue;
 
       calc_Rr_(subbandX);
       load_R_();
@@ -697,6 +766,35 @@ void MultiChannelWPEDereverberation::next_speaker()
       gsl_vector_complex_set_zero(Gn_[channelX][n]);
 }
 
+void MultiChannelWPEDereverberation::save_state(const String& fileName) const
+{
+  StateWriter writer("MultiChannelWPEDereverberation");
+  writer.write("subbandsN", int(subbandsN_));
+  writer.write("channelsN", int(channelsN_));
+  writer.write("lowerN", int(lowerN_));
+  writer.write("upperN", int(upperN_));
+  writer.write("estimated", int(estimated_));
+  for (unsigned channelX = 0; channelX < channelsN_; channelX++)
+    for (unsigned n = 0; n < subbandsN_; n++)
+      writer.write("Gn", Gn_[channelX][n]);
+  writer.save(fileName);
+}
+
+void MultiChannelWPEDereverberation::load_state(const String& fileName)
+{
+  StateReader reader(fileName, "MultiChannelWPEDereverberation");
+  reader.check("subbandsN", subbandsN_);
+  reader.check("channelsN", channelsN_);
+  reader.check("lowerN", lowerN_);
+  reader.check("upperN", upperN_);
+  bool estimated = reader.read_int("estimated");
+  for (unsigned channelX = 0; channelX < channelsN_; channelX++)
+    for (unsigned n = 0; n < subbandsN_; n++)
+      reader.read("Gn", Gn_[channelX][n]);
+  reader.commit();
+  estimated_ = estimated;
+}
+
 
 // ----- methods for class `MultiChannelWPEDereverberationFeature' -----
 //
@@ -708,6 +806,14 @@ MultiChannelWPEDereverberationFeature(MultiChannelWPEDereverberationPtr& source,
 
 MultiChannelWPEDereverberationFeature::~MultiChannelWPEDereverberationFeature() { }
 
+// the shared dereverberation is counted with the primary channel
+void MultiChannelWPEDereverberationFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorComplexFeatureStream::memory_buffers_(usage);
+  if (channelX_ == primaryChannelX_)
+    usage.merge("dereverberation", source_->memory_usage());
+}
+
 /**
    @breif return the dereveberated output for a specified channel
  */
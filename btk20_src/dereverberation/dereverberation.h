@@ -19,6 +19,8 @@
 #include "common/jexception.h"
 
 #include "stream/stream.h"
+#include "stream/subband_range.h"
+#include "stream/deadline_scheduler.h"
 #include "feature/feature.h"
 
 /*
@@ -46,6 +48,18 @@ class SingleChannelWPEDereverberationFeature : public VectorComplexFeatureStream
   void next_speaker();
   void print_objective_func(int subbandX){ printing_subbandX_ = subbandX;}
 
+  // checkpoint the prediction filters; loading them makes estimate_filter() unnecessary
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
+
+  // estimate and apply the prediction filters only in the bins lower..upper; the other bins pass the observation unless 'mode' is ZERO_OUT_OF_BAND
+  void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND){ range_.set_range(lower, upper, mode); }
+  void set_bin_mask(const gsl_vector* mask){ range_.set_mask(mask); }
+  void clear_bin_range(){ range_.clear(); }
+
+  // pass the observation through without the prediction in the frames in which 'sched' reports the deadline at risk
+  void set_deadline_scheduler(const DeadlineSchedulerPtr& sched, const String& nm = "WPE"){ deadline_ = sched;  deadlineX_ = deadline_->add_stage(nm); }
+
 #ifdef ENABLE_LEGACY_BTK_API
   void nextSpeaker(){ next_speaker(); }
 #endif
@@ -53,6 +67,7 @@ class SingleChannelWPEDereverberationFeature : public VectorComplexFeatureStream
 private:
   static const double					subband_floor_;
 
+  virtual void memory_buffers_(MemoryUsage& usage) const;
   void fill_buffer_(int start_frame_no, int frame_num);
   void estimate_Gn_();
   void calc_Rr_(unsigned subbandX);
@@ -72,6 +87,7 @@ private:
   const double						load_factor_;
   const unsigned					lower_bandWidthN_;
   const unsigned					upper_bandWidthN_;
+  SubbandRange						range_;
 
   Samples_						yn_; // buffer to keep observations
   gsl_matrix*						thetan_;
@@ -80,6 +96,8 @@ private:
   gsl_vector_complex*					r_;
   gsl_vector_complex*					lag_samples_;
   int                                                   printing_subbandX_;
+  DeadlineSchedulerPtr					deadline_;
+  unsigned						deadlineX_;
 };
 
 typedef Inherit<SingleChannelWPEDereverberationFeature, VectorComplexFeatureStreamPtr> SingleChannelWPEDereverberationFeaturePtr;
@@ -113,6 +131,21 @@ class MultiChannelWPEDereverberation : public Countable {
   int  frame_no() const { return frame_no_; }
   void print_objective_func(int subbandX){ printing_subbandX_ = subbandX;}
 
+  // bytes held by the frame buffer, the filters and the correlation matrices, now and at most over the calls
+  const MemoryUsage& memory_usage() const;
+
+  // checkpoint the prediction filters; loading them makes estimate_filter() unnecessary
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
+
+  // estimate and apply the prediction filters only in the bins lower..upper; the other bins pass the observation unless 'mode' is ZERO_OUT_OF_BAND
+  void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND){ range_.set_range(lower, upper, mode); }
+  void set_bin_mask(const gsl_vector* mask){ range_.set_mask(mask); }
+  void clear_bin_range(){ range_.clear(); }
+
+  // pass the observation through without the prediction in the frames in which 'sched' reports the deadline at risk
+  void set_deadline_scheduler(const DeadlineSchedulerPtr& sched, const String& nm = "WPE"){ deadline_ = sched;  deadlineX_ = deadline_->add_stage(nm); }
+
 #ifdef ENABLE_LEGACY_BTK_API
   void setInput(VectorComplexFeatureStreamPtr& samples){ set_input(samples); }
   const gsl_vector_complex* getOutput(unsigned channelX, int frame_no = -5){ return get_output(channelX); }
@@ -146,6 +179,7 @@ private:
   const double						load_factor_;
   const unsigned					lower_bandWidthN_;
   const unsigned					upper_bandWidthN_;
+  SubbandRange						range_;
 
   FrameBraceList_					frames_;
   gsl_matrix**						thetan_;
@@ -160,6 +194,9 @@ private:
 
   const double                                          diagonal_bias_;
   int                                                   printing_subbandX_;
+  DeadlineSchedulerPtr					deadline_;
+  unsigned						deadlineX_;
+  mutable MemoryUsage					memory_;
 };
 
 typedef refcountable_ptr<MultiChannelWPEDereverberation> MultiChannelWPEDereverberationPtr;
@@ -177,6 +214,8 @@ public:
   virtual void reset();
 
 private:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   MultiChannelWPEDereverberationPtr			source_;
   const unsigned					channelX_;
   const unsigned					primaryChannelX_; // compute the dereverbed output only when channelX_ == primaryChannelX_. Otherwise copy the precomputed output
@@ -60,6 +60,12 @@ class SingleChannelWPEDereverberationFeature : public VectorComplexFeatureStream
   void next_speaker();
   unsigned estimate_filter(int start_frame_no = 0, int frame_num = -1);
   void print_objective_func(int subband_no);
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
+  void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND);
+  void set_bin_mask(const gsl_vector* mask);
+  void clear_bin_range();
+  void set_deadline_scheduler(const DeadlineSchedulerPtr& sched, const String& nm = "WPE");
 
 #ifdef ENABLE_LEGACY_BTK_API
   void nextSpeaker();
@@ -123,6 +129,13 @@ public:
   void next_speaker();
   void print_objective_func(int subband_no);
   int frame_no() const;
+  const MemoryUsage& memory_usage() const;
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
+  void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND);
+  void set_bin_mask(const gsl_vector* mask);
+  void clear_bin_range();
+  void set_deadline_scheduler(const DeadlineSchedulerPtr& sched, const String& nm = "WPE");
 
 #ifdef ENABLE_LEGACY_BTK_API
   void setInput(VectorComplexFeatureStreamPtr& samples);
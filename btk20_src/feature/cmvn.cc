@@ -0,0 +1,410 @@
+/*
+ * @file cmvn.cc
+ * @brief Cepstral mean and variance normalization with statistics accumulated over a corpus.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include "common/mach_ind_io.h"
+#include "feature/cmvn.h"
+#include "feature/frame_kernels.h"
+
+
+// ----- methods for class `CMVNStatistics' -----
+//
+const char* CMVNStatistics::Magic       = "BTK-CMVN-STATS-2";
+const char* CMVNStatistics::MagicSingle = "BTK-CMVN-STATS-1";
+
+CMVNStatistics::CMVNStatistics(unsigned dim)
+  : dim_(dim) { }
+
+CMVNStatistics::Stats_& CMVNStatistics::stats_for_(const String& key)
+{
+  _StatsMap::iterator itr = stats_.find(key);
+  if (itr == stats_.end())
+    itr = stats_.insert(_StatsMap::value_type(key, Stats_(dim_))).first;
+
+  return itr->second;
+}
+
+double CMVNStatistics::count(const String& key) const
+{
+  _StatsMap::const_iterator itr = stats_.find(key);
+  if (itr == stats_.end())
+    throw jkey_error("No CMVN statistics for key '%s'.", key.c_str());
+
+  return itr->second.count_;
+}
+
+void CMVNStatistics::accumulate(const gsl_vector_float* frame, const String& key, double wgt)
+{
+  if (frame->size != dim_)
+    throw jdimension_error("Frame size (%d) does not match CMVN dimension (%d).", frame->size, dim_);
+
+  Stats_& stats = stats_for_(key);
+  stats.count_ += wgt;
+  for (unsigned i = 0; i < dim_; i++) {
+    double f = gsl_vector_float_get(frame, i);
+    stats.sum_[i]   += wgt * f;
+    stats.sumsq_[i] += wgt * f * f;
+  }
+}
+
+unsigned CMVNStatistics::accumulate(const VectorFloatFeatureStreamPtr& src, const String& key,
+				    const VectorFloatFeatureStreamPtr& weight)
+{
+  src->reset();
+  if (weight.is_null() == false) weight->reset();
+
+  int frame_no = 0;
+  while (true) {
+    try {
+      const gsl_vector_float* srcVec = src->next(frame_no);
+      double                  wgt    = 1.0;
+      if (weight.is_null() == false)
+	wgt = gsl_vector_float_get(weight->next(frame_no), 0);
+      accumulate(srcVec, key, wgt);
+      frame_no++;
+    } catch (jiterator_error& e) {
+      break;
+    } catch (j_error& e) {
+      if (e.getCode() == JITERATOR) break;
+      throw;
+    }
+  }
+
+  return frame_no;
+}
+
+void CMVNStatistics::merge(const CMVNStatistics& other)
+{
+  if (other.dim_ != dim_)
+    throw jdimension_error("Cannot merge CMVN statistics of dimension %d into %d.", other.dim_, dim_);
+
+  for (_StatsMap::const_iterator itr = other.stats_.begin(); itr != other.stats_.end(); itr++) {
+    Stats_& stats = stats_for_(itr->first);
+    stats.count_ += itr->second.count_;
+    for (unsigned i = 0; i < dim_; i++) {
+      stats.sum_[i]   += itr->second.sum_[i];
+      stats.sumsq_[i] += itr->second.sumsq_[i];
+    }
+  }
+}
+
+void CMVNStatistics::mean_variance(const String& key, gsl_vector_float* mean, gsl_vector_float* variance) const
+{
+  _StatsMap::const_iterator itr = stats_.find(key);
+  if (itr == stats_.end())
+    throw jkey_error("No CMVN statistics for key '%s'.", key.c_str());
+  if (mean->size != dim_ || (variance != NULL && variance->size != dim_))
+    throw jdimension_error("Mean or variance vector does not have CMVN dimension (%d).", dim_);
+
+  const Stats_& stats = itr->second;
+  if (stats.count_ <= 0.0)
+    throw jconsistency_error("Total weight for key '%s' is %g.", key.c_str(), stats.count_);
+
+  for (unsigned i = 0; i < dim_; i++) {
+    double m = stats.sum_[i] / stats.count_;
+    gsl_vector_float_set(mean, i, m);
+    if (variance != NULL)
+      gsl_vector_float_set(variance, i, stats.sumsq_[i] / stats.count_ - m * m);
+  }
+}
+
+// a double as its IEEE bits, most significant word first; 'write_int' takes care of the byte order
+static void write_double_(FILE* fp, double val)
+{
+  uint64_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  write_int(fp, int(uint32_t(bits >> 32)));
+  write_int(fp, int(uint32_t(bits)));
+}
+
+static double read_double_(FILE* fp)
+{
+  uint64_t bits = uint64_t(uint32_t(read_int(fp))) << 32;
+  bits |= uint32_t(read_int(fp));
+  double val;
+  memcpy(&val, &bits, sizeof(val));
+  return val;
+}
+
+// File layout (mach_ind_io):
+//   magic string, dimension, number of keys,
+//   then per key: key string, total weight, 'dim' means and 'dim' variances as doubles.
+// Files of the first version hold the integral and fractional part of the total
+// weight instead, and the means and variances as floats; 'read()' accepts them.
+void CMVNStatistics::write(const String& fileName) const
+{
+  FILE* fp = btk_fopen(fileName, "w");
+
+  write_string(fp, Magic);
+  write_int(fp, dim_);
+  write_int(fp, stats_.size());
+
+  for (_StatsMap::const_iterator itr = stats_.begin(); itr != stats_.end(); itr++) {
+    const Stats_& stats = itr->second;
+
+    write_string(fp, itr->first.c_str());
+    write_double_(fp, stats.count_);
+
+    for (unsigned i = 0; i < dim_; i++)
+      write_double_(fp, (stats.count_ > 0.0) ? stats.sum_[i] / stats.count_ : 0.0);
+    for (unsigned i = 0; i < dim_; i++) {
+      double m = (stats.count_ > 0.0) ? stats.sum_[i] / stats.count_ : 0.0;
+      write_double_(fp, (stats.count_ > 0.0) ? stats.sumsq_[i] / stats.count_ - m * m : 0.0);
+    }
+  }
+
+  btk_fclose(fileName, fp);
+}
+
+void CMVNStatistics::read(const String& fileName)
+{
+  char buffer[32768 + 1];
+
+  FILE* fp = btk_fopen(fileName, "r");
+
+  bool single = false;
+  if (read_string(fp, buffer) == 0 || (strcmp(buffer, Magic) != 0 && (single = (strcmp(buffer, MagicSingle) == 0)) == false)) {
+    btk_fclose(fileName, fp);
+    throw jio_error("'%s' is not a CMVN statistics file.", fileName.c_str());
+  }
+  unsigned dim = read_int(fp);
+  if (dim != dim_) {
+    btk_fclose(fileName, fp);
+    throw jdimension_error("CMVN statistics in '%s' have dimension %d, expected %d.", fileName.c_str(), dim, dim_);
+  }
+
+  unsigned       keysN = read_int(fp);
+  vector<double> mean(dim_), variance(dim_);
+  vector<float>  singles(dim_);
+  for (unsigned keyX = 0; keyX < keysN; keyX++) {
+    if (read_string(fp, buffer) == 0) {
+      btk_fclose(fileName, fp);
+      throw jio_error("Premature end of CMVN statistics file '%s'.", fileName.c_str());
+    }
+    double count;
+    if (single) {
+      count  = read_int(fp);
+      count += read_float(fp);
+      bool complete = (read_floats(fp, &singles[0], dim_) == int(dim_));
+      mean.assign(singles.begin(), singles.end());
+      complete = complete && (read_floats(fp, &singles[0], dim_) == int(dim_));
+      variance.assign(singles.begin(), singles.end());
+      if (complete == false) {
+	btk_fclose(fileName, fp);
+	throw jio_error("Premature end of CMVN statistics file '%s'.", fileName.c_str());
+      }
+    } else {
+      count = read_double_(fp);
+      for (unsigned i = 0; i < dim_; i++)
+	mean[i] = read_double_(fp);
+      for (unsigned i = 0; i < dim_; i++)
+	variance[i] = read_double_(fp);
+    }
+    if (feof(fp) || ferror(fp)) {
+      btk_fclose(fileName, fp);
+      throw jio_error("Premature end of CMVN statistics file '%s'.", fileName.c_str());
+    }
+
+    Stats_& stats = stats_for_(buffer);
+    stats.count_ += count;
+    for (unsigned i = 0; i < dim_; i++) {
+      stats.sum_[i]   += count * mean[i];
+      stats.sumsq_[i] += count * (variance[i] + mean[i] * mean[i]);
+    }
+  }
+
+  btk_fclose(fileName, fp);
+}
+
+
+// ----- methods for class `CMVNAccumulator' -----
+//
+CMVNAccumulator::CMVNAccumulator(unsigned dim, unsigned threadsN)
+  : dim_(dim), threadsN_(threadsN == 0 ? 1 : threadsN), nextJobX_(0)
+{
+  pthread_mutex_init(&mutex_, NULL);
+}
+
+CMVNAccumulator::~CMVNAccumulator()
+{
+  pthread_mutex_destroy(&mutex_);
+}
+
+void CMVNAccumulator::add(const VectorFloatFeatureStreamPtr& src, const String& key,
+			  const VectorFloatFeatureStreamPtr& weight)
+{
+  if (src->size() != dim_)
+    throw jdimension_error("Stream '%s' has size %d, expected %d.", src->name().c_str(), src->size(), dim_);
+
+  jobs_.push_back(Job_(src, key, weight));
+}
+
+void* CMVNAccumulator::worker_(void* arg)
+{
+  ((CMVNAccumulator*) arg)->work_();
+  return NULL;
+}
+
+void CMVNAccumulator::work_()
+{
+  CMVNStatistics local(dim_);
+
+  while (true) {
+    pthread_mutex_lock(&mutex_);
+    unsigned jobX = nextJobX_++;
+    bool     stop = (jobX >= jobs_.size() || error_ != "");
+    pthread_mutex_unlock(&mutex_);
+    if (stop) break;
+
+    // no exception may leave a thread; 'run()' raises the error once all have been joined
+    try {
+      local.accumulate(jobs_[jobX].src_, jobs_[jobX].key_, jobs_[jobX].weight_);
+    } catch (std::exception& e) {
+      fail_(e.what());
+      break;
+    } catch (...) {
+      fail_("unknown exception");
+      break;
+    }
+  }
+
+  pthread_mutex_lock(&mutex_);
+  try {
+    total_->merge(local);
+    pthread_mutex_unlock(&mutex_);
+  } catch (std::exception& e) {
+    pthread_mutex_unlock(&mutex_);
+    fail_(e.what());
+  } catch (...) {
+    pthread_mutex_unlock(&mutex_);
+    fail_("unknown exception");
+  }
+}
+
+void CMVNAccumulator::fail_(const char* msg)
+{
+  pthread_mutex_lock(&mutex_);
+  error_ = (*msg == '\0') ? "unknown error" : msg;
+  pthread_mutex_unlock(&mutex_);
+}
+
+CMVNStatisticsPtr CMVNAccumulator::run()
+{
+  total_    = new CMVNStatistics(dim_);
+  nextJobX_ = 0;
+  error_    = "";
+
+  unsigned threadsN = (jobs_.size() < threadsN_) ? jobs_.size() : threadsN_;
+  unsigned startedN = 0;
+  if (threadsN <= 1) {
+    work_();
+  } else {
+    vector<pthread_t> threads(threadsN);
+    for (; startedN < threadsN; startedN++)
+      if (pthread_create(&threads[startedN], NULL, worker_, this) != 0) break;
+    // the threads already running stop after their current job
+    if (startedN < threadsN) {
+      pthread_mutex_lock(&mutex_);
+      error_ = "thread creation failed";
+      pthread_mutex_unlock(&mutex_);
+    }
+    for (unsigned threadX = 0; threadX < startedN; threadX++)
+      pthread_join(threads[threadX], NULL);
+  }
+  jobs_.clear();
+
+  if (threadsN > 1 && startedN < threadsN) {
+    total_ = NULL;
+    throw jallocation_error("Could not create CMVN accumulation thread %d.", startedN);
+  }
+  if (error_ != "") {
+    total_ = NULL;
+    throw jconsistency_error("CMVN accumulation failed: %s", error_.c_str());
+  }
+
+  CMVNStatisticsPtr total(total_);
+  total_ = NULL;
+
+  return total;
+}
+
+
+// ----- methods for class `CMVNFeature' -----
+//
+const float CMVNFeature::variance_floor_ = 0.0001;
+
+CMVNFeature::
+CMVNFeature(const VectorFloatFeatureStreamPtr& src, const CMVNStatisticsPtr& stats,
+	    double devNormFactor, const String& nm)
+  : VectorFloatFeatureStream(src->size(), nm), src_(src), stats_(stats), devNormFactor_(devNormFactor),
+    mean_(new float[size()]), scale_(new float[size()])
+{
+  if (stats_->dim() != size())
+    throw jdimension_error("CMVN statistics have dimension %d, feature '%s' has %d.",
+			   stats_->dim(), src_->name().c_str(), size());
+
+  for (unsigned i = 0; i < size(); i++) {
+    mean_[i]  = 0.0;
+    scale_[i] = 1.0;
+  }
+}
+
+CMVNFeature::~CMVNFeature()
+{
+  delete[] mean_;
+  delete[] scale_;
+}
+
+void CMVNFeature::select(const String& key)
+{
+  gsl_vector_float* mean     = gsl_vector_float_alloc(size());
+  gsl_vector_float* variance = gsl_vector_float_alloc(size());
+
+  try {
+    stats_->mean_variance(key, mean, variance);
+  } catch (j_error& e) {
+    gsl_vector_float_free(mean);  gsl_vector_float_free(variance);
+    throw;
+  }
+
+  for (unsigned i = 0; i < size(); i++) {
+    mean_[i] = gsl_vector_float_get(mean, i);
+    if (devNormFactor_ > 0.0) {
+      float var = gsl_vector_float_get(variance, i);
+      if (var < variance_floor_) var = variance_floor_;
+      scale_[i] = 1.0 / (devNormFactor_ * sqrt(var));
+    } else {
+      scale_[i] = 1.0;
+    }
+  }
+  key_ = key;
+
+  gsl_vector_float_free(mean);  gsl_vector_float_free(variance);
+}
+
+const gsl_vector_float* CMVNFeature::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  if (frame_no >= 0 && frame_no - 1 != frame_no_)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
+
+  if (key_ == "")
+    throw jconsistency_error("No statistics selected for feature '%s'.", name().c_str());
+
+  const gsl_vector_float* srcVec = src_->next(frame_no_ + 1);
+  increment_();
+
+  if (srcVec->stride == 1) {
+    mean_variance_normalize(vector_->data, srcVec->data, mean_, scale_, size());
+  } else {
+    for (unsigned i = 0; i < size(); i++)
+      gsl_vector_float_set(vector_, i, (gsl_vector_float_get(srcVec, i) - mean_[i]) * scale_[i]);
+  }
+
+  return vector_;
+}
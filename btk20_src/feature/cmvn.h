@@ -0,0 +1,146 @@
+/**
+ * @file cmvn.h
+ * @brief Cepstral mean and variance normalization with statistics accumulated over a corpus.
+ */
+
+#ifndef CMVN_H
+#define CMVN_H
+
+#include <gsl/gsl_vector.h>
+#include <pthread.h>
+#include "stream/stream.h"
+#include "common/mlist.h"
+
+/**
+* \defgroup CMVN Cepstral Mean and Variance Normalization
+* Statistics are gathered for each speaker or utterance key in a first pass,
+* possibly over many utterances in parallel, stored in a compact file and
+* applied by 'CMVNFeature' in a single streaming pass.
+*/
+/*@{*/
+
+// ----- definition for class `CMVNStatistics' -----
+//
+class CMVNStatistics {
+  class Stats_ {
+  public:
+    Stats_(unsigned dim) : count_(0.0), sum_(dim, 0.0), sumsq_(dim, 0.0) { }
+
+    double					count_;
+    vector<double>				sum_;
+    vector<double>				sumsq_;
+  };
+  typedef map<String, Stats_>			_StatsMap;
+
+ public:
+  CMVNStatistics(unsigned dim);
+
+  unsigned dim() const { return dim_; }
+  unsigned keysN() const { return stats_.size(); }
+  bool has(const String& key) const { return stats_.find(key) != stats_.end(); }
+  double count(const String& key) const;
+
+  // accumulate every frame of 'src' under 'key'; returns the number of frames read
+  unsigned accumulate(const VectorFloatFeatureStreamPtr& src, const String& key,
+		      const VectorFloatFeatureStreamPtr& weight = NULL);
+  void accumulate(const gsl_vector_float* frame, const String& key, double wgt = 1.0);
+
+  void merge(const CMVNStatistics& other);
+  void clear() { stats_.clear(); }
+
+  void mean_variance(const String& key, gsl_vector_float* mean, gsl_vector_float* variance) const;
+
+  void write(const String& fileName) const;
+  // merge the statistics stored in 'fileName'
+  void read(const String& fileName);
+
+ private:
+  Stats_& stats_for_(const String& key);
+
+  static const char*				Magic;
+  static const char*				MagicSingle;	// first version, with floats
+
+  const unsigned				dim_;
+  _StatsMap					stats_;
+};
+
+typedef refcount_ptr<CMVNStatistics>		CMVNStatisticsPtr;
+
+
+// ----- definition for class `CMVNAccumulator' -----
+//
+// Runs 'CMVNStatistics::accumulate' for many (stream, key) jobs on a pool of
+// threads. Every job must own its whole stream chain; streams calling back
+// into Python cannot be used here.
+//
+class CMVNAccumulator {
+  class Job_ {
+  public:
+    Job_(const VectorFloatFeatureStreamPtr& src, const String& key, const VectorFloatFeatureStreamPtr& weight)
+      : src_(src), key_(key), weight_(weight) { }
+
+    VectorFloatFeatureStreamPtr			src_;
+    String					key_;
+    VectorFloatFeatureStreamPtr			weight_;
+  };
+
+ public:
+  CMVNAccumulator(unsigned dim, unsigned threadsN = 1);
+  ~CMVNAccumulator();
+
+  void add(const VectorFloatFeatureStreamPtr& src, const String& key,
+	   const VectorFloatFeatureStreamPtr& weight = NULL);
+  unsigned jobsN() const { return jobs_.size(); }
+
+  // process all queued jobs and return the merged statistics
+  CMVNStatisticsPtr run();
+
+ private:
+  static void* worker_(void* arg);
+  void work_();
+  void fail_(const char* msg);
+
+  const unsigned				dim_;
+  const unsigned				threadsN_;
+  vector<Job_>					jobs_;
+  unsigned					nextJobX_;
+  CMVNStatisticsPtr				total_;
+  String					error_;
+  pthread_mutex_t				mutex_;
+};
+
+typedef refcount_ptr<CMVNAccumulator>		CMVNAccumulatorPtr;
+
+
+// ----- definition for class `CMVNFeature' -----
+//
+class CMVNFeature : public VectorFloatFeatureStream {
+ public:
+  CMVNFeature(const VectorFloatFeatureStreamPtr& src, const CMVNStatisticsPtr& stats,
+	      double devNormFactor = 0.0, const String& nm = "CMVN");
+  virtual ~CMVNFeature();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+
+  virtual void reset() { src_->reset(); VectorFloatFeatureStream::reset(); }
+
+  // use the statistics of speaker or utterance 'key' from now on
+  void select(const String& key);
+  const String& selected() const { return key_; }
+
+ private:
+  static const float				variance_floor_;
+
+  VectorFloatFeatureStreamPtr			src_;
+  CMVNStatisticsPtr				stats_;
+  const double					devNormFactor_;
+  String					key_;
+  float*					mean_;
+  float*					scale_;
+};
+
+typedef Inherit<CMVNFeature, VectorFloatFeatureStreamPtr> CMVNFeaturePtr;
+
+/*@}*/
+
+#endif
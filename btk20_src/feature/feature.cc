@@ -9,6 +9,7 @@
 #include <sys/time.h>
 #include "common/mach_ind_io.h"
 #include "feature/feature.h"
+#include "feature/frame_kernels.h"
 #include <gsl/gsl_blas.h>
 #include <gsl/gsl_cblas.h>
 #include <gsl/gsl_sf.h>
@@ -235,6 +236,13 @@ SampleFeature::~SampleFeature()
     if (copy_dsamples_ != NULL) gsl_vector_free(copy_dsamples_);
 }
 
+void SampleFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorFloatFeatureStream::memory_buffers_(usage);
+  usage.add("samples", (samples_ == NULL) ? 0 : ttlsamples_ * sizeof(float));
+  usage.add("copies", MemoryUsage::bytes(copy_fsamples_) + MemoryUsage::bytes(copy_dsamples_));
+}
+
 unsigned SampleFeature::
 read(const String& fn, int format, int samplerate, int chX, int chN, int cfrom, int to, int outsamplerate, float norm)
 {
@@ -999,6 +1007,25 @@ const gsl_vector_float* BlockSizeConversionFeature::next(int frame_no)
 }
 
 
+void BlockSizeConversionFeature::describe(StreamInfo& info) const
+{
+  char signature[64];
+  sprintf(signature, "%u,%u", blockLen_, shiftLen_);
+
+  info.sources.push_back(src_.operator->());
+  info.signature = signature;
+  info.identity  = (blockLen_ == inputLen_ && shiftLen_ == inputLen_);
+  info.lockstep  = info.identity;
+}
+
+void BlockSizeConversionFeature::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(src_, src);
+}
+
+
 // ----- methods for class `BlockSizeConversionFeatureShort' -----
 //
 BlockSizeConversionFeatureShort::
@@ -1200,6 +1227,31 @@ const gsl_vector_float* HammingFeature::next(int frame_no)
 }
 
 
+void HammingFeature::describe(StreamInfo& info) const
+{
+  char signature[32];
+  sprintf(signature, "%u", windowLen_);
+
+  info.sources.push_back(samp_.operator->());
+  info.signature = signature;
+  info.flops     = windowLen_;
+  info.bytes     = windowLen_ * sizeof(double);
+}
+
+void HammingFeature::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(samp_, src);
+}
+
+void HammingFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorFloatFeatureStream::memory_buffers_(usage);
+  usage.add("window", windowLen_ * sizeof(double));
+}
+
+
 // ----- methods for class `FFTFeature' -----
 //
 FFTFeature::FFTFeature(const VectorFloatFeatureStreamPtr& samp, unsigned fftLen, const String& nm)
@@ -1258,6 +1310,38 @@ const gsl_vector_complex* FFTFeature::next(int frame_no)
 }
 
 
+void FFTFeature::describe(StreamInfo& info) const
+{
+  char signature[32];
+  sprintf(signature, "%u", fftLen_);
+
+  info.sources.push_back(samp_.operator->());
+  info.signature = signature;
+  // real transform, about half the operations of a complex one
+  info.flops     = 2.5 * fftLen_ * log2((double) fftLen_);
+  info.bytes     = fftLen_ * sizeof(double);
+#ifdef HAVE_LIBFFTW3
+  info.bytes    += (fftLen_ / 2 + 1) * sizeof(fftw_complex);
+#endif
+}
+
+void FFTFeature::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(samp_, src);
+}
+
+void FFTFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorComplexFeatureStream::memory_buffers_(usage);
+  usage.add("samples", fftLen_ * sizeof(double));
+#ifdef HAVE_LIBFFTW3
+  usage.add("spectrum", (fftLen_ / 2 + 1) * sizeof(fftw_complex));
+#endif
+}
+
+
 // ----- methods for class `SpectralPowerFloatFeature' -----
 //
 SpectralPowerFloatFeature::
@@ -1286,6 +1370,24 @@ const gsl_vector_float* SpectralPowerFloatFeature::next(int frame_no)
 }
 
 
+void SpectralPowerFloatFeature::describe(StreamInfo& info) const
+{
+  char signature[32];
+  sprintf(signature, "%u", size());
+
+  info.sources.push_back(fft_.operator->());
+  info.signature = signature;
+  info.flops     = 3.0 * size();
+}
+
+void SpectralPowerFloatFeature::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(fft_, src);
+}
+
+
 // ----- methods for class `SpectralPowerFeature' -----
 //
 SpectralPowerFeature::
@@ -1326,14 +1428,50 @@ const gsl_vector_float* SignalPowerFeature::next(int frame_no)
   const gsl_vector_float* block = samp_->next(frame_no_ + 1);
   increment_();
 
+  gsl_vector_float_set(vector_, 0, power_(block));
+
+  return vector_;
+}
+
+float SignalPowerFeature::power_(const gsl_vector_float* block) const
+{
   double power = 0.0;
-  for (unsigned i = 0; i < samp_->size(); i++) {
-    double val = gsl_vector_float_get(block, i);
-    power += val * val;
+  if (block->stride == 1) {
+    power = signal_power(block->data, samp_->size());
+  } else {
+    for (unsigned i = 0; i < samp_->size(); i++) {
+      double val = gsl_vector_float_get(block, i);
+      power += val * val;
+    }
   }
-  gsl_vector_float_set(vector_, 0, power / samp_->size() / range_);
+  return power / samp_->size() / range_;
+}
 
-  return vector_;
+unsigned SignalPowerFeature::next_block(gsl_matrix_float* block)
+{
+  if (block->size2 != size())
+    throw jdimension_error("Block has %lu columns but feature %s has size %d\n", block->size2, name().c_str(), size());
+  if (block->size1 == 0) return 0;
+
+  unsigned frameX = 0;
+  for (; frameX < block->size1; frameX++) {
+    const gsl_vector_float* samp;
+    try {
+      samp = samp_->next(frame_no_ + 1);
+    } catch (jiterator_error& e) {
+      if (frameX == 0) throw;
+      break;
+    } catch (j_error& e) {
+      if (e.getCode() != JITERATOR || frameX == 0) throw;
+      break;
+    }
+    increment_();
+
+    gsl_matrix_float_set(block, frameX, 0, power_(samp));
+  }
+  gsl_vector_float_set(vector_, 0, gsl_matrix_float_get(block, frameX - 1, 0));
+
+  return frameX;
 }
 
 
@@ -1500,6 +1638,18 @@ const gsl_vector_float* ThresholdFeature::next(int frame_no)
   const gsl_vector_float* block = samp_->next(frame_no_ + 1);
   increment_();
 
+  threshold_(block, vector_);
+
+  return vector_;
+}
+
+void ThresholdFeature::threshold_(const gsl_vector_float* block, gsl_vector_float* output) const
+{
+  if (block->stride == 1 && output->stride == 1) {
+    threshold_samples(output->data, block->data, size(), compare_, value_, thresh_);
+    return;
+  }
+
   for (unsigned i = 0; i < size(); i++) {
     double v = gsl_vector_float_get(block, i);
 
@@ -1512,10 +1662,116 @@ const gsl_vector_float* ThresholdFeature::next(int frame_no)
       if (v <= thresh_) v = value_;
     }
 
-    gsl_vector_float_set(vector_, i, v);
+    gsl_vector_float_set(output, i, v);
   }
+}
 
-  return vector_;
+unsigned ThresholdFeature::next_block(gsl_matrix_float* block)
+{
+  if (block->size2 != size())
+    throw jdimension_error("Block has %lu columns but feature %s has size %d\n", block->size2, name().c_str(), size());
+  if (block->size1 == 0) return 0;
+
+  unsigned frameX = 0;
+  for (; frameX < block->size1; frameX++) {
+    const gsl_vector_float* samp;
+    try {
+      samp = samp_->next(frame_no_ + 1);
+    } catch (jiterator_error& e) {
+      if (frameX == 0) throw;
+      break;
+    } catch (j_error& e) {
+      if (e.getCode() != JITERATOR || frameX == 0) throw;
+      break;
+    }
+    increment_();
+
+    gsl_vector_float_view row = gsl_matrix_float_row(block, frameX);
+    threshold_(samp, &row.vector);
+  }
+  gsl_vector_float_const_view last = gsl_matrix_float_const_row(block, frameX - 1);
+  gsl_vector_float_memcpy(vector_, &last.vector);
+
+  return frameX;
+}
+
+
+// ----- methods for class `SpectralInterpolationMatrix' -----
+//
+SpectralInterpolationMatrix::
+SpectralInterpolationMatrix(unsigned rowsN, unsigned colsN, bool roundInput, bool roundOutput)
+  : rowsN_(rowsN), colsN_(colsN), roundInput_(roundInput), roundOutput_(roundOutput) { }
+
+void SpectralInterpolationMatrix::close_rows_(unsigned rowX)
+{
+  while (start_.size() <= rowX)
+    start_.push_back(index_.size());
+}
+
+void SpectralInterpolationMatrix::add(unsigned rowX, unsigned colX, double weight)
+{
+  if (rowX >= rowsN_ || colX >= colsN_)
+    throw jindex_error("Entry (%d, %d) is outside of (%d x %d) matrix", rowX, colX, rowsN_, colsN_);
+  if (rowX + 1 < start_.size())
+    throw jconsistency_error("Rows must be filled in increasing order (%d < %d)", rowX, start_.size() - 1);
+
+  close_rows_(rowX);
+  index_.push_back(colX);
+  weight_.push_back(weight);
+}
+
+void SpectralInterpolationMatrix::normalize(unsigned rowX, double norm)
+{
+  if (rowX >= rowsN_)
+    throw jindex_error("Row %d is outside of (%d x %d) matrix", rowX, rowsN_, colsN_);
+
+  if (norm_.size() == 0)
+    norm_.resize(rowsN_, 0.0);
+  norm_[rowX] = norm;
+}
+
+void SpectralInterpolationMatrix::apply(const gsl_vector* src, gsl_vector* dst) const
+{
+  if (src->size < colsN_ || dst->size != rowsN_)
+    throw jdimension_error("Cannot apply (%d x %d) interpolation matrix to %d-dimensional input giving %d outputs",
+			   rowsN_, colsN_, src->size, dst->size);
+
+  const double* srcData   = src->data;
+  const size_t  srcStride = src->stride;
+  const unsigned entriesN = index_.size();
+  for (unsigned rowX = 0; rowX < rowsN_; rowX++) {
+    unsigned begin = (rowX     < start_.size()) ? start_[rowX]     : entriesN;
+    unsigned end   = (rowX + 1 < start_.size()) ? start_[rowX + 1] : entriesN;
+
+    double z = 0.0;
+    for (unsigned n = begin; n < end; n++) {
+      double x = srcData[index_[n] * srcStride];
+      if (roundInput_) x = float(x);
+      z += weight_[n] * x;
+    }
+    if (norm_.size() > 0 && norm_[rowX] > 1E-20)
+      z /= norm_[rowX];
+    if (roundOutput_) z = float(z);
+
+    dst->data[rowX * dst->stride] = z;
+  }
+}
+
+void SpectralInterpolationMatrix::matrix(gsl_matrix* mat) const
+{
+  if (mat->size1 != rowsN_ || mat->size2 != colsN_)
+    throw jdimension_error("Matrix (%d x %d) does not match (%d x %d)",
+                           mat->size1, mat->size2, rowsN_, colsN_);
+
+  gsl_matrix_set_zero(mat);
+  const unsigned entriesN = index_.size();
+  for (unsigned rowX = 0; rowX < rowsN_; rowX++) {
+    unsigned begin = (rowX     < start_.size()) ? start_[rowX]     : entriesN;
+    unsigned end   = (rowX + 1 < start_.size()) ? start_[rowX + 1] : entriesN;
+    double   norm  = (norm_.size() > 0 && norm_[rowX] > 1E-20) ? norm_[rowX] : 1.0;
+    for (unsigned n = begin; n < end; n++)
+      gsl_matrix_set(mat, rowX, index_[n], gsl_matrix_get(mat, rowX, index_[n]) + weight_[n] / norm);
+  }
 }
 
 
@@ -1526,11 +1782,24 @@ const double SpectralResamplingFeature::SampleRatio = 16.0 / 22.05;
 SpectralResamplingFeature::
 SpectralResamplingFeature(const VectorFeatureStreamPtr& src, double ratio, unsigned len,
 		  const String& nm)
-  : VectorFeatureStream((len == 0 ? src->size() : len), nm), src_(src), ratio_(ratio * float(src->size()) / float(size()))
+  : VectorFeatureStream((len == 0 ? src->size() : len), nm), src_(src), ratio_(ratio * float(src->size()) / float(size())),
+    interp_(size(), src->size(), /* roundInput= */ false, /* roundOutput= */ true)
 {
   if (ratio_ > 1.0)
     throw jconsistency_error("Must resample the spectrum to a higher rate (ratio = %10.4f < 1.0).",
 			     ratio_);
+
+  // linear interpolation between the two neighbouring source bins
+  for (unsigned coeffX = 0; coeffX < size(); coeffX++) {
+    float    exact = coeffX * ratio_;
+    unsigned low   = unsigned(coeffX * ratio_);
+    unsigned high  = low + 1;
+
+    float    wgt   = high - exact;
+    interp_.add(coeffX, low, wgt);
+    if (high < src->size())
+      interp_.add(coeffX, high, 1.0 - wgt);
+  }
 }
 
 SpectralResamplingFeature::~SpectralResamplingFeature() { }
@@ -1545,17 +1814,7 @@ const gsl_vector* SpectralResamplingFeature::next(int frame_no)
   const gsl_vector* srcVec = src_->next(frame_no_ + 1);
   increment_();
 
-  for (unsigned coeffX = 0; coeffX < size(); coeffX++) {
-    float    exact = coeffX * ratio_;
-    unsigned low   = unsigned(coeffX * ratio_);
-    unsigned high  = low + 1;
-
-    float    wgt   = high - exact;
-    float    coeff = wgt * gsl_vector_get(srcVec, low)
-      + (1.0 - wgt) * gsl_vector_get(srcVec, high);
-
-    gsl_vector_set(vector_, coeffX, coeff);
-  }
+  interp_.apply(srcVec, vector_);
 
   return vector_;
 }
@@ -1663,34 +1922,62 @@ VTLNFeature::VTLNFeature(const VectorFeatureStreamPtr& pow,
 			 unsigned coeffN, double ratio, double edge, int version, 
 			 const String& nm)
   : VectorFeatureStream(coeffN == 0 ? pow->size() : coeffN, nm), pow_(pow), ratio_(ratio),
-    edge_(edge), version_(version)
+    edge_(edge), version_(version), current_(NULL)
 {
-  auxV_ = gsl_vector_alloc(coeffN);
+  if (version_ != 1 && version_ != 2)
+    throw jtype_error("[ERROR] VTLNFeature::VTLNFeature >> unknown version number (%d)", version_);
 }
 
+VTLNFeature::~VTLNFeature() { clear_cache(); }
 
-const gsl_vector* VTLNFeature::nextOrg(int frame_no)
+void VTLNFeature::clear_cache()
 {
-  if (frame_no == frame_no_) return vector_;
+  for (_WarpMatrices::iterator itr = matrices_.begin(); itr != matrices_.end(); itr++)
+    delete itr->second;
+  matrices_.clear();
+  current_ = NULL;
+}
 
-  if (frame_no >= 0 && frame_no - 1 != frame_no_)
-    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
+const SpectralInterpolationMatrix* VTLNFeature::warp_matrix(double w)
+{
+  _WarpMatrices::iterator itr = matrices_.find(w);
+  if (itr != matrices_.end()) return itr->second;
 
-  const gsl_vector* powVec = pow_->next(frame_no_ + 1);
-  increment_();
+  SpectralInterpolationMatrix* mat = build_matrix(size(), pow_->size(), w, edge_, version_);
+  matrices_.insert(_WarpMatrices::value_type(w, mat));
 
-  double yedge = (edge_ < ratio_) ? (edge_ / ratio_)              : 1.0;
-  double b     = (yedge < 1.0)    ? (1.0 - edge_) / (1.0 - yedge) : 0;
+  return mat;
+}
 
-  for (unsigned coeffX = 0; coeffX < size(); coeffX++) {
+SpectralInterpolationMatrix* VTLNFeature::build_matrix(unsigned coeffN, unsigned powN, double ratio, double edge, int version)
+{
+  switch(version) {
+    case 1:
+      return build_org_(coeffN, powN, ratio, edge);
+    case 2:
+      return build_ff_(coeffN, powN, ratio, edge);
+    default:
+      throw jtype_error("[ERROR] VTLNFeature::build_matrix >> unknown version number (%d)", version);
+  }
+}
 
-    double Y0 = double(coeffX)   / double(size());
-    double Y1 = double(coeffX+1) / double(size());
+// piecewise linear warping with the bins of the power spectrum integrated over each output bin
+SpectralInterpolationMatrix* VTLNFeature::build_org_(unsigned coeffN, unsigned powN, double ratio, double edge)
+{
+  SpectralInterpolationMatrix* mat = new SpectralInterpolationMatrix(coeffN, powN);
 
-    double X0 = ((Y0 < yedge) ? (ratio_ * Y0) :
-		 (b     * Y0 +  1.0 - b)) * size();
-    double X1 = ((Y1 < yedge) ? (ratio_ * Y1) :
-		 (b     * Y1 +  1.0 - b)) * size();
+  double yedge = (edge < ratio) ? (edge / ratio)              : 1.0;
+  double b     = (yedge < 1.0)  ? (1.0 - edge) / (1.0 - yedge) : 0;
+
+  for (unsigned coeffX = 0; coeffX < coeffN; coeffX++) {
+
+    double Y0 = double(coeffX)   / double(coeffN);
+    double Y1 = double(coeffX+1) / double(coeffN);
+
+    double X0 = ((Y0 < yedge) ? (ratio * Y0) :
+		 (b     * Y0 +  1.0 - b)) * coeffN;
+    double X1 = ((Y1 < yedge) ? (ratio * Y1) :
+		 (b     * Y1 +  1.0 - b)) * coeffN;
 
     int    Lower_coeffY1 = int(X1);
     double alpha1        = X1 - Lower_coeffY1;
@@ -1698,56 +1985,47 @@ const gsl_vector* VTLNFeature::nextOrg(int frame_no)
     int    Lower_coeffY0 = int(X0);
     double alpha0        = int(X0) + 1 - X0;
 
-    double z             =  0.0;
+    if (Lower_coeffY0 >= int(powN))
+      Lower_coeffY0 = powN - 1;
 
-    if (Lower_coeffY0 >= powVec->size)
-      Lower_coeffY0 = powVec->size - 1;
-         
-    if (Lower_coeffY1 > powVec->size)
-      Lower_coeffY1 = powVec->size;
+    if (Lower_coeffY1 > int(powN))
+      Lower_coeffY1 = powN;
 
     if ( Lower_coeffY0 == Lower_coeffY1) {
-      z += (X1-X0) * gsl_vector_get(powVec, Lower_coeffY0);
+      mat->add(coeffX, Lower_coeffY0, X1-X0);
     } else {
-      z += alpha0  * gsl_vector_get(powVec, Lower_coeffY0);
+      mat->add(coeffX, Lower_coeffY0, alpha0);
 
       for (int i = Lower_coeffY0+1; i < Lower_coeffY1; i++)
-	z += gsl_vector_get(powVec, i);
+	mat->add(coeffX, i, 1.0);
 
-      if ( Lower_coeffY1 < int(powVec->size))
-	z += alpha1 * gsl_vector_get(powVec, Lower_coeffY1);
+      if ( Lower_coeffY1 < int(powN))
+	mat->add(coeffX, Lower_coeffY1, alpha1);
     }
-
-    gsl_vector_set(vector_, coeffX, z);
   }
 
-  return vector_;
+  return mat;
 }
 
-const gsl_vector* VTLNFeature::nextFF(int frame_no)
+// each bin of the power spectrum is spread over the warped bins it overlaps, then normalized
+SpectralInterpolationMatrix* VTLNFeature::build_ff_(unsigned coeffN, unsigned powN, double ratio, double edge)
 {
-  if (frame_no == frame_no_) return vector_;
+  unsigned N	= coeffN;
+  if (powN < N)
+    throw jdimension_error("Power spectrum (%d) is shorter than VTLN output (%d)", powN, N);
 
-  if (frame_no >= 0 && frame_no - 1 != frame_no_)
-    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
-
-  const gsl_vector* powVec = pow_->next(frame_no_ + 1);
-  increment_();
+  vector< vector< pair<unsigned, double> > > rows(N);
+  vector<double> norms(N, 0.0);
 
-  unsigned N	= size();
-  float b	= N * edge_;
-  float slope1	= ratio_;
-  float slope2	= ratio_;
+  float b	= N * edge;
+  float slope1	= ratio;
+  float slope2	= ratio;
   if (slope1 < 1.0)
     slope2 = (N - slope1 * b) / (N - b);
 
-  gsl_vector_set_zero(vector_);
-  gsl_vector_set_zero(auxV_);
-
   for (int sIdx = 0; sIdx < N; sIdx++) {
     float sIdx1	= sIdx - 0.5;
     float sIdx2	= sIdx + 0.5;
-    float v	= gsl_vector_get(powVec, sIdx);
     float dIdx1 = sIdx1*slope1;
     if (sIdx1 > b)
       dIdx1 = b * slope1 + (sIdx1 - b) * slope2;
@@ -1776,30 +2054,38 @@ const gsl_vector* VTLNFeature::nextFF(int frame_no)
         if (j == i2)
           a = alpha2;
 
-        gsl_vector_set(vector_, k, gsl_vector_get(vector_, k) + a * v);
-        gsl_vector_set(auxV_, k, gsl_vector_get(auxV_, k) + a);
+        rows[k].push_back(make_pair(unsigned(sIdx), a));
+        norms[k] += a;
       }
     }
   }
 
-  for (unsigned i = 0; i < N; i++) {
-    double norm = gsl_vector_get(auxV_, i);
-    if (norm > 1E-20)
-      gsl_vector_set(vector_, i, gsl_vector_get(vector_, i)/norm);
+  // the per-frame code read the power spectrum through a float
+  SpectralInterpolationMatrix* mat = new SpectralInterpolationMatrix(N, powN, /* roundInput= */ true);
+  for (unsigned k = 0; k < N; k++) {
+    for (unsigned n = 0; n < rows[k].size(); n++)
+      mat->add(k, rows[k][n].first, rows[k][n].second);
+    mat->normalize(k, norms[k]);
   }
 
-  return vector_;
+  return mat;
 }
 
-const gsl_vector* VTLNFeature::next(int frame_no) {
-  switch(version_) {
-    case 1:
-      return nextOrg(frame_no);
-    case 2:
-      return nextFF(frame_no);
-    default:
-      throw jtype_error("[ERROR] VTLNFeature::next >> unknown version number (%d)", version_);
-  }
+const gsl_vector* VTLNFeature::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  if (frame_no >= 0 && frame_no - 1 != frame_no_)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
+
+  const gsl_vector* powVec = pow_->next(frame_no_ + 1);
+  increment_();
+
+  if (current_ == NULL)
+    current_ = warp_matrix(ratio_);
+  current_->apply(powVec, vector_);
+
+  return vector_;
 }
 
 void VTLNFeature::matrix(gsl_matrix* mat) const
@@ -1850,6 +2136,45 @@ void VTLNFeature::matrix(gsl_matrix* mat) const
 }
 
 
+// ----- methods for class 'MultiWarpVTLNFeature' -----
+//
+MultiWarpVTLNFeature::
+MultiWarpVTLNFeature(const VectorFeatureStreamPtr& pow, const gsl_vector* warps,
+		     unsigned coeffN, double edge, int version, const String& nm)
+  : VectorFeatureStream((coeffN == 0 ? pow->size() : coeffN) * warps->size, nm), pow_(pow),
+    coeffN_(coeffN == 0 ? pow->size() : coeffN)
+{
+  for (unsigned warpX = 0; warpX < warps->size; warpX++) {
+    warps_.push_back(gsl_vector_get(warps, warpX));
+    matrices_.push_back(VTLNFeature::build_matrix(coeffN_, pow_->size(), warps_[warpX], edge, version));
+  }
+}
+
+MultiWarpVTLNFeature::~MultiWarpVTLNFeature()
+{
+  for (unsigned warpX = 0; warpX < matrices_.size(); warpX++)
+    delete matrices_[warpX];
+}
+
+const gsl_vector* MultiWarpVTLNFeature::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  if (frame_no >= 0 && frame_no - 1 != frame_no_)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
+
+  const gsl_vector* powVec = pow_->next(frame_no_ + 1);
+  increment_();
+
+  for (unsigned warpX = 0; warpX < matrices_.size(); warpX++) {
+    gsl_vector_view warped = gsl_vector_subvector(vector_, warpX * coeffN_, coeffN_);
+    matrices_[warpX]->apply(powVec, &warped.vector);
+  }
+
+  return vector_;
+}
+
+
 // ----- methods for class `MelFeature::SparseMatrix_' -----
 //
 MelFeature::SparseMatrix_::SparseMatrix_(unsigned m, unsigned n, unsigned version)
@@ -2445,6 +2770,22 @@ const gsl_vector* FloatToDoubleConversionFeature::next(int frame_no) {
 
 }
 
+void FloatToDoubleConversionFeature::describe(StreamInfo& info) const
+{
+  char signature[32];
+  sprintf(signature, "%u", size());
+
+  info.sources.push_back(src_.operator->());
+  info.signature = signature;
+}
+
+void FloatToDoubleConversionFeature::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(src_, src);
+}
+
 // ----- methods for class `MeanSubtractionFeature' -----
 //
 const float     MeanSubtractionFeature::variance_floor_  = 0.0001;
@@ -2552,11 +2893,13 @@ const gsl_vector_float* MeanSubtractionFeature::nextBatch_(int frame_no)
   return vector_;
 }
 
+// mean and second moment are gathered in the same pass over the source
 void MeanSubtractionFeature::calcMeanVariance_()
 {
   int    frame_no = 0;
   double ttlWgt = 0.0;
   gsl_vector_float_set_zero(mean_);
+  gsl_vector_float_set_zero(var_);
   while (true) {
     try {
       const gsl_vector_float* srcVec = src_->next(frame_no);
@@ -2568,62 +2911,28 @@ void MeanSubtractionFeature::calcMeanVariance_()
 
       // printf("Frame %4d : Weight %6.2f\n", frame_no, wgt);
 
-      // sum for mean
+      // sum for mean and covariance
       for (unsigned i = 0; i < size(); i++) {
         float f = gsl_vector_float_get(srcVec, i);
         float m = gsl_vector_float_get(mean_, i);
+        float v = gsl_vector_float_get(var_, i);
 
         gsl_vector_float_set(mean_, i, m + wgt * f);
+        gsl_vector_float_set(var_, i, v + wgt * f * f);
       }
       frame_no++;  ttlWgt += wgt;
     } catch (jiterator_error& e) {
-      for (unsigned i = 0; i < size(); i++)
-	gsl_vector_float_set(mean_, i, gsl_vector_float_get(mean_, i) / ttlWgt);
       break;
     } catch (j_error& e) {
-      if (e.getCode() == JITERATOR) {
-        for (unsigned i = 0; i < size(); i++)
-          gsl_vector_float_set(mean_, i, gsl_vector_float_get(mean_, i) / ttlWgt);
+      if (e.getCode() == JITERATOR)
         break;
-      }
     }
   }
 
-  frame_no = 0;  ttlWgt = 0.0;
-  gsl_vector_float_set_zero(var_);
-  while (true) {
-    try {
-      const gsl_vector_float* srcVec = src_->next(frame_no);
-      float                   wgt    = 1.0;
-      if (wgt_.is_null() == false) {
-        const gsl_vector_float* wgtVec = wgt_->next(frame_no);
-        wgt    = gsl_vector_float_get(wgtVec, 0);
-      }
-
-      // sum for covariance
-      for (unsigned i = 0; i < size(); i++) {
-        float f = gsl_vector_float_get(srcVec, i);
-        float v = gsl_vector_float_get(var_, i);
-
-        gsl_vector_float_set(var_, i, v + wgt * f * f);
-      }
-      frame_no++;  ttlWgt += wgt;
-    } catch (jiterator_error& e) {
-      for (unsigned i = 0; i < size(); i++) {
-        float m = gsl_vector_float_get(mean_, i);
-        gsl_vector_float_set(var_, i, (gsl_vector_float_get(var_, i) / ttlWgt) - (m * m));
-      }
-      break;
-    } catch (j_error& e) {
-      if (e.getCode() == JITERATOR) {
-        for (unsigned i = 0; i < size(); i++) {
-          float m = gsl_vector_float_get(mean_, i);
-          gsl_vector_float_set(var_, i, (gsl_vector_float_get(var_, i) / ttlWgt) - (m * m));
-        }
-        break;
-      }
-
-    }
+  for (unsigned i = 0; i < size(); i++) {
+    gsl_vector_float_set(mean_, i, gsl_vector_float_get(mean_, i) / ttlWgt);
+    float m = gsl_vector_float_get(mean_, i);
+    gsl_vector_float_set(var_, i, (gsl_vector_float_get(var_, i) / ttlWgt) - (m * m));
   }
   mean_var_found_ = true;
 }
@@ -2853,6 +3162,13 @@ LinearTransformFeature(const VectorFloatFeatureStreamPtr& src, unsigned sz, cons
   trans_(gsl_matrix_float_calloc(size(), src_->size()))
 {}
 
+LinearTransformFeature::~LinearTransformFeature()
+{
+  gsl_matrix_float_free(trans_);
+  for (unsigned i = 0; i < retired_.size(); i++)
+    gsl_matrix_float_free(retired_[i]);
+}
+
 const gsl_vector_float* LinearTransformFeature::next(int frame_no)
 {
   if (frame_no == frame_no_) return vector_;
@@ -2900,6 +3216,238 @@ void LinearTransformFeature::identity()
 }
 
 
+// dimensions and a hash of the bits of 'mat'; 'matrix_data_()' lets 'StreamGraph' rule out collisions
+static String matrix_signature_(const gsl_matrix_float* mat)
+{
+  unsigned long long hash = 14695981039346656037ULL;		// FNV-1a
+  for (size_t i = 0; i < mat->size1; i++) {
+    const unsigned char* row = (const unsigned char*) (mat->data + i * mat->tda);
+    for (size_t b = 0; b < mat->size2 * sizeof(float); b++) {
+      hash ^= row[b];
+      hash *= 1099511628211ULL;
+    }
+  }
+
+  char signature[64];
+  sprintf(signature, "%lux%lu:%016llx", (unsigned long) mat->size1, (unsigned long) mat->size2, hash);
+  return signature;
+}
+
+static void matrix_data_(const gsl_matrix_float* mat, StreamInfo& info)
+{
+  for (size_t i = 0; i < mat->size1; i++)
+    info.data.push_back(std::make_pair((const void*) (mat->data + i * mat->tda), mat->size2 * sizeof(float)));
+}
+
+void LinearTransformFeature::describe(StreamInfo& info) const
+{
+  info.sources.push_back(src_.operator->());
+  info.signature = matrix_signature_(trans_);
+  matrix_data_(trans_, info);
+  info.flops     = 2.0 * trans_->size1 * trans_->size2;
+  info.bytes     = trans_->size1 * trans_->size2 * sizeof(float);
+
+  info.identity  = (trans_->size1 == trans_->size2);
+  for (unsigned i = 0; info.identity && i < trans_->size1; i++)
+    for (unsigned j = 0; j < trans_->size2; j++)
+      if (gsl_matrix_float_get(trans_, i, j) != ((i == j) ? 1.0 : 0.0)) { info.identity = false; break; }
+}
+
+void LinearTransformFeature::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(src_, src);
+}
+
+void LinearTransformFeature::fuse_source()
+{
+  LinearTransformFeature* inner = dynamic_cast<LinearTransformFeature*>(src_.operator->());
+  if (inner == NULL)
+    throw jtype_error("Source of '%s' is not a linear transform.", name().c_str());
+
+  // 'inner' may go away when 'src_' is replaced
+  VectorFloatFeatureStreamPtr src(inner->src_);
+  const gsl_matrix_float* A = inner->trans_;
+  gsl_matrix_float* product = gsl_matrix_float_calloc(size(), A->size2);
+  for (unsigned i = 0; i < size(); i++) {
+    for (unsigned j = 0; j < A->size2; j++) {
+      double sum = 0.0;
+      for (unsigned k = 0; k < A->size1; k++)
+	sum += gsl_matrix_float_get(trans_, i, k) * gsl_matrix_float_get(A, k, j);
+      gsl_matrix_float_set(product, i, j, sum);
+    }
+  }
+
+  // Python may still hold a view of the old matrix
+  retired_.push_back(trans_);
+  trans_ = product;
+  src_   = src;
+}
+
+void LinearTransformFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorFloatFeatureStream::memory_buffers_(usage);
+  usage.add("matrix", MemoryUsage::bytes(trans_));
+  if (retired_.size() == 0) return;
+
+  size_t retired = 0;
+  for (unsigned i = 0; i < retired_.size(); i++)
+    retired += MemoryUsage::bytes(retired_[i]);
+  usage.add("retired matrices", retired);
+}
+
+
+// ----- methods for class `SpliceProjectFeature' -----
+//
+SpliceProjectFeature::
+SpliceProjectFeature(const VectorFloatFeatureStreamPtr& src, unsigned delta, unsigned sz,
+		     unsigned blockLen, const String& nm) :
+  VectorFloatFeatureStream((sz == 0) ? (2 * delta + 1) * src->size() : sz, nm),
+  src_(src), delta_(delta), singleSize_(src->size()), blockLen_((blockLen == 0) ? 1 : blockLen),
+  trans_(gsl_matrix_float_calloc(size(), (2 * delta_ + 1) * singleSize_)),
+  frames_(gsl_matrix_float_calloc(blockLen_ + 2 * delta_, singleSize_)),
+  block_(gsl_matrix_float_calloc(blockLen_, size())),
+  blockStart_(0), blockN_(0), srcFramesN_(-1)
+{}
+
+SpliceProjectFeature::~SpliceProjectFeature()
+{
+  gsl_matrix_float_free(trans_);
+  gsl_matrix_float_free(frames_);
+  gsl_matrix_float_free(block_);
+}
+
+void SpliceProjectFeature::load(const String& fileName, bool old)
+{
+  gsl_matrix_float_load(trans_, fileName, old);
+  trans_ = gsl_matrix_float_resize(trans_, size(), (2 * delta_ + 1) * singleSize_);
+}
+
+void SpliceProjectFeature::identity()
+{
+  if (size() != trans_->size2)
+    throw jdimension_error("Cannot set an (%d x %d) matrix to identity.", size(), trans_->size2);
+
+  gsl_matrix_float_set_zero(trans_);
+  for (unsigned i = 0; i < size(); i++)
+    gsl_matrix_float_set(trans_, i, i, 1.0);
+}
+
+void SpliceProjectFeature::describe(StreamInfo& info) const
+{
+  char signature[32];
+  sprintf(signature, "%u,%u,", delta_, blockLen_);
+
+  info.sources.push_back(src_.operator->());
+  info.signature = String(signature) + matrix_signature_(trans_);
+  matrix_data_(trans_, info);
+  info.flops     = 2.0 * trans_->size1 * trans_->size2;
+  info.bytes     = (trans_->size1 * trans_->size2 + frames_->size1 * frames_->size2
+		    + block_->size1 * block_->size2) * sizeof(float);
+  // reads up to 'blockLen + delta' frames ahead
+  info.lockstep  = false;
+}
+
+void SpliceProjectFeature::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(src_, src);
+}
+
+void SpliceProjectFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorFloatFeatureStream::memory_buffers_(usage);
+  usage.add("matrix", MemoryUsage::bytes(trans_));
+  usage.add("frames", MemoryUsage::bytes(frames_));
+  usage.add("block",  MemoryUsage::bytes(block_));
+}
+
+// Row 'r' of 'frames_' holds source frame 'blockStart_ - delta_ + r'; as in
+// 'AdjacentFeature', indices before the first or after the last frame repeat
+// the first or last frame respectively.
+void SpliceProjectFeature::fill_block_()
+{
+  const unsigned rowsN = blockLen_ + 2 * delta_;
+  const unsigned rowLen = singleSize_ * sizeof(float);
+  unsigned       rowX;
+
+  if (blockStart_ == 0) {
+    const gsl_vector_float* srcVec = src_->next(0);
+    for (rowX = 0; rowX <= delta_; rowX++)
+      for (unsigned i = 0; i < singleSize_; i++)
+	gsl_matrix_float_set(frames_, rowX, i, gsl_vector_float_get(srcVec, i));
+  } else {
+    // the context of the previous block becomes the left context of this one
+    memmove(frames_->data, frames_->data + blockLen_ * frames_->tda, 2 * delta_ * frames_->tda * sizeof(float));
+    rowX = 2 * delta_;
+  }
+
+  for (; rowX < rowsN; rowX++) {
+    int frame_no = blockStart_ - int(delta_) + int(rowX);
+    if (srcFramesN_ < 0) {
+      try {
+	const gsl_vector_float* srcVec = src_->next(frame_no);
+	for (unsigned i = 0; i < singleSize_; i++)
+	  gsl_matrix_float_set(frames_, rowX, i, gsl_vector_float_get(srcVec, i));
+	continue;
+      } catch (jiterator_error& e) {
+	srcFramesN_ = frame_no;
+      } catch (j_error& e) {
+	if (e.getCode() != JITERATOR) throw;
+	srcFramesN_ = frame_no;
+      }
+    }
+    if (rowX > 0)
+      memcpy(frames_->data + rowX * frames_->tda, frames_->data + (rowX - 1) * frames_->tda, rowLen);
+  }
+
+  blockN_ = blockLen_;
+  if (srcFramesN_ >= 0 && srcFramesN_ - blockStart_ < blockN_)
+    blockN_ = srcFramesN_ - blockStart_;
+  if (blockN_ <= 0)
+    throw jiterator_error("end of samples (SpliceProjectFeature)!");
+
+  // output(t) = sum_k trans_(:, k-th column block) * frame(t - delta + k)
+  gsl_matrix_float_view output = gsl_matrix_float_submatrix(block_, 0, 0, blockN_, size());
+  for (unsigned k = 0; k <= 2 * delta_; k++) {
+    gsl_matrix_float_view input = gsl_matrix_float_submatrix(frames_, k, 0, blockN_, singleSize_);
+    gsl_matrix_float_view coeff = gsl_matrix_float_submatrix(trans_, 0, k * singleSize_, size(), singleSize_);
+    gsl_blas_sgemm(CblasNoTrans, CblasTrans, 1.0, &input.matrix, &coeff.matrix, (k == 0) ? 0.0 : 1.0, &output.matrix);
+  }
+}
+
+const gsl_vector_float* SpliceProjectFeature::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  if (frame_no >= 0 && frame_no - 1 != frame_no_)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
+
+  int next_no = frame_no_ + 1;
+  if (next_no >= blockStart_ + blockN_) {
+    blockStart_ += blockN_;
+    fill_block_();
+  }
+  increment_();
+
+  gsl_vector_float_const_view row = gsl_matrix_float_const_row(block_, next_no - blockStart_);
+  gsl_vector_float_memcpy(vector_, &row.vector);
+
+  return vector_;
+}
+
+void SpliceProjectFeature::reset()
+{
+  src_->reset();
+
+  blockStart_ = 0;  blockN_ = 0;  srcFramesN_ = -1;
+
+  VectorFloatFeatureStream::reset();
+}
+
+
 // ----- methods for class `StorageFeature' -----
 //
 StorageFeature::StorageFeature(const VectorFloatFeatureStreamPtr& src,
@@ -2916,6 +3464,16 @@ StorageFeature::~StorageFeature()
     gsl_vector_float_free(frames_[i]);
 }
 
+// all 'MaxFrames' frames are allocated up front
+void StorageFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorFloatFeatureStream::memory_buffers_(usage);
+  size_t bytes = 0;
+  for (unsigned frameX = 0; frameX < frames_.size(); frameX++)
+    bytes += MemoryUsage::bytes(frames_[frameX]);
+  usage.add("frames", bytes);
+}
+
 const int StorageFeature::MaxFrames = 100000;
 const gsl_vector_float* StorageFeature::next(int frame_no)
 {
@@ -3013,6 +3571,15 @@ StaticStorageFeature::~StaticStorageFeature()
     gsl_vector_float_free(frames_[i]);
 }
 
+void StaticStorageFeature::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorFloatFeatureStream::memory_buffers_(usage);
+  size_t bytes = 0;
+  for (unsigned frameX = 0; frameX < frames_.size(); frameX++)
+    bytes += MemoryUsage::bytes(frames_[frameX]);
+  usage.add("frames", bytes);
+}
+
 
 const gsl_vector_float* StaticStorageFeature::next(int frame_no)
 {
@@ -3429,11 +3996,13 @@ const gsl_vector_float* JackFeature::next(int frame_no)
 //
 ZeroCrossingRateHammingFeature::ZeroCrossingRateHammingFeature(const VectorFloatFeatureStreamPtr& samp, const String& nm)
   : VectorFloatFeatureStream(1, nm), samp_(samp), windowLen_(samp->size()),
-    window_(new double[windowLen_])
+    window_(new double[windowLen_]), windowF_(new float[windowLen_])
 {
   double temp = 2. * M_PI / (double)(windowLen_ - 1);
-  for ( unsigned i = 0 ; i < windowLen_; i++ )
-    window_[i] = 0.54 - 0.46*cos(temp*i);
+  for ( unsigned i = 0 ; i < windowLen_; i++ ) {
+    window_[i]  = 0.54 - 0.46*cos(temp*i);
+    windowF_[i] = window_[i];
+  }
 }
 
 const gsl_vector_float* ZeroCrossingRateHammingFeature::next(int frame_no)
@@ -3446,6 +4015,16 @@ const gsl_vector_float* ZeroCrossingRateHammingFeature::next(int frame_no)
   const gsl_vector_float* block = samp_->next(frame_no_ + 1);
   increment_();
 
+  gsl_vector_float_set(vector_, 0, zcr_(block));
+
+  return vector_;
+}
+
+float ZeroCrossingRateHammingFeature::zcr_(const gsl_vector_float* block) const
+{
+  if (block->stride == 1)
+    return zero_crossing_rate_hamming(block->data, windowF_, windowLen_);
+
   float sum = 0;
   for (unsigned i = 0; i < windowLen_ - 1; i++) {
     int s_n = gsl_vector_float_get(block, i + 1) >= 0 ? 1 : -1;
@@ -3453,9 +4032,35 @@ const gsl_vector_float* ZeroCrossingRateHammingFeature::next(int frame_no)
     sum += abs(s_n - s) / 2 * window_[i];
   }
   sum /= windowLen_;
-  gsl_vector_float_set(vector_, 0, sum);
 
-  return vector_;
+  return sum;
+}
+
+unsigned ZeroCrossingRateHammingFeature::next_block(gsl_matrix_float* block)
+{
+  if (block->size2 != size())
+    throw jdimension_error("Block has %lu columns but feature %s has size %d\n", block->size2, name().c_str(), size());
+  if (block->size1 == 0) return 0;
+
+  unsigned frameX = 0;
+  for (; frameX < block->size1; frameX++) {
+    const gsl_vector_float* samp;
+    try {
+      samp = samp_->next(frame_no_ + 1);
+    } catch (jiterator_error& e) {
+      if (frameX == 0) throw;
+      break;
+    } catch (j_error& e) {
+      if (e.getCode() != JITERATOR || frameX == 0) throw;
+      break;
+    }
+    increment_();
+
+    gsl_matrix_float_set(block, frameX, 0, zcr_(samp));
+  }
+  gsl_vector_float_set(vector_, 0, gsl_matrix_float_get(block, frameX - 1, 0));
+
+  return frameX;
 }
 
 
@@ -190,6 +190,8 @@ class SampleFeature : public VectorFloatFeatureStream {
   void setSamples(const gsl_vector* samples, unsigned sampleRate);
 
 protected:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   float*              samples_;
   float               norm_;
   unsigned            ttlsamples_;
@@ -333,6 +335,9 @@ class BlockSizeConversionFeature : public VectorFloatFeatureStream {
 
   virtual const gsl_vector_float* next(int frame_no = -5);
 
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
+
  private:
   void inputLonger_();
   void outputLonger_();
@@ -498,7 +503,12 @@ class HammingFeature : public VectorFloatFeatureStream {
 
   virtual void reset() { samp_->reset(); VectorFloatFeatureStream::reset(); }
 
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
+
  private:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   VectorFloatFeatureStreamPtr			samp_;
   unsigned					windowLen_;
   double*					window_;
@@ -523,6 +533,9 @@ class FFTFeature : public VectorComplexFeatureStream {
   virtual const gsl_vector_complex* next(int frame_no = -5);
   virtual void reset() { samp_->reset(); VectorComplexFeatureStream::reset(); }
 
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
+
   unsigned fftLen()    const { return fftLen_;    }
   unsigned windowLen() const { return windowLen_; }
 
@@ -534,6 +547,8 @@ class FFTFeature : public VectorComplexFeatureStream {
 #endif
 
  private:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   VectorFloatFeatureStreamPtr			samp_;
   unsigned					fftLen_;
   unsigned					windowLen_;
@@ -564,6 +579,9 @@ class SpectralPowerFloatFeature : public VectorFloatFeatureStream {
 
   virtual void reset() { fft_->reset(); VectorFloatFeatureStream::reset(); }
 
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
+
  private:
   VectorComplexFeatureStreamPtr    fft_;
 };
@@ -616,9 +634,14 @@ class SignalPowerFeature : public VectorFloatFeatureStream {
 
   virtual const gsl_vector_float* next(int frame_no = -5);
 
+  // compute the power of the next 'block->size1' frames, one per row
+  unsigned next_block(gsl_matrix_float* block);
+
   virtual void reset() { samp_->reset(); VectorFloatFeatureStream::reset(); }
 
  private:
+  float power_(const gsl_vector_float* block) const;
+
   VectorFloatFeatureStreamPtr			samp_;
   double					range_;
 };
@@ -720,9 +743,14 @@ class ThresholdFeature : public VectorFloatFeatureStream {
 
   virtual const gsl_vector_float* next(int frame_no = -5);
 
+  // threshold the next 'block->size1' frames, one per row
+  unsigned next_block(gsl_matrix_float* block);
+
   virtual void reset() { samp_->reset(); VectorFloatFeatureStream::reset(); }
 
  private:
+  void threshold_(const gsl_vector_float* block, gsl_vector_float* output) const;
+
   VectorFloatFeatureStreamPtr			samp_;
   double					value_;
   double					thresh_;
@@ -733,6 +761,49 @@ typedef Inherit<ThresholdFeature, VectorFloatFeatureStreamPtr> ThresholdFeatureP
 
 /*@}*/
 
+/**
+* \defgroup SpectralInterpolationMatrix Spectral Interpolation Matrix
+*/
+/*@{*/
+
+// ----- definition for class `SpectralInterpolationMatrix' -----
+//
+// Sparse (row-compressed) form of the frequency-axis interpolation
+// used by 'SpectralResamplingFeature' and 'VTLNFeature'. The weights are
+// stored in the same order in which the per-frame loops accumulated them,
+// so applying the matrix reproduces their results exactly.
+//
+class SpectralInterpolationMatrix {
+ public:
+  SpectralInterpolationMatrix(unsigned rowsN, unsigned colsN, bool roundInput = false, bool roundOutput = false);
+
+  unsigned rowsN() const { return rowsN_; }
+  unsigned colsN() const { return colsN_; }
+  unsigned entriesN() const { return index_.size(); }
+
+  // append an entry to row 'rowX'; rows must be filled in increasing order
+  void add(unsigned rowX, unsigned colX, double weight);
+  // divide row 'rowX' by 'norm' after accumulation if 'norm' > 1.0E-20
+  void normalize(unsigned rowX, double norm);
+
+  void apply(const gsl_vector* src, gsl_vector* dst) const;
+  void matrix(gsl_matrix* mat) const;
+
+ private:
+  void close_rows_(unsigned rowX);
+
+  const unsigned				rowsN_;
+  const unsigned				colsN_;
+  const bool					roundInput_;
+  const bool					roundOutput_;
+  vector<unsigned>				start_;
+  vector<unsigned>				index_;
+  vector<double>				weight_;
+  vector<double>				norm_;
+};
+
+/*@}*/
+
 /**
 * \defgroup SpectralResamplingFeature Spectral Resampling Feature
 */
@@ -755,6 +826,7 @@ class SpectralResamplingFeature : public VectorFeatureStream {
  private:
   VectorFeatureStreamPtr			src_;
   const double					ratio_;
+  SpectralInterpolationMatrix			interp_;
 };
 
 typedef Inherit<SpectralResamplingFeature, VectorFeatureStreamPtr> SpectralResamplingFeaturePtr;
@@ -811,37 +883,82 @@ typedef Inherit<SamplerateConversionFeature, VectorFloatFeatureStreamPtr> Sample
 // Piecewise linear: Y = X/Ratio  for X < edge
 // -------------------------------------------
 class VTLNFeature : public VectorFeatureStream {
+  typedef map<double, SpectralInterpolationMatrix*>	_WarpMatrices;
  public:
   VTLNFeature(const VectorFeatureStreamPtr& pow,
 	      unsigned coeffN = 0, double ratio = 1.0, double edge = 1.0, int version = 1,
 	      const String& nm = "VTLN");
-  virtual ~VTLNFeature() {  }
+  virtual ~VTLNFeature();
 
   virtual const gsl_vector* next(int frame_no = -5);
 
   virtual void reset() { pow_->reset(); VectorFeatureStream::reset(); }
 
   // specify the warp factor
-  void warp(double w) { ratio_ = w; }
+  void warp(double w) { ratio_ = w; current_ = NULL; }
 
   void matrix(gsl_matrix* mat) const;
 
+  // interpolation matrix for warp factor 'w'; built once and kept for the lifetime of the feature
+  const SpectralInterpolationMatrix* warp_matrix(double w);
+  unsigned cached_warps() const { return matrices_.size(); }
+  void clear_cache();
+
+  static SpectralInterpolationMatrix* build_matrix(unsigned coeffN, unsigned powN, double ratio, double edge, int version);
+
 private:
-  virtual const gsl_vector* nextFF(int frame_no);
-  virtual const gsl_vector* nextOrg(int frame_no);
+  static SpectralInterpolationMatrix* build_org_(unsigned coeffN, unsigned powN, double ratio, double edge);
+  static SpectralInterpolationMatrix* build_ff_(unsigned coeffN, unsigned powN, double ratio, double edge);
 
  private:
   VectorFeatureStreamPtr pow_;
   double                 ratio_;
   const double           edge_;
   const int              version_;
-  gsl_vector*            auxV_;
+  _WarpMatrices          matrices_;
+  const SpectralInterpolationMatrix* current_;
 };
 
 typedef Inherit<VTLNFeature, VectorFeatureStreamPtr> VTLNFeaturePtr;
 
 /*@}*/
 
+/**
+* \defgroup MultiWarpVTLNFeature Multi-Warp VTLN Feature
+*/
+/*@{*/
+
+// ----- definition for class `MultiWarpVTLNFeature' -----
+//
+// Warps each power spectrum with every candidate factor in 'warps' and
+// stacks the results: coefficients [k * coeffN, (k + 1) * coeffN) belong to warps[k].
+//
+class MultiWarpVTLNFeature : public VectorFeatureStream {
+ public:
+  MultiWarpVTLNFeature(const VectorFeatureStreamPtr& pow, const gsl_vector* warps,
+		       unsigned coeffN = 0, double edge = 1.0, int version = 1,
+		       const String& nm = "MultiWarpVTLN");
+  virtual ~MultiWarpVTLNFeature();
+
+  virtual const gsl_vector* next(int frame_no = -5);
+
+  virtual void reset() { pow_->reset(); VectorFeatureStream::reset(); }
+
+  unsigned warpsN() const { return warps_.size(); }
+  unsigned coeffN() const { return coeffN_; }
+  double warp(unsigned warpX) const { return warps_[warpX]; }
+
+ private:
+  VectorFeatureStreamPtr			pow_;
+  const unsigned				coeffN_;
+  vector<double>				warps_;
+  vector<SpectralInterpolationMatrix*>		matrices_;
+};
+
+typedef Inherit<MultiWarpVTLNFeature, VectorFeatureStreamPtr> MultiWarpVTLNFeaturePtr;
+
+/*@}*/
+
 /**
 * \defgroup MelFeature Mel Feature
 */
@@ -990,6 +1107,9 @@ class FloatToDoubleConversionFeature : public VectorFeatureStream {
 
   virtual void reset() { src_->reset(); VectorFeatureStream::reset(); }
 
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
+
  private:
   VectorFloatFeatureStreamPtr     src_;
 
@@ -1165,7 +1285,7 @@ class LinearTransformFeature : public VectorFloatFeatureStream {
   LinearTransformFeature(const VectorFloatFeatureStreamPtr& src, unsigned sz = 0, const String& nm = "Transform");
 #endif
 
-  virtual ~LinearTransformFeature() { gsl_matrix_float_free(trans_); }
+  virtual ~LinearTransformFeature();
 
   virtual const gsl_vector_float* next(int frame_no = -5);
 
@@ -1177,15 +1297,79 @@ class LinearTransformFeature : public VectorFloatFeatureStream {
 
   virtual void reset() { src_->reset(); VectorFloatFeatureStream::reset(); }
 
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
+
+  /**
+     @brief read from the source of the source, which must be a 'LinearTransformFeature', through the product of both matrices
+     @note the product replaces the matrix; a matrix handed out before by 'matrix()' stays valid but is no longer used
+  */
+  void fuse_source();
+
  protected:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   VectorFloatFeatureStreamPtr			src_;
   gsl_matrix_float*				trans_;
+  std::vector<gsl_matrix_float*>		retired_;	// replaced by 'fuse_source()', freed with the transform
 };
 
 typedef Inherit<LinearTransformFeature, VectorFloatFeatureStreamPtr> LinearTransformFeaturePtr;
 
 /*@}*/
 
+/**
+* \defgroup SpliceProjectFeature Splice and Project Feature
+* Fused 'AdjacentFeature' + 'LinearTransformFeature'. Frames of the source are kept
+* in a contiguous buffer and a block of 'blockLen' outputs is computed at once as a
+* 1-D convolution: one GEMM per context position between the buffered frames and
+* the corresponding column block of the transformation matrix.
+*/
+/*@{*/
+
+// ----- definition for class `SpliceProjectFeature' -----
+//
+class SpliceProjectFeature : public VectorFloatFeatureStream {
+ public:
+  SpliceProjectFeature(const VectorFloatFeatureStreamPtr& src, unsigned delta = 5, unsigned sz = 0,
+		       unsigned blockLen = 32, const String& nm = "SpliceProject");
+
+  virtual ~SpliceProjectFeature();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+
+  virtual void reset();
+
+  // (sz x (2 * delta + 1) * src->size()) matrix, laid out as for 'LinearTransformFeature'
+  gsl_matrix_float* matrix() const { return trans_; }
+
+  void load(const String& fileName, bool old = false);
+
+  void identity();
+
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
+
+ private:
+  void fill_block_();
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
+  VectorFloatFeatureStreamPtr			src_;
+  const unsigned				delta_;
+  const unsigned				singleSize_;
+  const unsigned				blockLen_;
+  gsl_matrix_float*				trans_;
+  gsl_matrix_float*				frames_;	// (blockLen + 2 * delta) source frames
+  gsl_matrix_float*				block_;		// (blockLen x sz) outputs
+  int						blockStart_;
+  int						blockN_;
+  int						srcFramesN_;	// -1 until the end of 'src' is seen
+};
+
+typedef Inherit<SpliceProjectFeature, VectorFloatFeatureStreamPtr> SpliceProjectFeaturePtr;
+
+/*@}*/
+
 /**
 * \defgroup StorageFeature Storage Feature
 */
@@ -1210,6 +1394,8 @@ class StorageFeature : public VectorFloatFeatureStream {
   int evaluate();
 
  private:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   VectorFloatFeatureStreamPtr			src_;
   _StorageVector				frames_;
 };
@@ -1241,6 +1427,8 @@ class StaticStorageFeature : public VectorFloatFeatureStream {
   unsigned currentNFrames() const { return frame_no_; };
 
  private:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   //VectorFloatFeatureStreamPtr     src_;
   _StorageVector        frames_;
   int                  framesN_;
@@ -1566,16 +1754,22 @@ class JackFeature : public VectorFloatFeatureStream {
 class ZeroCrossingRateHammingFeature : public VectorFloatFeatureStream {
  public:
   ZeroCrossingRateHammingFeature(const VectorFloatFeatureStreamPtr& samp, const String& nm = "Zero Crossing Rate Hamming");
-  virtual ~ZeroCrossingRateHammingFeature() { delete[] window_; }
+  virtual ~ZeroCrossingRateHammingFeature() { delete[] window_; delete[] windowF_; }
 
   virtual const gsl_vector_float* next(int frame_no = -5);
 
+  // compute the zero crossing rate of the next 'block->size1' frames, one per row
+  unsigned next_block(gsl_matrix_float* block);
+
   virtual void reset() { samp_->reset(); VectorFloatFeatureStream::reset(); }
 
  private:
+  float zcr_(const gsl_vector_float* block) const;
+
   VectorFloatFeatureStreamPtr			samp_;
   unsigned					windowLen_;
   double*					window_;
+  float*					windowF_;
 };
 
 typedef Inherit<ZeroCrossingRateHammingFeature, VectorFloatFeatureStreamPtr> ZeroCrossingRateHammingFeaturePtr;
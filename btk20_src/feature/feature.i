@@ -17,6 +17,9 @@
 #include <numpy/arrayobject.h>
 #include "feature/feature.h"
 #include "feature/lpc.h"
+#include "feature/cmvn.h"
+#include "feature/pca.h"
+#include "feature/stream_graph.h"
 using namespace sndfile;
 %}
 
@@ -642,6 +645,7 @@ class SignalPowerFeature : public VectorFloatFeatureStream {
 public:
   SignalPowerFeature(const VectorFloatFeatureStreamPtr& samp, const String nm = "SignalPower");
   const gsl_vector_float* next() const;
+  unsigned next_block(gsl_matrix_float* block);
 };
 
 class SignalPowerFeaturePtr : public VectorFloatFeatureStreamPtr {
@@ -746,6 +750,7 @@ public:
   ThresholdFeature(const VectorFloatFeatureStreamPtr& samp, double value = 0.0, double thresh = 1.0,
                    const String& mode = "upper", const String& nm = "Threshold");
   const gsl_vector_float* next() const;
+  unsigned next_block(gsl_matrix_float* block);
 };
 
 class ThresholdFeaturePtr : public VectorFloatFeatureStreamPtr {
@@ -849,6 +854,8 @@ public:
   void matrix(gsl_matrix* matrix) const;
   // specify the warp factor
   void warp(double w);
+  unsigned cached_warps() const;
+  void clear_cache();
 };
 
 class VTLNFeaturePtr : public VectorFeatureStreamPtr {
@@ -870,6 +877,41 @@ class VTLNFeaturePtr : public VectorFeatureStreamPtr {
 };
 
 
+// ----- definition for class `MultiWarpVTLNFeature' -----
+//
+%ignore MultiWarpVTLNFeature;
+class MultiWarpVTLNFeature : public VectorFeatureStream {
+  %feature("kwargs") next;
+  %feature("kwargs") warp;
+public:
+  MultiWarpVTLNFeature(const VectorFeatureStreamPtr& pow, const gsl_vector* warps,
+                       unsigned coeffN = 0, double edge = 1.0, int version = 1,
+                       const String& nm = "MultiWarpVTLN");
+  virtual const gsl_vector* next(int frame_no = -5) const;
+  unsigned warpsN() const;
+  unsigned coeffN() const;
+  double warp(unsigned warpX) const;
+};
+
+class MultiWarpVTLNFeaturePtr : public VectorFeatureStreamPtr {
+  %feature("kwargs") MultiWarpVTLNFeaturePtr;
+ public:
+  %extend {
+    MultiWarpVTLNFeaturePtr(const VectorFeatureStreamPtr& pow, const gsl_vector* warps,
+                            unsigned coeff_num = 0, double edge = 1.0, int version = 1,
+                            const String& nm = "MultiWarpVTLN") {
+      return new MultiWarpVTLNFeaturePtr(new MultiWarpVTLNFeature(pow, warps, coeff_num, edge, version, nm));
+    }
+
+    MultiWarpVTLNFeaturePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  MultiWarpVTLNFeature* operator->();
+};
+
+
 // ----- definition for class `MelFeature' -----
 //
 %ignore MelFeature;
@@ -1265,6 +1307,177 @@ class FileMeanSubtractionFeaturePtr : public VectorFloatFeatureStreamPtr {
 };
 
 
+// ----- definition for class `CMVNStatistics' -----
+//
+%ignore CMVNStatistics;
+class CMVNStatistics {
+  %feature("kwargs") count;
+  %feature("kwargs") has;
+  %feature("kwargs") accumulate;
+  %feature("kwargs") merge;
+  %feature("kwargs") mean_variance;
+  %feature("kwargs") write;
+  %feature("kwargs") read;
+ public:
+  CMVNStatistics(unsigned dim);
+  unsigned dim() const;
+  unsigned keysN() const;
+  bool has(const String& key) const;
+  double count(const String& key) const;
+  unsigned accumulate(const VectorFloatFeatureStreamPtr& src, const String& key,
+                      const VectorFloatFeatureStreamPtr& weight = NULL);
+  void clear();
+  void mean_variance(const String& key, gsl_vector_float* mean, gsl_vector_float* variance) const;
+  void write(const String& fileName) const;
+  void read(const String& fileName);
+};
+
+class CMVNStatisticsPtr {
+  %feature("kwargs") CMVNStatisticsPtr;
+ public:
+  %extend {
+    CMVNStatisticsPtr(unsigned dim) {
+      return new CMVNStatisticsPtr(new CMVNStatistics(dim));
+    }
+
+    void merge(const CMVNStatisticsPtr& other) {
+      (*self)->merge(*other);
+    }
+  }
+
+  CMVNStatistics* operator->();
+};
+
+
+// ----- definition for class `CMVNAccumulator' -----
+//
+%ignore CMVNAccumulator;
+class CMVNAccumulator {
+  %feature("kwargs") add;
+ public:
+  CMVNAccumulator(unsigned dim, unsigned threadsN = 1);
+  void add(const VectorFloatFeatureStreamPtr& src, const String& key,
+           const VectorFloatFeatureStreamPtr& weight = NULL);
+  unsigned jobsN() const;
+  CMVNStatisticsPtr run();
+};
+
+class CMVNAccumulatorPtr {
+  %feature("kwargs") CMVNAccumulatorPtr;
+ public:
+  %extend {
+    CMVNAccumulatorPtr(unsigned dim, unsigned threadsN = 1) {
+      return new CMVNAccumulatorPtr(new CMVNAccumulator(dim, threadsN));
+    }
+  }
+
+  CMVNAccumulator* operator->();
+};
+
+
+// ----- definition for class `CMVNFeature' -----
+//
+%ignore CMVNFeature;
+class CMVNFeature : public VectorFloatFeatureStream {
+  %feature("kwargs") next;
+  %feature("kwargs") select;
+ public:
+  CMVNFeature(const VectorFloatFeatureStreamPtr& src, const CMVNStatisticsPtr& stats,
+              double devNormFactor = 0.0, const String& nm = "CMVN");
+  virtual ~CMVNFeature();
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  void select(const String& key);
+  const String& selected() const;
+};
+
+class CMVNFeaturePtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") CMVNFeaturePtr;
+ public:
+  %extend {
+    CMVNFeaturePtr(const VectorFloatFeatureStreamPtr& src, const CMVNStatisticsPtr& stats,
+                   double devNormFactor = 0.0, const String nm = "CMVN") {
+      return new CMVNFeaturePtr(new CMVNFeature(src, stats, devNormFactor, nm));
+    }
+
+    CMVNFeaturePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  CMVNFeature* operator->();
+};
+
+
+// ----- definition for class `StreamingPCAEstimator' -----
+//
+%ignore StreamingPCAEstimator;
+class StreamingPCAEstimator {
+  %feature("kwargs") accumulate;
+  %feature("kwargs") estimate;
+  %feature("kwargs") estimate_randomized;
+  %feature("kwargs") save;
+ public:
+  StreamingPCAEstimator(unsigned dim, unsigned blockLen = 64);
+  unsigned dim() const;
+  double count() const;
+  void clear();
+  void accumulate(const gsl_vector_float* frame);
+  unsigned accumulate(const VectorFloatFeatureStreamPtr& src);
+  void estimate(unsigned k = 0);
+  void estimate_randomized(unsigned k, unsigned oversample = 10, unsigned iterationsN = 2, unsigned long seed = 0);
+  const gsl_vector* mean() const;
+  const gsl_matrix* covariance();
+  const gsl_vector* eigenvalues() const;
+  const gsl_matrix* eigenvectors() const;
+  void save(const String& basisFileName, const String& meanFileName) const;
+};
+
+class StreamingPCAEstimatorPtr {
+  %feature("kwargs") StreamingPCAEstimatorPtr;
+ public:
+  %extend {
+    StreamingPCAEstimatorPtr(unsigned dim, unsigned blockLen = 64) {
+      return new StreamingPCAEstimatorPtr(new StreamingPCAEstimator(dim, blockLen));
+    }
+  }
+
+  StreamingPCAEstimator* operator->();
+};
+
+
+// ----- definition for class `PCAProjectionFeature' -----
+//
+%ignore PCAProjectionFeature;
+class PCAProjectionFeature : public VectorFloatFeatureStream {
+  %feature("kwargs") next;
+  %feature("kwargs") set;
+ public:
+  PCAProjectionFeature(const VectorFloatFeatureStreamPtr& src, unsigned sz, bool reconstruct = false,
+                       unsigned blockLen = 32, const String& nm = "PCAProjection");
+  virtual ~PCAProjectionFeature();
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  void set(const gsl_vector* mean, const gsl_matrix* basis);
+  void set(const StreamingPCAEstimatorPtr& estimator);
+};
+
+class PCAProjectionFeaturePtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") PCAProjectionFeaturePtr;
+ public:
+  %extend {
+    PCAProjectionFeaturePtr(const VectorFloatFeatureStreamPtr& src, unsigned sz, bool reconstruct = false,
+                            unsigned blockLen = 32, const String& nm = "PCAProjection") {
+      return new PCAProjectionFeaturePtr(new PCAProjectionFeature(src, sz, reconstruct, blockLen, nm));
+    }
+
+    PCAProjectionFeaturePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  PCAProjectionFeature* operator->();
+};
+
+
 // ----- definition for class `AdjacentFeature' -----
 //
 %ignore AdjacentFeature;
@@ -1310,6 +1523,7 @@ class LinearTransformFeature : public VectorFloatFeatureStream {
   gsl_matrix_float* matrix() const;
   void load(const String& fileName, bool old = false);
   void identity();
+  void fuse_source();
 };
 
 class LinearTransformFeaturePtr : public VectorFloatFeatureStreamPtr {
@@ -1331,6 +1545,88 @@ class LinearTransformFeaturePtr : public VectorFloatFeatureStreamPtr {
 };
 
 
+// ----- definition for class `SpliceProjectFeature' -----
+//
+%ignore SpliceProjectFeature;
+class SpliceProjectFeature : public VectorFloatFeatureStream {
+  %feature("kwargs") next;
+  %feature("kwargs") matrix;
+  %feature("kwargs") load;
+  %feature("kwargs") identity;
+ public:
+  SpliceProjectFeature(const VectorFloatFeatureStreamPtr& src, unsigned delta = 5, unsigned sz = 0,
+                       unsigned blockLen = 32, const String& nm = "SpliceProject");
+  virtual ~SpliceProjectFeature();
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  gsl_matrix_float* matrix() const;
+  void load(const String& fileName, bool old = false);
+  void identity();
+};
+
+class SpliceProjectFeaturePtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") SpliceProjectFeaturePtr;
+ public:
+  %extend {
+    SpliceProjectFeaturePtr(const VectorFloatFeatureStreamPtr& src, unsigned delta = 5, unsigned sz = 0,
+                            unsigned blockLen = 32, const String& nm = "SpliceProject") {
+      return new SpliceProjectFeaturePtr(new SpliceProjectFeature(src, delta, sz, blockLen, nm));
+    }
+
+    SpliceProjectFeaturePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  SpliceProjectFeature* operator->();
+};
+
+
+// ----- definition for class `StreamGraph' -----
+//
+%ignore StreamGraph;
+class StreamGraph {
+  %feature("kwargs") add_output;
+ public:
+  StreamGraph();
+  ~StreamGraph();
+
+  void add_output(const VectorCharFeatureStreamPtr& output);
+  void add_output(const VectorShortFeatureStreamPtr& output);
+  void add_output(const VectorFloatFeatureStreamPtr& output);
+  void add_output(const VectorFeatureStreamPtr& output);
+  void add_output(const VectorComplexFeatureStreamPtr& output);
+
+  unsigned nodeN() const;
+  double flops() const;
+  size_t bytes() const;
+  String dump() const;
+  StreamGraphPtr optimize();
+
+  const MemoryUsage& memory_usage() const;
+  String memory_report() const;
+  void check_memory(size_t budget) const;
+
+  unsigned deduplicated() const;
+  unsigned fused() const;
+  unsigned bypassed() const;
+  double flops_saved() const;
+  long bytes_saved() const;
+  const String& report() const;
+};
+
+class StreamGraphPtr {
+  %feature("kwargs") StreamGraphPtr;
+ public:
+  %extend {
+    StreamGraphPtr() {
+      return new StreamGraphPtr(new StreamGraph());
+    }
+  }
+
+  StreamGraph* operator->();
+};
+
+
 // ----- definition for class `StorageFeature' -----
 //
 %ignore StorageFeature;
@@ -1645,6 +1941,7 @@ class ZeroCrossingRateHammingFeature : public VectorFloatFeatureStream {
 public:
   ZeroCrossingRateHammingFeature(const VectorFloatFeatureStreamPtr& samp, const String& nm = "Zero Crossing Rate Hamming");
   const gsl_vector_float* next() const;
+  unsigned next_block(gsl_matrix_float* block);
 };
 
 class ZeroCrossingRateHammingFeaturePtr : public VectorFloatFeatureStreamPtr {
@@ -0,0 +1,194 @@
+/*
+ * @file frame_kernels.cc
+ * @brief Per-frame kernels for the time-domain features (zero crossing rate, signal power, threshold).
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "feature/frame_kernels.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// ----- helpers -----
+//
+// ThresholdFeature compares the float samples against double thresholds; rounding
+// the threshold to the nearest float on the correct side keeps the float compare exact.
+//
+static float float_threshold_ge_(double thresh)
+{
+  float f = float(thresh);
+  if (double(f) < thresh) f = nextafterf(f, HUGE_VALF);
+  return f;
+}
+
+static float float_threshold_le_(double thresh)
+{
+  float f = float(thresh);
+  if (double(f) > thresh) f = nextafterf(f, -HUGE_VALF);
+  return f;
+}
+
+#ifdef __SSE2__
+static inline float horizontal_sum_(__m128 v)
+{
+  __m128 shuf = _mm_movehl_ps(v, v);
+  __m128 sums = _mm_add_ps(v, shuf);
+  shuf = _mm_shuffle_ps(sums, sums, 0x1);
+  return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+static inline double horizontal_sum_(__m128d v)
+{
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+#endif
+
+
+// ----- zero crossing rate -----
+//
+float zero_crossing_rate_hamming_scalar(const float* samples, const double* window, unsigned len)
+{
+  float sum = 0;
+  for (unsigned i = 0; i < len - 1; i++) {
+    int s_n = samples[i + 1] >= 0 ? 1 : -1;
+    int s   = samples[i]     >= 0 ? 1 : -1;
+    sum += abs(s_n - s) / 2 * window[i];
+  }
+  return sum / len;
+}
+
+float zero_crossing_rate_hamming(const float* samples, const float* window, unsigned len)
+{
+  if (len < 2) return 0.0;
+
+  const unsigned pairsN = len - 1;
+  float sum = 0;
+  unsigned i = 0;
+#ifdef __SSE2__
+  // a crossing is where the '>= 0' masks of neighbouring samples differ;
+  // the xor of the masks selects the window weight directly
+  const __m128 zero = _mm_setzero_ps();
+  __m128 acc = _mm_setzero_ps();
+  for (; i + 4 <= pairsN; i += 4) {
+    __m128 s   = _mm_cmpge_ps(_mm_loadu_ps(samples + i),     zero);
+    __m128 s_n = _mm_cmpge_ps(_mm_loadu_ps(samples + i + 1), zero);
+    acc = _mm_add_ps(acc, _mm_and_ps(_mm_xor_ps(s, s_n), _mm_loadu_ps(window + i)));
+  }
+  sum = horizontal_sum_(acc);
+#endif
+  for (; i < pairsN; i++)
+    if ((samples[i + 1] >= 0) != (samples[i] >= 0)) sum += window[i];
+
+  return sum / len;
+}
+
+
+// ----- signal power -----
+//
+double signal_power_scalar(const float* samples, unsigned len)
+{
+  double power = 0.0;
+  for (unsigned i = 0; i < len; i++) {
+    double val = samples[i];
+    power += val * val;
+  }
+  return power;
+}
+
+double signal_power(const float* samples, unsigned len)
+{
+  double power = 0.0;
+  unsigned i = 0;
+#ifdef __SSE2__
+  // widen to double before squaring so the sum keeps the precision of the scalar loop
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+  for (; i + 4 <= len; i += 4) {
+    __m128  x  = _mm_loadu_ps(samples + i);
+    __m128d lo = _mm_cvtps_pd(x);
+    __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+    acc0 = _mm_add_pd(acc0, _mm_mul_pd(lo, lo));
+    acc1 = _mm_add_pd(acc1, _mm_mul_pd(hi, hi));
+  }
+  power = horizontal_sum_(_mm_add_pd(acc0, acc1));
+#endif
+  for (; i < len; i++) {
+    double val = samples[i];
+    power += val * val;
+  }
+  return power;
+}
+
+
+// ----- threshold -----
+//
+void threshold_samples_scalar(float* dst, const float* src, unsigned len, int compare, double value, double thresh)
+{
+  for (unsigned i = 0; i < len; i++) {
+    double v = src[i];
+
+    if (compare > 0) {
+      if (v >= thresh) v = value;
+    } else if (compare == 0) {
+      if (v >= thresh) v = value;
+      else if (v <= -thresh) v = -value;
+    } else if (compare < 0) {
+      if (v <= thresh) v = value;
+    }
+
+    dst[i] = v;
+  }
+}
+
+void threshold_samples(float* dst, const float* src, unsigned len, int compare, double value, double thresh)
+{
+  const float upper  = float_threshold_ge_(thresh);
+  const float lower  = (compare == 0) ? float_threshold_le_(-thresh) : float_threshold_le_(thresh);
+  const float valueF = float(value);
+  const float lowerV = (compare == 0) ? float(-value) : valueF;
+
+  unsigned i = 0;
+#ifdef __SSE2__
+  const __m128 up  = _mm_set1_ps(upper);
+  const __m128 lo  = _mm_set1_ps(lower);
+  const __m128 upV = _mm_set1_ps(valueF);
+  const __m128 loV = _mm_set1_ps(lowerV);
+  for (; i + 4 <= len; i += 4) {
+    __m128 v = _mm_loadu_ps(src + i);
+    if (compare <= 0) {
+      __m128 m = _mm_cmple_ps(v, lo);
+      v = _mm_or_ps(_mm_and_ps(m, loV), _mm_andnot_ps(m, v));
+    }
+    if (compare >= 0) {
+      // evaluated on the original sample so that 'upper' takes precedence as in the scalar code
+      __m128 m = _mm_cmpge_ps(_mm_loadu_ps(src + i), up);
+      v = _mm_or_ps(_mm_and_ps(m, upV), _mm_andnot_ps(m, v));
+    }
+    _mm_storeu_ps(dst + i, v);
+  }
+#endif
+  for (; i < len; i++) {
+    float v = src[i];
+    if (compare >= 0 && v >= upper)      v = valueF;
+    else if (compare <= 0 && v <= lower) v = lowerV;
+    dst[i] = v;
+  }
+}
+
+
+// ----- mean and variance normalization -----
+//
+void mean_variance_normalize(float* dst, const float* src, const float* mean, const float* scale, unsigned len)
+{
+  unsigned i = 0;
+#ifdef __SSE2__
+  for (; i + 4 <= len; i += 4) {
+    __m128 x = _mm_sub_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(mean + i));
+    _mm_storeu_ps(dst + i, _mm_mul_ps(x, _mm_loadu_ps(scale + i)));
+  }
+#endif
+  for (; i < len; i++)
+    dst[i] = (src[i] - mean[i]) * scale[i];
+}
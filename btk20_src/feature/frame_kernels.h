@@ -0,0 +1,36 @@
+/**
+ * @file frame_kernels.h
+ * @brief Per-frame kernels for the time-domain features (zero crossing rate, signal power, threshold).
+ */
+
+#ifndef FRAME_KERNELS_H
+#define FRAME_KERNELS_H
+
+// ----- kernels for `ZeroCrossingRateHammingFeature' -----
+//
+// The scalar versions reproduce the original loops of feature.cc sample by sample,
+// the default versions use SSE2 when it is available at compile time and fall back
+// to the scalar code otherwise.
+//
+float zero_crossing_rate_hamming(const float* samples, const float* window, unsigned len);
+float zero_crossing_rate_hamming_scalar(const float* samples, const double* window, unsigned len);
+
+// ----- kernels for `SignalPowerFeature' -----
+//
+double signal_power(const float* samples, unsigned len);
+double signal_power_scalar(const float* samples, unsigned len);
+
+// ----- kernels for `ThresholdFeature' -----
+//
+// compare > 0 : 'upper', compare == 0 : 'both', compare < 0 : 'lower'
+//
+void threshold_samples(float* dst, const float* src, unsigned len, int compare, double value, double thresh);
+void threshold_samples_scalar(float* dst, const float* src, unsigned len, int compare, double value, double thresh);
+
+// ----- kernels for `CMVNFeature' -----
+//
+// dst[i] = (src[i] - mean[i]) * scale[i]
+//
+void mean_variance_normalize(float* dst, const float* src, const float* mean, const float* scale, unsigned len);
+
+#endif
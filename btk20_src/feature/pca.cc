@@ -0,0 +1,348 @@
+/*
+ * @file pca.cc
+ * @brief Streaming principal component analysis and batched PCA projection.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_eigen.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include "common/jexception.h"
+#include "feature/pca.h"
+
+
+// ----- methods for class `StreamingPCAEstimator' -----
+//
+StreamingPCAEstimator::StreamingPCAEstimator(unsigned dim, unsigned blockLen)
+  : dim_(dim), blockLen_((blockLen == 0) ? 1 : blockLen),
+    block_(gsl_matrix_calloc(blockLen_, dim_)), blockN_(0), count_(0.0),
+    shift_(gsl_vector_calloc(dim_)), sum_(gsl_vector_calloc(dim_)),
+    scatter_(gsl_matrix_calloc(dim_, dim_)), mean_(gsl_vector_calloc(dim_)),
+    cov_(gsl_matrix_calloc(dim_, dim_)), eval_(NULL), evec_(NULL) { }
+
+StreamingPCAEstimator::~StreamingPCAEstimator()
+{
+  gsl_matrix_free(block_);
+  gsl_vector_free(shift_);
+  gsl_vector_free(sum_);
+  gsl_matrix_free(scatter_);
+  gsl_vector_free(mean_);
+  gsl_matrix_free(cov_);
+  if (eval_ != NULL) gsl_vector_free(eval_);
+  if (evec_ != NULL) gsl_matrix_free(evec_);
+}
+
+void StreamingPCAEstimator::clear()
+{
+  blockN_ = 0;  count_ = 0.0;
+  gsl_vector_set_zero(shift_);
+  gsl_vector_set_zero(sum_);
+  gsl_matrix_set_zero(scatter_);
+  gsl_vector_set_zero(mean_);
+  gsl_matrix_set_zero(cov_);
+  if (eval_ != NULL) { gsl_vector_free(eval_);  eval_ = NULL; }
+  if (evec_ != NULL) { gsl_matrix_free(evec_);  evec_ = NULL; }
+}
+
+void StreamingPCAEstimator::accumulate(const gsl_vector_float* frame)
+{
+  if (frame->size != dim_)
+    throw jdimension_error("Frame size (%d) does not match PCA dimension (%d).", frame->size, dim_);
+
+  if (count_ == 0.0 && blockN_ == 0)
+    for (unsigned i = 0; i < dim_; i++)
+      gsl_vector_set(shift_, i, gsl_vector_float_get(frame, i));
+
+  for (unsigned i = 0; i < dim_; i++) {
+    double val = gsl_vector_float_get(frame, i) - gsl_vector_get(shift_, i);
+    gsl_matrix_set(block_, blockN_, i, val);
+    gsl_vector_set(sum_, i, gsl_vector_get(sum_, i) + val);
+  }
+
+  if (++blockN_ == blockLen_) flush_();
+}
+
+unsigned StreamingPCAEstimator::accumulate(const VectorFloatFeatureStreamPtr& src)
+{
+  src->reset();
+
+  int frame_no = 0;
+  while (true) {
+    try {
+      accumulate(src->next(frame_no));
+      frame_no++;
+    } catch (jiterator_error& e) {
+      break;
+    } catch (j_error& e) {
+      if (e.getCode() == JITERATOR) break;
+      throw;
+    }
+  }
+
+  return frame_no;
+}
+
+// scatter += block^T block as a single rank-k update
+void StreamingPCAEstimator::flush_()
+{
+  if (blockN_ == 0) return;
+
+  gsl_matrix_view block = gsl_matrix_submatrix(block_, 0, 0, blockN_, dim_);
+  gsl_blas_dsyrk(CblasLower, CblasTrans, 1.0, &block.matrix, 1.0, scatter_);
+  count_ += blockN_;  blockN_ = 0;
+}
+
+const gsl_matrix* StreamingPCAEstimator::covariance()
+{
+  flush_();
+  if (count_ < 1.0)
+    throw jconsistency_error("No data has been accumulated for PCA.");
+
+  for (unsigned i = 0; i < dim_; i++) {
+    double mi = gsl_vector_get(sum_, i) / count_;
+    gsl_vector_set(mean_, i, gsl_vector_get(shift_, i) + mi);
+    for (unsigned j = 0; j <= i; j++) {
+      double mj = gsl_vector_get(sum_, j) / count_;
+      double c  = gsl_matrix_get(scatter_, i, j) / count_ - mi * mj;
+      gsl_matrix_set(cov_, i, j, c);
+      gsl_matrix_set(cov_, j, i, c);
+    }
+  }
+
+  return cov_;
+}
+
+void StreamingPCAEstimator::estimate(unsigned k)
+{
+  if (k == 0 || k > dim_) k = dim_;
+
+  covariance();
+
+  gsl_matrix* ccov = gsl_matrix_alloc(dim_, dim_);
+  gsl_vector* eval = gsl_vector_alloc(dim_);
+  gsl_matrix* evec = gsl_matrix_alloc(dim_, dim_);
+  gsl_matrix_memcpy(ccov, cov_);
+  gsl_eigen_symmv_workspace* w = gsl_eigen_symmv_alloc(dim_);
+  gsl_eigen_symmv(ccov, eval, evec, w);
+  gsl_eigen_symmv_free(w);
+  gsl_eigen_symmv_sort(eval, evec, GSL_EIGEN_SORT_VAL_DESC);
+
+  if (eval_ != NULL) gsl_vector_free(eval_);
+  if (evec_ != NULL) gsl_matrix_free(evec_);
+  eval_ = gsl_vector_alloc(k);
+  evec_ = gsl_matrix_alloc(dim_, k);
+  gsl_vector_const_view      ev = gsl_vector_const_subvector(eval, 0, k);
+  gsl_matrix_const_view      em = gsl_matrix_const_submatrix(evec, 0, 0, dim_, k);
+  gsl_vector_memcpy(eval_, &ev.vector);
+  gsl_matrix_memcpy(evec_, &em.matrix);
+
+  gsl_matrix_free(ccov);  gsl_vector_free(eval);  gsl_matrix_free(evec);
+}
+
+// modified Gram-Schmidt on the columns of 'mat'; columns in the span of their
+// predecessors are set to zero
+static void orthonormalize_columns_(gsl_matrix* mat)
+{
+  for (unsigned j = 0; j < mat->size2; j++) {
+    gsl_vector_view colj = gsl_matrix_column(mat, j);
+    for (unsigned i = 0; i < j; i++) {
+      gsl_vector_view coli = gsl_matrix_column(mat, i);
+      double r;
+      gsl_blas_ddot(&coli.vector, &colj.vector, &r);
+      gsl_blas_daxpy(-r, &coli.vector, &colj.vector);
+    }
+    double norm = gsl_blas_dnrm2(&colj.vector);
+    if (norm > 1.0E-12)
+      gsl_vector_scale(&colj.vector, 1.0 / norm);
+    else
+      gsl_vector_set_zero(&colj.vector);
+  }
+}
+
+// Halko, Martinsson and Tropp, "Finding structure with randomness", 2011:
+// Q = orth((C^q) C Omega), then the eigenvectors of Q^T C Q are rotated back by Q.
+void StreamingPCAEstimator::estimate_randomized(unsigned k, unsigned oversample, unsigned iterationsN, unsigned long seed)
+{
+  if (k == 0 || k > dim_) k = dim_;
+  unsigned l = k + oversample;
+  if (l > dim_) l = dim_;
+
+  covariance();
+
+  gsl_matrix* omega = gsl_matrix_alloc(dim_, l);
+  gsl_matrix* Y     = gsl_matrix_alloc(dim_, l);
+  gsl_rng*    rng   = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(rng, seed);
+  for (unsigned i = 0; i < dim_; i++)
+    for (unsigned j = 0; j < l; j++)
+      gsl_matrix_set(omega, i, j, gsl_ran_ugaussian(rng));
+  gsl_rng_free(rng);
+
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, cov_, omega, 0.0, Y);
+  for (unsigned iterX = 0; iterX < iterationsN; iterX++) {
+    orthonormalize_columns_(Y);
+    gsl_matrix_memcpy(omega, Y);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, cov_, omega, 0.0, Y);
+  }
+  orthonormalize_columns_(Y);
+
+  // B = Q^T C Q
+  gsl_matrix* B = gsl_matrix_alloc(l, l);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, cov_, Y, 0.0, omega);
+  gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, Y, omega, 0.0, B);
+
+  gsl_vector* eval = gsl_vector_alloc(l);
+  gsl_matrix* evec = gsl_matrix_alloc(l, l);
+  gsl_eigen_symmv_workspace* w = gsl_eigen_symmv_alloc(l);
+  gsl_eigen_symmv(B, eval, evec, w);
+  gsl_eigen_symmv_free(w);
+  gsl_eigen_symmv_sort(eval, evec, GSL_EIGEN_SORT_VAL_DESC);
+
+  if (eval_ != NULL) gsl_vector_free(eval_);
+  if (evec_ != NULL) gsl_matrix_free(evec_);
+  eval_ = gsl_vector_alloc(k);
+  evec_ = gsl_matrix_alloc(dim_, k);
+  gsl_vector_const_view ev = gsl_vector_const_subvector(eval, 0, k);
+  gsl_matrix_const_view em = gsl_matrix_const_submatrix(evec, 0, 0, l, k);
+  gsl_vector_memcpy(eval_, &ev.vector);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, Y, &em.matrix, 0.0, evec_);
+
+  gsl_matrix_free(omega);  gsl_matrix_free(Y);  gsl_matrix_free(B);
+  gsl_vector_free(eval);   gsl_matrix_free(evec);
+}
+
+void StreamingPCAEstimator::check_estimate_() const
+{
+  if (evec_ == NULL)
+    throw jconsistency_error("PCA basis has not been estimated.");
+}
+
+void StreamingPCAEstimator::save(const String& basisFileName, const String& meanFileName) const
+{
+  check_estimate_();
+
+  unsigned    k     = evec_->size2;
+  gsl_matrix* basis = gsl_matrix_alloc(dim_, k);
+  for (unsigned colX = 0; colX < k; colX++) {
+    gsl_vector_const_view col = gsl_matrix_const_column(evec_, k - 1 - colX);
+    gsl_matrix_set_col(basis, colX, &col.vector);
+  }
+
+  FILE* fp = btk_fopen(basisFileName, "w");
+  gsl_matrix_fwrite(fp, basis);
+  btk_fclose(basisFileName, fp);
+  gsl_matrix_free(basis);
+
+  fp = btk_fopen(meanFileName, "w");
+  gsl_vector_fwrite(fp, mean_);
+  btk_fclose(meanFileName, fp);
+}
+
+
+// ----- methods for class `PCAProjectionFeature' -----
+//
+PCAProjectionFeature::
+PCAProjectionFeature(const VectorFloatFeatureStreamPtr& src, unsigned sz, bool reconstruct,
+		     unsigned blockLen, const String& nm)
+  : VectorFloatFeatureStream(sz, nm), src_(src), reconstruct_(reconstruct),
+    dim_(reconstruct ? sz : src->size()), k_(reconstruct ? src->size() : sz),
+    blockLen_((blockLen == 0) ? 1 : blockLen),
+    basis_(gsl_matrix_float_calloc(dim_, k_)), offset_(gsl_vector_float_calloc(sz)),
+    input_(gsl_matrix_float_calloc(blockLen_, src->size())), output_(gsl_matrix_float_calloc(blockLen_, sz)),
+    blockStart_(0), blockN_(0), endOfSamples_(false)
+{
+  if (k_ > dim_)
+    throw jdimension_error("Number of components (%d) exceeds the dimension (%d).", k_, dim_);
+}
+
+PCAProjectionFeature::~PCAProjectionFeature()
+{
+  gsl_matrix_float_free(basis_);
+  gsl_vector_float_free(offset_);
+  gsl_matrix_float_free(input_);
+  gsl_matrix_float_free(output_);
+}
+
+void PCAProjectionFeature::set(const gsl_vector* mean, const gsl_matrix* basis)
+{
+  if (mean->size != dim_ || basis->size1 != dim_ || basis->size2 < k_)
+    throw jdimension_error("PCA basis (%d x %d) and mean (%d) do not match (%d x %d).",
+			   basis->size1, basis->size2, mean->size, dim_, k_);
+
+  for (unsigned i = 0; i < dim_; i++)
+    for (unsigned j = 0; j < k_; j++)
+      gsl_matrix_float_set(basis_, i, j, gsl_matrix_get(basis, i, j));
+
+  if (reconstruct_) {
+    for (unsigned i = 0; i < dim_; i++)
+      gsl_vector_float_set(offset_, i, gsl_vector_get(mean, i));
+  } else {
+    // y = basis^T x - basis^T mean
+    for (unsigned j = 0; j < k_; j++) {
+      double proj = 0.0;
+      for (unsigned i = 0; i < dim_; i++)
+	proj += gsl_matrix_get(basis, i, j) * gsl_vector_get(mean, i);
+      gsl_vector_float_set(offset_, j, -proj);
+    }
+  }
+}
+
+void PCAProjectionFeature::fill_block_()
+{
+  blockN_ = 0;
+  while (blockN_ < int(blockLen_)) {
+    try {
+      const gsl_vector_float* srcVec = src_->next(blockStart_ + blockN_);
+      gsl_matrix_float_set_row(input_, blockN_, srcVec);
+      blockN_++;
+    } catch (jiterator_error& e) {
+      endOfSamples_ = true;  break;
+    } catch (j_error& e) {
+      if (e.getCode() != JITERATOR) throw;
+      endOfSamples_ = true;  break;
+    }
+  }
+  if (blockN_ == 0)
+    throw jiterator_error("end of samples (PCAProjectionFeature)!");
+
+  for (int rowX = 0; rowX < blockN_; rowX++)
+    gsl_matrix_float_set_row(output_, rowX, offset_);
+
+  gsl_matrix_float_view input  = gsl_matrix_float_submatrix(input_, 0, 0, blockN_, input_->size2);
+  gsl_matrix_float_view output = gsl_matrix_float_submatrix(output_, 0, 0, blockN_, size());
+  gsl_blas_sgemm(CblasNoTrans, reconstruct_ ? CblasTrans : CblasNoTrans, 1.0,
+		 &input.matrix, basis_, 1.0, &output.matrix);
+}
+
+const gsl_vector_float* PCAProjectionFeature::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  if (frame_no >= 0 && frame_no - 1 != frame_no_)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", name().c_str(), frame_no - 1, frame_no_);
+
+  int next_no = frame_no_ + 1;
+  if (next_no >= blockStart_ + blockN_) {
+    if (endOfSamples_)
+      throw jiterator_error("end of samples (PCAProjectionFeature)!");
+    blockStart_ += blockN_;
+    fill_block_();
+  }
+  increment_();
+
+  gsl_vector_float_const_view row = gsl_matrix_float_const_row(output_, next_no - blockStart_);
+  gsl_vector_float_memcpy(vector_, &row.vector);
+
+  return vector_;
+}
+
+void PCAProjectionFeature::reset()
+{
+  src_->reset();
+
+  blockStart_ = 0;  blockN_ = 0;  endOfSamples_ = false;
+
+  VectorFloatFeatureStream::reset();
+}
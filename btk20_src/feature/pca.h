@@ -0,0 +1,121 @@
+/**
+ * @file pca.h
+ * @brief Streaming principal component analysis and batched PCA projection.
+ */
+
+#ifndef PCA_H
+#define PCA_H
+
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include "stream/stream.h"
+#include "common/mlist.h"
+
+/**
+* \defgroup PCA Streaming Principal Component Analysis
+* 'StreamingPCAEstimator' never stores the training data: frames are collected
+* in a small block and folded into the scatter matrix with one rank-k update
+* (BLAS dsyrk) per block. The basis is obtained either from a full eigen
+* decomposition or, for high-dimensional stacked features, from a randomized
+* subspace iteration that only needs the leading 'k' components.
+* 'PCAProjectionFeature' applies a basis to blocks of frames with one GEMM.
+*/
+/*@{*/
+
+// ----- definition for class `StreamingPCAEstimator' -----
+//
+class StreamingPCAEstimator {
+ public:
+  StreamingPCAEstimator(unsigned dim, unsigned blockLen = 64);
+  ~StreamingPCAEstimator();
+
+  unsigned dim() const { return dim_; }
+  double count() const { return count_ + blockN_; }
+
+  void clear();
+
+  void accumulate(const gsl_vector_float* frame);
+  // accumulate every frame of 'src'; returns the number of frames read
+  unsigned accumulate(const VectorFloatFeatureStreamPtr& src);
+
+  // full eigen decomposition of the covariance; keep the 'k' largest components (all if 0)
+  void estimate(unsigned k = 0);
+  // leading 'k' components by randomized subspace iteration
+  void estimate_randomized(unsigned k, unsigned oversample = 10, unsigned iterationsN = 2, unsigned long seed = 0);
+
+  const gsl_vector* mean() const { return mean_; }
+  // covariance (dim x dim) of the data accumulated so far
+  const gsl_matrix* covariance();
+  // eigenvalues and eigenvectors (columns), largest first
+  const gsl_vector* eigenvalues() const { return eval_; }
+  const gsl_matrix* eigenvectors() const { return evec_; }
+
+  // write eigenvectors and mean with 'gsl_matrix_fwrite' and 'gsl_vector_fwrite';
+  // the columns are stored in ascending order as expected by 'PCAFeature'
+  void save(const String& basisFileName, const String& meanFileName) const;
+
+ private:
+  void flush_();
+  void check_estimate_() const;
+
+  const unsigned				dim_;
+  const unsigned				blockLen_;
+
+  gsl_matrix*					block_;		// frames minus 'shift_', one per row
+  unsigned					blockN_;
+  double					count_;
+  gsl_vector*					shift_;		// first frame seen; keeps the scatter well conditioned
+  gsl_vector*					sum_;
+  gsl_matrix*					scatter_;	// lower triangle only
+  gsl_vector*					mean_;
+  gsl_matrix*					cov_;
+
+  gsl_vector*					eval_;
+  gsl_matrix*					evec_;
+};
+
+typedef refcount_ptr<StreamingPCAEstimator>	StreamingPCAEstimatorPtr;
+
+
+// ----- definition for class `PCAProjectionFeature' -----
+//
+// forward      : y = basis^T (x - mean)
+// reconstruct  : y = basis x + mean
+//
+class PCAProjectionFeature : public VectorFloatFeatureStream {
+ public:
+  PCAProjectionFeature(const VectorFloatFeatureStreamPtr& src, unsigned sz, bool reconstruct = false,
+		       unsigned blockLen = 32, const String& nm = "PCAProjection");
+  virtual ~PCAProjectionFeature();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+
+  virtual void reset();
+
+  // 'basis' is (dim x k) with the components as columns; only the first 'k' columns are used
+  void set(const gsl_vector* mean, const gsl_matrix* basis);
+  void set(const StreamingPCAEstimatorPtr& estimator) { set(estimator->mean(), estimator->eigenvectors()); }
+
+ private:
+  void fill_block_();
+
+  VectorFloatFeatureStreamPtr			src_;
+  const bool					reconstruct_;
+  const unsigned				dim_;		// size of the PCA space
+  const unsigned				k_;		// number of components
+  const unsigned				blockLen_;
+
+  gsl_matrix_float*				basis_;		// (dim x k)
+  gsl_vector_float*				offset_;	// output offset
+  gsl_matrix_float*				input_;
+  gsl_matrix_float*				output_;
+  int						blockStart_;
+  int						blockN_;
+  bool						endOfSamples_;
+};
+
+typedef Inherit<PCAProjectionFeature, VectorFloatFeatureStreamPtr> PCAProjectionFeaturePtr;
+
+/*@}*/
+
+#endif
@@ -0,0 +1,366 @@
+/**
+ * @file stream_graph.cc
+ * @brief Introspection and optimization of graphs of feature streams.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <typeinfo>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+#include "feature/stream_graph.h"
+#include "feature/feature.h"
+
+
+// class name of a stream
+static String class_name_(const Countable* stream)
+{
+  const char* mangled = typeid(*stream).name();
+#ifdef __GNUG__
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(mangled, NULL, NULL, &status);
+  if (status == 0 && demangled != NULL) {
+    String name(demangled);
+    free(demangled);
+    return name;
+  }
+#endif
+  return mangled;
+}
+
+// fill in the type, size and description if 'stream' is a 'StreamType'
+template <class StreamType>
+static bool probe_(Countable* stream, const char* type, String& typeName, unsigned& size, size_t& itemsize,
+		   String& name, StreamInfo& info)
+{
+  StreamType* s = dynamic_cast<StreamType*>(stream);
+  if (s == NULL) return false;
+
+  typeName = type;
+  size     = s->size();
+  itemsize = s->itemsize();
+  name     = s->name();
+  s->describe(info);
+
+  return true;
+}
+
+template <class StreamType>
+static bool set_source_(Countable* stream, unsigned srcX, Countable* src)
+{
+  StreamType* s = dynamic_cast<StreamType*>(stream);
+  if (s == NULL) return false;
+
+  s->set_source(srcX, src);
+  return true;
+}
+
+template <class StreamType>
+static const MemoryUsage* memory_usage_(const Countable* stream)
+{
+  const StreamType* s = dynamic_cast<const StreamType*>(stream);
+  return (s == NULL) ? NULL : &(s->memory_usage());
+}
+
+static void set_source_(Countable* stream, unsigned srcX, Countable* src)
+{
+  if (set_source_<VectorCharFeatureStream>(stream, srcX, src)    ||
+      set_source_<VectorShortFeatureStream>(stream, srcX, src)   ||
+      set_source_<VectorFloatFeatureStream>(stream, srcX, src)   ||
+      set_source_<VectorFeatureStream>(stream, srcX, src)        ||
+      set_source_<VectorComplexFeatureStream>(stream, srcX, src)) return;
+
+  throw jtype_error("Object is not a feature stream.");
+}
+
+
+// ----- methods for class `StreamGraph' -----
+//
+StreamGraph::StreamGraph()
+  : deduplicatedN_(0), fusedN_(0), bypassedN_(0), flopsSaved_(0.0), bytesSaved_(0) { }
+
+StreamGraph::~StreamGraph() { }
+
+void StreamGraph::add_(Countable* output)
+{
+  if (output == NULL)
+    throw jparameter_error("Output stream is NULL.");
+
+  unsigned nodeX = visit_(output);
+  nodes_[nodeX].output = true;
+}
+
+unsigned StreamGraph::visit_(Countable* stream)
+{
+  std::map<Countable*, unsigned>::const_iterator itr = index_.find(stream);
+  if (itr != index_.end()) return itr->second;
+
+  if (visiting_.find(stream) != visiting_.end())
+    throw jconsistency_error("Stream graph has a cycle.");
+  visiting_[stream] = true;
+
+  Node_ node;
+  node.stream = stream;
+  node.cls    = class_name_(stream);
+  node.output = false;
+  if ((probe_<VectorCharFeatureStream>(stream, "char", node.type, node.size, node.itemsize, node.name, node.info)       ||
+       probe_<VectorShortFeatureStream>(stream, "short", node.type, node.size, node.itemsize, node.name, node.info)     ||
+       probe_<VectorFloatFeatureStream>(stream, "float", node.type, node.size, node.itemsize, node.name, node.info)     ||
+       probe_<VectorFeatureStream>(stream, "double", node.type, node.size, node.itemsize, node.name, node.info)         ||
+       probe_<VectorComplexFeatureStream>(stream, "complex", node.type, node.size, node.itemsize, node.name, node.info)) == false)
+    throw jtype_error("Object of class '%s' is not a feature stream.", node.cls.c_str());
+
+  for (unsigned srcX = 0; srcX < node.info.sources.size(); srcX++)
+    if (node.info.sources[srcX] != NULL)
+      node.sources.push_back(visit_(node.info.sources[srcX]));
+    else
+      throw jconsistency_error("Source %d of '%s' is NULL.", srcX, node.name.c_str());
+
+  unsigned nodeX = nodes_.size();
+  for (unsigned srcX = 0; srcX < node.sources.size(); srcX++)
+    nodes_[node.sources[srcX]].consumers.push_back(std::make_pair(nodeX, srcX));
+  nodes_.push_back(node);
+  held_.push_back(refcountable_ptr<Countable>(stream));
+  index_[stream] = nodeX;
+  visiting_.erase(stream);
+
+  return nodeX;
+}
+
+double StreamGraph::flops() const
+{
+  double flops = 0.0;
+  for (unsigned nodeX = 0; nodeX < nodes_.size(); nodeX++)
+    flops += nodes_[nodeX].info.flops;
+  return flops;
+}
+
+size_t StreamGraph::bytes() const
+{
+  size_t bytes = 0;
+  for (unsigned nodeX = 0; nodeX < nodes_.size(); nodeX++)
+    bytes += node_bytes_(nodes_[nodeX]);
+  return bytes;
+}
+
+String StreamGraph::dump() const
+{
+  char line[256];
+  sprintf(line, "%lu streams, %.0f flop/frame, %lu bytes\n", (unsigned long) nodes_.size(), flops(), (unsigned long) bytes());
+  String text(line);
+
+  for (unsigned nodeX = 0; nodeX < nodes_.size(); nodeX++) {
+    const Node_& node(nodes_[nodeX]);
+    sprintf(line, "%4u  ", nodeX);
+    text += String(line) + node.cls + " '" + node.name + "' ";
+    sprintf(line, "%s[%u]", node.type.c_str(), node.size);
+    text += line;
+
+    if (node.sources.size() > 0) {
+      text += " <-";
+      for (unsigned srcX = 0; srcX < node.sources.size(); srcX++) {
+	sprintf(line, "%s %u", (srcX == 0) ? "" : ",", node.sources[srcX]);
+	text += line;
+      }
+    } else if (node.info.signature == "") {
+      text += " (leaf)";
+    }
+
+    sprintf(line, "  %.0f flop/frame, %lu bytes", node.info.flops, (unsigned long) node_bytes_(node));
+    text += line;
+    if (node.output) text += "  [output]";
+    text += "\n";
+  }
+
+  return text;
+}
+
+const MemoryUsage& StreamGraph::memory_usage() const
+{
+  memory_.begin();
+  for (unsigned nodeX = 0; nodeX < nodes_.size(); nodeX++) {
+    const Countable* stream = nodes_[nodeX].stream;
+    const MemoryUsage* usage = memory_usage_<VectorCharFeatureStream>(stream);
+    if (usage == NULL) usage = memory_usage_<VectorShortFeatureStream>(stream);
+    if (usage == NULL) usage = memory_usage_<VectorFloatFeatureStream>(stream);
+    if (usage == NULL) usage = memory_usage_<VectorFeatureStream>(stream);
+    if (usage == NULL) usage = memory_usage_<VectorComplexFeatureStream>(stream);
+
+    char prefix[32];
+    sprintf(prefix, "%u ", nodeX);
+    memory_.merge(String(prefix) + nodes_[nodeX].name, *usage);
+  }
+
+  return memory_;
+}
+
+void StreamGraph::check_memory(size_t budget) const
+{
+  const MemoryUsage& usage(memory_usage());
+  if (usage.current() > budget)
+    throw jallocation_error("Streams hold %lu bytes; budget %lu.", (unsigned long) usage.current(), (unsigned long) budget);
+}
+
+bool StreamGraph::lockstep_(const std::vector<std::pair<unsigned, unsigned> >& consumers) const
+{
+  for (unsigned conX = 0; conX < consumers.size(); conX++)
+    if (nodes_[consumers[conX].first].info.lockstep == false) return false;
+  return true;
+}
+
+// point the consumers of node 'from' at node 'to'; returns the number of consumers left behind
+unsigned StreamGraph::rewire_(std::vector<std::vector<std::pair<unsigned, unsigned> > >& consumers, unsigned from, unsigned to)
+{
+  std::vector<std::pair<unsigned, unsigned> > left;
+  for (unsigned conX = 0; conX < consumers[from].size(); conX++) {
+    const std::pair<unsigned, unsigned>& consumer(consumers[from][conX]);
+    try {
+      set_source_(nodes_[consumer.first].stream, consumer.second, nodes_[to].stream);
+      consumers[to].push_back(consumer);
+    } catch (j_error& e) {
+      left.push_back(consumer);
+    }
+  }
+  consumers[from] = left;
+
+  return left.size();
+}
+
+// forget that node 'nodeX' reads 'sources'
+void StreamGraph::drop_consumer_(std::vector<std::vector<std::pair<unsigned, unsigned> > >& consumers,
+				 const std::vector<unsigned>& sources, unsigned nodeX)
+{
+  for (unsigned srcX = 0; srcX < sources.size(); srcX++) {
+    std::vector<std::pair<unsigned, unsigned> >& list(consumers[sources[srcX]]);
+    for (unsigned conX = 0; conX < list.size(); )
+      if (list[conX].first == nodeX)
+	list.erase(list.begin() + conX);
+      else
+	conX++;
+  }
+}
+
+// the parameter bytes of 'a' and 'b' behind their signatures are equal
+static bool same_data_(const StreamInfo& a, const StreamInfo& b)
+{
+  if (a.data.size() != b.data.size()) return false;
+  for (unsigned i = 0; i < a.data.size(); i++)
+    if (a.data[i].second != b.data[i].second ||
+	(a.data[i].first != b.data[i].first && memcmp(a.data[i].first, b.data[i].first, a.data[i].second) != 0))
+      return false;
+  return true;
+}
+
+StreamGraphPtr StreamGraph::optimize()
+{
+  const unsigned nodeN = nodes_.size();
+  std::vector<unsigned> canonical(nodeN);
+  std::vector<std::vector<std::pair<unsigned, unsigned> > > consumers(nodeN);
+  std::map<String, std::vector<unsigned> > signatures;
+  unsigned deduplicatedN = 0, fusedN = 0, bypassedN = 0;
+
+  // bypass streams that pass their input through and share identical ones; the nodes are in topological order
+  for (unsigned nodeX = 0; nodeX < nodeN; nodeX++) {
+    const Node_& node(nodes_[nodeX]);
+    canonical[nodeX] = nodeX;
+    consumers[nodeX] = node.consumers;
+
+    std::vector<unsigned> sources(node.sources.size());
+    for (unsigned srcX = 0; srcX < sources.size(); srcX++)
+      sources[srcX] = canonical[node.sources[srcX]];
+
+    if (node.info.identity && node.output == false && sources.size() > 0) {
+      const Node_& src(nodes_[sources[0]]);
+      if (src.type == node.type && src.size == node.size && consumers[nodeX].size() > 0 &&
+	  rewire_(consumers, nodeX, sources[0]) == 0) {
+	drop_consumer_(consumers, sources, nodeX);
+	canonical[nodeX] = sources[0];
+	bypassedN++;
+	continue;
+      }
+    }
+
+    if (node.info.signature == "") continue;
+
+    char line[64];
+    String key = node.cls + "|" + node.type + "|" + node.info.signature;
+    for (unsigned srcX = 0; srcX < sources.size(); srcX++) {
+      sprintf(line, "|%u", sources[srcX]);
+      key += line;
+    }
+
+    // equal signatures may still hash different parameters
+    std::vector<unsigned>& candidates(signatures[key]);
+    unsigned candX = 0;
+    while (candX < candidates.size() && same_data_(nodes_[candidates[candX]].info, node.info) == false) candX++;
+    if (candX == candidates.size()) {
+      candidates.push_back(nodeX);
+      continue;
+    }
+
+    unsigned sharedX = candidates[candX];
+    if (node.output == false && consumers[nodeX].size() > 0 &&
+	lockstep_(consumers[nodeX]) && lockstep_(consumers[sharedX]) &&
+	rewire_(consumers, nodeX, sharedX) == 0) {
+      drop_consumer_(consumers, sources, nodeX);
+      canonical[nodeX] = sharedX;
+      deduplicatedN++;
+    }
+  }
+
+  // fuse chains of linear transforms where that saves operations
+  for (unsigned nodeX = 0; nodeX < nodeN; nodeX++) {
+    if (canonical[nodeX] != nodeX) continue;
+    LinearTransformFeature* outer = dynamic_cast<LinearTransformFeature*>(nodes_[nodeX].stream);
+    if (outer == NULL) continue;
+
+    // the source may have been fused in turn
+    StreamInfo outerInfo;
+    outer->describe(outerInfo);
+    std::map<Countable*, unsigned>::const_iterator itr = index_.find(outerInfo.sources[0]);
+    if (itr == index_.end()) continue;
+    unsigned innerX = itr->second;
+    LinearTransformFeature* inner = dynamic_cast<LinearTransformFeature*>(nodes_[innerX].stream);
+    if (inner == NULL) continue;
+
+    StreamInfo innerInfo;
+    inner->describe(innerInfo);
+    std::map<Countable*, unsigned>::const_iterator srcItr = index_.find(innerInfo.sources[0]);
+    if (srcItr == index_.end()) continue;
+    unsigned srcX = srcItr->second;
+
+    double m = outer->size(), k = inner->size(), n = nodes_[srcX].size;
+    bool innerNeeded = (nodes_[innerX].output || consumers[innerX].size() > 1);
+    if (m * n >= m * k + (innerNeeded ? 0.0 : k * n)) continue;
+
+    outer->fuse_source();
+    for (unsigned conX = 0; conX < consumers[innerX].size(); conX++)
+      if (consumers[innerX][conX].first == nodeX) {
+	consumers[innerX].erase(consumers[innerX].begin() + conX);  break;
+      }
+    consumers[srcX].push_back(std::make_pair(nodeX, 0));
+    fusedN++;
+  }
+
+  StreamGraphPtr result(new StreamGraph());
+  for (unsigned nodeX = 0; nodeX < nodeN; nodeX++)
+    if (nodes_[nodeX].output) result->add_(nodes_[nodeX].stream);
+
+  result->deduplicatedN_ = deduplicatedN;
+  result->fusedN_        = fusedN;
+  result->bypassedN_     = bypassedN;
+  result->flopsSaved_    = flops() - result->flops();
+  result->bytesSaved_    = long(bytes()) - long(result->bytes());
+
+  char line[256];
+  sprintf(line, "streams %lu -> %lu: %u shared, %u linear transforms fused, %u bypassed\n"
+	  "flop/frame %.0f -> %.0f (%.0f saved), bytes %lu -> %lu (%ld saved)\n",
+	  (unsigned long) nodeN, (unsigned long) result->nodeN(), deduplicatedN, fusedN, bypassedN,
+	  flops(), result->flops(), result->flopsSaved_,
+	  (unsigned long) bytes(), (unsigned long) result->bytes(), result->bytesSaved_);
+  result->report_ = line;
+
+  return result;
+}
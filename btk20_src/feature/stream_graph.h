@@ -0,0 +1,121 @@
+/**
+ * @file stream_graph.h
+ * @brief Introspection and optimization of graphs of feature streams.
+ */
+
+#ifndef STREAM_GRAPH_H
+#define STREAM_GRAPH_H
+
+#include <map>
+#include <vector>
+#include <utility>
+#include "common/refcount.h"
+#include "common/jexception.h"
+#include "stream/stream.h"
+
+/**
+* \defgroup StreamGraph Stream Graph
+* A 'StreamGraph' follows the sources of a set of output streams, as reported
+* by 'FeatureStream::describe()', and lists the resulting DAG with the class,
+* name, type and size of every stream together with its estimated operations
+* per frame and memory. Streams that do not describe themselves are leaves.
+*
+* 'optimize()' rewires the streams in place and returns the graph of the
+* result, in which
+*
+*   - identical subgraphs, that is, streams of the same class and signature
+*     reading the same sources, are computed once for all consumers,
+*   - a 'LinearTransformFeature' reading another one reads the source of the
+*     latter through the product of both matrices if that saves operations,
+*   - streams whose output equals their input, such as identity transforms
+*     and block size conversions that keep the block size, are bypassed.
+*
+* A stream keeps only its current frame, so it is shared only if all of its
+* consumers read it frame by frame ('StreamInfo::lockstep'). The outputs are
+* never replaced. Optimize before the first frame or after 'reset()'.
+*
+* 'memory_usage()' collects the buffers of all streams; a worker can call
+* 'check_memory()' every few frames to enforce its budget.
+*/
+/*@{*/
+
+class StreamGraph;
+typedef refcount_ptr<StreamGraph> StreamGraphPtr;
+
+// ----- definition for class `StreamGraph' -----
+//
+class StreamGraph {
+ public:
+  StreamGraph();
+  ~StreamGraph();
+
+  void add_output(const VectorCharFeatureStreamPtr& output)    { add_(output.operator->()); }
+  void add_output(const VectorShortFeatureStreamPtr& output)   { add_(output.operator->()); }
+  void add_output(const VectorFloatFeatureStreamPtr& output)   { add_(output.operator->()); }
+  void add_output(const VectorFeatureStreamPtr& output)        { add_(output.operator->()); }
+  void add_output(const VectorComplexFeatureStreamPtr& output) { add_(output.operator->()); }
+
+  unsigned nodeN() const { return nodes_.size(); }
+  // estimated operations per frame and memory of all streams
+  double flops() const;
+  size_t bytes() const;
+
+  // one line per stream, sources before their consumers
+  String dump() const;
+
+  // bytes held by the buffers of all streams as "node name/buffer", now and at most over the calls
+  const MemoryUsage& memory_usage() const;
+  String memory_report() const { return memory_usage().report(); }
+  // throw 'jallocation_error' if the streams hold more than 'budget' bytes; 'memory_report()' tells which
+  void check_memory(size_t budget) const;
+
+  // rewire the streams and return the graph of the result; this graph keeps describing the streams before
+  StreamGraphPtr optimize();
+
+  // counts and estimated savings of the 'optimize()' that returned this graph
+  unsigned deduplicated() const { return deduplicatedN_; }
+  unsigned fused() const { return fusedN_; }
+  unsigned bypassed() const { return bypassedN_; }
+  double flops_saved() const { return flopsSaved_; }
+  long bytes_saved() const { return bytesSaved_; }
+  const String& report() const { return report_; }
+
+ private:
+  struct Node_ {
+    Countable*					stream;
+    String					cls;
+    String					type;
+    String					name;
+    unsigned					size;
+    size_t					itemsize;
+    bool					output;
+    StreamInfo					info;
+    std::vector<unsigned>			sources;
+    std::vector<std::pair<unsigned, unsigned> >	consumers;	// (node, source index)
+  };
+
+  void add_(Countable* output);
+  unsigned visit_(Countable* stream);
+  size_t node_bytes_(const Node_& node) const { return node.size * node.itemsize + node.info.bytes; }
+  bool lockstep_(const std::vector<std::pair<unsigned, unsigned> >& consumers) const;
+  unsigned rewire_(std::vector<std::vector<std::pair<unsigned, unsigned> > >& consumers, unsigned from, unsigned to);
+  void drop_consumer_(std::vector<std::vector<std::pair<unsigned, unsigned> > >& consumers,
+		      const std::vector<unsigned>& sources, unsigned nodeX);
+
+  std::vector<Node_>				nodes_;
+  std::vector<refcountable_ptr<Countable> >	held_;
+  std::map<Countable*, unsigned>		index_;
+  std::map<Countable*, bool>			visiting_;
+  mutable MemoryUsage				memory_;
+
+  unsigned					deduplicatedN_;
+  unsigned					fusedN_;
+  unsigned					bypassedN_;
+  double					flopsSaved_;
+  long						bytesSaved_;
+  String					report_;
+};
+
+/*@}*/
+
+#endif
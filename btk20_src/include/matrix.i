@@ -131,6 +131,34 @@
   }
 }
 
+// gsl_matrix_float typemaps: only for the argument 'block' of 'next_block()',
+// which is written in place and must therefore not be a copy
+%typemap(in) gsl_matrix_float* block %{
+  PyArrayObject *_PyMatrix$argnum;
+  gsl_matrix_float_view matrix$argnum;
+  {
+    _PyMatrix$argnum = (PyArrayObject*)
+      PyArray_ContiguousFromObject($input, PyArray_FLOAT, 2, 2);
+    if (_PyMatrix$argnum == NULL)
+      return NULL;
+    if ((PyObject*)_PyMatrix$argnum != $input) {
+      Py_DECREF(_PyMatrix$argnum);
+      PyErr_SetString(PyExc_TypeError, "block must be a contiguous 2-d float32 array");
+      return NULL;
+    }
+    matrix$argnum
+      = gsl_matrix_float_view_array((float*)_PyMatrix$argnum->data,
+				    _PyMatrix$argnum->dimensions[0],
+				    _PyMatrix$argnum->dimensions[1]);
+    $1 = &matrix$argnum.matrix;
+  }
+%}
+
+%typemap(freearg) gsl_matrix_float* block {
+  if (_PyMatrix$argnum != NULL)
+    Py_DECREF(_PyMatrix$argnum);
+}
+
 // gsl_matrix_complex typemaps
 %typemap(in) gsl_matrix_complex* %{
   PyArrayObject *_PyMatrix$argnum;
@@ -1119,45 +1119,41 @@ class SubbandSOSBatchBeamformer(SubbandBeamformer):
         :param samplerate: sampling rate
         :type samplerate: int
         :param mask_t: TF mask whose element indicates the activity of the target source
-        :type mask_t: "no. frames" x "no. subbands" float matrix
+        :type mask_t: "no. frames" x "no. subbands" float matrix or TFMaskFeaturePtr
         :param mask_j: TF mask, indicator of the noise presence
-        :type mask_j: "no. frames" x "no. subbands" float matrix
+        :type mask_j: "no. frames" x "no. subbands" float matrix or TFMaskFeaturePtr
         """
 
-        target_frame_counts = numpy.zeros(self._fftlen2+1, numpy.int)
-        noise_frame_counts  = numpy.zeros(self._fftlen2+1, numpy.int)
-        target_covariance_matrices = numpy.zeros((self._fftlen2+1, self._chan_num, self._chan_num), numpy.complex)
-        noise_covariance_matrices  = numpy.zeros((self._fftlen2+1, self._chan_num, self._chan_num), numpy.complex)
+        # the weighted outer products of all the bins are accumulated in one C++ call per frame
+        accumulator = MaskedSOSAccumulatorPtr(self._array_source._snapshot_array)
         frame_no = 0
         while True: # Process all the frames in one utterance (batch)
             try:
                 energy = self._array_source.update_snapshot_array(chan_no = 0) / self._fftlen
+                if isinstance(mask_t, TFMaskFeaturePtr):
+                    frame_mask_t = mask_t.next()
+                    frame_mask_j = mask_j.next()
+                else:
+                    frame_mask_t = mask_t[frame_no]
+                    frame_mask_j = mask_j[frame_no]
                 if energy > energy_threshold:
-                    for m in range(self._fftlen2+1):
-                        if mask_t[frame_no][m] > 0 or  mask_j[frame_no][m] > 0:
-                            XK = self._array_source.get_snapshot(m)
-                            SigmaXX = numpy.outer(XK, numpy.conjugate(XK))
-                            # accumulate SOS for the target source
-                            if mask_t[frame_no][m] > 0:
-                                target_frame_counts[m] += mask_t[frame_no][m]
-                                target_covariance_matrices[m] += mask_t[frame_no][m] * SigmaXX
-                            # accumulate SOS for the noise source
-                            if mask_j[frame_no][m] > 0:
-                                noise_frame_counts[m] += mask_j[frame_no][m]
-                                noise_covariance_matrices[m] += mask_j[frame_no][m] * SigmaXX
+                    accumulator.accumulate(frame_mask_t, frame_mask_j)
             except StopIteration:
                 break
 
             frame_no += 1
 
-        # accumulate stats for spatial covariance matrices.
-        self._target_frame_counts += target_frame_counts
+        target_covariance_matrices = numpy.array([accumulator.target_covariance(m) for m in range(self._fftlen2+1)])
+        noise_covariance_matrices  = numpy.array([accumulator.noise_covariance(m) for m in range(self._fftlen2+1)])
+
+        # accumulate stats for spatial covariance matrices; the counts are the sums of the mask values.
+        self._target_frame_counts = self._target_frame_counts + numpy.array(accumulator.target_weights())
         if self._target_covariance_matrices is None:
             self._target_covariance_matrices = target_covariance_matrices
         else:
             self._target_covariance_matrices += target_covariance_matrices
 
-        self._noise_frame_counts += noise_frame_counts
+        self._noise_frame_counts = self._noise_frame_counts + numpy.array(accumulator.noise_weights())
         if self._noise_covariance_matrices is None:
             self._noise_covariance_matrices = noise_covariance_matrices
         else:
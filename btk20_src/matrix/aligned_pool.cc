@@ -0,0 +1,514 @@
+/**
+ * @file aligned_pool.cc
+ * @brief Aligned, pooled storage for GSL vectors and matrices.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "common/jexception.h"
+#include "matrix/aligned_pool.h"
+
+#ifndef BTK20_GSL_POOL_DEFAULT
+#define BTK20_GSL_POOL_DEFAULT "pooled"
+#endif
+
+
+// ----- chunk layout -----
+//
+// A chunk holds the header, padded to a multiple of the alignment, followed
+// by the data. The GSL object and its block live in the header, so that
+// the object is released with a single call and found from its address.
+//
+namespace {
+
+const unsigned ChunkMagic_ = 0x42544b50;
+const unsigned MinClass_   = 6;		// 64 bytes
+const unsigned MaxClass_   = 26;	// 64 MB; larger chunks are never cached
+const unsigned Unpooled_   = ~0U;
+
+struct ChunkHeader_ {
+  unsigned			magic;
+  unsigned			classX;		// size class, or 'Unpooled_'
+  size_t			capacity;	// bytes of data
+  ChunkHeader_*			next;		// on the free list
+  union {
+    gsl_block			real;
+    gsl_block_float		flt;
+    gsl_block_complex		cplx;
+  } block;
+  union {
+    gsl_vector			vec;
+    gsl_vector_float		vecf;
+    gsl_vector_complex		vecc;
+    gsl_matrix			mat;
+    gsl_matrix_float		matf;
+    gsl_matrix_complex		matc;
+  } object;
+};
+
+const size_t HeaderSize_ = (sizeof(ChunkHeader_) + GSLAlignedPool::Alignment - 1) & ~(GSLAlignedPool::Alignment - 1);
+
+struct PoolState_ {
+  PoolState_();
+
+  pthread_mutex_t		mutex;
+  GSLAlignedPool::Mode		mode;
+  ChunkHeader_*			freeList[MaxClass_ + 1];
+  size_t			maxCached;
+  size_t			cached;
+  size_t			inUse;
+  unsigned long			allocs;
+  unsigned long			reuses;
+  unsigned long			heapAllocs;
+  unsigned long			heapReleases;
+};
+
+bool parse_mode_(const char* name, GSLAlignedPool::Mode& mode)
+{
+  if (strcmp(name, "system") == 0 || strcmp(name, "off") == 0) { mode = GSLAlignedPool::System;  return true; }
+  if (strcmp(name, "aligned") == 0)                            { mode = GSLAlignedPool::Aligned; return true; }
+  if (strcmp(name, "pooled") == 0 || strcmp(name, "on") == 0)  { mode = GSLAlignedPool::Pooled;  return true; }
+  return false;
+}
+
+PoolState_::PoolState_()
+  : mode(GSLAlignedPool::Pooled), maxCached(64 * 1024 * 1024), cached(0), inUse(0),
+    allocs(0), reuses(0), heapAllocs(0), heapReleases(0)
+{
+  pthread_mutex_init(&mutex, NULL);
+  for (unsigned classX = 0; classX <= MaxClass_; classX++)
+    freeList[classX] = NULL;
+
+  parse_mode_(BTK20_GSL_POOL_DEFAULT, mode);
+  const char* env = getenv("BTK20_GSL_POOL");
+  if (env != NULL && parse_mode_(env, mode) == false)
+    fprintf(stderr, "Ignoring BTK20_GSL_POOL='%s'; use 'system', 'aligned' or 'pooled'.\n", env);
+}
+
+// never destroyed: objects may be released by the destructors of other static objects
+PoolState_& state_()
+{
+  static PoolState_* state = new PoolState_();
+  return *state;
+}
+
+unsigned class_of_(size_t bytes)
+{
+  unsigned classX = MinClass_;
+  while (classX <= MaxClass_ && (size_t(1) << classX) < bytes)
+    classX++;
+  return classX;
+}
+
+// return the free lists to the heap; the mutex must be held
+void clear_free_lists_(PoolState_& s)
+{
+  for (unsigned classX = MinClass_; classX <= MaxClass_; classX++) {
+    while (s.freeList[classX] != NULL) {
+      ChunkHeader_* chunk = s.freeList[classX];
+      s.freeList[classX] = chunk->next;
+      s.cached -= chunk->capacity;
+      s.heapReleases++;
+      free(chunk);
+    }
+  }
+}
+
+// a chunk with at least 'bytes' of data; NULL in the 'System' mode
+ChunkHeader_* acquire_(size_t bytes, bool zero)
+{
+  PoolState_& s = state_();
+  if (bytes == 0) bytes = 1;
+
+  pthread_mutex_lock(&s.mutex);
+  s.allocs++;
+  if (s.mode == GSLAlignedPool::System) {
+    pthread_mutex_unlock(&s.mutex);
+    return NULL;
+  }
+
+  unsigned classX   = Unpooled_;
+  size_t   capacity = bytes;
+  if (s.mode == GSLAlignedPool::Pooled) {
+    unsigned cls = class_of_(bytes);
+    if (cls <= MaxClass_) {
+      classX   = cls;
+      capacity = size_t(1) << classX;
+      ChunkHeader_* chunk = s.freeList[classX];
+      if (chunk != NULL) {
+	s.freeList[classX] = chunk->next;
+	s.cached -= capacity;
+	s.inUse  += capacity;
+	s.reuses++;
+	pthread_mutex_unlock(&s.mutex);
+
+	chunk->next = NULL;
+	if (zero) memset((char*) chunk + HeaderSize_, 0, capacity);
+	return chunk;
+      }
+    }
+  }
+  s.inUse += capacity;
+  s.heapAllocs++;
+  pthread_mutex_unlock(&s.mutex);
+
+  void* mem = NULL;
+  if (posix_memalign(&mem, GSLAlignedPool::Alignment, HeaderSize_ + capacity) != 0) {
+    pthread_mutex_lock(&s.mutex);
+    s.inUse -= capacity;
+    s.heapAllocs--;
+    pthread_mutex_unlock(&s.mutex);
+    throw jallocation_error("Could not allocate %lu aligned bytes.", (unsigned long) (HeaderSize_ + capacity));
+  }
+
+  ChunkHeader_* chunk = (ChunkHeader_*) mem;
+  chunk->magic    = ChunkMagic_;
+  chunk->classX   = classX;
+  chunk->capacity = capacity;
+  chunk->next     = NULL;
+  if (zero) memset((char*) chunk + HeaderSize_, 0, capacity);
+
+  return chunk;
+}
+
+void release_(ChunkHeader_* chunk)
+{
+  if (chunk->magic != ChunkMagic_)
+    throw jconsistency_error("Object was not allocated with a 'gsl_*_aligned_alloc()' function.");
+
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  s.inUse -= chunk->capacity;
+  if (chunk->classX != Unpooled_ && s.mode == GSLAlignedPool::Pooled && s.cached + chunk->capacity <= s.maxCached) {
+    chunk->next = s.freeList[chunk->classX];
+    s.freeList[chunk->classX] = chunk;
+    s.cached += chunk->capacity;
+    pthread_mutex_unlock(&s.mutex);
+    return;
+  }
+  s.heapReleases++;
+  pthread_mutex_unlock(&s.mutex);
+
+  chunk->magic = 0;
+  free(chunk);
+}
+
+template <class Object>
+ChunkHeader_* header_of_(Object* object)
+{
+  return (ChunkHeader_*) ((char*) object - offsetof(ChunkHeader_, object));
+}
+
+// 'Atom' is the type of the data pointer; a complex element is 'atomN' = 2 of them
+template <class Vector, class Block, class Atom>
+Vector* vector_alloc_(size_t n, unsigned atomN, bool zero)
+{
+  ChunkHeader_* chunk = acquire_(n * atomN * sizeof(Atom), zero);
+  if (chunk == NULL) return NULL;
+
+  Block*  block = (Block*) &chunk->block;
+  Vector* v     = (Vector*) &chunk->object;
+  block->size = n;
+  block->data = (Atom*) ((char*) chunk + HeaderSize_);
+  v->size   = n;
+  v->stride = 1;
+  v->data   = block->data;
+  v->block  = block;
+  v->owner  = 0;
+
+  return v;
+}
+
+template <class Matrix, class Block, class Atom>
+Matrix* matrix_alloc_(size_t n1, size_t n2, unsigned atomN, bool zero)
+{
+  ChunkHeader_* chunk = acquire_(n1 * n2 * atomN * sizeof(Atom), zero);
+  if (chunk == NULL) return NULL;
+
+  Block*  block = (Block*) &chunk->block;
+  Matrix* m     = (Matrix*) &chunk->object;
+  block->size = n1 * n2;
+  block->data = (Atom*) ((char*) chunk + HeaderSize_);
+  m->size1 = n1;
+  m->size2 = n2;
+  m->tda   = n2;
+  m->data  = block->data;
+  m->block = block;
+  m->owner = 0;
+
+  return m;
+}
+
+}
+
+
+// ----- allocation functions -----
+//
+// Objects of the 'System' mode own their block, those of the pool do not.
+//
+gsl_vector* gsl_vector_aligned_alloc(size_t n)
+{
+  gsl_vector* v = vector_alloc_<gsl_vector, gsl_block, double>(n, 1, false);
+  return (v != NULL) ? v : gsl_vector_alloc(n);
+}
+
+gsl_vector* gsl_vector_aligned_calloc(size_t n)
+{
+  gsl_vector* v = vector_alloc_<gsl_vector, gsl_block, double>(n, 1, true);
+  return (v != NULL) ? v : gsl_vector_calloc(n);
+}
+
+void gsl_vector_aligned_free(gsl_vector* v)
+{
+  if (v == NULL) return;
+  if (v->owner) gsl_vector_free(v); else release_(header_of_(v));
+}
+
+gsl_vector_float* gsl_vector_float_aligned_alloc(size_t n)
+{
+  gsl_vector_float* v = vector_alloc_<gsl_vector_float, gsl_block_float, float>(n, 1, false);
+  return (v != NULL) ? v : gsl_vector_float_alloc(n);
+}
+
+gsl_vector_float* gsl_vector_float_aligned_calloc(size_t n)
+{
+  gsl_vector_float* v = vector_alloc_<gsl_vector_float, gsl_block_float, float>(n, 1, true);
+  return (v != NULL) ? v : gsl_vector_float_calloc(n);
+}
+
+void gsl_vector_float_aligned_free(gsl_vector_float* v)
+{
+  if (v == NULL) return;
+  if (v->owner) gsl_vector_float_free(v); else release_(header_of_(v));
+}
+
+gsl_vector_complex* gsl_vector_complex_aligned_alloc(size_t n)
+{
+  gsl_vector_complex* v = vector_alloc_<gsl_vector_complex, gsl_block_complex, double>(n, 2, false);
+  return (v != NULL) ? v : gsl_vector_complex_alloc(n);
+}
+
+gsl_vector_complex* gsl_vector_complex_aligned_calloc(size_t n)
+{
+  gsl_vector_complex* v = vector_alloc_<gsl_vector_complex, gsl_block_complex, double>(n, 2, true);
+  return (v != NULL) ? v : gsl_vector_complex_calloc(n);
+}
+
+void gsl_vector_complex_aligned_free(gsl_vector_complex* v)
+{
+  if (v == NULL) return;
+  if (v->owner) gsl_vector_complex_free(v); else release_(header_of_(v));
+}
+
+gsl_matrix* gsl_matrix_aligned_alloc(size_t n1, size_t n2)
+{
+  gsl_matrix* m = matrix_alloc_<gsl_matrix, gsl_block, double>(n1, n2, 1, false);
+  return (m != NULL) ? m : gsl_matrix_alloc(n1, n2);
+}
+
+gsl_matrix* gsl_matrix_aligned_calloc(size_t n1, size_t n2)
+{
+  gsl_matrix* m = matrix_alloc_<gsl_matrix, gsl_block, double>(n1, n2, 1, true);
+  return (m != NULL) ? m : gsl_matrix_calloc(n1, n2);
+}
+
+void gsl_matrix_aligned_free(gsl_matrix* m)
+{
+  if (m == NULL) return;
+  if (m->owner) gsl_matrix_free(m); else release_(header_of_(m));
+}
+
+gsl_matrix_float* gsl_matrix_float_aligned_alloc(size_t n1, size_t n2)
+{
+  gsl_matrix_float* m = matrix_alloc_<gsl_matrix_float, gsl_block_float, float>(n1, n2, 1, false);
+  return (m != NULL) ? m : gsl_matrix_float_alloc(n1, n2);
+}
+
+gsl_matrix_float* gsl_matrix_float_aligned_calloc(size_t n1, size_t n2)
+{
+  gsl_matrix_float* m = matrix_alloc_<gsl_matrix_float, gsl_block_float, float>(n1, n2, 1, true);
+  return (m != NULL) ? m : gsl_matrix_float_calloc(n1, n2);
+}
+
+void gsl_matrix_float_aligned_free(gsl_matrix_float* m)
+{
+  if (m == NULL) return;
+  if (m->owner) gsl_matrix_float_free(m); else release_(header_of_(m));
+}
+
+gsl_matrix_complex* gsl_matrix_complex_aligned_alloc(size_t n1, size_t n2)
+{
+  gsl_matrix_complex* m = matrix_alloc_<gsl_matrix_complex, gsl_block_complex, double>(n1, n2, 2, false);
+  return (m != NULL) ? m : gsl_matrix_complex_alloc(n1, n2);
+}
+
+gsl_matrix_complex* gsl_matrix_complex_aligned_calloc(size_t n1, size_t n2)
+{
+  gsl_matrix_complex* m = matrix_alloc_<gsl_matrix_complex, gsl_block_complex, double>(n1, n2, 2, true);
+  return (m != NULL) ? m : gsl_matrix_complex_calloc(n1, n2);
+}
+
+void gsl_matrix_complex_aligned_free(gsl_matrix_complex* m)
+{
+  if (m == NULL) return;
+  if (m->owner) gsl_matrix_complex_free(m); else release_(header_of_(m));
+}
+
+
+// ----- methods for class `GSLAlignedPool' -----
+//
+void GSLAlignedPool::set_mode(Mode mode)
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  s.mode = mode;
+  if (mode != Pooled) clear_free_lists_(s);
+  pthread_mutex_unlock(&s.mutex);
+}
+
+void GSLAlignedPool::set_mode(const String& name)
+{
+  Mode mode;
+  if (parse_mode_(name.c_str(), mode) == false)
+    throw jparameter_error("Unknown allocation mode '%s'; use 'system', 'aligned' or 'pooled'.", name.c_str());
+  set_mode(mode);
+}
+
+GSLAlignedPool::Mode GSLAlignedPool::mode()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  Mode mode = s.mode;
+  pthread_mutex_unlock(&s.mutex);
+
+  return mode;
+}
+
+const char* GSLAlignedPool::mode_name(Mode mode)
+{
+  switch (mode) {
+  case System:  return "system";
+  case Aligned: return "aligned";
+  default:      return "pooled";
+  }
+}
+
+void GSLAlignedPool::set_max_cached_bytes(size_t maxBytes)
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  s.maxCached = maxBytes;
+  if (s.cached > s.maxCached) clear_free_lists_(s);
+  pthread_mutex_unlock(&s.mutex);
+}
+
+size_t GSLAlignedPool::max_cached_bytes()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  size_t maxBytes = s.maxCached;
+  pthread_mutex_unlock(&s.mutex);
+
+  return maxBytes;
+}
+
+unsigned long GSLAlignedPool::allocations()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  unsigned long allocs = s.allocs;
+  pthread_mutex_unlock(&s.mutex);
+
+  return allocs;
+}
+
+unsigned long GSLAlignedPool::reuses()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  unsigned long reuses = s.reuses;
+  pthread_mutex_unlock(&s.mutex);
+
+  return reuses;
+}
+
+unsigned long GSLAlignedPool::heap_allocations()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  unsigned long heapAllocs = s.heapAllocs;
+  pthread_mutex_unlock(&s.mutex);
+
+  return heapAllocs;
+}
+
+unsigned long GSLAlignedPool::heap_releases()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  unsigned long heapReleases = s.heapReleases;
+  pthread_mutex_unlock(&s.mutex);
+
+  return heapReleases;
+}
+
+size_t GSLAlignedPool::bytes_in_use()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  size_t inUse = s.inUse;
+  pthread_mutex_unlock(&s.mutex);
+
+  return inUse;
+}
+
+size_t GSLAlignedPool::bytes_cached()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  size_t cached = s.cached;
+  pthread_mutex_unlock(&s.mutex);
+
+  return cached;
+}
+
+void GSLAlignedPool::clear()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  clear_free_lists_(s);
+  pthread_mutex_unlock(&s.mutex);
+}
+
+void GSLAlignedPool::reset_statistics()
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  s.allocs = s.reuses = s.heapAllocs = s.heapReleases = 0;
+  pthread_mutex_unlock(&s.mutex);
+}
+
+void GSLAlignedPool::report(FILE* fp)
+{
+  PoolState_& s = state_();
+
+  pthread_mutex_lock(&s.mutex);
+  fprintf(fp, "GSL aligned pool (%s): %lu allocations, %lu reused (%0.2f %%), %lu heap allocations, %lu heap releases, %0.2f MB in use, %0.2f of %0.2f MB cached\n",
+	  mode_name(s.mode), s.allocs, s.reuses, (s.allocs == 0) ? 0.0 : 100.0 * s.reuses / s.allocs,
+	  s.heapAllocs, s.heapReleases, s.inUse / 1048576.0, s.cached / 1048576.0, s.maxCached / 1048576.0);
+  pthread_mutex_unlock(&s.mutex);
+}
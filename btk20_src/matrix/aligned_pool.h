@@ -0,0 +1,100 @@
+/**
+ * @file aligned_pool.h
+ * @brief Aligned, pooled storage for GSL vectors and matrices.
+ */
+
+#ifndef ALIGNED_POOL_H
+#define ALIGNED_POOL_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include "common/mlist.h"
+
+/**
+* \defgroup GSLAlignedPool Aligned Pool for GSL Objects
+* 'gsl_vector_complex_alloc()' and its relatives make three heap requests
+* per object, and the data get only the alignment of 'malloc()'. The
+* functions below return ordinary GSL vectors and matrices whose data start
+* on a 64-byte boundary; the object, its block and the data share a single
+* chunk. Released chunks are kept on free lists of power-of-two size classes
+* and handed out again, so that temporaries allocated in 'next()' cause no
+* heap traffic once the stream runs.
+*
+* The allocation mode is chosen when the first object is allocated: from the
+* environment variable BTK20_GSL_POOL if it is set, otherwise from the
+* CMake option of the same name; 'set_mode()' changes it at any time:
+*
+*   - "pooled":  aligned chunks recycled through the free lists (default),
+*   - "aligned": aligned chunks returned to the heap at once,
+*   - "system":  plain 'gsl_*_alloc()' and 'gsl_*_free()'.
+*
+* An object must be released with the matching 'gsl_*_aligned_free()', which
+* accepts objects of every mode; 'gsl_*_free()' must not be used on it.
+* Views of the objects are ordinary GSL views. All functions are
+* thread-safe.
+*/
+/*@{*/
+
+gsl_vector* gsl_vector_aligned_alloc(size_t n);
+gsl_vector* gsl_vector_aligned_calloc(size_t n);
+void gsl_vector_aligned_free(gsl_vector* v);
+
+gsl_vector_float* gsl_vector_float_aligned_alloc(size_t n);
+gsl_vector_float* gsl_vector_float_aligned_calloc(size_t n);
+void gsl_vector_float_aligned_free(gsl_vector_float* v);
+
+gsl_vector_complex* gsl_vector_complex_aligned_alloc(size_t n);
+gsl_vector_complex* gsl_vector_complex_aligned_calloc(size_t n);
+void gsl_vector_complex_aligned_free(gsl_vector_complex* v);
+
+gsl_matrix* gsl_matrix_aligned_alloc(size_t n1, size_t n2);
+gsl_matrix* gsl_matrix_aligned_calloc(size_t n1, size_t n2);
+void gsl_matrix_aligned_free(gsl_matrix* m);
+
+gsl_matrix_float* gsl_matrix_float_aligned_alloc(size_t n1, size_t n2);
+gsl_matrix_float* gsl_matrix_float_aligned_calloc(size_t n1, size_t n2);
+void gsl_matrix_float_aligned_free(gsl_matrix_float* m);
+
+gsl_matrix_complex* gsl_matrix_complex_aligned_alloc(size_t n1, size_t n2);
+gsl_matrix_complex* gsl_matrix_complex_aligned_calloc(size_t n1, size_t n2);
+void gsl_matrix_complex_aligned_free(gsl_matrix_complex* m);
+
+
+// ----- definition for class `GSLAlignedPool' -----
+//
+class GSLAlignedPool {
+ public:
+  enum Mode { System = 0, Aligned = 1, Pooled = 2 };
+
+  static const size_t Alignment = 64;
+
+  static void set_mode(Mode mode);
+  // "system", "aligned" or "pooled"
+  static void set_mode(const String& name);
+  static Mode mode();
+  static const char* mode_name(Mode mode);
+
+  // bound on the memory kept on the free lists
+  static void   set_max_cached_bytes(size_t maxBytes);
+  static size_t max_cached_bytes();
+
+  // objects handed out, and how many of them came from the free lists
+  static unsigned long allocations();
+  static unsigned long reuses();
+  // chunks requested from and returned to the heap
+  static unsigned long heap_allocations();
+  static unsigned long heap_releases();
+  static size_t        bytes_in_use();
+  static size_t        bytes_cached();
+
+  // return the free lists to the heap
+  static void clear();
+  static void reset_statistics();
+  static void report(FILE* fp = stdout);
+};
+
+/*@}*/
+
+#endif
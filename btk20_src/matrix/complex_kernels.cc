@@ -0,0 +1,789 @@
+/**
+ * @file complex_kernels.cc
+ * @brief Vectorized kernels on interleaved double-complex arrays.
+ *
+ * Must be compiled with -ffp-contract=off: a multiply-add fused by the
+ * compiler in one implementation but not in another breaks the bit-for-bit
+ * agreement.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "common/jexception.h"
+#include "matrix/complex_kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BTK_KERNELS_X86
+#include <immintrin.h>
+#define BTK_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#if defined(__aarch64__)
+#define BTK_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+
+// ----- scalar implementation -----
+//
+// The reference for all others; the order of the operations is the one of
+// 'gsl_complex_mul()' and 'gsl_complex_abs2()'.
+//
+static void mul_scalar_(size_t n, const double* a, const double* b, double* y)
+{
+  for (size_t i = 0; i < 2 * n; i += 2) {
+    double ar = a[i], ai = a[i + 1], br = b[i], bi = b[i + 1];
+    y[i]     = ar * br - ai * bi;
+    y[i + 1] = ar * bi + ai * br;
+  }
+}
+
+static void mul_conj_scalar_(size_t n, const double* a, const double* b, double* y)
+{
+  for (size_t i = 0; i < 2 * n; i += 2) {
+    double ar = a[i], ai = a[i + 1], br = b[i], bi = b[i + 1];
+    y[i]     = ar * br + ai * bi;
+    y[i + 1] = ar * bi - ai * br;
+  }
+}
+
+static void scale_scalar_(size_t n, const double* alpha, const double* x, double* y)
+{
+  double ar = alpha[0], ai = alpha[1];
+  for (size_t i = 0; i < 2 * n; i += 2) {
+    double xr = x[i], xi = x[i + 1];
+    y[i]     = xr * ar - xi * ai;
+    y[i + 1] = xr * ai + xi * ar;
+  }
+}
+
+static void scale_real_scalar_(size_t n, double alpha, const double* x, double* y)
+{
+  for (size_t i = 0; i < 2 * n; i++)
+    y[i] = alpha * x[i];
+}
+
+static void axpy_scalar_(size_t n, const double* alpha, const double* x, double* y)
+{
+  double ar = alpha[0], ai = alpha[1];
+  for (size_t i = 0; i < 2 * n; i += 2) {
+    double xr = x[i], xi = x[i + 1];
+    y[i]     = y[i]     + (xr * ar - xi * ai);
+    y[i + 1] = y[i + 1] + (xr * ai + xi * ar);
+  }
+}
+
+static void axpy_conj_scalar_(size_t n, const double* alpha, const double* x, double* y)
+{
+  double ar = alpha[0], ai = alpha[1];
+  for (size_t i = 0; i < 2 * n; i += 2) {
+    double xr = x[i], xi = x[i + 1];
+    y[i]     = y[i]     + (xr * ar + xi * ai);
+    y[i + 1] = y[i + 1] + (xr * ai - xi * ar);
+  }
+}
+
+static void dotc_scalar_(size_t n, const double* x, const double* y, double* result)
+{
+  double re = 0.0, im = 0.0;
+  for (size_t i = 0; i < 2 * n; i += 2) {
+    re += x[i] * y[i] + x[i + 1] * y[i + 1];
+    im += x[i] * y[i + 1] - x[i + 1] * y[i];
+  }
+  result[0] = re;  result[1] = im;
+}
+
+static void abs2_scalar_(size_t n, const double* x, double* y)
+{
+  for (size_t k = 0; k < n; k++)
+    y[k] = x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1];
+}
+
+static void abs2_smooth_scalar_(size_t n, double alpha, double beta, const double* x, double* y)
+{
+  for (size_t k = 0; k < n; k++)
+    y[k] = alpha * y[k] + beta * (x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1]);
+}
+
+static const ComplexKernels::Table ScalarTable_ = {
+  ComplexKernels::Scalar, "scalar",
+  mul_scalar_, mul_conj_scalar_, scale_scalar_, scale_real_scalar_, axpy_scalar_, axpy_conj_scalar_,
+  dotc_scalar_, abs2_scalar_, abs2_smooth_scalar_
+};
+
+
+#ifdef BTK_KERNELS_X86
+
+// ----- SSE2 implementation -----
+//
+// One complex number per register.
+//
+BTK_TARGET("sse2") static inline __m128d mul_sse2_(__m128d a, __m128d b)
+{
+  const __m128d sign = _mm_set_pd(0.0, -0.0);
+  __m128d t1 = _mm_mul_pd(a, _mm_unpacklo_pd(b, b));			// ar br, ai br
+  __m128d t2 = _mm_mul_pd(_mm_shuffle_pd(a, a, 1), _mm_unpackhi_pd(b, b));	// ai bi, ar bi
+  return _mm_add_pd(t1, _mm_xor_pd(t2, sign));
+}
+
+// conj(a) b
+BTK_TARGET("sse2") static inline __m128d mul_conj_sse2_(__m128d a, __m128d b)
+{
+  const __m128d sign = _mm_set_pd(-0.0, 0.0);
+  __m128d t1 = _mm_mul_pd(a, _mm_unpacklo_pd(b, b));
+  __m128d t2 = _mm_mul_pd(_mm_shuffle_pd(a, a, 1), _mm_unpackhi_pd(b, b));
+  return _mm_add_pd(_mm_xor_pd(t1, sign), t2);
+}
+
+// |x0|^2, |x1|^2
+BTK_TARGET("sse2") static inline __m128d abs2_sse2_(__m128d x0, __m128d x1)
+{
+  __m128d s0 = _mm_mul_pd(x0, x0), s1 = _mm_mul_pd(x1, x1);
+  return _mm_add_pd(_mm_unpacklo_pd(s0, s1), _mm_unpackhi_pd(s0, s1));
+}
+
+BTK_TARGET("sse2") static void mul_sse2(size_t n, const double* a, const double* b, double* y)
+{
+  for (size_t k = 0; k < n; k++)
+    _mm_storeu_pd(y + 2 * k, mul_sse2_(_mm_loadu_pd(a + 2 * k), _mm_loadu_pd(b + 2 * k)));
+}
+
+BTK_TARGET("sse2") static void mul_conj_sse2(size_t n, const double* a, const double* b, double* y)
+{
+  for (size_t k = 0; k < n; k++)
+    _mm_storeu_pd(y + 2 * k, mul_conj_sse2_(_mm_loadu_pd(a + 2 * k), _mm_loadu_pd(b + 2 * k)));
+}
+
+BTK_TARGET("sse2") static void scale_sse2(size_t n, const double* alpha, const double* x, double* y)
+{
+  __m128d al = _mm_loadu_pd(alpha);
+  for (size_t k = 0; k < n; k++)
+    _mm_storeu_pd(y + 2 * k, mul_sse2_(_mm_loadu_pd(x + 2 * k), al));
+}
+
+BTK_TARGET("sse2") static void scale_real_sse2(size_t n, double alpha, const double* x, double* y)
+{
+  __m128d al = _mm_set1_pd(alpha);
+  for (size_t k = 0; k < n; k++)
+    _mm_storeu_pd(y + 2 * k, _mm_mul_pd(al, _mm_loadu_pd(x + 2 * k)));
+}
+
+BTK_TARGET("sse2") static void axpy_sse2(size_t n, const double* alpha, const double* x, double* y)
+{
+  __m128d al = _mm_loadu_pd(alpha);
+  for (size_t k = 0; k < n; k++)
+    _mm_storeu_pd(y + 2 * k, _mm_add_pd(_mm_loadu_pd(y + 2 * k), mul_sse2_(_mm_loadu_pd(x + 2 * k), al)));
+}
+
+BTK_TARGET("sse2") static void axpy_conj_sse2(size_t n, const double* alpha, const double* x, double* y)
+{
+  __m128d al = _mm_loadu_pd(alpha);
+  for (size_t k = 0; k < n; k++)
+    _mm_storeu_pd(y + 2 * k, _mm_add_pd(_mm_loadu_pd(y + 2 * k), mul_conj_sse2_(_mm_loadu_pd(x + 2 * k), al)));
+}
+
+BTK_TARGET("sse2") static void dotc_sse2(size_t n, const double* x, const double* y, double* result)
+{
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  size_t  k    = 0;
+  for (; k + 2 <= n; k += 2) {
+    acc0 = _mm_add_pd(acc0, mul_conj_sse2_(_mm_loadu_pd(x + 2 * k),     _mm_loadu_pd(y + 2 * k)));
+    acc1 = _mm_add_pd(acc1, mul_conj_sse2_(_mm_loadu_pd(x + 2 * k + 2), _mm_loadu_pd(y + 2 * k + 2)));
+  }
+  if (k < n)
+    acc0 = _mm_add_pd(acc0, mul_conj_sse2_(_mm_loadu_pd(x + 2 * k), _mm_loadu_pd(y + 2 * k)));
+  _mm_storeu_pd(result, _mm_add_pd(acc0, acc1));
+}
+
+BTK_TARGET("sse2") static void abs2_sse2(size_t n, const double* x, double* y)
+{
+  size_t k = 0;
+  for (; k + 2 <= n; k += 2)
+    _mm_storeu_pd(y + k, abs2_sse2_(_mm_loadu_pd(x + 2 * k), _mm_loadu_pd(x + 2 * k + 2)));
+  abs2_scalar_(n - k, x + 2 * k, y + k);
+}
+
+BTK_TARGET("sse2") static void abs2_smooth_sse2(size_t n, double alpha, double beta, const double* x, double* y)
+{
+  __m128d al = _mm_set1_pd(alpha), be = _mm_set1_pd(beta);
+  size_t  k  = 0;
+  for (; k + 2 <= n; k += 2) {
+    __m128d p = abs2_sse2_(_mm_loadu_pd(x + 2 * k), _mm_loadu_pd(x + 2 * k + 2));
+    _mm_storeu_pd(y + k, _mm_add_pd(_mm_mul_pd(al, _mm_loadu_pd(y + k)), _mm_mul_pd(be, p)));
+  }
+  abs2_smooth_scalar_(n - k, alpha, beta, x + 2 * k, y + k);
+}
+
+static const ComplexKernels::Table SSE2Table_ = {
+  ComplexKernels::SSE2, "sse2",
+  mul_sse2, mul_conj_sse2, scale_sse2, scale_real_sse2, axpy_sse2, axpy_conj_sse2,
+  dotc_sse2, abs2_sse2, abs2_smooth_sse2
+};
+
+
+// ----- AVX2 implementation -----
+//
+// Two complex numbers per register; the odd one at the end goes through the
+// scalar code, which performs the same operations.
+//
+BTK_TARGET("avx2") static inline __m256d mul_avx2_(__m256d a, __m256d b)
+{
+  __m256d t1 = _mm256_mul_pd(a, _mm256_movedup_pd(b));
+  __m256d t2 = _mm256_mul_pd(_mm256_permute_pd(a, 0x5), _mm256_permute_pd(b, 0xF));
+  return _mm256_addsub_pd(t1, t2);
+}
+
+BTK_TARGET("avx2") static inline __m256d mul_conj_avx2_(__m256d a, __m256d b)
+{
+  const __m256d sign = _mm256_set_pd(-0.0, 0.0, -0.0, 0.0);
+  __m256d t1 = _mm256_mul_pd(a, _mm256_movedup_pd(b));
+  __m256d t2 = _mm256_mul_pd(_mm256_permute_pd(a, 0x5), _mm256_permute_pd(b, 0xF));
+  return _mm256_add_pd(_mm256_xor_pd(t1, sign), t2);
+}
+
+// |x0|^2, ..., |x3|^2 of the four numbers in 'x01' and 'x23'
+BTK_TARGET("avx2") static inline __m256d abs2_avx2_(__m256d x01, __m256d x23)
+{
+  __m256d h = _mm256_hadd_pd(_mm256_mul_pd(x01, x01), _mm256_mul_pd(x23, x23));	// x0, x2, x1, x3
+  return _mm256_permute4x64_pd(h, 0xD8);
+}
+
+BTK_TARGET("avx2") static void mul_avx2(size_t n, const double* a, const double* b, double* y)
+{
+  size_t k = 0;
+  for (; k + 2 <= n; k += 2)
+    _mm256_storeu_pd(y + 2 * k, mul_avx2_(_mm256_loadu_pd(a + 2 * k), _mm256_loadu_pd(b + 2 * k)));
+  mul_scalar_(n - k, a + 2 * k, b + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx2") static void mul_conj_avx2(size_t n, const double* a, const double* b, double* y)
+{
+  size_t k = 0;
+  for (; k + 2 <= n; k += 2)
+    _mm256_storeu_pd(y + 2 * k, mul_conj_avx2_(_mm256_loadu_pd(a + 2 * k), _mm256_loadu_pd(b + 2 * k)));
+  mul_conj_scalar_(n - k, a + 2 * k, b + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx2") static void scale_avx2(size_t n, const double* alpha, const double* x, double* y)
+{
+  __m256d al = _mm256_set_pd(alpha[1], alpha[0], alpha[1], alpha[0]);
+  size_t  k  = 0;
+  for (; k + 2 <= n; k += 2)
+    _mm256_storeu_pd(y + 2 * k, mul_avx2_(_mm256_loadu_pd(x + 2 * k), al));
+  scale_scalar_(n - k, alpha, x + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx2") static void scale_real_avx2(size_t n, double alpha, const double* x, double* y)
+{
+  __m256d al = _mm256_set1_pd(alpha);
+  size_t  k  = 0;
+  for (; k + 2 <= n; k += 2)
+    _mm256_storeu_pd(y + 2 * k, _mm256_mul_pd(al, _mm256_loadu_pd(x + 2 * k)));
+  scale_real_scalar_(n - k, alpha, x + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx2") static void axpy_avx2(size_t n, const double* alpha, const double* x, double* y)
+{
+  __m256d al = _mm256_set_pd(alpha[1], alpha[0], alpha[1], alpha[0]);
+  size_t  k  = 0;
+  for (; k + 2 <= n; k += 2)
+    _mm256_storeu_pd(y + 2 * k, _mm256_add_pd(_mm256_loadu_pd(y + 2 * k), mul_avx2_(_mm256_loadu_pd(x + 2 * k), al)));
+  axpy_scalar_(n - k, alpha, x + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx2") static void axpy_conj_avx2(size_t n, const double* alpha, const double* x, double* y)
+{
+  __m256d al = _mm256_set_pd(alpha[1], alpha[0], alpha[1], alpha[0]);
+  size_t  k  = 0;
+  for (; k + 2 <= n; k += 2)
+    _mm256_storeu_pd(y + 2 * k, _mm256_add_pd(_mm256_loadu_pd(y + 2 * k), mul_conj_avx2_(_mm256_loadu_pd(x + 2 * k), al)));
+  axpy_conj_scalar_(n - k, alpha, x + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx2") static void dotc_avx2(size_t n, const double* x, const double* y, double* result)
+{
+  __m256d acc = _mm256_setzero_pd();
+  size_t  k   = 0;
+  for (; k + 2 <= n; k += 2)
+    acc = _mm256_add_pd(acc, mul_conj_avx2_(_mm256_loadu_pd(x + 2 * k), _mm256_loadu_pd(y + 2 * k)));
+  double lanes[4];
+  _mm256_storeu_pd(lanes, acc);
+  double tail[2];
+  dotc_scalar_(n - k, x + 2 * k, y + 2 * k, tail);
+  result[0] = (lanes[0] + lanes[2]) + tail[0];
+  result[1] = (lanes[1] + lanes[3]) + tail[1];
+}
+
+BTK_TARGET("avx2") static void abs2_avx2(size_t n, const double* x, double* y)
+{
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4)
+    _mm256_storeu_pd(y + k, abs2_avx2_(_mm256_loadu_pd(x + 2 * k), _mm256_loadu_pd(x + 2 * k + 4)));
+  abs2_scalar_(n - k, x + 2 * k, y + k);
+}
+
+BTK_TARGET("avx2") static void abs2_smooth_avx2(size_t n, double alpha, double beta, const double* x, double* y)
+{
+  __m256d al = _mm256_set1_pd(alpha), be = _mm256_set1_pd(beta);
+  size_t  k  = 0;
+  for (; k + 4 <= n; k += 4) {
+    __m256d p = abs2_avx2_(_mm256_loadu_pd(x + 2 * k), _mm256_loadu_pd(x + 2 * k + 4));
+    _mm256_storeu_pd(y + k, _mm256_add_pd(_mm256_mul_pd(al, _mm256_loadu_pd(y + k)), _mm256_mul_pd(be, p)));
+  }
+  abs2_smooth_scalar_(n - k, alpha, beta, x + 2 * k, y + k);
+}
+
+static const ComplexKernels::Table AVX2Table_ = {
+  ComplexKernels::AVX2, "avx2",
+  mul_avx2, mul_conj_avx2, scale_avx2, scale_real_avx2, axpy_avx2, axpy_conj_avx2,
+  dotc_avx2, abs2_avx2, abs2_smooth_avx2
+};
+
+
+// ----- AVX-512F implementation -----
+//
+// Four complex numbers per register. There is no 'addsub' for 512 bits, so
+// the sign of the lanes to subtract is flipped first, which is exact.
+//
+BTK_TARGET("avx512f") static inline __m512d flip_sign_avx512_(__m512d v, __m512i mask)
+{
+  return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(v), mask));
+}
+
+BTK_TARGET("avx512f") static inline __m512d mul_avx512_(__m512d a, __m512d b)
+{
+  const __m512i even = _mm512_set_epi64(0, 1LL << 63, 0, 1LL << 63, 0, 1LL << 63, 0, 1LL << 63);
+  __m512d t1 = _mm512_mul_pd(a, _mm512_movedup_pd(b));
+  __m512d t2 = _mm512_mul_pd(_mm512_permute_pd(a, 0x55), _mm512_permute_pd(b, 0xFF));
+  return _mm512_add_pd(t1, flip_sign_avx512_(t2, even));
+}
+
+BTK_TARGET("avx512f") static inline __m512d mul_conj_avx512_(__m512d a, __m512d b)
+{
+  const __m512i odd = _mm512_set_epi64(1LL << 63, 0, 1LL << 63, 0, 1LL << 63, 0, 1LL << 63, 0);
+  __m512d t1 = _mm512_mul_pd(a, _mm512_movedup_pd(b));
+  __m512d t2 = _mm512_mul_pd(_mm512_permute_pd(a, 0x55), _mm512_permute_pd(b, 0xFF));
+  return _mm512_add_pd(flip_sign_avx512_(t1, odd), t2);
+}
+
+BTK_TARGET("avx512f") static inline __m512d abs2_avx512_(__m512d x03, __m512d x47)
+{
+  const __m512i re = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+  const __m512i im = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+  __m512d s03 = _mm512_mul_pd(x03, x03), s47 = _mm512_mul_pd(x47, x47);
+  return _mm512_add_pd(_mm512_permutex2var_pd(s03, re, s47), _mm512_permutex2var_pd(s03, im, s47));
+}
+
+BTK_TARGET("avx512f") static inline __m512d broadcast_avx512_(const double* alpha)
+{
+  return _mm512_set_pd(alpha[1], alpha[0], alpha[1], alpha[0], alpha[1], alpha[0], alpha[1], alpha[0]);
+}
+
+BTK_TARGET("avx512f") static void mul_avx512(size_t n, const double* a, const double* b, double* y)
+{
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4)
+    _mm512_storeu_pd(y + 2 * k, mul_avx512_(_mm512_loadu_pd(a + 2 * k), _mm512_loadu_pd(b + 2 * k)));
+  mul_scalar_(n - k, a + 2 * k, b + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx512f") static void mul_conj_avx512(size_t n, const double* a, const double* b, double* y)
+{
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4)
+    _mm512_storeu_pd(y + 2 * k, mul_conj_avx512_(_mm512_loadu_pd(a + 2 * k), _mm512_loadu_pd(b + 2 * k)));
+  mul_conj_scalar_(n - k, a + 2 * k, b + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx512f") static void scale_avx512(size_t n, const double* alpha, const double* x, double* y)
+{
+  __m512d al = broadcast_avx512_(alpha);
+  size_t  k  = 0;
+  for (; k + 4 <= n; k += 4)
+    _mm512_storeu_pd(y + 2 * k, mul_avx512_(_mm512_loadu_pd(x + 2 * k), al));
+  scale_scalar_(n - k, alpha, x + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx512f") static void scale_real_avx512(size_t n, double alpha, const double* x, double* y)
+{
+  __m512d al = _mm512_set1_pd(alpha);
+  size_t  k  = 0;
+  for (; k + 4 <= n; k += 4)
+    _mm512_storeu_pd(y + 2 * k, _mm512_mul_pd(al, _mm512_loadu_pd(x + 2 * k)));
+  scale_real_scalar_(n - k, alpha, x + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx512f") static void axpy_avx512(size_t n, const double* alpha, const double* x, double* y)
+{
+  __m512d al = broadcast_avx512_(alpha);
+  size_t  k  = 0;
+  for (; k + 4 <= n; k += 4)
+    _mm512_storeu_pd(y + 2 * k, _mm512_add_pd(_mm512_loadu_pd(y + 2 * k), mul_avx512_(_mm512_loadu_pd(x + 2 * k), al)));
+  axpy_scalar_(n - k, alpha, x + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx512f") static void axpy_conj_avx512(size_t n, const double* alpha, const double* x, double* y)
+{
+  __m512d al = broadcast_avx512_(alpha);
+  size_t  k  = 0;
+  for (; k + 4 <= n; k += 4)
+    _mm512_storeu_pd(y + 2 * k, _mm512_add_pd(_mm512_loadu_pd(y + 2 * k), mul_conj_avx512_(_mm512_loadu_pd(x + 2 * k), al)));
+  axpy_conj_scalar_(n - k, alpha, x + 2 * k, y + 2 * k);
+}
+
+BTK_TARGET("avx512f") static void dotc_avx512(size_t n, const double* x, const double* y, double* result)
+{
+  __m512d acc = _mm512_setzero_pd();
+  size_t  k   = 0;
+  for (; k + 4 <= n; k += 4)
+    acc = _mm512_add_pd(acc, mul_conj_avx512_(_mm512_loadu_pd(x + 2 * k), _mm512_loadu_pd(y + 2 * k)));
+  double lanes[8];
+  _mm512_storeu_pd(lanes, acc);
+  double tail[2];
+  dotc_scalar_(n - k, x + 2 * k, y + 2 * k, tail);
+  result[0] = ((lanes[0] + lanes[2]) + (lanes[4] + lanes[6])) + tail[0];
+  result[1] = ((lanes[1] + lanes[3]) + (lanes[5] + lanes[7])) + tail[1];
+}
+
+BTK_TARGET("avx512f") static void abs2_avx512(size_t n, const double* x, double* y)
+{
+  size_t k = 0;
+  for (; k + 8 <= n; k += 8)
+    _mm512_storeu_pd(y + k, abs2_avx512_(_mm512_loadu_pd(x + 2 * k), _mm512_loadu_pd(x + 2 * k + 8)));
+  abs2_scalar_(n - k, x + 2 * k, y + k);
+}
+
+BTK_TARGET("avx512f") static void abs2_smooth_avx512(size_t n, double alpha, double beta, const double* x, double* y)
+{
+  __m512d al = _mm512_set1_pd(alpha), be = _mm512_set1_pd(beta);
+  size_t  k  = 0;
+  for (; k + 8 <= n; k += 8) {
+    __m512d p = abs2_avx512_(_mm512_loadu_pd(x + 2 * k), _mm512_loadu_pd(x + 2 * k + 8));
+    _mm512_storeu_pd(y + k, _mm512_add_pd(_mm512_mul_pd(al, _mm512_loadu_pd(y + k)), _mm512_mul_pd(be, p)));
+  }
+  abs2_smooth_scalar_(n - k, alpha, beta, x + 2 * k, y + k);
+}
+
+static const ComplexKernels::Table AVX512Table_ = {
+  ComplexKernels::AVX512, "avx512",
+  mul_avx512, mul_conj_avx512, scale_avx512, scale_real_avx512, axpy_avx512, axpy_conj_avx512,
+  dotc_avx512, abs2_avx512, abs2_smooth_avx512
+};
+
+#endif // BTK_KERNELS_X86
+
+
+#ifdef BTK_KERNELS_NEON
+
+// ----- NEON implementation -----
+//
+// One complex number per register. The sign flips are multiplications by
+// -1, which are exact.
+//
+static inline float64x2_t mul_neon_(float64x2_t a, float64x2_t b)
+{
+  const float64x2_t sign = { -1.0, 1.0 };
+  float64x2_t t1 = vmulq_f64(a, vdupq_laneq_f64(b, 0));
+  float64x2_t t2 = vmulq_f64(vextq_f64(a, a, 1), vdupq_laneq_f64(b, 1));
+  return vaddq_f64(t1, vmulq_f64(t2, sign));
+}
+
+static inline float64x2_t mul_conj_neon_(float64x2_t a, float64x2_t b)
+{
+  const float64x2_t sign = { 1.0, -1.0 };
+  float64x2_t t1 = vmulq_f64(a, vdupq_laneq_f64(b, 0));
+  float64x2_t t2 = vmulq_f64(vextq_f64(a, a, 1), vdupq_laneq_f64(b, 1));
+  return vaddq_f64(vmulq_f64(t1, sign), t2);
+}
+
+static inline float64x2_t abs2_neon_(float64x2_t x0, float64x2_t x1)
+{
+  float64x2_t s0 = vmulq_f64(x0, x0), s1 = vmulq_f64(x1, x1);
+  return vaddq_f64(vuzp1q_f64(s0, s1), vuzp2q_f64(s0, s1));
+}
+
+static void mul_neon(size_t n, const double* a, const double* b, double* y)
+{
+  for (size_t k = 0; k < n; k++)
+    vst1q_f64(y + 2 * k, mul_neon_(vld1q_f64(a + 2 * k), vld1q_f64(b + 2 * k)));
+}
+
+static void mul_conj_neon(size_t n, const double* a, const double* b, double* y)
+{
+  for (size_t k = 0; k < n; k++)
+    vst1q_f64(y + 2 * k, mul_conj_neon_(vld1q_f64(a + 2 * k), vld1q_f64(b + 2 * k)));
+}
+
+static void scale_neon(size_t n, const double* alpha, const double* x, double* y)
+{
+  float64x2_t al = vld1q_f64(alpha);
+  for (size_t k = 0; k < n; k++)
+    vst1q_f64(y + 2 * k, mul_neon_(vld1q_f64(x + 2 * k), al));
+}
+
+static void scale_real_neon(size_t n, double alpha, const double* x, double* y)
+{
+  float64x2_t al = vdupq_n_f64(alpha);
+  for (size_t k = 0; k < n; k++)
+    vst1q_f64(y + 2 * k, vmulq_f64(al, vld1q_f64(x + 2 * k)));
+}
+
+static void axpy_neon(size_t n, const double* alpha, const double* x, double* y)
+{
+  float64x2_t al = vld1q_f64(alpha);
+  for (size_t k = 0; k < n; k++)
+    vst1q_f64(y + 2 * k, vaddq_f64(vld1q_f64(y + 2 * k), mul_neon_(vld1q_f64(x + 2 * k), al)));
+}
+
+static void axpy_conj_neon(size_t n, const double* alpha, const double* x, double* y)
+{
+  float64x2_t al = vld1q_f64(alpha);
+  for (size_t k = 0; k < n; k++)
+    vst1q_f64(y + 2 * k, vaddq_f64(vld1q_f64(y + 2 * k), mul_conj_neon_(vld1q_f64(x + 2 * k), al)));
+}
+
+static void dotc_neon(size_t n, const double* x, const double* y, double* result)
+{
+  float64x2_t acc0 = vdupq_n_f64(0.0), acc1 = vdupq_n_f64(0.0);
+  size_t      k    = 0;
+  for (; k + 2 <= n; k += 2) {
+    acc0 = vaddq_f64(acc0, mul_conj_neon_(vld1q_f64(x + 2 * k),     vld1q_f64(y + 2 * k)));
+    acc1 = vaddq_f64(acc1, mul_conj_neon_(vld1q_f64(x + 2 * k + 2), vld1q_f64(y + 2 * k + 2)));
+  }
+  if (k < n)
+    acc0 = vaddq_f64(acc0, mul_conj_neon_(vld1q_f64(x + 2 * k), vld1q_f64(y + 2 * k)));
+  vst1q_f64(result, vaddq_f64(acc0, acc1));
+}
+
+static void abs2_neon(size_t n, const double* x, double* y)
+{
+  size_t k = 0;
+  for (; k + 2 <= n; k += 2)
+    vst1q_f64(y + k, abs2_neon_(vld1q_f64(x + 2 * k), vld1q_f64(x + 2 * k + 2)));
+  abs2_scalar_(n - k, x + 2 * k, y + k);
+}
+
+static void abs2_smooth_neon(size_t n, double alpha, double beta, const double* x, double* y)
+{
+  float64x2_t al = vdupq_n_f64(alpha), be = vdupq_n_f64(beta);
+  size_t      k  = 0;
+  for (; k + 2 <= n; k += 2) {
+    float64x2_t p = abs2_neon_(vld1q_f64(x + 2 * k), vld1q_f64(x + 2 * k + 2));
+    vst1q_f64(y + k, vaddq_f64(vmulq_f64(al, vld1q_f64(y + k)), vmulq_f64(be, p)));
+  }
+  abs2_smooth_scalar_(n - k, alpha, beta, x + 2 * k, y + k);
+}
+
+static const ComplexKernels::Table NEONTable_ = {
+  ComplexKernels::NEON, "neon",
+  mul_neon, mul_conj_neon, scale_neon, scale_real_neon, axpy_neon, axpy_conj_neon,
+  dotc_neon, abs2_neon, abs2_smooth_neon
+};
+
+#endif // BTK_KERNELS_NEON
+
+
+// ----- dispatch -----
+//
+static const ComplexKernels::Table* table_of_(ComplexKernels::Isa isa)
+{
+  switch (isa) {
+  case ComplexKernels::Scalar:
+    return &ScalarTable_;
+#ifdef BTK_KERNELS_X86
+  case ComplexKernels::SSE2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") ? &SSE2Table_ : NULL;
+  case ComplexKernels::AVX2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? &AVX2Table_ : NULL;
+  case ComplexKernels::AVX512:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") ? &AVX512Table_ : NULL;
+#endif
+#ifdef BTK_KERNELS_NEON
+  case ComplexKernels::NEON:
+    return &NEONTable_;
+#endif
+  default:
+    return NULL;
+  }
+}
+
+static bool parse_isa_(const char* name, ComplexKernels::Isa& isa)
+{
+  static const ComplexKernels::Isa isas[] = { ComplexKernels::Scalar, ComplexKernels::SSE2, ComplexKernels::AVX2,
+					      ComplexKernels::AVX512, ComplexKernels::NEON };
+  for (unsigned i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+    if (strcmp(name, ComplexKernels::isa_name(isas[i])) == 0) {
+      isa = isas[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+static const ComplexKernels::Table* initial_table_()
+{
+  const char* env = getenv("BTK20_SIMD");
+  if (env != NULL) {
+    ComplexKernels::Isa isa;
+    if (parse_isa_(env, isa) && table_of_(isa) != NULL)
+      return table_of_(isa);
+    fprintf(stderr, "Ignoring BTK20_SIMD='%s': unknown or not supported by this processor.\n", env);
+  }
+
+  static const ComplexKernels::Isa preferred[] = { ComplexKernels::AVX512, ComplexKernels::AVX2, ComplexKernels::NEON, ComplexKernels::SSE2 };
+  for (unsigned i = 0; i < sizeof(preferred) / sizeof(preferred[0]); i++)
+    if (table_of_(preferred[i]) != NULL)
+      return table_of_(preferred[i]);
+
+  return &ScalarTable_;
+}
+
+static const ComplexKernels::Table*& active_table_()
+{
+  static const ComplexKernels::Table* table = initial_table_();
+  return table;
+}
+
+
+// ----- methods for class `ComplexKernels' -----
+//
+const ComplexKernels::Table& ComplexKernels::active_()
+{
+  return *__atomic_load_n(&active_table_(), __ATOMIC_ACQUIRE);
+}
+
+ComplexKernels::Isa ComplexKernels::isa()
+{
+  return active_().isa;
+}
+
+const char* ComplexKernels::isa_name(Isa isa)
+{
+  switch (isa) {
+  case SSE2:   return "sse2";
+  case AVX2:   return "avx2";
+  case AVX512: return "avx512";
+  case NEON:   return "neon";
+  default:     return "scalar";
+  }
+}
+
+bool ComplexKernels::supported(Isa isa)
+{
+  return table_of_(isa) != NULL;
+}
+
+void ComplexKernels::set_isa(Isa isa)
+{
+  const Table* table = table_of_(isa);
+  if (table == NULL)
+    throw jparameter_error("The '%s' kernels are not supported by this processor.", isa_name(isa));
+  __atomic_store_n(&active_table_(), table, __ATOMIC_RELEASE);
+}
+
+void ComplexKernels::set_isa(const String& name)
+{
+  Isa isa;
+  if (parse_isa_(name.c_str(), isa) == false)
+    throw jparameter_error("Unknown kernel set '%s'; use 'scalar', 'sse2', 'avx2', 'avx512' or 'neon'.", name.c_str());
+  set_isa(isa);
+}
+
+const ComplexKernels::Table& ComplexKernels::table(Isa isa)
+{
+  const Table* table = table_of_(isa);
+  if (table == NULL)
+    throw jparameter_error("The '%s' kernels are not supported by this processor.", isa_name(isa));
+  return *table;
+}
+
+// uniform in [-1, 1); a private generator so that 'rand()' is left alone
+static double random_(unsigned long& state)
+{
+  state = state * 6364136223846793005UL + 1442695040888963407UL;
+  return ((state >> 11) * (1.0 / 9007199254740992.0)) * 2.0 - 1.0;
+}
+
+static void compare_(const char* kernel, const ComplexKernels::Table& table, size_t n,
+		     const std::vector<double>& expected, const std::vector<double>& actual)
+{
+  if (memcmp(&expected[0], &actual[0], expected.size() * sizeof(double)) != 0)
+    throw jconsistency_error("'%s' of the '%s' kernels differs from the scalar one for n = %lu.",
+			     kernel, table.name, (unsigned long) n);
+}
+
+double ComplexKernels::check_agreement(Isa isa)
+{
+  const Table& scalar = ScalarTable_;
+  const Table& simd   = table(isa);
+
+  static const size_t sizes[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 64, 127, 1031 };
+  unsigned long state = 1;
+  double maxDeviation = 0.0;
+
+  for (unsigned sizeX = 0; sizeX < sizeof(sizes) / sizeof(sizes[0]); sizeX++) {
+    size_t n = sizes[sizeX];
+    // one spare element so that '&v[0]' is valid for n = 0
+    std::vector<double> a(2 * n + 2), b(2 * n + 2), y(2 * n + 2), r(n + 1);
+    for (size_t i = 0; i < a.size(); i++) {
+      a[i] = random_(state);  b[i] = random_(state);  y[i] = random_(state);
+    }
+    for (size_t i = 0; i < r.size(); i++)
+      r[i] = fabs(random_(state));
+    double alpha[2] = { random_(state), random_(state) };
+
+    std::vector<double> expected(y), actual(y);
+    scalar.mul(n, &a[0], &b[0], &expected[0]);  simd.mul(n, &a[0], &b[0], &actual[0]);
+    compare_("mul", simd, n, expected, actual);
+
+    expected = actual = b;
+    scalar.mul(n, &a[0], &expected[0], &expected[0]);  simd.mul(n, &a[0], &actual[0], &actual[0]);
+    compare_("mul in place", simd, n, expected, actual);
+
+    expected = actual = y;
+    scalar.mul_conj(n, &a[0], &b[0], &expected[0]);  simd.mul_conj(n, &a[0], &b[0], &actual[0]);
+    compare_("mul_conj", simd, n, expected, actual);
+
+    expected = actual = y;
+    scalar.scale(n, alpha, &a[0], &expected[0]);  simd.scale(n, alpha, &a[0], &actual[0]);
+    compare_("scale", simd, n, expected, actual);
+
+    expected = actual = y;
+    scalar.scale_real(n, alpha[0], &a[0], &expected[0]);  simd.scale_real(n, alpha[0], &a[0], &actual[0]);
+    compare_("scale_real", simd, n, expected, actual);
+
+    expected = actual = y;
+    scalar.axpy(n, alpha, &a[0], &expected[0]);  simd.axpy(n, alpha, &a[0], &actual[0]);
+    compare_("axpy", simd, n, expected, actual);
+
+    expected = actual = y;
+    scalar.axpy_conj(n, alpha, &a[0], &expected[0]);  simd.axpy_conj(n, alpha, &a[0], &actual[0]);
+    compare_("axpy_conj", simd, n, expected, actual);
+
+    expected = actual = r;
+    scalar.abs2(n, &a[0], &expected[0]);  simd.abs2(n, &a[0], &actual[0]);
+    compare_("abs2", simd, n, expected, actual);
+
+    expected = actual = r;
+    scalar.abs2_smooth(n, 0.9, 0.1, &a[0], &expected[0]);  simd.abs2_smooth(n, 0.9, 0.1, &a[0], &actual[0]);
+    compare_("abs2_smooth", simd, n, expected, actual);
+
+    double dotExpected[2], dotActual[2], bound = 0.0;
+    scalar.dotc(n, &a[0], &b[0], dotExpected);  simd.dotc(n, &a[0], &b[0], dotActual);
+    for (size_t k = 0; k < n; k++)
+      bound += sqrt((a[2 * k] * a[2 * k] + a[2 * k + 1] * a[2 * k + 1]) * (b[2 * k] * b[2 * k] + b[2 * k + 1] * b[2 * k + 1]));
+    if (bound > 0.0) {
+      double deviation = sqrt((dotExpected[0] - dotActual[0]) * (dotExpected[0] - dotActual[0]) +
+			      (dotExpected[1] - dotActual[1]) * (dotExpected[1] - dotActual[1])) / bound;
+      if (deviation > maxDeviation) maxDeviation = deviation;
+    }
+  }
+
+  return maxDeviation;
+}
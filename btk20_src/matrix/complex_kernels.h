@@ -0,0 +1,96 @@
+/**
+ * @file complex_kernels.h
+ * @brief Vectorized kernels on interleaved double-complex arrays.
+ */
+
+#ifndef COMPLEX_KERNELS_H
+#define COMPLEX_KERNELS_H
+
+#include <stddef.h>
+#include <gsl/gsl_complex.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include "common/mlist.h"
+
+/**
+* \defgroup ComplexKernels Complex Kernels
+* The kernels operate on n complex numbers stored as interleaved (real,
+* imaginary) doubles, that is, on the data of a 'gsl_vector_complex' with
+* unit stride or of a row of a 'gsl_matrix_complex'. The output may be one
+* of the inputs.
+*
+* There are scalar, SSE2, AVX2 and AVX-512F implementations for x86-64 and
+* a NEON one for AArch64. The fastest one that the processor supports is
+* chosen on first use; the environment variable BTK20_SIMD or 'set_isa()'
+* selects another. The element-wise kernels of every implementation perform
+* the same IEEE operations in the same order as the scalar one, without
+* fused multiply-adds, so they agree with it bit for bit; only 'dotc()'
+* sums in a different order. 'check_agreement()' verifies both.
+*/
+/*@{*/
+
+// ----- definition for class `ComplexKernels' -----
+//
+class ComplexKernels {
+ public:
+  enum Isa { Scalar = 0, SSE2 = 1, AVX2 = 2, AVX512 = 3, NEON = 4 };
+
+  struct Table {
+    Isa		isa;
+    const char*	name;
+    void (*mul)(size_t n, const double* a, const double* b, double* y);
+    void (*mul_conj)(size_t n, const double* a, const double* b, double* y);
+    void (*scale)(size_t n, const double* alpha, const double* x, double* y);
+    void (*scale_real)(size_t n, double alpha, const double* x, double* y);
+    void (*axpy)(size_t n, const double* alpha, const double* x, double* y);
+    void (*axpy_conj)(size_t n, const double* alpha, const double* x, double* y);
+    void (*dotc)(size_t n, const double* x, const double* y, double* result);
+    void (*abs2)(size_t n, const double* x, double* y);
+    void (*abs2_smooth)(size_t n, double alpha, double beta, const double* x, double* y);
+  };
+
+  // y = a .* b
+  static void mul(size_t n, const double* a, const double* b, double* y) { active_().mul(n, a, b, y); }
+  // y = conj(a) .* b
+  static void mul_conj(size_t n, const double* a, const double* b, double* y) { active_().mul_conj(n, a, b, y); }
+  // y = alpha x
+  static void scale(size_t n, gsl_complex alpha, const double* x, double* y) { active_().scale(n, alpha.dat, x, y); }
+  static void scale_real(size_t n, double alpha, const double* x, double* y) { active_().scale_real(n, alpha, x, y); }
+  // y = y + alpha x
+  static void axpy(size_t n, gsl_complex alpha, const double* x, double* y) { active_().axpy(n, alpha.dat, x, y); }
+  // y = y + alpha conj(x)
+  static void axpy_conj(size_t n, gsl_complex alpha, const double* x, double* y) { active_().axpy_conj(n, alpha.dat, x, y); }
+  // x^H y
+  static gsl_complex dotc(size_t n, const double* x, const double* y) { gsl_complex r; active_().dotc(n, x, y, r.dat); return r; }
+  // y = |x|^2, real output
+  static void abs2(size_t n, const double* x, double* y) { active_().abs2(n, x, y); }
+  // y = alpha y + beta |x|^2, real output; the recursive power estimate of the post-filters
+  static void abs2_smooth(size_t n, double alpha, double beta, const double* x, double* y) { active_().abs2_smooth(n, alpha, beta, x, y); }
+
+  // data of GSL objects, which must have unit stride
+  static double* data(gsl_vector_complex* v) { return v->data; }
+  static const double* data(const gsl_vector_complex* v) { return v->data; }
+  static double* row(gsl_matrix_complex* m, size_t rowX) { return m->data + 2 * rowX * m->tda; }
+
+  static Isa         isa();
+  static const char* isa_name(Isa isa);
+  static bool        supported(Isa isa);
+  static void        set_isa(Isa isa);
+  // "scalar", "sse2", "avx2", "avx512" or "neon"
+  static void        set_isa(const String& name);
+  static const Table& table(Isa isa);
+
+  /**
+     @brief run every kernel of 'isa' and the scalar ones on the same random data
+     @return the largest relative deviation of 'dotc()'
+     @note throws 'jconsistency_error' if an element-wise kernel differs in a single bit
+  */
+  static double check_agreement(Isa isa);
+
+ private:
+  static const Table& active_();
+};
+
+/*@}*/
+
+#endif
@@ -10,6 +10,8 @@
 #include <gsl/gsl_matrix_double.h>
 #include <gsl/gsl_matrix_float.h>
 #include "matrix/gslmatrix.h"
+#include "matrix/aligned_pool.h"
+#include "matrix/complex_kernels.h"
 %}
 
 #ifdef AUTODOC
@@ -81,3 +83,51 @@
 gsl_matrix_float* gsl_matrix_float_load(gsl_matrix_float* m, const char* filename, bool old = false);
 
 gsl_matrix_float* gsl_matrix_float_resize(gsl_matrix_float* m, size_t size1, size_t size2);
+
+
+// ----- definition for class `GSLAlignedPool' -----
+//
+class GSLAlignedPool {
+ public:
+  enum Mode { System = 0, Aligned = 1, Pooled = 2 };
+
+  static void set_mode(Mode mode);
+  static void set_mode(const String& name);
+  static Mode mode();
+  static const char* mode_name(Mode mode);
+
+  static void   set_max_cached_bytes(size_t maxBytes);
+  static size_t max_cached_bytes();
+
+  static unsigned long allocations();
+  static unsigned long reuses();
+  static unsigned long heap_allocations();
+  static unsigned long heap_releases();
+  static size_t        bytes_in_use();
+  static size_t        bytes_cached();
+
+  static void clear();
+  static void reset_statistics();
+  static void report();
+
+ private:
+  GSLAlignedPool();
+};
+
+
+// ----- definition for class `ComplexKernels' -----
+//
+class ComplexKernels {
+ public:
+  enum Isa { Scalar = 0, SSE2 = 1, AVX2 = 2, AVX512 = 3, NEON = 4 };
+
+  static Isa         isa();
+  static const char* isa_name(Isa isa);
+  static bool        supported(Isa isa);
+  static void        set_isa(Isa isa);
+  static void        set_isa(const String& name);
+  static double      check_agreement(Isa isa);
+
+ private:
+  ComplexKernels();
+};
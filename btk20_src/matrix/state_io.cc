@@ -0,0 +1,331 @@
+/**
+ * @file state_io.cc
+ * @brief Binary checkpoints of the state of adaptive filters.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "common/jexception.h"
+#include "matrix/state_io.h"
+
+static const char     StateMagic[]   = "BTKSTATE";
+static const uint32_t StateVersion   = 1;
+static const uint32_t ByteOrderMark  = 0x01020304;
+static const char     TrailerKey[]   = "__end__";
+
+typedef enum { IntRecord = 1, DoubleRecord, VectorRecord, ComplexVectorRecord, MatrixRecord, ComplexMatrixRecord } RecordType_;
+
+// a pending 'double' array; it is stored as a 'VectorRecord'
+static const unsigned ArrayPending_ = 0;
+
+static const char* record_name_(unsigned type)
+{
+  static const char* names[] = { "?", "int", "double", "vector", "complex vector", "matrix", "complex matrix" };
+  return names[(type <= ComplexMatrixRecord) ? type : 0];
+}
+
+static uint32_t fnv1a_(const char* data, size_t len)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= (unsigned char) data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+
+// ----- methods for class `StateWriter' -----
+//
+StateWriter::StateWriter(const String& kind)
+{
+  put_(StateMagic, 8);
+  put_(&StateVersion, sizeof(StateVersion));
+  put_(&ByteOrderMark, sizeof(ByteOrderMark));
+
+  uint32_t len = kind.size();
+  put_(&len, sizeof(len));
+  put_(kind.c_str(), len);
+}
+
+void StateWriter::put_(const void* data, size_t len)
+{
+  const char* bytes = (const char*) data;
+  buffer_.insert(buffer_.end(), bytes, bytes + len);
+}
+
+void StateWriter::put_header_(const String& key, unsigned type, unsigned size1, unsigned size2)
+{
+  uint32_t len = key.size();
+  put_(&len, sizeof(len));
+  put_(key.c_str(), len);
+
+  uint8_t  t  = type;
+  uint32_t s1 = size1, s2 = size2;
+  put_(&t, sizeof(t));
+  put_(&s1, sizeof(s1));
+  put_(&s2, sizeof(s2));
+}
+
+void StateWriter::write(const String& key, int value)
+{
+  put_header_(key, IntRecord, 1, 1);
+  int64_t v = value;
+  put_(&v, sizeof(v));
+}
+
+void StateWriter::write(const String& key, double value)
+{
+  put_header_(key, DoubleRecord, 1, 1);
+  put_(&value, sizeof(value));
+}
+
+void StateWriter::write(const String& key, const gsl_vector* value)
+{
+  put_header_(key, VectorRecord, value->size, 1);
+  for (size_t i = 0; i < value->size; i++) {
+    double v = gsl_vector_get(value, i);
+    put_(&v, sizeof(v));
+  }
+}
+
+void StateWriter::write(const String& key, const gsl_vector_complex* value)
+{
+  put_header_(key, ComplexVectorRecord, value->size, 1);
+  for (size_t i = 0; i < value->size; i++)
+    put_(value->data + 2 * i * value->stride, 2 * sizeof(double));
+}
+
+void StateWriter::write(const String& key, const gsl_matrix* value)
+{
+  put_header_(key, MatrixRecord, value->size1, value->size2);
+  for (size_t i = 0; i < value->size1; i++)
+    put_(value->data + i * value->tda, value->size2 * sizeof(double));
+}
+
+void StateWriter::write(const String& key, const gsl_matrix_complex* value)
+{
+  put_header_(key, ComplexMatrixRecord, value->size1, value->size2);
+  for (size_t i = 0; i < value->size1; i++)
+    put_(value->data + 2 * i * value->tda, 2 * value->size2 * sizeof(double));
+}
+
+void StateWriter::write(const String& key, const double* value, unsigned n)
+{
+  put_header_(key, VectorRecord, n, 1);
+  put_(value, n * sizeof(double));
+}
+
+void StateWriter::save(const String& fileName)
+{
+  uint32_t checksum = fnv1a_(&buffer_[0], buffer_.size());
+
+  FILE* fp = fopen(fileName.c_str(), "wb");
+  if (fp == NULL)
+    throw jio_error("Could not open state file '%s' for writing.", fileName.c_str());
+
+  uint32_t len = strlen(TrailerKey);
+  bool ok = (fwrite(&buffer_[0], 1, buffer_.size(), fp) == buffer_.size());
+  ok = ok && fwrite(&len, sizeof(len), 1, fp) == 1;
+  ok = ok && fwrite(TrailerKey, 1, len, fp) == len;
+  ok = ok && fwrite(&checksum, sizeof(checksum), 1, fp) == 1;
+  ok = (fclose(fp) == 0) && ok;
+
+  if (ok == false)
+    throw jio_error("Could not write state file '%s'.", fileName.c_str());
+}
+
+
+// ----- methods for class `StateReader' -----
+//
+StateReader::StateReader(const String& fileName, const String& kind)
+  : fileName_(fileName), pos_(0), end_(0)
+{
+  FILE* fp = fopen(fileName.c_str(), "rb");
+  if (fp == NULL)
+    throw jio_error("Could not open state file '%s'.", fileName.c_str());
+
+  char   chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+    buffer_.insert(buffer_.end(), chunk, chunk + n);
+  fclose(fp);
+
+  // trailer
+  uint32_t trailerLen = strlen(TrailerKey);
+  size_t   trailerSize = sizeof(uint32_t) + trailerLen + sizeof(uint32_t);
+  if (buffer_.size() < 8 + 3 * sizeof(uint32_t) + trailerSize)
+    throw jconsistency_error("State file '%s' is truncated.", fileName.c_str());
+
+  end_ = buffer_.size() - trailerSize;
+  uint32_t len, checksum;
+  memcpy(&len, &buffer_[end_], sizeof(len));
+  memcpy(&checksum, &buffer_[buffer_.size() - sizeof(checksum)], sizeof(checksum));
+  if (len != trailerLen || memcmp(&buffer_[end_ + sizeof(len)], TrailerKey, trailerLen) != 0)
+    throw jconsistency_error("State file '%s' is truncated.", fileName.c_str());
+  if (checksum != fnv1a_(&buffer_[0], end_))
+    throw jconsistency_error("State file '%s' is corrupted (checksum mismatch).", fileName.c_str());
+
+  // header
+  char     magic[8];
+  uint32_t version, mark;
+  get_(magic, 8);
+  get_(&version, sizeof(version));
+  get_(&mark, sizeof(mark));
+  if (memcmp(magic, StateMagic, 8) != 0)
+    throw jconsistency_error("'%s' is not a state file.", fileName.c_str());
+  if (mark != ByteOrderMark)
+    throw jconsistency_error("State file '%s' was written with a different byte order.", fileName.c_str());
+  if (version != StateVersion)
+    throw jconsistency_error("State file '%s' has version %d; expected %d.", fileName.c_str(), version, StateVersion);
+
+  get_(&len, sizeof(len));
+  if (len > end_ - pos_)
+    throw jconsistency_error("State file '%s' is corrupted.", fileName.c_str());
+  kind_ = String(string(&buffer_[pos_], len));
+  pos_ += len;
+  if (kind_ != kind)
+    throw jconsistency_error("State file '%s' holds the state of '%s', not '%s'.", fileName.c_str(), kind_.c_str(), kind.c_str());
+}
+
+void StateReader::get_(void* data, size_t len)
+{
+  if (len > end_ - pos_)
+    throw jconsistency_error("State file '%s' ended unexpectedly.", fileName_.c_str());
+  memcpy(data, &buffer_[pos_], len);
+  pos_ += len;
+}
+
+void StateReader::get_header_(const String& key, unsigned type, unsigned size1, unsigned size2)
+{
+  uint32_t len;
+  get_(&len, sizeof(len));
+  if (len > end_ - pos_)
+    throw jconsistency_error("State file '%s' ended unexpectedly.", fileName_.c_str());
+  String found(string(&buffer_[pos_], len));
+  pos_ += len;
+
+  uint8_t  t;
+  uint32_t s1, s2;
+  get_(&t, sizeof(t));
+  get_(&s1, sizeof(s1));
+  get_(&s2, sizeof(s2));
+
+  if (found != key)
+    throw jconsistency_error("State file '%s': expected '%s' but found '%s'.", fileName_.c_str(), key.c_str(), found.c_str());
+  if (t != type)
+    throw jconsistency_error("State file '%s': '%s' is a %s, expected a %s.", fileName_.c_str(), key.c_str(),
+			     record_name_(t), record_name_(type));
+  if (s1 != size1 || s2 != size2)
+    throw jconsistency_error("State file '%s': '%s' has shape %d x %d, expected %d x %d.", fileName_.c_str(), key.c_str(),
+			     s1, s2, size1, size2);
+}
+
+void StateReader::check(const String& key, int expected)
+{
+  int value = read_int(key);
+  if (value != expected)
+    throw jdimension_error("State file '%s': '%s' is %d but the filter has %d.", fileName_.c_str(), key.c_str(), value, expected);
+}
+
+int StateReader::read_int(const String& key)
+{
+  get_header_(key, IntRecord, 1, 1);
+  int64_t v;
+  get_(&v, sizeof(v));
+  return int(v);
+}
+
+double StateReader::read_double(const String& key)
+{
+  get_header_(key, DoubleRecord, 1, 1);
+  double v;
+  get_(&v, sizeof(v));
+  return v;
+}
+
+void StateReader::skip_(size_t len)
+{
+  if (len > end_ - pos_)
+    throw jconsistency_error("State file '%s' ended unexpectedly.", fileName_.c_str());
+  pos_ += len;
+}
+
+void StateReader::read(const String& key, gsl_vector* value)
+{
+  get_header_(key, VectorRecord, value->size, 1);
+  pending_.push_back(Pending_(VectorRecord, value, pos_));
+  skip_(value->size * sizeof(double));
+}
+
+void StateReader::read(const String& key, gsl_vector_complex* value)
+{
+  get_header_(key, ComplexVectorRecord, value->size, 1);
+  pending_.push_back(Pending_(ComplexVectorRecord, value, pos_));
+  skip_(2 * value->size * sizeof(double));
+}
+
+void StateReader::read(const String& key, gsl_matrix* value)
+{
+  get_header_(key, MatrixRecord, value->size1, value->size2);
+  pending_.push_back(Pending_(MatrixRecord, value, pos_));
+  skip_(value->size1 * value->size2 * sizeof(double));
+}
+
+void StateReader::read(const String& key, gsl_matrix_complex* value)
+{
+  get_header_(key, ComplexMatrixRecord, value->size1, value->size2);
+  pending_.push_back(Pending_(ComplexMatrixRecord, value, pos_));
+  skip_(2 * value->size1 * value->size2 * sizeof(double));
+}
+
+void StateReader::read(const String& key, double* value, unsigned n)
+{
+  get_header_(key, VectorRecord, n, 1);
+  pending_.push_back(Pending_(ArrayPending_, value, pos_, n));
+  skip_(n * sizeof(double));
+}
+
+void StateReader::commit()
+{
+  if (pos_ != end_)
+    throw jconsistency_error("State file '%s' has records that were not read.", fileName_.c_str());
+
+  for (unsigned i = 0; i < pending_.size(); i++) {
+    const char* payload = &buffer_[pending_[i].pos];
+    switch (pending_[i].type) {
+    case VectorRecord: {
+      gsl_vector* value = (gsl_vector*) pending_[i].value;
+      for (size_t j = 0; j < value->size; j++) {
+	double v;
+	memcpy(&v, payload + j * sizeof(double), sizeof(v));
+	gsl_vector_set(value, j, v);
+      }
+      break;
+    }
+    case ArrayPending_:
+      memcpy(pending_[i].value, payload, pending_[i].size * sizeof(double));
+      break;
+    case ComplexVectorRecord: {
+      gsl_vector_complex* value = (gsl_vector_complex*) pending_[i].value;
+      for (size_t j = 0; j < value->size; j++)
+	memcpy(value->data + 2 * j * value->stride, payload + 2 * j * sizeof(double), 2 * sizeof(double));
+      break;
+    }
+    case MatrixRecord: {
+      gsl_matrix* value = (gsl_matrix*) pending_[i].value;
+      for (size_t j = 0; j < value->size1; j++)
+	memcpy(value->data + j * value->tda, payload + j * value->size2 * sizeof(double), value->size2 * sizeof(double));
+      break;
+    }
+    default: {
+      gsl_matrix_complex* value = (gsl_matrix_complex*) pending_[i].value;
+      for (size_t j = 0; j < value->size1; j++)
+	memcpy(value->data + 2 * j * value->tda, payload + 2 * j * value->size2 * sizeof(double), 2 * value->size2 * sizeof(double));
+      break;
+    }
+    }
+  }
+  pending_.clear();
+}
@@ -0,0 +1,110 @@
+/**
+ * @file state_io.h
+ * @brief Binary checkpoints of the state of adaptive filters.
+ */
+
+#ifndef STATE_IO_H
+#define STATE_IO_H
+
+#include <vector>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include "common/mlist.h"
+
+/**
+* \defgroup StateIO State Checkpoints
+* A checkpoint holds a header, a sequence of named records and a trailer:
+*
+*   "BTKSTATE" | version | byte order mark | kind
+*   key | type | size1 | size2 | payload          (repeated)
+*   "__end__" | checksum
+*
+* Strings are stored as their length followed by the characters, integers
+* as 32 or 64 bits in host byte order and all numerical payloads as doubles;
+* the checksum is the 32-bit FNV-1a hash of everything before the trailer.
+*
+* 'StateReader' loads and verifies the whole file before the first record
+* is read. The records must be read back in the order they were written; a
+* different key, type or shape raises 'jconsistency_error', and a geometry
+* value that differs from the one of the running filter 'jdimension_error'.
+* 'read()' only checks a vector or matrix record and remembers where it
+* goes; 'commit()' copies all of them once every record has been read, so
+* a truncated, corrupted or foreign checkpoint leaves the filter untouched.
+*/
+/*@{*/
+
+// ----- definition for class `StateWriter' -----
+//
+class StateWriter {
+ public:
+  // 'kind' identifies the class whose state is written
+  StateWriter(const String& kind);
+
+  void write(const String& key, int value);
+  void write(const String& key, double value);
+  void write(const String& key, const gsl_vector* value);
+  void write(const String& key, const gsl_vector_complex* value);
+  void write(const String& key, const gsl_matrix* value);
+  void write(const String& key, const gsl_matrix_complex* value);
+  // 'n' doubles, stored as a vector
+  void write(const String& key, const double* value, unsigned n);
+
+  // append the trailer and write the checkpoint
+  void save(const String& fileName);
+
+ private:
+  void put_(const void* data, size_t len);
+  void put_header_(const String& key, unsigned type, unsigned size1, unsigned size2);
+
+  std::vector<char>				buffer_;
+};
+
+
+// ----- definition for class `StateReader' -----
+//
+class StateReader {
+ public:
+  // load 'fileName' and check that it holds a complete checkpoint of 'kind'
+  StateReader(const String& fileName, const String& kind);
+
+  const String& kind() const { return kind_; }
+
+  // read an integer that must equal 'expected'
+  void check(const String& key, int expected);
+
+  int read_int(const String& key);
+  double read_double(const String& key);
+  void read(const String& key, gsl_vector* value);
+  void read(const String& key, gsl_vector_complex* value);
+  void read(const String& key, gsl_matrix* value);
+  void read(const String& key, gsl_matrix_complex* value);
+  void read(const String& key, double* value, unsigned n);
+
+  // check that all records have been read and copy the vectors and matrices into their destinations
+  void commit();
+
+ private:
+  struct Pending_ {
+    Pending_(unsigned t, void* v, size_t p, unsigned n = 0) : type(t), value(v), pos(p), size(n) { }
+
+    unsigned					type;
+    void*					value;
+    size_t					pos;	// of the payload in 'buffer_'
+    unsigned					size;	// of a 'double' array
+  };
+
+  void get_(void* data, size_t len);
+  void skip_(size_t len);
+  void get_header_(const String& key, unsigned type, unsigned size1, unsigned size2);
+
+  const String					fileName_;
+  String					kind_;
+  std::vector<char>				buffer_;
+  size_t					pos_;
+  size_t					end_;	// start of the trailer
+  std::vector<Pending_>				pending_;
+};
+
+/*@}*/
+
+#endif
@@ -151,6 +151,24 @@ void NormalFFTAnalysisBank::reset()
   framesPadded_ = 0;
 }
 
+void NormalFFTAnalysisBank::describe(StreamInfo& info) const
+{
+  char signature[64];
+  sprintf(signature, "%u,%u,%d", M_, r_, winType_);
+
+  info.sources.push_back(samp_.operator->());
+  info.signature = signature;
+  info.flops     = 2.0 * M_ + 5.0 * M_ * log2(double(M_));
+  info.bytes     = (M_ * R_ + M_ + D_ * R_ + N_ + 2 * N_) * sizeof(double);
+}
+
+void NormalFFTAnalysisBank::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(samp_, src);
+}
+
 void NormalFFTAnalysisBank::update_buf_()
 {
   for (unsigned sampX = 0; sampX < R_; sampX++)
@@ -415,6 +433,28 @@ void OverSampledDFTAnalysisBank::reset()
   framesPadded_ = 0;
 }
 
+void OverSampledDFTAnalysisBank::describe(StreamInfo& info) const
+{
+  char signature[64];
+  sprintf(signature, "%u,%u,%u,%u,%u,%d", M_, m_, r_, laN_, processing_delay_, gain_factor_);
+
+  info.sources.push_back(samp_.operator->());
+  info.signature = signature;
+  // the banks must have the same prototype as well
+  info.data.push_back(std::make_pair((const void*) prototype_->data, prototype_->size * sizeof(double)));
+  info.flops     = 2.0 * M_ * m_ + 5.0 * M_ * log2(double(M_));
+  info.bytes     = (N_ + M_ * m_ * R_ + M_ + D_ * R_ + 2 * M_) * sizeof(double);
+  // reads 'laN_' frames ahead to compensate the processing delay
+  info.lockstep  = (laN_ == 0);
+}
+
+void OverSampledDFTAnalysisBank::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(samp_, src);
+}
+
 bool OverSampledDFTAnalysisBank::update_buffer_(int frame_no)
 {
   const gsl_vector_float* block;
@@ -621,6 +661,28 @@ void OverSampledDFTSynthesisBank::reset()
   buffer_.zero();
 }
 
+void OverSampledDFTSynthesisBank::describe(StreamInfo& info) const
+{
+  // fed by 'input_source_vector()'
+  if (no_stream_feature_ || samp_.is_null()) return;
+
+  char signature[64];
+  sprintf(signature, "%u,%u,%u,%u,%d", M_, m_, r_, processing_delay_, gain_factor_);
+
+  info.sources.push_back(samp_.operator->());
+  info.signature = signature;
+  info.data.push_back(std::make_pair((const void*) prototype_->data, prototype_->size * sizeof(double)));
+  info.flops     = 2.0 * M_ * m_ + 5.0 * M_ * log2(double(M_));
+  info.bytes     = (N_ + M_ * m_ * R_ + M_ + M_ * R_ + 2 * M_) * sizeof(double);
+}
+
+void OverSampledDFTSynthesisBank::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0 || no_stream_feature_)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(samp_, src);
+}
+
 void write_gsl_format(const String& fileName, const gsl_vector* prototype)
 {
   FILE* fp = btk_fopen(fileName, "w");
@@ -724,6 +786,26 @@ void PerfectReconstructionFFTAnalysisBank::reset()
   framesPadded_ = 0;
 }
 
+void PerfectReconstructionFFTAnalysisBank::describe(StreamInfo& info) const
+{
+  char signature[64];
+  sprintf(signature, "%u,%u,%u", M_, m_, r_);
+
+  info.sources.push_back(samp_.operator->());
+  info.signature = signature;
+  // the banks must have the same prototype as well
+  info.data.push_back(std::make_pair((const void*) prototype_->data, prototype_->size * sizeof(double)));
+  info.flops     = 2.0 * Mx2_ * m_ + 6.0 * Mx2_ + 5.0 * Mx2_ * log2(double(Mx2_));
+  info.bytes     = (N_ + Mx2_ * m_ * (r_ + 2) + Mx2_ + 2 * Mx2_ + D_ * Rx2_ + 2 * Mx2_) * sizeof(double);
+}
+
+void PerfectReconstructionFFTAnalysisBank::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(samp_, src);
+}
+
 void PerfectReconstructionFFTAnalysisBank::update_buffer_(int frame_no)
 {
   if (framesPadded_ == 0) { // normal processing
@@ -903,6 +985,27 @@ void PerfectReconstructionFFTSynthesisBank::reset()
   buffer_.zero();
 }
 
+void PerfectReconstructionFFTSynthesisBank::describe(StreamInfo& info) const
+{
+  if (samp_.is_null()) return;
+
+  char signature[64];
+  sprintf(signature, "%u,%u,%u", M_, m_, r_);
+
+  info.sources.push_back(samp_.operator->());
+  info.signature = signature;
+  info.data.push_back(std::make_pair((const void*) prototype_->data, prototype_->size * sizeof(double)));
+  info.flops     = 2.0 * Mx2_ * m_ + 6.0 * Mx2_ + 5.0 * Mx2_ * log2(double(Mx2_));
+  info.bytes     = (N_ + Mx2_ * m_ * (r_ + 2) + Mx2_ + 2 * Mx2_ + Mx2_ * Rx2_ + 2 * Mx2_) * sizeof(double);
+}
+
+void PerfectReconstructionFFTSynthesisBank::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(samp_, src);
+}
+
 // ----- definition for class `DelayFeature' -----
 //
 DelayFeature::DelayFeature(const VectorComplexFeatureStreamPtr& samp, float time_delay, const String& nm )
@@ -920,6 +1023,20 @@ void DelayFeature::reset()
   VectorComplexFeatureStream::reset();
 }
 
+void DelayFeature::describe(StreamInfo& info) const
+{
+  // 'set_time_delay()' may change the output at any time: never shared
+  info.sources.push_back(samp_.operator->());
+  info.flops = 8.0 * size();
+}
+
+void DelayFeature::set_source(unsigned srcX, Countable* src)
+{
+  if (srcX != 0)
+    throw jindex_error("Stream '%s' has a single source.", name().c_str());
+  rewire_source(samp_, src);
+}
+
 const gsl_vector_complex* DelayFeature::next(int frame_no)
 {
   if ( frame_no == frame_no_ ) return vector_;
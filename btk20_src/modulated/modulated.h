@@ -167,6 +167,8 @@ class NormalFFTAnalysisBank
 
   virtual const gsl_vector_complex* next(int frame_no = -5);
   virtual void reset();
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
   unsigned fftlen() const { return N_; }
 
 #ifdef ENABLE_LEGACY_BTK_API
@@ -180,7 +182,7 @@ protected:
 #ifdef HAVE_LIBFFTW3
   fftw_plan                          fftwPlan_;
 #endif
-  const VectorFloatFeatureStreamPtr  samp_;
+  VectorFloatFeatureStreamPtr        samp_;
   int                                winType_; // 1 = hamming, 2 = hann window
   unsigned                           N_;       // FFT length
   const unsigned	             processing_delay_;
@@ -278,6 +280,8 @@ class OverSampledDFTAnalysisBank
   virtual const gsl_vector_complex* next(int frame_no = -5);
 
   virtual void reset();
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
 
   unsigned fftlen() const { return M_; }
   unsigned shiftlen() const { return D_; }
@@ -299,7 +303,7 @@ class OverSampledDFTAnalysisBank
 #ifdef HAVE_LIBFFTW3
   fftw_plan					fftwPlan_;
 #endif
-  const VectorFloatFeatureStreamPtr		samp_;
+  VectorFloatFeatureStreamPtr			samp_;
   double*					polyphase_output_;
   unsigned					framesPadded_;
 };
@@ -325,6 +329,8 @@ class OverSampledDFTSynthesisBank
 
   virtual const gsl_vector_float* next(int frame_no = -5);
   virtual void reset();
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
   using OverSampledDFTFilterBank::polyphase;
 
   void input_source_vector(const gsl_vector_complex* block){ update_buf_(block); }
@@ -338,7 +344,7 @@ class OverSampledDFTSynthesisBank
   bool update_buffer_(int frame_no);
   void update_buf_(const gsl_vector_complex* block);
 
-  const VectorComplexFeatureStreamPtr		samp_;
+  VectorComplexFeatureStreamPtr			samp_;
   bool                                          no_stream_feature_;
 #ifdef HAVE_LIBFFTW3
   fftw_plan					fftwPlan_;
@@ -368,6 +374,8 @@ class PerfectReconstructionFFTAnalysisBank
   virtual const gsl_vector_complex* next(int frame_no = -5);
 
   virtual void reset();
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
 
 #ifdef ENABLE_LEGACY_BTK_API
   unsigned fftLen()	 const { return Mx2_; }
@@ -387,7 +395,7 @@ class PerfectReconstructionFFTAnalysisBank
   double*					polyphase_output_;
   unsigned					framesPadded_;
 
-  const VectorFloatFeatureStreamPtr		samp_;
+  VectorFloatFeatureStreamPtr			samp_;
 };
 
 typedef Inherit<PerfectReconstructionFFTAnalysisBank, VectorComplexFeatureStreamPtr> PerfectReconstructionFFTAnalysisBankPtr;
@@ -410,6 +418,8 @@ class PerfectReconstructionFFTSynthesisBank
   virtual const gsl_vector_float* next(int frame_no = -5);
 
   virtual void reset();
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
 
   using PerfectReconstructionFilterBank::polyphase;
 
@@ -417,7 +427,7 @@ class PerfectReconstructionFFTSynthesisBank
   void update_buffer_(int frame_no);
   void update_buffer_(const gsl_vector_complex* block);
 
-  const VectorComplexFeatureStreamPtr		samp_;
+  VectorComplexFeatureStreamPtr			samp_;
 #ifdef HAVE_LIBFFTW3
   fftw_plan					fftwPlan_;
 #endif
@@ -437,9 +447,11 @@ class DelayFeature : public VectorComplexFeatureStream {
   virtual const gsl_vector_complex* next(int frame_no = -5);
 
   virtual void reset();
+  virtual void describe(StreamInfo& info) const;
+  virtual void set_source(unsigned srcX, Countable* src);
 
 private:
-  const VectorComplexFeatureStreamPtr samp_;
+  VectorComplexFeatureStreamPtr       samp_;
   float                               time_delay_;
 };
 
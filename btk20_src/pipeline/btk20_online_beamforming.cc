@@ -0,0 +1,103 @@
+/**
+ * @file btk20_online_beamforming.cc
+ * @brief Command line front end of 'OnlineBeamformingPipeline'.
+ *
+ * Accepts the options of unit_test/test_online_beamforming.py:
+ *
+ *   btk20_online_beamforming -c confs/sd_and_zelinski.json -o out/beamformed.wav \
+ *     -a prototype.ny/h-M256-m4-r1.pickle -s prototype.ny/g-M256-m4-r1.pickle \
+ *     -i c1.wav c2.wav c3.wav c4.wav
+ *
+ * With '-T depth' the analysis bank of each channel runs on its own thread.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include "common/jexception.h"
+#include "pipeline/online_beamforming.h"
+
+// default configuration of the Python script
+static const char* DefaultConf =
+  "{\"array_type\":\"linear\","
+  " \"microphone_positions\":[[-113.0, 0.0, 2.0], [36.0, 0.0, 2.0], [76.0, 0.0, 2.0], [113.0, 0.0, 2.0]],"
+  " \"target\":{\"positions\":[[0.0, [-1.306379, null, null]]]},"
+  " \"beamformer\":{\"type\":\"super_directive\"},"
+  " \"postfilter\":{\"type\":\"zelinski\", \"subtype\":2, \"alpha\":0.7}}";
+
+static void usage_(const char* prog)
+{
+  fprintf(stderr,
+	  "usage: %s [-a analysis-prototype] [-s synthesis-prototype] [-M subbands] [-m length-factor]\n"
+	  "          [-r decimation-factor] [-R samplerate] [-c config.json] [-T stage-depth] [-q]\n"
+	  "          -o output.wav -i input1.wav ... inputN.wav\n",
+	  prog);
+}
+
+int main(int argc, char **argv)
+{
+  unsigned M = 256, m = 4, r = 1, samplerate = 16000, stageDepth = 0;
+  String   analysisPath, synthesisPath, confPath, outPath;
+  bool     quiet = false;
+  vector<String> inputPaths;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "a:s:M:m:r:R:c:o:i:T:qh")) != -1) {
+    switch (opt) {
+    case 'a': analysisPath  = optarg; break;
+    case 's': synthesisPath = optarg; break;
+    case 'M': M = atoi(optarg); break;
+    case 'm': m = atoi(optarg); break;
+    case 'r': r = atoi(optarg); break;
+    case 'R': samplerate = atoi(optarg); break;
+    case 'c': confPath = optarg; break;
+    case 'o': outPath  = optarg; break;
+    case 'i': inputPaths.push_back(optarg); break;
+    case 'T': stageDepth = atoi(optarg); break;
+    case 'q': quiet = true; break;
+    default:
+      usage_(argv[0]);
+      return 1;
+    }
+  }
+  // '-i' takes the remaining arguments as further inputs
+  for (int argX = optind; argX < argc; argX++)
+    inputPaths.push_back(argv[argX]);
+
+  char defaultPath[256];
+  if (analysisPath == "") {
+    snprintf(defaultPath, sizeof(defaultPath), "prototype.ny/h-M%d-m%d-r%d.pickle", M, m, r);
+    analysisPath = defaultPath;
+  }
+  if (synthesisPath == "") {
+    snprintf(defaultPath, sizeof(defaultPath), "prototype.ny/g-M%d-m%d-r%d.pickle", M, m, r);
+    synthesisPath = defaultPath;
+  }
+  if (outPath == "" || inputPaths.size() == 0) {
+    usage_(argv[0]);
+    return 1;
+  }
+
+  try {
+    JsonValue conf = (confPath == "") ? JsonValue::parse(DefaultConf) : JsonValue::load(confPath);
+    if (quiet == false)
+      fprintf(stderr, "BF config.\n%s\n\n", conf.dump().c_str());
+
+    gsl_vector* h = load_filter_prototype(analysisPath);
+    gsl_vector* g = load_filter_prototype(synthesisPath);
+    OnlineBeamformingPipeline pipeline(conf, h, g, M, m, r, inputPaths, samplerate, stageDepth);
+    gsl_vector_free(h);  gsl_vector_free(g);
+
+    double   totalEnergy;
+    unsigned framesN = pipeline.process(outPath, &totalEnergy, quiet ? 0 : 128);
+
+    printf("Avg. output power: %f\n", (framesN > 0) ? totalEnergy / framesN : 0.0);
+    printf("No. frames processed: %d\n", framesN);
+    if (quiet == false && pipeline.deadline_scheduler().is_null() == false)
+      pipeline.deadline_scheduler()->report(stderr);
+  } catch (j_error& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 2;
+  }
+
+  return 0;
+}
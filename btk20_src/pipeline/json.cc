@@ -0,0 +1,310 @@
+/*
+ * @file json.cc
+ * @brief Minimal JSON reader for the array processing configurations.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "common/jexception.h"
+#include "common/common.h"
+#include "pipeline/json.h"
+
+
+// ----- definition for class `JsonValue::Parser_' -----
+//
+class JsonValue::Parser_ {
+ public:
+  Parser_(const String& text) : text_(text), pos_(0), line_(1) { }
+
+  JsonValue parse_document()
+  {
+    JsonValue value(parse_value_());
+    skip_space_();
+    if (pos_ != text_.size())
+      throw jparse_error("JSON: unexpected trailing characters at line %d", line_);
+    return value;
+  }
+
+ private:
+  void skip_space_()
+  {
+    while (pos_ < text_.size()) {
+      char c = text_[pos_];
+      if (c == '\n') line_++;
+      if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+      pos_++;
+    }
+  }
+
+  char peek_()
+  {
+    skip_space_();
+    if (pos_ >= text_.size())
+      throw jparse_error("JSON: unexpected end of input at line %d", line_);
+    return text_[pos_];
+  }
+
+  void expect_(char c)
+  {
+    if (peek_() != c)
+      throw jparse_error("JSON: expected '%c' but found '%c' at line %d", c, text_[pos_], line_);
+    pos_++;
+  }
+
+  bool match_(const char* word)
+  {
+    size_t len = strlen(word);
+    if (text_.compare(pos_, len, word) != 0) return false;
+    pos_ += len;
+    return true;
+  }
+
+  JsonValue parse_value_()
+  {
+    JsonValue value;
+    char c = peek_();
+    if (c == '{') {
+      pos_++;
+      value.type_ = Object;
+      if (peek_() == '}') { pos_++; return value; }
+      while (true) {
+	if (peek_() != '"')
+	  throw jparse_error("JSON: expected a key at line %d", line_);
+	String key(parse_string_());
+	expect_(':');
+	value.object_[key] = parse_value_();
+	if (peek_() == ',') { pos_++; continue; }
+	expect_('}');
+	break;
+      }
+    } else if (c == '[') {
+      pos_++;
+      value.type_ = Array;
+      if (peek_() == ']') { pos_++; return value; }
+      while (true) {
+	value.array_.push_back(parse_value_());
+	if (peek_() == ',') { pos_++; continue; }
+	expect_(']');
+	break;
+      }
+    } else if (c == '"') {
+      value.type_ = Text;
+      value.text_ = parse_string_();
+    } else if (match_("true")) {
+      value.type_    = Boolean;
+      value.boolean_ = true;
+    } else if (match_("false")) {
+      value.type_    = Boolean;
+      value.boolean_ = false;
+    } else if (match_("null")) {
+      value.type_ = Null;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+      const char* begin = text_.c_str() + pos_;
+      char*       end;
+      value.type_   = Number;
+      value.number_ = strtod(begin, &end);
+      if (end == begin)
+	throw jparse_error("JSON: invalid number at line %d", line_);
+      pos_ += end - begin;
+    } else {
+      throw jparse_error("JSON: unexpected character '%c' at line %d", c, line_);
+    }
+    return value;
+  }
+
+  // UTF-8 encoding of one code point
+  static void append_utf8_(String& str, unsigned cp)
+  {
+    if (cp < 0x80) {
+      str += char(cp);
+    } else if (cp < 0x800) {
+      str += char(0xC0 | (cp >> 6));
+      str += char(0x80 | (cp & 0x3F));
+    } else {
+      str += char(0xE0 | (cp >> 12));
+      str += char(0x80 | ((cp >> 6) & 0x3F));
+      str += char(0x80 | (cp & 0x3F));
+    }
+  }
+
+  String parse_string_()
+  {
+    expect_('"');
+    String str;
+    while (true) {
+      if (pos_ >= text_.size())
+	throw jparse_error("JSON: unterminated string at line %d", line_);
+      char c = text_[pos_++];
+      if (c == '"') break;
+      if (c != '\\') { str += c; continue; }
+
+      if (pos_ >= text_.size())
+	throw jparse_error("JSON: unterminated string at line %d", line_);
+      c = text_[pos_++];
+      switch (c) {
+      case '"':  str += '"';  break;
+      case '\\': str += '\\'; break;
+      case '/':  str += '/';  break;
+      case 'b':  str += '\b'; break;
+      case 'f':  str += '\f'; break;
+      case 'n':  str += '\n'; break;
+      case 'r':  str += '\r'; break;
+      case 't':  str += '\t'; break;
+      case 'u': {
+	if (pos_ + 4 > text_.size())
+	  throw jparse_error("JSON: invalid escape at line %d", line_);
+	unsigned cp = strtoul(text_.substr(pos_, 4).c_str(), NULL, 16);
+	pos_ += 4;
+	append_utf8_(str, cp);
+	break;
+      }
+      default:
+	throw jparse_error("JSON: invalid escape '\\%c' at line %d", c, line_);
+      }
+    }
+    return str;
+  }
+
+  const String&					text_;
+  size_t					pos_;
+  int						line_;
+};
+
+
+// ----- methods for class `JsonValue' -----
+//
+JsonValue JsonValue::parse(const String& text)
+{
+  Parser_ parser(text);
+  return parser.parse_document();
+}
+
+JsonValue JsonValue::load(const String& fileName)
+{
+  FILE* fp = btk_fopen(fileName, "r");
+  String text;
+  char   buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    text.append(buffer, n);
+  btk_fclose(fileName, fp);
+
+  return parse(text);
+}
+
+static const char* type_name_(JsonValue::Type type)
+{
+  static const char* names[] = { "null", "boolean", "number", "string", "array", "object" };
+  return names[type];
+}
+
+void JsonValue::check_type_(Type type) const
+{
+  if (type_ != type)
+    throw jtype_error("JSON: expected %s but found %s", type_name_(type), type_name_(type_));
+}
+
+bool JsonValue::boolean() const
+{
+  check_type_(Boolean);
+  return boolean_;
+}
+
+double JsonValue::number() const
+{
+  check_type_(Number);
+  return number_;
+}
+
+const String& JsonValue::text() const
+{
+  check_type_(Text);
+  return text_;
+}
+
+unsigned JsonValue::size() const
+{
+  if (type_ == Object) return object_.size();
+  check_type_(Array);
+  return array_.size();
+}
+
+const JsonValue& JsonValue::operator[](unsigned index) const
+{
+  check_type_(Array);
+  if (index >= array_.size())
+    throw jindex_error("JSON: index %d out of range (%d)", index, array_.size());
+  return array_[index];
+}
+
+bool JsonValue::has(const String& key) const
+{
+  check_type_(Object);
+  return object_.find(key) != object_.end();
+}
+
+const JsonValue& JsonValue::operator[](const String& key) const
+{
+  check_type_(Object);
+  map<String, JsonValue>::const_iterator itr = object_.find(key);
+  if (itr == object_.end())
+    throw jkey_error("JSON: missing key '%s'", key.c_str());
+  return itr->second;
+}
+
+vector<String> JsonValue::keys() const
+{
+  check_type_(Object);
+  vector<String> keys;
+  for (map<String, JsonValue>::const_iterator itr = object_.begin(); itr != object_.end(); itr++)
+    keys.push_back(itr->first);
+  return keys;
+}
+
+double JsonValue::get(const String& key, double def) const
+{
+  if (has(key) == false || (*this)[key].is_null()) return def;
+  return (*this)[key].number();
+}
+
+String JsonValue::get(const String& key, const char* def) const
+{
+  if (has(key) == false || (*this)[key].is_null()) return def;
+  return (*this)[key].text();
+}
+
+String JsonValue::dump(unsigned indent) const
+{
+  String pad(string(indent + 2, ' ')), out;
+  char   buffer[64];
+
+  switch (type_) {
+  case Null:    return "null";
+  case Boolean: return boolean_ ? "true" : "false";
+  case Number:
+    snprintf(buffer, sizeof(buffer), "%.10g", number_);
+    return buffer;
+  case Text:
+    out = "\"";
+    for (unsigned i = 0; i < text_.size(); i++) {
+      if (text_[i] == '"' || text_[i] == '\\') out += '\\';
+      out += text_[i];
+    }
+    return out + "\"";
+  case Array:
+    out = "[";
+    for (unsigned i = 0; i < array_.size(); i++)
+      out += ((i > 0) ? ", " : "") + array_[i].dump(indent + 2);
+    return out + "]";
+  case Object:
+  default:
+    out = "{\n";
+    for (map<String, JsonValue>::const_iterator itr = object_.begin(); itr != object_.end(); itr++) {
+      if (itr != object_.begin()) out += ",\n";
+      out += pad + "\"" + itr->first + "\": " + itr->second.dump(indent + 2);
+    }
+    return out + "\n" + string(indent, ' ') + "}";
+  }
+}
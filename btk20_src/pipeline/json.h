@@ -0,0 +1,78 @@
+/**
+ * @file json.h
+ * @brief Minimal JSON reader for the array processing configurations.
+ */
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <map>
+#include <vector>
+#include "common/mlist.h"
+
+/**
+* \defgroup JsonValue JSON Configuration Values
+* Parses the JSON files under unit_test/confs so that the native pipeline
+* runners accept the same configurations as the Python scripts. Malformed
+* input raises 'jparse_error', a missing key 'jkey_error' and access with
+* the wrong type 'jtype_error'.
+*/
+/*@{*/
+
+// ----- definition for class `JsonValue' -----
+//
+class JsonValue {
+ public:
+  typedef enum { Null, Boolean, Number, Text, Array, Object } Type;
+
+  JsonValue() : type_(Null), boolean_(false), number_(0.0) { }
+
+  static JsonValue parse(const String& text);
+  static JsonValue load(const String& fileName);
+
+  Type type() const { return type_; }
+  bool is_null() const { return type_ == Null; }
+  bool is_number() const { return type_ == Number; }
+  bool is_array() const { return type_ == Array; }
+  bool is_object() const { return type_ == Object; }
+
+  bool boolean() const;
+  double number() const;
+  const String& text() const;
+
+  // arrays and objects
+  unsigned size() const;
+  const JsonValue& operator[](unsigned index) const;
+  const JsonValue& operator[](int index) const { return (*this)[unsigned(index)]; }
+
+  // objects
+  bool has(const String& key) const;
+  const JsonValue& operator[](const String& key) const;
+  const JsonValue& operator[](const char* key) const { return (*this)[String(key)]; }
+  vector<String> keys() const;
+
+  // value of 'key' or 'def' if 'key' is missing or null
+  double get(const String& key, double def) const;
+  int get(const String& key, int def) const { return int(get(key, double(def))); }
+  String get(const String& key, const char* def) const;
+
+  // serialize with two-space indentation
+  String dump(unsigned indent = 0) const;
+
+ private:
+  class Parser_;
+  friend class Parser_;
+
+  void check_type_(Type type) const;
+
+  Type						type_;
+  bool						boolean_;
+  double					number_;
+  String					text_;
+  vector<JsonValue>				array_;
+  map<String, JsonValue>			object_;
+};
+
+/*@}*/
+
+#endif
@@ -0,0 +1,531 @@
+/*
+ * @file online_beamforming.cc
+ * @brief Native online subband beamforming pipeline driven by the JSON array processing configurations.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "common/jexception.h"
+#include "common/common.h"
+#include "pipeline/online_beamforming.h"
+
+using namespace sndfile;
+
+
+// ----- delays -----
+//
+gsl_vector* calc_array_delays(const String& arrayType, const gsl_matrix* micPositions, const double* position,
+			      double sspeed, int refMicX)
+{
+  unsigned    chanN  = micPositions->size1;
+  gsl_vector* delays = gsl_vector_alloc(chanN);
+  if (refMicX < 0) refMicX = chanN / 2;
+  if (refMicX >= int(chanN))
+    throw jindex_error("reference microphone %d out of range (%d)", refMicX, chanN);
+
+#define MPOS(i, j) gsl_matrix_get(micPositions, i, j)
+  if (arrayType == "linear") {
+    for (unsigned i = 0; i < chanN; i++)
+      gsl_vector_set(delays, i, - MPOS(i, 0) * cos(position[0]) / sspeed);
+    double ref = gsl_vector_get(delays, refMicX);
+    gsl_vector_add_constant(delays, -ref);
+  } else if (arrayType == "planar") {
+    double s = sin(position[1]);
+    for (unsigned i = 0; i < chanN; i++) {
+      double dx = MPOS(i, 0) - MPOS(refMicX, 0);
+      double dy = MPOS(i, 1) - MPOS(refMicX, 1);
+      gsl_vector_set(delays, i, - (dx * cos(position[0]) * s + dy * sin(position[0]) * s) / sspeed);
+    }
+  } else if (arrayType == "circular") {
+    double cx = - sin(position[1]) * cos(position[0]);
+    double cy = - sin(position[1]) * sin(position[0]);
+    double cz = - cos(position[1]);
+    for (unsigned i = 0; i < chanN; i++)
+      gsl_vector_set(delays, i, (cx * MPOS(i, 0) + cy * MPOS(i, 1) + cz * MPOS(i, 2)) / sspeed);
+  } else if (arrayType == "nearfield") {
+    for (unsigned i = 0; i < chanN; i++) {
+      double dx = position[0] - MPOS(i, 0), dy = position[1] - MPOS(i, 1), dz = position[2] - MPOS(i, 2);
+      gsl_vector_set(delays, i, sqrt(dx * dx + dy * dy + dz * dz) / sspeed);
+    }
+    double ref = gsl_vector_get(delays, refMicX);
+    gsl_vector_add_constant(delays, -ref);
+  } else {
+    gsl_vector_free(delays);
+    throw jparameter_error("Invalid array type: %s", arrayType.c_str());
+  }
+#undef MPOS
+
+  return delays;
+}
+
+
+// ----- filter prototypes -----
+//
+static unsigned read_le32_(const unsigned char* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (unsigned(p[3]) << 24);
+}
+
+// Python 3 pickles bytes with protocol 2 as a latin-1 string encoded in UTF-8
+static bool decode_latin1_(const unsigned char* p, unsigned len, String& out)
+{
+  out.clear();
+  for (unsigned i = 0; i < len; i++) {
+    if (p[i] < 0x80) {
+      out += char(p[i]);
+    } else if ((p[i] & 0xE0) == 0xC0 && i + 1 < len) {
+      unsigned cp = ((p[i] & 0x1F) << 6) | (p[i + 1] & 0x3F);
+      if (cp > 0xFF) return false;
+      out += char(cp);  i++;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+  The prototypes are 1-D float64 numpy arrays. Rather than interpreting the
+  pickle, take the largest raw string of the stream whose size is a multiple
+  of eight bytes; it holds the little-endian array data.
+*/
+static gsl_vector* read_pickled_prototype_(const String& data, const String& fileName)
+{
+  if (data.find("numpy") == String::npos || data.find("f8") == String::npos)
+    throw jparse_error("%s: not a pickled float64 numpy array", fileName.c_str());
+
+  const unsigned char* p = (const unsigned char*) data.data();
+  const unsigned       n = data.size();
+  String               best;
+
+  for (unsigned i = 0; i + 5 <= n; i++) {
+    unsigned len = 0, hdr = 0;
+    bool     utf8 = false;
+    switch (p[i]) {
+    case 'T':	// BINSTRING
+    case 'B':	// BINBYTES
+      len = read_le32_(p + i + 1);  hdr = 5;  break;
+    case 'C':	// SHORT_BINBYTES
+      len = p[i + 1];  hdr = 2;  break;
+    case 'X':	// BINUNICODE
+      len = read_le32_(p + i + 1);  hdr = 5;  utf8 = true;  break;
+    default:
+      continue;
+    }
+    if (len < 8 || i + hdr + len > n) continue;
+
+    String payload;
+    if (utf8) {
+      if (decode_latin1_(p + i + hdr, len, payload) == false) continue;
+    } else {
+      payload.assign((const char*) p + i + hdr, len);
+    }
+    if (payload.size() % 8 == 0 && payload.size() > best.size())
+      best = payload;
+  }
+
+  if (best.size() == 0)
+    throw jparse_error("%s: could not find the array data", fileName.c_str());
+
+  unsigned    len   = best.size() / 8;
+  gsl_vector* proto = gsl_vector_alloc(len);
+  const unsigned char* q = (const unsigned char*) best.data();
+  for (unsigned i = 0; i < len; i++) {
+    unsigned long long bits = 0;
+    for (int b = 7; b >= 0; b--)
+      bits = (bits << 8) | q[8 * i + b];
+    double val;
+    memcpy(&val, &bits, sizeof(double));
+    gsl_vector_set(proto, i, val);
+  }
+  return proto;
+}
+
+gsl_vector* load_filter_prototype(const String& fileName)
+{
+  FILE*  fp = btk_fopen(fileName, "rb");
+  String data;
+  char   buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    data.append(buffer, n);
+  btk_fclose(fileName, fp);
+
+  if (data.size() > 0 && ((unsigned char) data[0] == 0x80 || data.compare(0, 6, "cnumpy") == 0))
+    return read_pickled_prototype_(data, fileName);
+
+  vector<double> coeffs;
+  const char*    ptr = data.c_str();
+  while (true) {
+    char*  end;
+    double val = strtod(ptr, &end);
+    if (end == ptr) break;
+    coeffs.push_back(val);
+    ptr = end;
+  }
+  if (coeffs.size() == 0)
+    throw jparse_error("%s: no filter coefficients", fileName.c_str());
+
+  gsl_vector* proto = gsl_vector_alloc(coeffs.size());
+  for (unsigned i = 0; i < coeffs.size(); i++)
+    gsl_vector_set(proto, i, coeffs[i]);
+  return proto;
+}
+
+
+// ----- methods for class `OnlineBeamformingPipeline' -----
+//
+OnlineBeamformingPipeline::
+OnlineBeamformingPipeline(const JsonValue& conf, const gsl_vector* h, const gsl_vector* g,
+			  unsigned M, unsigned m, unsigned r, const vector<String>& inputFiles,
+			  unsigned samplerate, unsigned stageDepth)
+  : conf_(conf), M_(M), D_(M >> r), samplerate_(samplerate), chanN_(inputFiles.size()),
+    arrayType_(conf["array_type"].text()), bfType_(conf["beamformer"]["type"].text()),
+    micPositions_(NULL), activeN_(chanN_), activePositions_(NULL), h_(NULL), g_(NULL), isWeightSet_(false), posX_(0),
+    isWeightPending_(false), deadline_(NULL), deadlineX_(0)
+{
+  vector<VectorFloatFeatureStreamPtr> inputs;
+  for (unsigned chanX = 0; chanX < chanN_; chanX++) {
+    SampleFeaturePtr sample(new SampleFeature("", D_, D_, /* padZeros= */ true));
+    sample->read(inputFiles[chanX], 0, samplerate_);
+    inputs.push_back(VectorFloatFeatureStreamPtr(sample));
+  }
+
+  build_(inputs, h, g, m, r, stageDepth);
+}
+
+OnlineBeamformingPipeline::
+OnlineBeamformingPipeline(const JsonValue& conf, const gsl_vector* h, const gsl_vector* g,
+			  unsigned M, unsigned m, unsigned r, const vector<VectorFloatFeatureStreamPtr>& inputs,
+			  unsigned samplerate, unsigned stageDepth)
+  : conf_(conf), M_(M), D_(M >> r), samplerate_(samplerate), chanN_(inputs.size()),
+    arrayType_(conf["array_type"].text()), bfType_(conf["beamformer"]["type"].text()),
+    micPositions_(NULL), activeN_(chanN_), activePositions_(NULL), h_(NULL), g_(NULL), isWeightSet_(false), posX_(0),
+    isWeightPending_(false), deadline_(NULL), deadlineX_(0)
+{
+  for (unsigned chanX = 0; chanX < chanN_; chanX++)
+    if (inputs[chanX]->size() != D_)
+      throw jdimension_error("input %d has blocks of %d samples instead of %d", chanX, inputs[chanX]->size(), D_);
+
+  build_(inputs, h, g, m, r, stageDepth);
+}
+
+void OnlineBeamformingPipeline::build_(const vector<VectorFloatFeatureStreamPtr>& inputs, const gsl_vector* h, const gsl_vector* g,
+				       unsigned m, unsigned r, unsigned stageDepth)
+{
+  const JsonValue& mpos = conf_["microphone_positions"];
+  if (mpos.size() != chanN_)
+    throw jdimension_error("%d inputs for %d microphones", chanN_, mpos.size());
+  if (h->size != M_ * m || g->size != M_ * m)
+    throw jdimension_error("prototype lengths %d and %d do not match M * m = %d", h->size, g->size, M_ * m);
+
+  check_positions_();
+
+  micPositions_ = gsl_matrix_calloc(chanN_, 3);
+  for (unsigned chanX = 0; chanX < chanN_; chanX++)
+    for (unsigned i = 0; i < mpos[chanX].size() && i < 3; i++)
+      gsl_matrix_set(micPositions_, chanX, i, mpos[chanX][i].number());
+
+  h_ = gsl_vector_alloc(h->size);  gsl_vector_memcpy(h_, h);
+  g_ = gsl_vector_alloc(g->size);  gsl_vector_memcpy(g_, g);
+
+  for (unsigned chanX = 0; chanX < chanN_; chanX++) {
+    VectorFloatFeatureStreamPtr samp(inputs[chanX]);
+    VectorComplexFeatureStreamPtr analysis(new OverSampledDFTAnalysisBank(samp, h_, M_, m, r, 2));
+    if (stageDepth > 0)
+      analysis = VectorComplexPipelineStagePtr(new VectorComplexPipelineStage(analysis, stageDepth));
+    analysis_.push_back(analysis);
+  }
+
+  build_beamformer_();
+  update_positions_();
+  build_postfilter_();
+  synthesis_ = new OverSampledDFTSynthesisBank(spatialFilter_, g_, M_, m, r, 2);
+
+  if (conf_.has("real_time")) {
+    const JsonValue& rtConf = conf_["real_time"];
+    double deadline = rtConf.get("deadline_ms", 1.0E+03 * D_ / samplerate_) / 1.0E+03;
+    deadline_  = new DeadlineScheduler(deadline, rtConf.get("margin", 0.8));
+    deadlineX_ = deadline_->add_stage("beamformer weights", rtConf.get("max_deferral", 10));
+  }
+
+  calc_weights_(0);
+}
+
+OnlineBeamformingPipeline::~OnlineBeamformingPipeline()
+{
+  if (micPositions_ != NULL) gsl_matrix_free(micPositions_);
+  if (activePositions_ != NULL) gsl_matrix_free(activePositions_);
+  if (h_ != NULL) gsl_vector_free(h_);
+  if (g_ != NULL) gsl_vector_free(g_);
+}
+
+VectorComplexFeatureStreamPtr& OnlineBeamformingPipeline::analysis(unsigned chanX)
+{
+  if (chanX >= chanN_)
+    throw jindex_error("channel %d out of range (%d)", chanX, chanN_);
+  return analysis_[chanX];
+}
+
+// the checks of 'check_position_data_format()' in the Python script
+void OnlineBeamformingPipeline::check_positions_() const
+{
+  unsigned minDim = 3;
+  if (arrayType_ == "linear") minDim = 1;
+  else if (arrayType_ == "planar" || arrayType_ == "circular") minDim = 2;
+
+  const JsonValue& targets = conf_["target"]["positions"];
+  if (targets.size() == 0)
+    throw jparameter_error("No target position");
+  for (unsigned posX = 0; posX < targets.size(); posX++) {
+    double t = targets[posX][0].number();
+    if (targets[posX][1].size() < minDim)
+      throw jparameter_error("Insufficient position info. at time %0.3f", t);
+    if (conf_.has("noises") == false) continue;
+    for (unsigned noiseX = 0; noiseX < conf_["noises"].size(); noiseX++) {
+      const JsonValue& noise = conf_["noises"][noiseX]["positions"][posX];
+      if (noise[0].number() != t)
+	throw jparameter_error("%d-th noise: Misaligned time stamp %0.4f != %0.4f", noiseX, t, noise[0].number());
+      if (noise[1].size() < minDim)
+	throw jparameter_error("Insufficient position info. at time %0.3f", t);
+    }
+  }
+}
+
+void OnlineBeamformingPipeline::build_beamformer_()
+{
+  const JsonValue& bfConf = conf_["beamformer"];
+
+  if (conf_.has("noises") && bfType_ != "lcmv")
+    fprintf(stderr, "Noise information will be ignored\n");
+
+  if (bfType_ == "delay_and_sum" || bfType_ == "lcmv") {
+    gsc_        = new SubbandGSC(M_, /* halfBandShift= */ false);
+    beamformer_ = gsc_;
+  } else if (bfType_ == "super_directive") {
+    mvdr_       = new SubbandMVDRGSC(M_, /* halfBandShift= */ false);
+    beamformer_ = mvdr_;
+  } else if (bfType_ == "gscrls") {
+    // the native RLS update; 'init_diagonal_load' sets the initial precision matrices,
+    // 'max_wa_l2norm' bounds the norm of the active weights if 'constraint_option' >= 2
+    rls_ = new SubbandGSCRLS(M_, /* halfBandShift= */ false, bfConf.get("mu", 0.97), bfConf.get("regularization_param", 1.0E-2));
+    if (bfConf.get("constraint_option", 3) >= 2)
+      rls_->set_quadratic_constraint(bfConf.get("max_wa_l2norm", 100.0), THRESHOLD_LIMITATION);
+    beamformer_ = rls_;
+  } else if (bfType_ == "gsclms") {
+    throw jparameter_error("Beamformer type %s is only implemented in Python (lib/pybeamformer.py)", bfType_.c_str());
+  } else {
+    throw jkey_error("Invalid beamformer type: %s", bfType_.c_str());
+  }
+
+  if (conf_.has("channel_selection") == false) {
+    for (unsigned chanX = 0; chanX < chanN_; chanX++)
+      beamformer_->set_channel(analysis_[chanX]);
+    return;
+  }
+
+  // the selector commits a new selection in 'update()', before the next frame is pulled
+  const JsonValue& selConf = conf_["channel_selection"];
+  activeN_  = selConf.get("channels", int(chanN_));
+  selector_ = new ChannelSelector(activeN_, selConf.get("interval", 50), selConf.get("forgetting_factor", 0.95),
+				  selConf.get("bin_step", 4), selConf.get("dead_db", -30.0), selConf.get("distortion_db", 10.0),
+				  selConf.get("hysteresis", 0.05), /* autoCommit= */ false);
+  for (unsigned chanX = 0; chanX < chanN_; chanX++)
+    selector_->add_channel(analysis_[chanX]);
+  for (unsigned slotX = 0; slotX < activeN_; slotX++) {
+    VectorComplexFeatureStreamPtr chan(new SelectedChannelFeature(selector_, slotX));
+    beamformer_->set_channel(chan);
+  }
+}
+
+// copy the positions of the microphones routed to the beamformer
+void OnlineBeamformingPipeline::update_positions_()
+{
+  if (activePositions_ == NULL)
+    activePositions_ = gsl_matrix_alloc(activeN_, 3);
+
+  for (unsigned slotX = 0; slotX < activeN_; slotX++) {
+    unsigned chanX = selector_.is_null() ? slotX : selector_->selected(slotX);
+    for (unsigned i = 0; i < 3; i++)
+      gsl_matrix_set(activePositions_, slotX, i, gsl_matrix_get(micPositions_, chanX, i));
+  }
+}
+
+void OnlineBeamformingPipeline::set_noise_model_()
+{
+  const JsonValue& bfConf = conf_["beamformer"];
+  String           pfType = conf_["postfilter"]["type"].text();
+
+  if (pfType == "mccowan") {
+    McCowanPostFilter* pf = (McCowanPostFilter*) &(*postfilter_);
+    pf->set_diffuse_noise_model(activePositions_, samplerate_, BTK_SOUND_SPEED);
+    pf->set_all_diagonal_loading(bfConf.get("diagonal_load", 0.01));
+  } else if (pfType == "lefkimmiatis") {
+    LefkimmiatisPostFilter* pf = (LefkimmiatisPostFilter*) &(*postfilter_);
+    pf->set_diffuse_noise_model(activePositions_, samplerate_, BTK_SOUND_SPEED);
+    pf->set_all_diagonal_loading(bfConf.get("diagonal_load", 0.1));
+    pf->calc_inverse_noise_spatial_spectral_matrix();
+  }
+}
+
+void OnlineBeamformingPipeline::build_postfilter_()
+{
+  spatialFilter_ = beamformer_;
+  if (conf_.has("postfilter") == false) return;
+
+  if (bfType_ != "delay_and_sum" && bfType_ != "lcmv" && bfType_ != "super_directive")
+    throw jparameter_error("Post-filter unsupported: %s", bfType_.c_str());
+
+  const JsonValue& pfConf = conf_["postfilter"];
+  String           pfType = pfConf["type"].text();
+  VectorComplexFeatureStreamPtr bf(beamformer_);
+
+  if (pfType == "zelinski") {
+    postfilter_ = new ZelinskiPostFilter(bf, M_, pfConf.get("alpha", 0.6), pfConf.get("subtype", 2));
+  } else if (pfType == "mccowan") {
+    postfilter_ = new McCowanPostFilter(bf, M_, pfConf.get("alpha", 0.6), pfConf.get("subtype", 2));
+  } else if (pfType == "lefkimmiatis") {
+    postfilter_ = new LefkimmiatisPostFilter(bf, M_, pfConf.get("min_sv", 1.0E-8), pfConf.get("fbin_no1", 128),
+					     pfConf.get("alpha", 0.8), pfConf.get("subtype", 2));
+  } else {
+    throw jkey_error("Invalid post-filter type: %s", pfType.c_str());
+  }
+  set_noise_model_();
+  spatialFilter_ = postfilter_;
+}
+
+gsl_vector* OnlineBeamformingPipeline::delays_(const JsonValue& source, unsigned posX) const
+{
+  const JsonValue& pos = source["positions"][posX][1];
+  double position[3] = { 0.0, 0.0, 0.0 };
+  for (unsigned i = 0; i < pos.size() && i < 3; i++)
+    if (pos[i].is_null() == false) position[i] = pos[i].number();
+
+  return calc_array_delays(arrayType_, activePositions_, position, BTK_SOUND_SPEED);
+}
+
+void OnlineBeamformingPipeline::calc_weights_(unsigned posX)
+{
+  const JsonValue& bfConf  = conf_["beamformer"];
+  gsl_vector*      delaysT = delays_(conf_["target"], posX);
+
+  if (bfType_ == "delay_and_sum") {
+    gsc_->calc_gsc_weights(samplerate_, delaysT);
+    gsc_->zero_active_weights();
+  } else if (bfType_ == "lcmv") {
+    if (conf_.has("noises") == false) {
+      gsl_vector_free(delaysT);
+      throw jparameter_error("LCMV beamforming: missing noise source positions");
+    }
+    unsigned    noiseN  = conf_["noises"].size();
+    gsl_matrix* delaysJ = gsl_matrix_alloc(noiseN, activeN_);
+    for (unsigned noiseX = 0; noiseX < noiseN; noiseX++) {
+      gsl_vector* delays = delays_(conf_["noises"][noiseX], posX);
+      gsl_matrix_set_row(delaysJ, noiseX, delays);
+      gsl_vector_free(delays);
+    }
+    gsc_->calc_gsc_weights_n(samplerate_, delaysT, delaysJ, noiseN + 1);
+    gsc_->zero_active_weights();
+    gsl_matrix_free(delaysJ);
+  } else if (bfType_ == "super_directive") {
+    mvdr_->calc_array_manifold_vectors(samplerate_, delaysT);
+    mvdr_->set_diffuse_noise_model(activePositions_, samplerate_, BTK_SOUND_SPEED);
+    mvdr_->set_all_diagonal_loading(bfConf.get("diagonal_load", 0.01));
+    mvdr_->calc_mvdr_weights(samplerate_, 1.0E-8, true);
+    mvdr_->zero_active_weights();
+  } else if (bfType_ == "gscrls") {
+    rls_->calc_gsc_weights(samplerate_, delaysT);
+    if (isWeightSet_ == false)
+      rls_->init_precision_matrix(bfConf.get("init_diagonal_load", 1.0E+6));
+  }
+  gsl_vector_free(delaysT);
+
+  // the post-filter refers to the weights of the beamformer, which are reallocated above
+  if (postfilter_.is_null() == false)
+    postfilter_->set_beamformer(beamformer_);
+
+  isWeightSet_ = true;
+}
+
+void OnlineBeamformingPipeline::update(int frame_no)
+{
+  const JsonValue& targets = conf_["target"]["positions"];
+  double elapsed = frame_no * double(D_) / samplerate_;
+
+  if (frame_no > 0 && elapsed > targets[posX_][0].number() && posX_ + 1 < targets.size()) {
+    posX_++;
+    isWeightPending_ = true;
+  }
+
+  // a different set of microphones: new geometry, and the adaptive state of the old one is void:
+  // the noise matrices of the post-filter follow the new positions, its spectral densities start
+  // afresh, and 'calc_weights_()' below resets the precision matrices of the RLS beamformer
+  bool remapped = false;
+  if (selector_.is_null() == false && selector_->commit()) {
+    update_positions_();
+    if (postfilter_.is_null() == false) {
+      set_noise_model_();
+      postfilter_->restart_spectral_densities();
+    }
+    isWeightSet_ = false;
+    isWeightPending_ = true;
+    remapped = true;
+  }
+
+  if (isWeightPending_ == false) return;
+
+  // keep the last weights while the deadline is at risk, unless they belong to other microphones
+  if (remapped == false && deadline_.is_null() == false && deadline_->fallback(deadlineX_)) return;
+
+  calc_weights_(posX_);
+  isWeightPending_ = false;
+  if (deadline_.is_null() == false) deadline_->done(deadlineX_);
+}
+
+unsigned OnlineBeamformingPipeline::process(const String& outputFile, double* totalEnergy, int progressInterval)
+{
+  SF_INFO info;
+  memset(&info, 0, sizeof(info));
+  info.samplerate = samplerate_;
+  info.channels   = 1;
+  info.format     = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+  SNDFILE* sndfile = sf_open(outputFile.c_str(), SFM_WRITE, &info);
+  if (sndfile == NULL)
+    throw jio_error("Could not open file %s.", outputFile.c_str());
+
+  short*   buffer = new short[D_];
+  double   energy = 0.0;
+  unsigned frameX = 0;
+  try {
+    while (true) {
+      if (deadline_.is_null() == false) deadline_->begin_frame();
+      update(frameX);
+      const gsl_vector_float* block = synthesis_->next(frameX);
+      if (deadline_.is_null() == false) deadline_->end_frame();
+      if (progressInterval > 0 && frameX % progressInterval == 0)
+	fprintf(stderr, "%0.2f sec. processed\n", frameX * double(D_) / samplerate_);
+
+      for (unsigned n = 0; n < D_; n++) {
+	float val = gsl_vector_float_get(block, n);
+	energy += val * val;
+	if (val > 32767.0)  val = 32767.0;
+	if (val < -32768.0) val = -32768.0;
+	buffer[n] = short(val);
+      }
+      sf_writef_short(sndfile, buffer, D_);
+      frameX++;
+    }
+  } catch (j_error& e) {
+    if (e.getCode() != JITERATOR) {
+      delete[] buffer;
+      sf_close(sndfile);
+      throw;
+    }
+  }
+  delete[] buffer;
+  sf_close(sndfile);
+
+  if (totalEnergy != NULL) *totalEnergy = energy;
+  return frameX;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file online_beamforming.h
+ * @brief Native online subband beamforming pipeline driven by the JSON array processing configurations.
+ */
+
+#ifndef ONLINE_BEAMFORMING_H
+#define ONLINE_BEAMFORMING_H
+
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include "stream/stream.h"
+#include "stream/pipelined_stream.h"
+#include "stream/deadline_scheduler.h"
+#include "feature/feature.h"
+#include "modulated/modulated.h"
+#include "beamformer/beamformer.h"
+#include "beamformer/channel_selection.h"
+#include "postfilter/postfilter.h"
+#include "pipeline/json.h"
+
+/**
+* \defgroup OnlineBeamformingPipeline Online Beamforming Pipeline
+* Builds the stream graph of unit_test/test_online_beamforming.py,
+*
+*   SampleFeature -> OverSampledDFTAnalysisBank -> beamformer [-> post-filter] -> OverSampledDFTSynthesisBank,
+*
+* in C++ from the same JSON configuration, so that no interpreter is involved
+* in the per-frame processing. The supported beamformers are 'delay_and_sum',
+* 'lcmv', 'super_directive' and 'gscrls'; the post-filters are 'zelinski',
+* 'mccowan' and 'lefkimmiatis'.
+*
+* An optional "channel_selection" block, e.g.
+*
+*   "channel_selection": {"channels": 8, "interval": 50}
+*
+* routes only the best 'channels' microphones to the beamformer through a
+* 'ChannelSelector'; whenever the selection changes, the weights and the
+* noise models of the post-filter are recomputed for the positions of the
+* selected microphones, and the spectral densities of the post-filter and the
+* precision matrices of 'gscrls' start afresh.
+*
+* An optional "real_time" block, e.g.
+*
+*   "real_time": {"deadline_ms": 8.0, "margin": 0.8, "max_deferral": 10}
+*
+* runs 'process()' under a 'DeadlineScheduler'. The deadline defaults to the
+* frame shift. While the deadline is at risk, a recomputation of the weights
+* for a new look direction is deferred and the last weights are kept, for at
+* most 'max_deferral' consecutive frames (0: no limit). A new set of selected
+* microphones is never deferred, as the last weights belong to other channels.
+*/
+/*@{*/
+
+#define BTK_SOUND_SPEED 343740.0	// mm per second
+
+/**
+   @brief calculate the time delays towards a source, as 'calc_delays()' in lib/pybeamformer.py
+   @param const String& arrayType[in] 'linear', 'planar', 'circular' or 'nearfield'
+   @param const gsl_matrix* micPositions[in] positions of the microphones in mm (chanN x 3)
+   @param const double* position[in] azimuth for 'linear'; azimuth and polar angle for 'planar' and 'circular'; x, y and z for 'nearfield'
+   @param double sspeed[in] speed of sound in mm/s
+   @param int refMicX[in] reference microphone; the middle one if negative
+   @return delays in seconds; the caller must free it
+ */
+gsl_vector* calc_array_delays(const String& arrayType, const gsl_matrix* micPositions, const double* position,
+			      double sspeed = BTK_SOUND_SPEED, int refMicX = -1);
+
+/**
+   @brief load a filter bank prototype
+   @note Both the plain text format of 'PrototypeDesignBase::save()' (one coefficient per line)
+         and the pickled numpy arrays written by tools/filterbank are accepted.
+ */
+gsl_vector* load_filter_prototype(const String& fileName);
+
+
+// ----- definition for class `OnlineBeamformingPipeline' -----
+//
+class OnlineBeamformingPipeline {
+ public:
+  /**
+     @param const JsonValue& conf[in] array processing configuration, the schema of the files in unit_test/confs
+     @param const gsl_vector* h[in] analysis prototype
+     @param const gsl_vector* g[in] synthesis prototype
+     @param unsigned M[in] number of subbands
+     @param unsigned m[in] filter length factor
+     @param unsigned r[in] exponential decimation factor; the frame shift is M / 2^r
+     @param const vector<String>& inputFiles[in] one audio file per microphone
+     @param unsigned stageDepth[in] if > 0, run the analysis bank of each channel on its own
+                                    'PipelineStage' with that many frame buffers
+   */
+  OnlineBeamformingPipeline(const JsonValue& conf, const gsl_vector* h, const gsl_vector* g,
+			    unsigned M, unsigned m, unsigned r, const vector<String>& inputFiles,
+			    unsigned samplerate = 16000, unsigned stageDepth = 0);
+  // the same from sample streams with blocks of M / 2^r samples, e.g. synthetic signals
+  OnlineBeamformingPipeline(const JsonValue& conf, const gsl_vector* h, const gsl_vector* g,
+			    unsigned M, unsigned m, unsigned r, const vector<VectorFloatFeatureStreamPtr>& inputs,
+			    unsigned samplerate = 16000, unsigned stageDepth = 0);
+  ~OnlineBeamformingPipeline();
+
+  unsigned chanN() const { return chanN_; }
+  // number of channels processed by the beamformer
+  unsigned activeN() const { return activeN_; }
+  unsigned shiftLen() const { return D_; }
+
+  // the output stream; call 'update(frame_no)' before pulling each frame
+  VectorFloatFeatureStreamPtr& output() { return synthesis_; }
+  // the intermediate stages: the analysis bank of a channel and the beamformer or its post-filter
+  VectorComplexFeatureStreamPtr& analysis(unsigned chanX);
+  VectorComplexFeatureStreamPtr& spatial_filter() { return spatialFilter_; }
+
+  // recompute the weights once the elapsed time passes the time stamp of the next position
+  void update(int frame_no);
+
+  // NULL without a "real_time" block; other stages, e.g. an SRP estimator, may register with it
+  DeadlineSchedulerPtr& deadline_scheduler() { return deadline_; }
+
+  /**
+     @brief process all frames and write them as 16-bit mono audio
+     @param double* totalEnergy[out] sum of the squared output samples; ignored if NULL
+     @param int progressInterval[in] report the progress on stderr every that many frames; no report if <= 0
+     @return the number of frames processed
+   */
+  unsigned process(const String& outputFile, double* totalEnergy = NULL, int progressInterval = 0);
+
+ private:
+  void build_(const vector<VectorFloatFeatureStreamPtr>& inputs, const gsl_vector* h, const gsl_vector* g,
+	      unsigned m, unsigned r, unsigned stageDepth);
+  void check_positions_() const;
+  void build_beamformer_();
+  void build_postfilter_();
+  void calc_weights_(unsigned posX);
+  void update_positions_();
+  void set_noise_model_();
+  gsl_vector* delays_(const JsonValue& source, unsigned posX) const;
+
+  const JsonValue				conf_;
+  const unsigned				M_;
+  const unsigned				D_;
+  const unsigned				samplerate_;
+  const unsigned				chanN_;
+  String					arrayType_;
+  String					bfType_;
+  gsl_matrix*					micPositions_;
+  unsigned					activeN_;
+  gsl_matrix*					activePositions_;	// positions of the channels processed by the beamformer
+  gsl_vector*					h_;
+  gsl_vector*					g_;
+
+  vector<VectorComplexFeatureStreamPtr>		analysis_;
+  ChannelSelectorPtr				selector_;
+  SubbandDSPtr					beamformer_;	// one of the following
+  SubbandGSCPtr					gsc_;
+  SubbandGSCRLSPtr				rls_;
+  SubbandMVDRGSCPtr				mvdr_;
+  VectorComplexFeatureStreamPtr			spatialFilter_;
+  ZelinskiPostFilterPtr				postfilter_;
+  VectorFloatFeatureStreamPtr			synthesis_;
+  bool						isWeightSet_;
+  unsigned					posX_;
+  bool						isWeightPending_;
+  DeadlineSchedulerPtr				deadline_;
+  unsigned					deadlineX_;
+};
+
+typedef refcount_ptr<OnlineBeamformingPipeline> OnlineBeamformingPipelinePtr;
+
+/*@}*/
+
+#endif
@@ -1,6 +1,7 @@
 #include "postfilter/postfilter.h"
 #include <gsl/gsl_blas.h>
 #include <gsl/gsl_sf_trig.h>
+#include "matrix/complex_kernels.h"
 
 /**
    @brief calculate cross spectral density (CSD).
@@ -32,14 +33,7 @@ static void time_alignment_(  const gsl_vector_complex *arrayManifold_f,
 		     int nChan,
 		     gsl_vector_complex *output )
 {    
-  gsl_complex dsf, xsf, ysf;
-
-  for(int i=0;i<nChan;i++){
-    dsf = gsl_complex_conjugate( gsl_vector_complex_get( arrayManifold_f, i ) );
-    xsf = gsl_vector_complex_get( snapShot_f, i );
-    ysf = gsl_complex_mul( dsf, xsf );
-    gsl_vector_complex_set( output, i, ysf );
-  }
+  ComplexKernels::mul_conj( nChan, ComplexKernels::data(arrayManifold_f), ComplexKernels::data(snapShot_f), ComplexKernels::data(output) );
 }
 
 /**
@@ -140,6 +134,14 @@ double ZelinskiFilter_f(const gsl_vector_complex *arrayManifold,
 }
 
 
+// the weight of the last update of bin 'fbinX'; the bin is passed through until its first update
+static double held_weight_(const gsl_vector_complex* pfweights, unsigned fbinX)
+{
+  double weight = GSL_REAL( gsl_vector_complex_get( pfweights, fbinX ) );
+  return ( weight > 0.0 ) ? weight : 1.0;
+}
+
+
 /**
    @brief 
 
@@ -153,6 +155,7 @@ double ZelinskiFilter_f(const gsl_vector_complex *arrayManifold,
    @param gsl_vector_complex *pfweights  [out]  the weights of postfilter
    @param double alpha [in] 
    @param int pfType [in] You can select a real operator in Eq. (4). If pfType==TYPE_ZELINSKI1_REAL, the real value of the sum of cross spectral densities is taken. If pfType==TYPE_ZELINSKI1_ABS, the absolute of the sum of cross spectral densities is taken. If pfType==NO_USE_POST_FILTER, *prevCSDf is just updated.
+   @param AdaptationScheduler* scheduler [in] if not NULL, the bins it does not adapt keep their last weight
 */
 void ZelinskiFilter(gsl_vector_complex **arrayManifold,
 		    SnapShotArrayPtr     snapShotArray, 
@@ -160,7 +163,9 @@ void ZelinskiFilter(gsl_vector_complex **arrayManifold,
 		    gsl_vector_complex *beamformedSignal,
 		    gsl_vector_complex **prevCSDs, 
 		    gsl_vector_complex *pfweights,
-		    double alpha, int pfType )
+		    double alpha, int pfType,
+		    const SubbandRange* range,
+		    AdaptationScheduler* scheduler )
 {
   int fftLen = snapShotArray->fftLen();
   int nChan  = snapShotArray->nChan();
@@ -175,7 +180,12 @@ void ZelinskiFilter(gsl_vector_complex **arrayManifold,
       const gsl_vector_complex* snapShot    = snapShotArray->snapshot(fbinX);
       gsl_vector_complex* prevCSDf          = prevCSDs[fbinX];
     
-      r = ZelinskiFilter_f( propagation, snapShot, nChan, prevCSDf, alpha, pfType );
+      if( NULL != range && false == range->in_band(fbinX) )
+	r = ( ZERO_OUT_OF_BAND == range->mode() ) ? 0.0 : 1.0;
+      else if( NULL != scheduler && false == scheduler->adapt(fbinX) )
+	r = held_weight_( pfweights, fbinX );
+      else
+	r = ZelinskiFilter_f( propagation, snapShot, nChan, prevCSDf, ( NULL == scheduler ) ? alpha : scheduler->forgetting(alpha, fbinX), pfType );
       wf = gsl_complex_polar( r, 0 );
       gsl_vector_complex_set( pfweights, fbinX, wf );
     }
@@ -186,7 +196,12 @@ void ZelinskiFilter(gsl_vector_complex **arrayManifold,
       const gsl_vector_complex* snapShot    = snapShotArray->snapshot(fbinX);
       gsl_vector_complex* prevCSDf          = prevCSDs[fbinX];
     
-      r = ZelinskiFilter_f( propagation, snapShot, nChan, prevCSDf, alpha, pfType );
+      if( NULL != range && false == range->in_band(fbinX) )
+	r = ( ZERO_OUT_OF_BAND == range->mode() ) ? 0.0 : 1.0;
+      else if( NULL != scheduler && false == scheduler->adapt(fbinX) )
+	r = held_weight_( pfweights, fbinX );
+      else
+	r = ZelinskiFilter_f( propagation, snapShot, nChan, prevCSDf, ( NULL == scheduler ) ? alpha : scheduler->forgetting(alpha, fbinX), pfType );
       wf = gsl_complex_polar( r, 0 );
       gsl_vector_complex_set( pfweights, fbinX, wf );
       if( fbinX > 0 && fbinX < fftLen2 )// substitute a conjugate component
@@ -200,19 +215,11 @@ void ZelinskiFilter(gsl_vector_complex **arrayManifold,
     
   // filter the wave
   if( halfBandShift==true ){
-    for(int fbinX=0;fbinX<fftLen;fbinX++){
-      wf = gsl_vector_complex_get( pfweights, fbinX );
-      gsl_complex outf = gsl_complex_mul( wf, gsl_vector_complex_get( beamformedSignal, fbinX ) );
-      gsl_vector_complex_set( beamformedSignal, fbinX, outf );
-    }
+    ComplexKernels::mul( fftLen, ComplexKernels::data(pfweights), ComplexKernels::data(beamformedSignal), ComplexKernels::data(beamformedSignal) );
   } else {
-    for(int fbinX=0;fbinX<=fftLen2;fbinX++){
-      wf = gsl_vector_complex_get( pfweights, fbinX );
-      gsl_complex outf = gsl_complex_mul( wf, gsl_vector_complex_get( beamformedSignal, fbinX ) );
-      gsl_vector_complex_set( beamformedSignal, fbinX, outf );
-      if( fbinX > 0 && fbinX < fftLen2 ){// substitute a conjugate component
-	gsl_vector_complex_set( beamformedSignal, fftLen - fbinX, gsl_complex_conjugate( outf ) );
-      }
+    ComplexKernels::mul( fftLen2 + 1, ComplexKernels::data(pfweights), ComplexKernels::data(beamformedSignal), ComplexKernels::data(beamformedSignal) );
+    for(int fbinX=1;fbinX<fftLen2;fbinX++){// substitute a conjugate component
+      gsl_vector_complex_set( beamformedSignal, fftLen - fbinX, gsl_complex_conjugate( gsl_vector_complex_get( beamformedSignal, fbinX ) ) );
     }
   }
 
@@ -323,14 +330,7 @@ void ApabFilter( gsl_vector_complex **arrayManifold,
     length = fftLen;    
   else
     length = fftLen2;
-  for(int fbinX=0;fbinX<length;fbinX++){
-    gsl_complex outf;
-
-    wf = gsl_vector_complex_get( windowV, fbinX );
-    //wf = gsl_complex_abs( wf );
-    outf = gsl_complex_mul( wf, gsl_vector_complex_get( beamformedSignal, fbinX ) );
-    gsl_vector_complex_set( beamformedSignal, fbinX, outf );
-  }
+  ComplexKernels::mul( length, ComplexKernels::data(windowV), ComplexKernels::data(beamformedSignal), ComplexKernels::data(beamformedSignal) );
 
   gsl_vector_complex_free( windowV );
 }
@@ -352,7 +352,10 @@ ZelinskiPostFilter::ZelinskiPostFilter( VectorComplexFeatureStreamPtr &output, u
   alpha_(alpha),
   min_frames_(minFrames),
   bf_weights_(NULL),
-  has_bf_ptr_(false)
+  has_bf_ptr_(false),
+  range_(fftLen),
+  scheduler_(NULL),
+  restart_(false)
 {
   if( output->size() != fftLen ){
     throw jdimension_error("Input block length (%d) != fftLen (%d)\n", output->size(), fftLen );
@@ -414,6 +417,24 @@ void ZelinskiPostFilter::set_array_manifold_vector(unsigned fbinX, gsl_vector_co
   }
 }
 
+/**
+   @brief the forgetting factor of the current frame: 0 in the first frame and in the first after
+          'restart_spectral_densities()', where the spectral densities start from the current frame
+*/
+double ZelinskiPostFilter::forgetting_start_()
+{
+  if( frame_no_ > 0 && false == restart_ )
+    return alpha_;
+
+  if( restart_ ){
+    gsl_vector_complex** prevCSDs = bf_weights_->CSDs();
+    for(unsigned fbinX=0;fbinX<bf_weights_->fftLen();fbinX++)
+      gsl_vector_complex_set_zero( prevCSDs[fbinX] );
+    restart_ = false;
+  }
+  return 0.0;
+}
+
 void ZelinskiPostFilter::reset()
 {
   samp_->reset();
@@ -457,20 +478,24 @@ const gsl_vector_complex* ZelinskiPostFilter::next(int frame_no)
     wq = bf_weights_->arrayManifold();
   }
 
-  if( frame_no_ > 0 )
-    alpha =  alpha_;
-  else
-    alpha = 0.0;
+  alpha = forgetting_start_();
 
   for (unsigned fbinX = 0; fbinX < fftLen; fbinX++)
     gsl_vector_complex_set(vector_, fbinX, gsl_vector_complex_get( output, fbinX ) );
 
+  AdaptationScheduler* scheduler = NULL;
+  if( false == scheduler_.is_null() ){
+    scheduler = &(*scheduler_);
+    scheduler->begin_frame( frame_no_ + 1 );
+  }
   if( frame_no_ < min_frames_ ){// just update cross spectral densities
-    ZelinskiFilter( wq, snapshot_array_, bf_weights_->isHalfBandShift(), vector_, prevCSDs, wp1, alpha, (int)NO_USE_POST_FILTER);
+    ZelinskiFilter( wq, snapshot_array_, bf_weights_->isHalfBandShift(), vector_, prevCSDs, wp1, alpha, (int)NO_USE_POST_FILTER, &range_, scheduler );
   }
   else{
-    ZelinskiFilter( wq, snapshot_array_, bf_weights_->isHalfBandShift(), vector_, prevCSDs, wp1, alpha, type_ );
+    ZelinskiFilter( wq, snapshot_array_, bf_weights_->isHalfBandShift(), vector_, prevCSDs, wp1, alpha, type_, &range_, scheduler );
   }
+  if( NULL != scheduler )
+    scheduler->end_frame();
 
 #if 0
   unsigned showChanN = 2;// snapshot_array_->nChan();
@@ -862,10 +887,7 @@ void McCowanPostFilter::post_filtering_()
     wq = bf_weights_->arrayManifold();
   }
 
-  if( frame_no_ > 0 )
-    alpha =  alpha_;
-  else
-    alpha = 0.0;
+  alpha = forgetting_start_();
 
   if(  bf_weights_->isHalfBandShift()==false ){
     for(unsigned fbinX=0;fbinX<=fftLen2;fbinX++){
@@ -874,14 +896,22 @@ void McCowanPostFilter::post_filtering_()
       const gsl_vector_complex *snapShot    = snapshot_array_->snapshot(fbinX);
       gsl_vector_complex* prevCSDf          = prevCSDs[fbinX];
 
-      time_alignment_( propagation, snapShot, nChan, time_aligned_signal_f_ ); // beamforming
-      de = calculateSpectralDensities_f( time_aligned_signal_f_, prevCSDf, alpha  );
-      //fprintf(stderr,"de %d %f\n",fbinX,de);
-      nu = estimate_average_clean_PSD_(fbinX,prevCSDf);
-      //fprintf(stderr,"%d %d : %e = %e / %e \n",frame_no_,fbinX,nu/de,nu,de);
-      weight = nu / de;
-      if( weight >  1.0 ) weight =  1.0;
-      if( weight < SPECTRAL_FLOOR ) weight = SPECTRAL_FLOOR;
+      if( false == range_.in_band(fbinX) ){ // skip the estimation
+	weight = ( ZERO_OUT_OF_BAND == range_.mode() ) ? 0.0 : 1.0;
+      }
+      else if( false == adapt_(fbinX) ){ // keep the weight of the last update
+	weight = held_weight_( wp, fbinX );
+      }
+      else{
+	time_alignment_( propagation, snapShot, nChan, time_aligned_signal_f_ ); // beamforming
+	de = calculateSpectralDensities_f( time_aligned_signal_f_, prevCSDf, forgetting_( alpha, fbinX ) );
+	//fprintf(stderr,"de %d %f\n",fbinX,de);
+	nu = estimate_average_clean_PSD_(fbinX,prevCSDf);
+	//fprintf(stderr,"%d %d : %e = %e / %e \n",frame_no_,fbinX,nu/de,nu,de);
+	weight = nu / de;
+	if( weight >  1.0 ) weight =  1.0;
+	if( weight < SPECTRAL_FLOOR ) weight = SPECTRAL_FLOOR;
+      }
       gsl_vector_complex_set( wp, fbinX, gsl_complex_polar( weight, 0 ) );
       if( fbinX > 0 && fbinX < fftLen2 )
 	gsl_vector_complex_set( wp, fftLen_ - fbinX, gsl_complex_polar( weight, 0 ) );
@@ -926,7 +956,11 @@ const gsl_vector_complex* McCowanPostFilter::next(int frame_no)
   for (unsigned fbinX = 0; fbinX <= fftLen_/2; fbinX++)
     gsl_vector_complex_set(vector_, fbinX, gsl_vector_complex_get( output, fbinX ) );
 
+  if( false == scheduler_.is_null() )
+    scheduler_->begin_frame( frame_no_ + 1 );
   post_filtering_();
+  if( false == scheduler_.is_null() )
+    scheduler_->end_frame();
 
   increment_();
   return vector_;
@@ -1110,10 +1144,7 @@ void LefkimmiatisPostFilter::post_filtering_()
   if( NULL == time_aligned_signal_f_ )
     time_aligned_signal_f_ = gsl_vector_complex_calloc( nChan );
 
-  if( frame_no_ > 0 )
-    alpha =  alpha_;
-  else
-    alpha = 0.0;
+  alpha = forgetting_start_();
 
   if(  bf_weights_->isHalfBandShift()==false ){
     for(unsigned fbinX=0;fbinX<=fftLen2;fbinX++){
@@ -1122,25 +1153,33 @@ void LefkimmiatisPostFilter::post_filtering_()
       gsl_vector_complex* prevCSDf = prevCSDs[fbinX];
       const gsl_vector_complex *snapShot = snapshot_array_->snapshot(fbinX);
 
-      time_alignment_( arrayManifold[fbinX], snapShot, nChan, time_aligned_signal_f_ ); // beamforming
-      calculateSpectralDensities_f( time_aligned_signal_f_, prevCSDf, alpha );
-      phi_ss = estimate_average_clean_PSD_( fbinX, prevCSDf );
-      phi_vv = estimate_average_noise_PSD_( fbinX, prevCSDf );
-
-      if( fbinX < fbinX1_ ){
-	weight = phi_ss / ( phi_ss + phi_vv );
+      if( false == range_.in_band(fbinX) ){ // skip the estimation
+	weight = ( ZERO_OUT_OF_BAND == range_.mode() ) ? 0.0 : 1.0;
+      }
+      else if( false == adapt_(fbinX) ){ // keep the weight of the last update
+	weight = held_weight_( wp, fbinX );
       }
       else{
-	if( TYPE_ZELINSKI1_REAL & type_ ){
-	  phi_nn = phi_vv / GSL_REAL( calcLambda( fbinX ) );
+	time_alignment_( arrayManifold[fbinX], snapShot, nChan, time_aligned_signal_f_ ); // beamforming
+	calculateSpectralDensities_f( time_aligned_signal_f_, prevCSDf, forgetting_( alpha, fbinX ) );
+	phi_ss = estimate_average_clean_PSD_( fbinX, prevCSDf );
+	phi_vv = estimate_average_noise_PSD_( fbinX, prevCSDf );
+
+	if( fbinX < fbinX1_ ){
+  	weight = phi_ss / ( phi_ss + phi_vv );
+	}
+	else{
+  	if( TYPE_ZELINSKI1_REAL & type_ ){
+  	  phi_nn = phi_vv / GSL_REAL( calcLambda( fbinX ) );
+  	}
+  	else
+  	  phi_nn = phi_vv / gsl_complex_abs( calcLambda( fbinX ) );
+  	weight = phi_ss / ( phi_ss + phi_nn );
 	}
-	else
-	  phi_nn = phi_vv / gsl_complex_abs( calcLambda( fbinX ) );
-	weight = phi_ss / ( phi_ss + phi_nn );
-      }
 
-      if( weight >  1.0 ) weight =  1.0;
-      if( weight < SPECTRAL_FLOOR ) weight = SPECTRAL_FLOOR;
+	if( weight >  1.0 ) weight =  1.0;
+	if( weight < SPECTRAL_FLOOR ) weight = SPECTRAL_FLOOR;
+      }
       gsl_vector_complex_set( wp, fbinX, gsl_complex_polar( weight, 0 ) );
       if( fbinX > 0 && fbinX < fftLen2 )
 	gsl_vector_complex_set( wp, fftLen_ - fbinX, gsl_complex_polar( weight, 0 ) );
@@ -1186,7 +1225,11 @@ const gsl_vector_complex* LefkimmiatisPostFilter::next(int frame_no)
   for (unsigned fbinX = 0; fbinX <= fftLen_/2; fbinX++)
     gsl_vector_complex_set(vector_, fbinX, gsl_vector_complex_get( output, fbinX ) );
 
+  if( false == scheduler_.is_null() )
+    scheduler_->begin_frame( frame_no_ + 1 );
   post_filtering_();
+  if( false == scheduler_.is_null() )
+    scheduler_->end_frame();
 
   increment_();
   return vector_;
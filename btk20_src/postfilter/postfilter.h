@@ -53,7 +53,9 @@ void ZelinskiFilter(gsl_vector_complex **arrayManifold,
 		    gsl_vector_complex *beamformedSignal,
 		    gsl_vector_complex **prevCSDs, 
 		    gsl_vector_complex *pfweights,
-		    double alpha, int Ropt );
+		    double alpha, int Ropt,
+		    const SubbandRange* range = NULL,
+		    AdaptationScheduler* scheduler = NULL );
 
 void ApabFilter( gsl_vector_complex **arrayManifold,
 		 SnapShotArrayPtr     snapShotArray, 
@@ -88,6 +90,26 @@ public:
     return(bf_weights_->wp1());
   }
 
+  /**
+     @brief estimate and apply the post-filter only in the bins lower..upper
+     @param int mode[in] the other bins are passed through with ZERO_OUT_OF_BAND as the only exception
+   */
+  void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND){ range_.set_range(lower, upper, mode); }
+  void set_bin_mask(const gsl_vector* mask){ range_.set_mask(mask); }
+  void clear_bin_range(){ range_.clear(); }
+
+  /**
+     @brief update the spectral densities only in the frames and bins chosen by 'scheduler'
+     @note the other bins keep the weight of their last update
+   */
+  void set_adaptation_scheduler(const AdaptationSchedulerPtr& scheduler){ scheduler_ = scheduler; }
+
+  /**
+     @brief forget the auto and cross spectral densities; they start afresh with the next frame
+     @note for a new set of microphones, whose densities with the old ones are meaningless
+   */
+  void restart_spectral_densities(){ restart_ = true; }
+
 #ifdef ENABLE_LEGACY_BTK_API
   void setBeamformer(SubbandDSPtr &beamformer){ set_beamformer(beamformer); }
   void setSnapShotArray(SnapShotArrayPtr &snapShotArray){ set_snapshot_array(snapShotArray); }
@@ -96,6 +118,10 @@ public:
 #endif
 
 protected:
+  bool adapt_(unsigned fbinX){ return scheduler_.is_null() || scheduler_->adapt(fbinX); }
+  double forgetting_(double alpha, unsigned fbinX) const { return scheduler_.is_null() ? alpha : scheduler_->forgetting(alpha, fbinX); }
+  double forgetting_start_();
+
   unsigned                      fftLen_;
   VectorComplexFeatureStreamPtr samp_; /* output of the beamformer */
   PostfilterType                type_; /* the type of the Zelinski-postfilters */
@@ -105,6 +131,9 @@ protected:
   BeamformerWeights*            bf_weights_;
   bool                          has_bf_ptr_; /* true if bf_ptr_ is set with setBeamformer() */
   SnapShotArrayPtr              snapshot_array_; /* multi-channel input */
+  SubbandRange                  range_; /* bins to be post-filtered */
+  AdaptationSchedulerPtr        scheduler_;
+  bool                          restart_; /* true if the spectral densities start afresh with the next frame */
 };
 
 typedef Inherit<ZelinskiPostFilter, VectorComplexFeatureStreamPtr> ZelinskiPostFilterPtr;
@@ -63,6 +63,11 @@ public:
   void set_snapshot_array(SnapShotArrayPtr &snapShotArray);
   void set_array_manifold_vector(unsigned fbinX, gsl_vector_complex *arrayManifoldVector, bool halfBandShift, unsigned NC = 1);
   const gsl_vector_complex* postfilter_weights();
+  void set_bin_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND);
+  void set_bin_mask(const gsl_vector* mask);
+  void clear_bin_range();
+  void set_adaptation_scheduler(const AdaptationSchedulerPtr& scheduler);
+  void restart_spectral_densities();
 
 #ifdef ENABLE_LEGACY_BTK_API
   void setBeamformer( SubbandDSPtr &beamformer );
@@ -219,6 +224,8 @@ class SpectralSubtractor : public VectorComplexFeatureStream {
   void stop_noise_subtraction();
   bool read_noise_file(const String& fn, unsigned idx=0);
   bool write_noise_file(const String& fn, unsigned idx=0);
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
 
 #ifdef ENABLE_LEGACY_BTK_API
   void setChannel(VectorComplexFeatureStreamPtr& chan, double alpha=-1);
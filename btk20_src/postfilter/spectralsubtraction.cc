@@ -2,6 +2,7 @@
 #include <gsl/gsl_blas.h>
 #include <matrix/blas1_c.h>
 #include <matrix/linpack_c.h>
+#include <matrix/complex_kernels.h>
 
 PSDEstimator::PSDEstimator(unsigned fftLen2)
 {
@@ -118,8 +119,21 @@ bool AveragePSDEstimator::add_sample( const gsl_vector_complex *sample )
   return true;
 }
 
+// the stored samples grow until they are cleared
+void AveragePSDEstimator::memory_buffers_(MemoryUsage& usage) const
+{
+  PSDEstimator::memory_buffers_(usage);
+  size_t bytes = 0;
+  for (list<gsl_vector *>::const_iterator itr = sampleL_.begin(); itr != sampleL_.end(); itr++)
+    bytes += MemoryUsage::bytes(*itr);
+  usage.add("samples", bytes);
+}
+
 void AveragePSDEstimator::clear_samples()
 {
+  // record the peak of the stored samples
+  memory_usage();
+
   list<gsl_vector *>::iterator itr = sampleL_.begin();
   while( itr != sampleL_.end() ){
     gsl_vector_free( *itr );
@@ -160,6 +174,16 @@ SpectralSubtractor::~SpectralSubtractor()
     noisePSDList_.erase( noisePSDList_.begin(), noisePSDList_.end() );
 }
 
+void SpectralSubtractor::memory_buffers_(MemoryUsage& usage) const
+{
+  VectorComplexFeatureStream::memory_buffers_(usage);
+  char prefix[32];
+  for (unsigned chanX = 0; chanX < noisePSDList_.size(); chanX++) {
+    sprintf(prefix, "noise PSD %u", chanX);
+    usage.merge(prefix, noisePSDList_[chanX]->memory_usage());
+  }
+}
+
 void SpectralSubtractor::reset()
 {
   //fprintf(stderr,"SpectralSubtractor::reset\n");
@@ -206,6 +230,27 @@ bool SpectralSubtractor::read_noise_file(const String& fn, unsigned idx){
   return noisePSDList_.at(idx)->read_estimates( fn );
 }
 
+void SpectralSubtractor::save_state(const String& fileName) const
+{
+  StateWriter writer("SpectralSubtractor");
+  writer.write("fftLen", int(fftLen_));
+  writer.write("chanN", int(noisePSDList_.size()));
+  for (unsigned chanX = 0; chanX < noisePSDList_.size(); chanX++)
+    noisePSDList_[chanX]->write_state(writer);
+  writer.save(fileName);
+}
+
+void SpectralSubtractor::load_state(const String& fileName)
+{
+  StateReader reader(fileName, "SpectralSubtractor");
+  reader.check("fftLen", fftLen_);
+  reader.check("chanN", int(noisePSDList_.size()));
+  for (unsigned chanX = 0; chanX < noisePSDList_.size(); chanX++)
+    noisePSDList_[chanX]->read_state(reader);
+  reader.commit();
+  training_started_ = false;
+}
+
 /*
 @brief If the noise PSD model has been trained, which means training_started_ == false, 
        this method performs spectral subtraction on the audio data set by setChannel().  
@@ -317,7 +362,7 @@ const gsl_vector_complex *WienerFilter::next( int frame_no )
 
   const gsl_vector_complex *St = target_signal_->next( frame_no );
   const gsl_vector_complex *Nt = noise_signal_->next( frame_no );
-  double alpha, H, PSDs, PSDn, prevPSDs, prevPSDn, currPSDs, currPSDn;
+  double alpha, H, PSDs, PSDn, prevPSDn, currPSDn;
   gsl_complex val;
 
   if( frame_no_ > 0 )
@@ -327,10 +372,10 @@ const gsl_vector_complex *WienerFilter::next( int frame_no )
 
   if( false == halfBandShift_ ){
     gsl_vector_complex_set(vector_, 0, gsl_vector_complex_get( St, 0) );
+    // smoothed PSDs of bins 1, ..., fftLen2 in one pass
+    ComplexKernels::abs2_smooth( fftLen2_, alpha, 1-alpha, ComplexKernels::data(St) + 2, prev_PSDs_->data + 1 );
     for (unsigned fbinX = 1; fbinX <= fftLen2_; fbinX++) {
-      prevPSDs = gsl_vector_get( prev_PSDs_, fbinX );
-      currPSDs = gsl_complex_abs2( gsl_vector_complex_get( St, fbinX ) );
-      PSDs = alpha * prevPSDs + (1-alpha) * currPSDs;
+      PSDs = gsl_vector_get( prev_PSDs_, fbinX );
 
       prevPSDn = gsl_vector_get( prev_PSDn_, fbinX );
       if( update_noise_PSD_ ){
@@ -346,7 +391,6 @@ const gsl_vector_complex *WienerFilter::next( int frame_no )
       H = PSDs / ( PSDs + beta_ * PSDn );
       val = gsl_complex_mul_real( gsl_vector_complex_get( St, fbinX ), H );
       gsl_vector_complex_set(vector_, fbinX, val );
-      gsl_vector_set( prev_PSDs_, fbinX, PSDs );
       if( update_noise_PSD_ )
         gsl_vector_set( prev_PSDn_, fbinX, PSDn );
       if( fbinX == fftLen2_ )
@@ -15,12 +15,13 @@
 
 #include "stream/stream.h"
 #include "modulated/modulated.h"
+#include "matrix/state_io.h"
 
 class PSDEstimator {
 
  public:
   PSDEstimator(unsigned fftLen2);
-  ~PSDEstimator();
+  virtual ~PSDEstimator();
 
   bool read_estimates( const String& fn );
   bool write_estimates( const String& fn );
@@ -29,8 +30,17 @@ class PSDEstimator {
     return estimates_;
   }
 
+  void write_state(StateWriter& writer) const { writer.write("estimates", estimates_); }
+  void read_state(StateReader& reader) { reader.read("estimates", estimates_); }
+
+  // bytes held by the estimates and the stored samples, now and at most over the calls
+  const MemoryUsage& memory_usage() const { memory_.begin();  memory_buffers_(memory_);  return memory_; }
+
  protected:
+  virtual void memory_buffers_(MemoryUsage& usage) const { usage.add("estimates", MemoryUsage::bytes(estimates_)); }
+
   gsl_vector* estimates_; /* estimated noise PSD */
+  mutable MemoryUsage memory_;
 };
 
 typedef refcount_ptr<PSDEstimator> PSDEstimatorPtr;
@@ -59,6 +69,8 @@ class AveragePSDEstimator : public PSDEstimator {
   void clear();
 
  protected:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   float alpha_;
   bool sample_added_;
   list<gsl_vector *> sampleL_;
@@ -88,6 +100,10 @@ public:
   bool read_noise_file(const String& fn, unsigned idx=0);
   bool write_noise_file(const String& fn, unsigned idx=0){ return noisePSDList_.at(idx)->write_estimates(fn); }
 
+  // checkpoint the noise PSD estimates of all channels in one binary file
+  void save_state(const String& fileName) const;
+  void load_state(const String& fileName);
+
 #ifdef ENABLE_LEGACY_BTK_API
   void setNoiseOverEstimationFactor(float ft){ set_noise_over_estimation_factor(ft); }
   void setChannel(VectorComplexFeatureStreamPtr& chan, double alpha=-1){ set_channel(chan, alpha); }
@@ -101,6 +117,8 @@ public:
 #endif
 
  protected:
+  virtual void memory_buffers_(MemoryUsage& usage) const;
+
   typedef list<VectorComplexFeatureStreamPtr>	ChannelList_;
   typedef ChannelList_::iterator		ChannelIterator_;
   typedef vector<AveragePSDEstimatorPtr>	NoisePSDList_;
@@ -1976,3 +1976,50 @@ gsl_vector *HangoverMultiStageVADFeature::getScores()
 
 #endif /* _LOG_SAD_ */
 
+
+// ----- methods for class `VADControlFeature' -----
+//
+VADControlFeature::VADControlFeature(const VADPtr& vad, const String& nm)
+  : VectorFloatFeatureStream(/* sz= */ 1, nm), vad_(vad) { }
+
+VADControlFeature::~VADControlFeature() { }
+
+const gsl_vector_float* VADControlFeature::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  int frameX = (frame_no >= 0) ? frame_no : frame_no_ + 1;
+  gsl_vector_float_set(vector_, 0, vad_->next(frameX) ? 1.0 : 0.0);
+
+  increment_();
+  return vector_;
+}
+
+void VADControlFeature::reset()
+{
+  vad_->reset();  VectorFloatFeatureStream::reset();
+}
+
+
+// ----- methods for class `VADMetricControlFeature' -----
+//
+VADMetricControlFeature::VADMetricControlFeature(const VADMetricPtr& metric, const String& nm)
+  : VectorFloatFeatureStream(/* sz= */ 1, nm), metric_(metric) { }
+
+VADMetricControlFeature::~VADMetricControlFeature() { }
+
+const gsl_vector_float* VADMetricControlFeature::next(int frame_no)
+{
+  if (frame_no == frame_no_) return vector_;
+
+  int frameX = (frame_no >= 0) ? frame_no : frame_no_ + 1;
+  gsl_vector_float_set(vector_, 0, metric_->next(frameX));
+
+  increment_();
+  return vector_;
+}
+
+void VADMetricControlFeature::reset()
+{
+  metric_->reset();  VectorFloatFeatureStream::reset();
+}
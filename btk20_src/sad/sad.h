@@ -66,7 +66,7 @@ typedef refcount_ptr<NeuralNetVAD> NeuralNetVADPtr;
 class VAD {
  public:
   VAD(VectorComplexFeatureStreamPtr& samp);
-  ~VAD();
+  virtual ~VAD();
 
   virtual bool next(int frame_no = -5) = 0;
   virtual void reset() { frame_no_ = frame_reset_no_; }
@@ -770,4 +770,47 @@ protected:
 
 typedef Inherit<HangoverMultiStageVADFeature, HangoverVADFeaturePtr> HangoverMultiStageVADFeaturePtr;
 
+
+// ----- definition for class `VADControlFeature' -----
+//
+/**
+   @class VADControlFeature
+   @brief one-dimensional control stream, 1.0 for speech frames and 0.0 otherwise, from a 'VAD';
+          typically the control of an 'AdaptationScheduler'
+ */
+class VADControlFeature : public VectorFloatFeatureStream {
+ public:
+  VADControlFeature(const VADPtr& vad, const String& nm = "VADControlFeature");
+  ~VADControlFeature();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+
+ private:
+  VADPtr						vad_;
+};
+
+typedef Inherit<VADControlFeature, VectorFloatFeatureStreamPtr> VADControlFeaturePtr;
+
+
+// ----- definition for class `VADMetricControlFeature' -----
+//
+/**
+   @class VADMetricControlFeature
+   @brief one-dimensional control stream holding the score of a 'VADMetric'
+ */
+class VADMetricControlFeature : public VectorFloatFeatureStream {
+ public:
+  VADMetricControlFeature(const VADMetricPtr& metric, const String& nm = "VADMetricControlFeature");
+  ~VADMetricControlFeature();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+
+ private:
+  VADMetricPtr						metric_;
+};
+
+typedef Inherit<VADMetricControlFeature, VectorFloatFeatureStreamPtr> VADMetricControlFeaturePtr;
+
 #endif
@@ -1150,3 +1150,63 @@ class FastICAPtr {
 
   FastICA* operator->();
 };
+
+
+// ----- definition for class `VADControlFeature' -----
+//
+%ignore VADControlFeature;
+class VADControlFeature : public VectorFloatFeatureStream {
+  %feature("kwargs") next;
+  %feature("kwargs") reset;
+public:
+  VADControlFeature(const VADPtr& vad, const String& nm = "VADControlFeature");
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+};
+
+class VADControlFeaturePtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") VADControlFeaturePtr;
+ public:
+  %extend {
+    VADControlFeaturePtr(const VADPtr& vad, const String& nm = "VADControlFeature") {
+      return new VADControlFeaturePtr(new VADControlFeature(vad, nm));
+    }
+
+    VADControlFeaturePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VADControlFeature* operator->();
+};
+
+
+// ----- definition for class `VADMetricControlFeature' -----
+//
+%ignore VADMetricControlFeature;
+class VADMetricControlFeature : public VectorFloatFeatureStream {
+  %feature("kwargs") next;
+  %feature("kwargs") reset;
+public:
+  VADMetricControlFeature(const VADMetricPtr& metric, const String& nm = "VADMetricControlFeature");
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+};
+
+class VADMetricControlFeaturePtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") VADMetricControlFeaturePtr;
+ public:
+  %extend {
+    VADMetricControlFeaturePtr(const VADMetricPtr& metric, const String& nm = "VADMetricControlFeature") {
+      return new VADMetricControlFeaturePtr(new VADMetricControlFeature(metric, nm));
+    }
+
+    VADMetricControlFeaturePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VADMetricControlFeature* operator->();
+};
@@ -0,0 +1,147 @@
+/**
+ * @file adaptation_scheduler.cc
+ * @brief Scheduling of the updates of adaptive filters from a voice activity control stream.
+ */
+
+#include <math.h>
+#include "stream/adaptation_scheduler.h"
+
+
+// ----- methods for class `AdaptationScheduler' -----
+//
+AdaptationScheduler::AdaptationScheduler(int mode, unsigned period, double threshold, bool onActive, const String& nm)
+  : mode_((AdaptationType) mode), period_(period), threshold_(threshold), onActive_(onActive), name_(nm),
+    control_(NULL), active_(true), frameBinN_(0), start_(0.0),
+    gates_(1, true), openN_(1, 0), pending_(1, 0)
+{
+  if (mode < ADAPT_ALWAYS || mode > ADAPT_BATCHED)
+    throw jparameter_error("Invalid adaptation type %d.", mode);
+  if (period_ == 0)
+    throw jparameter_error("The adaptation period must be positive.");
+
+  reset_statistics();
+}
+
+void AdaptationScheduler::set_control(const VectorFloatFeatureStreamPtr& control)
+{
+  control_ = control;
+  unsigned sz = control_->size();
+  gates_.assign(sz, true);  openN_.assign(sz, 0);  pending_.assign(sz, 0);
+}
+
+void AdaptationScheduler::clear_control()
+{
+  control_ = NULL;
+  gates_.assign(1, true);  openN_.assign(1, 0);  pending_.assign(1, 0);
+}
+
+double AdaptationScheduler::now_()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1.0E-09 * ts.tv_nsec;
+}
+
+bool AdaptationScheduler::begin_frame(int frame_no)
+{
+  const gsl_vector_float* control = NULL;
+  if (mode_ != ADAPT_ALWAYS && control_.is_null() == false)
+    control = control_->next(frame_no);
+
+  bool any = false;
+  for (unsigned idx = 0; idx < gates_.size(); idx++) {
+    bool open;
+    if (mode_ == ADAPT_ALWAYS)
+      open = true;
+    else {
+      bool active = (control == NULL) ? active_ : (gsl_vector_float_get(control, idx) >= threshold_);
+      open = (active == onActive_);
+    }
+
+    bool gate = false;
+    if (open) {
+      openN_[idx]++;  pending_[idx]++;
+      gate = (mode_ < ADAPT_DECIMATED) || (openN_[idx] % period_ == 0);
+    }
+    gates_[idx] = gate;
+    any = any || gate;
+  }
+
+  frameBinN_ = 0;
+  frameN_++;
+  start_ = now_();
+
+  return any;
+}
+
+void AdaptationScheduler::end_frame()
+{
+  double y = now_() - start_;
+  double x = frameBinN_;
+
+  elapsed_ += y;
+  sumX_ += x;  sumY_ += y;  sumXX_ += x * x;  sumXY_ += x * y;
+  if (frameBinN_ > 0) adaptedN_++;
+
+  // the batch of an adapted gate is complete
+  for (unsigned idx = 0; idx < gates_.size(); idx++)
+    if (gates_[idx]) pending_[idx] = 0;
+}
+
+bool AdaptationScheduler::adapt(unsigned fbinX)
+{
+  unsigned idx = index_(fbinX);
+  if (idx >= gates_.size())
+    throw jdimension_error("Adaptation control of '%s' has %d entries; bin %d requested.", name_.c_str(), gates_.size(), fbinX);
+
+  binN_++;
+  if (gates_[idx] == false) return false;
+
+  frameBinN_++;  adaptedBinN_++;
+  return true;
+}
+
+double AdaptationScheduler::forgetting(double forgetFact, unsigned fbinX) const
+{
+  if (mode_ != ADAPT_BATCHED) return forgetFact;
+
+  unsigned idx = index_(fbinX);
+  if (idx >= pending_.size() || pending_[idx] <= 1) return forgetFact;
+
+  return pow(forgetFact, double(pending_[idx]));
+}
+
+// slope of the least squares line through the pairs (bins adapted, processing time) of all frames
+double AdaptationScheduler::update_cost() const
+{
+  double n  = frameN_;
+  double de = n * sumXX_ - sumX_ * sumX_;
+  if (frameN_ < 2 || de <= 0.0) return 0.0;
+
+  double cost = (n * sumXY_ - sumX_ * sumY_) / de;
+  return (cost > 0.0) ? cost : 0.0;
+}
+
+double AdaptationScheduler::saved_fraction() const
+{
+  double saved = saved_time();
+  if (elapsed_ + saved <= 0.0) return 0.0;
+
+  return saved / (elapsed_ + saved);
+}
+
+void AdaptationScheduler::reset()
+{
+  if (control_.is_null() == false)
+    control_->reset();
+
+  for (unsigned idx = 0; idx < gates_.size(); idx++) {
+    gates_[idx] = true;  openN_[idx] = 0;  pending_[idx] = 0;
+  }
+}
+
+void AdaptationScheduler::reset_statistics()
+{
+  frameN_ = adaptedN_ = binN_ = adaptedBinN_ = 0;
+  elapsed_ = sumX_ = sumY_ = sumXX_ = sumXY_ = 0.0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file adaptation_scheduler.h
+ * @brief Scheduling of the updates of adaptive filters from a voice activity control stream.
+ */
+
+#ifndef ADAPTATION_SCHEDULER_H
+#define ADAPTATION_SCHEDULER_H
+
+#include <vector>
+#include <time.h>
+#include "common/refcount.h"
+#include "common/jexception.h"
+#include "stream/stream.h"
+
+/**
+* \defgroup AdaptationScheduler Adaptation Scheduler
+* The GSC-RLS beamformer, the Kalman filter echo cancellers and the post-filters
+* update their statistics in every frame, although the updates are only useful
+* in some of them; e.g., the active weights of a GSC should only follow the
+* noise field while the target is silent. An 'AdaptationScheduler' decides per
+* frame, or per frame and bin, whether a stage adapts.
+*
+* The decision follows a control stream, typically the output of a voice
+* activity detector wrapped by 'VADControlFeature' in sad/. A control vector
+* with one entry gates whole frames; a longer one, such as a time-frequency
+* mask, gates each bin with its own entry. A bin is open while its control is
+* at least 'threshold' and 'onActive' is true, or below it and 'onActive' is
+* false. Without a control stream 'set_active()' sets the gate by hand.
+*
+*   - ADAPT_ALWAYS adapts every bin of every frame; the counters still run,
+*   - ADAPT_GATED adapts the open bins,
+*   - ADAPT_DECIMATED adapts an open bin only in every 'period'-th frame in
+*     which it is open,
+*   - ADAPT_BATCHED decimates as ADAPT_DECIMATED, and 'forgetting()' raises the
+*     forgetting factors of recursive averages to the number of open frames
+*     since the last update, so that the single update carries the weight of
+*     the whole batch.
+*
+* A stage calls 'begin_frame()' before and 'end_frame()' after processing a
+* frame, and 'adapt()' exactly once for every bin it could adapt. The counters
+* give the fraction of frames and bins adapted. The processing time of each
+* frame is regressed on the number of bins adapted in it, which yields the
+* cost of a single update and the time saved by the skipped ones.
+*/
+/*@{*/
+
+typedef enum {
+  ADAPT_ALWAYS    = 0x00,
+  ADAPT_GATED     = 0x01,
+  ADAPT_DECIMATED = 0x02,
+  ADAPT_BATCHED   = 0x03
+} AdaptationType;
+
+// ----- definition for class `AdaptationScheduler' -----
+//
+class AdaptationScheduler {
+ public:
+  /**
+     @param int mode[in] see 'AdaptationType'
+     @param unsigned period[in] decimation factor of ADAPT_DECIMATED and ADAPT_BATCHED
+     @param double threshold[in] a control entry at or above 'threshold' is active
+     @param bool onActive[in] adapt while the control is active if true, while it is inactive otherwise
+   */
+  AdaptationScheduler(int mode = ADAPT_GATED, unsigned period = 1, double threshold = 0.5, bool onActive = true,
+		      const String& nm = "AdaptationScheduler");
+
+  const String& name() const { return name_; }
+  AdaptationType mode() const { return mode_; }
+
+  void set_control(const VectorFloatFeatureStreamPtr& control);
+  void clear_control();
+  // gate used while no control stream is set
+  void set_active(bool active) { active_ = active; }
+
+  // decide the updates of frame 'frame_no'; returns true if any bin may be adapted
+  bool begin_frame(int frame_no);
+  void end_frame();
+
+  // true if bin 'fbinX' is adapted in the current frame
+  bool adapt(unsigned fbinX);
+  // the forgetting factor to use in place of 'forgetFact' when adapting bin 'fbinX'
+  double forgetting(double forgetFact, unsigned fbinX = 0) const;
+
+  unsigned frameN() const { return frameN_; }
+  unsigned adaptedN() const { return adaptedN_; }
+  unsigned binN() const { return binN_; }
+  unsigned adapted_binN() const { return adaptedBinN_; }
+  double adapted_fraction() const { return (frameN_ == 0) ? 0.0 : double(adaptedN_) / frameN_; }
+  double adapted_bin_fraction() const { return (binN_ == 0) ? 0.0 : double(adaptedBinN_) / binN_; }
+
+  // processing time in seconds between 'begin_frame()' and 'end_frame()'
+  double elapsed() const { return elapsed_; }
+  // estimated time of a single bin update, and of the updates skipped so far
+  double update_cost() const;
+  double saved_time() const { return update_cost() * (binN_ - adaptedBinN_); }
+  double saved_fraction() const;
+
+  void reset();
+  void reset_statistics();
+
+ private:
+  unsigned index_(unsigned fbinX) const { return (gates_.size() == 1) ? 0 : fbinX; }
+  static double now_();
+
+  const AdaptationType				mode_;
+  const unsigned				period_;
+  const double					threshold_;
+  const bool					onActive_;
+  const String					name_;
+
+  VectorFloatFeatureStreamPtr			control_;
+  bool						active_;
+  unsigned					frameBinN_;	// bins adapted in the current frame
+  double					start_;
+
+  std::vector<bool>				gates_;		// decision of the current frame
+  std::vector<unsigned>				openN_;		// frames each gate was open
+  std::vector<unsigned>				pending_;	// open frames since the last update
+
+  unsigned					frameN_;
+  unsigned					adaptedN_;
+  unsigned					binN_;
+  unsigned					adaptedBinN_;
+  double					elapsed_;
+
+  // sums of the regression of the frame time on the number of bins adapted
+  double					sumX_;
+  double					sumY_;
+  double					sumXX_;
+  double					sumXY_;
+};
+
+typedef refcount_ptr<AdaptationScheduler> AdaptationSchedulerPtr;
+
+/*@}*/
+
+#endif
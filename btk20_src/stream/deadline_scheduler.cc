@@ -0,0 +1,133 @@
+/**
+ * @file deadline_scheduler.cc
+ * @brief Per-frame deadline monitoring with fallbacks of the expensive processing stages.
+ */
+
+#include <time.h>
+#include "stream/deadline_scheduler.h"
+
+
+// ----- methods for class `DeadlineScheduler' -----
+//
+DeadlineScheduler::DeadlineScheduler(double deadline, double margin, double forgetFact, const String& nm)
+  : deadline_(deadline), margin_(margin), forgetFact_(forgetFact), name_(nm),
+    inFrame_(false), start_(0.0), debt_(0.0)
+{
+  if (deadline_ <= 0.0)
+    throw jparameter_error("The deadline of '%s' must be positive (%g).", name_.c_str(), deadline_);
+  if (margin_ <= 0.0 || margin_ > 1.0)
+    throw jparameter_error("The margin of '%s' must lie in (0, 1] (%g).", name_.c_str(), margin_);
+
+  reset_statistics();
+}
+
+double DeadlineScheduler::now_()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1.0E-09 * ts.tv_nsec;
+}
+
+const DeadlineScheduler::Stage_& DeadlineScheduler::stage_(unsigned stageX) const
+{
+  if (stageX >= stages_.size())
+    throw jindex_error("'%s' has %d stages; stage %d requested.", name_.c_str(), stages_.size(), stageX);
+  return stages_[stageX];
+}
+
+DeadlineScheduler::Stage_& DeadlineScheduler::stage_(unsigned stageX)
+{
+  if (stageX >= stages_.size())
+    throw jindex_error("'%s' has %d stages; stage %d requested.", name_.c_str(), stages_.size(), stageX);
+  return stages_[stageX];
+}
+
+unsigned DeadlineScheduler::add_stage(const String& name, unsigned maxFallbacks)
+{
+  stages_.push_back(Stage_(name, maxFallbacks));
+  return stages_.size() - 1;
+}
+
+void DeadlineScheduler::begin_frame()
+{
+  inFrame_ = true;
+  start_   = now_();
+}
+
+void DeadlineScheduler::end_frame()
+{
+  if (inFrame_ == false) return;
+
+  double latency = now_() - start_;
+  inFrame_ = false;
+
+  frameN_++;
+  sumLatency_ += latency;
+  if (latency > maxLatency_) maxLatency_ = latency;
+  if (latency + debt_ > deadline_) missN_++;
+
+  debt_ += latency - deadline_;
+  if (debt_ < 0.0) debt_ = 0.0;
+}
+
+bool DeadlineScheduler::fallback(unsigned stageX)
+{
+  Stage_& stage = stage_(stageX);
+  double  now   = now_();
+  double  spent = (inFrame_ ? now - start_ : 0.0) + debt_;
+
+  stage.start_      = now;
+  stage.isFallback_ = (spent + stage.cost_ > margin_ * deadline_);
+  if (stage.isFallback_ && stage.maxFallbacks_ > 0 && stage.consecutiveN_ >= stage.maxFallbacks_) {
+    stage.isFallback_ = false;
+    stage.forcedN_++;
+  }
+
+  if (stage.isFallback_) {
+    stage.fallbackN_++;  stage.consecutiveN_++;
+  } else {
+    stage.fullN_++;  stage.consecutiveN_ = 0;
+  }
+
+  return stage.isFallback_;
+}
+
+void DeadlineScheduler::done(unsigned stageX)
+{
+  Stage_& stage = stage_(stageX);
+  if (stage.isFallback_) return;
+
+  double cost = now_() - stage.start_;
+  stage.cost_ = (stage.fullN_ == 1) ? cost : forgetFact_ * stage.cost_ + (1.0 - forgetFact_) * cost;
+}
+
+double DeadlineScheduler::fallback_rate(unsigned stageX) const
+{
+  const Stage_& stage = stage_(stageX);
+  unsigned total = stage.fullN_ + stage.fallbackN_;
+  return (total == 0) ? 0.0 : double(stage.fallbackN_) / total;
+}
+
+void DeadlineScheduler::report(FILE* fp) const
+{
+  fprintf(fp, "%s: %d frames, deadline %0.3f ms, mean latency %0.3f ms, max latency %0.3f ms, %d deadlines missed (%0.2f %%)\n",
+	  name_.c_str(), frameN_, 1.0E+03 * deadline_, 1.0E+03 * mean_latency(), 1.0E+03 * maxLatency_,
+	  missN_, 100.0 * miss_rate());
+  for (unsigned stageX = 0; stageX < stages_.size(); stageX++) {
+    const Stage_& stage = stages_[stageX];
+    fprintf(fp, "  %-24s full %8d  fallback %8d (%6.2f %%)  forced %6d  cost %0.3f ms\n",
+	    stage.name_.c_str(), stage.fullN_, stage.fallbackN_, 100.0 * fallback_rate(stageX), stage.forcedN_,
+	    1.0E+03 * stage.cost_);
+  }
+}
+
+void DeadlineScheduler::reset_statistics()
+{
+  frameN_ = missN_ = 0;
+  sumLatency_ = maxLatency_ = 0.0;
+  debt_ = 0.0;
+  for (unsigned stageX = 0; stageX < stages_.size(); stageX++) {
+    Stage_& stage = stages_[stageX];
+    stage.fullN_ = stage.fallbackN_ = stage.forcedN_ = stage.consecutiveN_ = 0;
+  }
+}
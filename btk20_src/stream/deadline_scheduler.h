@@ -0,0 +1,130 @@
+/**
+ * @file deadline_scheduler.h
+ * @brief Per-frame deadline monitoring with fallbacks of the expensive processing stages.
+ */
+
+#ifndef DEADLINE_SCHEDULER_H
+#define DEADLINE_SCHEDULER_H
+
+#include <stdio.h>
+#include <vector>
+#include "common/refcount.h"
+#include "common/jexception.h"
+
+/**
+* \defgroup DeadlineScheduler Deadline Scheduler
+* A live enhancement chain must deliver every frame within the frame shift;
+* a frame on which several expensive updates coincide, e.g. a recomputation
+* of the MVDR weights and a fine SRP search, causes an xrun. A
+* 'DeadlineScheduler' measures the latency of each frame and lets the
+* expensive stages switch to a cheap fallback while the deadline is at risk.
+*
+* Each stage registers itself with 'add_stage()', which declares that it has
+* a fallback, e.g.
+*
+*   - the pipeline defers the recomputation of the beamformer weights and
+*     keeps the last ones,
+*   - WPE passes the observation through without the prediction,
+*   - the SRP DOA estimators search every 'coarseStep'-th direction only.
+*
+* The driver brackets every frame with 'begin_frame()' and 'end_frame()'.
+* Before its expensive part a stage calls 'fallback()', which returns true if
+* the time spent in the frame so far plus the smoothed cost of the full path
+* of the stage exceeds 'margin' times the deadline; afterwards it calls
+* 'done()'. Time by which a frame overran its deadline is carried into the
+* next frame, as an output buffer would be. After 'maxFallbacks' consecutive
+* fallbacks a stage runs its full path regardless, so that deferred work is
+* eventually done.
+*/
+/*@{*/
+
+// ----- definition for class `DeadlineScheduler' -----
+//
+class DeadlineScheduler {
+ public:
+  /**
+     @param double deadline[in] processing budget of a frame in seconds, usually the frame shift
+     @param double margin[in] fraction of the deadline the stages may plan to use
+     @param double forgetFact[in] forgetting factor of the smoothed stage costs
+   */
+  DeadlineScheduler(double deadline, double margin = 0.8, double forgetFact = 0.9, const String& nm = "DeadlineScheduler");
+
+  const String& name() const { return name_; }
+  double deadline() const { return deadline_; }
+
+  /**
+     @brief declare a stage with a fallback
+     @param unsigned maxFallbacks[in] consecutive fallbacks after which the full path is forced; 0 for no limit
+     @return the index of the stage
+   */
+  unsigned add_stage(const String& name, unsigned maxFallbacks = 0);
+
+  void begin_frame();
+  void end_frame();
+
+  // true if stage 'stageX' should take its fallback in the current frame
+  bool fallback(unsigned stageX);
+  // the stage has finished the path chosen by 'fallback()'
+  void done(unsigned stageX);
+
+  unsigned stageN() const { return stages_.size(); }
+  const String& stage_name(unsigned stageX) const { return stage_(stageX).name_; }
+  unsigned fullN(unsigned stageX) const { return stage_(stageX).fullN_; }
+  unsigned fallbackN(unsigned stageX) const { return stage_(stageX).fallbackN_; }
+  unsigned forcedN(unsigned stageX) const { return stage_(stageX).forcedN_; }
+  double fallback_rate(unsigned stageX) const;
+  // smoothed time of the full path in seconds
+  double stage_cost(unsigned stageX) const { return stage_(stageX).cost_; }
+
+  unsigned frameN() const { return frameN_; }
+  unsigned missN() const { return missN_; }
+  double miss_rate() const { return (frameN_ == 0) ? 0.0 : double(missN_) / frameN_; }
+  double mean_latency() const { return (frameN_ == 0) ? 0.0 : sumLatency_ / frameN_; }
+  double max_latency() const { return maxLatency_; }
+
+  void report(FILE* fp = stdout) const;
+  void reset_statistics();
+
+ private:
+  class Stage_ {
+  public:
+    Stage_(const String& nm, unsigned maxFallbacks)
+      : name_(nm), maxFallbacks_(maxFallbacks), cost_(0.0), start_(0.0), isFallback_(false),
+      consecutiveN_(0), fullN_(0), fallbackN_(0), forcedN_(0) { }
+
+    String					name_;
+    unsigned					maxFallbacks_;
+    double					cost_;
+    double					start_;
+    bool					isFallback_;
+    unsigned					consecutiveN_;
+    unsigned					fullN_;
+    unsigned					fallbackN_;
+    unsigned					forcedN_;
+  };
+
+  const Stage_& stage_(unsigned stageX) const;
+  Stage_& stage_(unsigned stageX);
+  static double now_();
+
+  const double					deadline_;
+  const double					margin_;
+  const double					forgetFact_;
+  const String					name_;
+
+  std::vector<Stage_>				stages_;
+  bool						inFrame_;
+  double					start_;
+  double					debt_;		// overrun carried from the previous frames
+
+  unsigned					frameN_;
+  unsigned					missN_;
+  double					sumLatency_;
+  double					maxLatency_;
+};
+
+typedef refcount_ptr<DeadlineScheduler> DeadlineSchedulerPtr;
+
+/*@}*/
+
+#endif
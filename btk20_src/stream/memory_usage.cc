@@ -0,0 +1,83 @@
+/**
+ * @file memory_usage.cc
+ * @brief Accounting of the memory held by the buffers of streams and processing objects.
+ */
+
+#include <stdio.h>
+#include "common/jexception.h"
+#include "stream/memory_usage.h"
+
+
+// ----- methods for class `MemoryUsage' -----
+//
+void MemoryUsage::begin()
+{
+  for (unsigned bufferX = 0; bufferX < buffers_.size(); bufferX++)
+    buffers_[bufferX].current = 0;
+  current_ = 0;
+}
+
+MemoryUsage::Buffer_& MemoryUsage::buffer_for_(const String& buffer)
+{
+  std::map<String, unsigned>::const_iterator itr = index_.find(buffer);
+  if (itr != index_.end())
+    return buffers_[itr->second];
+
+  Buffer_ newBuffer;
+  newBuffer.name    = buffer;
+  newBuffer.current = 0;
+  newBuffer.peak    = 0;
+  index_[buffer] = buffers_.size();
+  buffers_.push_back(newBuffer);
+
+  return buffers_.back();
+}
+
+void MemoryUsage::add(const String& buffer, size_t bytes)
+{
+  Buffer_& buf(buffer_for_(buffer));
+  buf.current += bytes;
+  if (buf.current > buf.peak) buf.peak = buf.current;
+
+  current_ += bytes;
+  if (current_ > peak_) peak_ = current_;
+}
+
+void MemoryUsage::merge(const String& prefix, const MemoryUsage& usage)
+{
+  for (unsigned bufferX = 0; bufferX < usage.buffers_.size(); bufferX++) {
+    const Buffer_& src(usage.buffers_[bufferX]);
+    Buffer_&       buf(buffer_for_(prefix + "/" + src.name));
+    buf.current += src.current;
+    if (buf.current > buf.peak) buf.peak = buf.current;
+    if (src.peak > buf.peak) buf.peak = src.peak;
+  }
+
+  // the peak of 'usage' on top of everything else held now
+  current_ += usage.current_;
+  if (current_ > peak_) peak_ = current_;
+  if (current_ - usage.current_ + usage.peak_ > peak_) peak_ = current_ - usage.current_ + usage.peak_;
+}
+
+const MemoryUsage::Buffer_& MemoryUsage::buffer_(unsigned bufferX) const
+{
+  if (bufferX >= buffers_.size())
+    throw jindex_error("Buffer index %d is out of range [0, %d).", bufferX, (int) buffers_.size());
+  return buffers_[bufferX];
+}
+
+String MemoryUsage::report() const
+{
+  char line[64];
+  sprintf(line, "%12s %12s  %s\n", "current", "peak", "buffer");
+  String text(line);
+  for (unsigned bufferX = 0; bufferX < buffers_.size(); bufferX++) {
+    const Buffer_& buf(buffers_[bufferX]);
+    sprintf(line, "%12lu %12lu  ", (unsigned long) buf.current, (unsigned long) buf.peak);
+    text += String(line) + buf.name + "\n";
+  }
+  sprintf(line, "%12lu %12lu  total\n", (unsigned long) current_, (unsigned long) peak_);
+  text += line;
+
+  return text;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file memory_usage.h
+ * @brief Accounting of the memory held by the buffers of streams and processing objects.
+ */
+
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <map>
+#include <vector>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include "common/mlist.h"
+
+// ----- definition for class `MemoryUsage' -----
+//
+// The bytes held by the named internal buffers of an object. Every call of
+// an object's 'memory_usage()' starts a new sample: the current bytes are
+// counted afresh, and the peaks are the largest values seen in any sample.
+class MemoryUsage {
+ public:
+  MemoryUsage() : current_(0), peak_(0) { }
+
+  // start a new sample; the current bytes of all buffers drop to zero
+  void begin();
+  // add 'bytes' to the current bytes of 'buffer'
+  void add(const String& buffer, size_t bytes);
+  // add the current bytes of all buffers of 'usage' as "prefix/buffer"; the peaks
+  // of 'usage' raise those of its buffers here, and its total peak on top of the
+  // current bytes of the other buffers raises the total peak
+  void merge(const String& prefix, const MemoryUsage& usage);
+
+  size_t current() const { return current_; }
+  size_t peak() const { return peak_; }
+
+  unsigned bufferN() const { return buffers_.size(); }
+  const String& buffer_name(unsigned bufferX) const { return buffer_(bufferX).name; }
+  size_t buffer_current(unsigned bufferX) const { return buffer_(bufferX).current; }
+  size_t buffer_peak(unsigned bufferX) const { return buffer_(bufferX).peak; }
+
+  // one line per buffer and one for the total
+  String report() const;
+
+  // bytes of GSL objects, including their headers; NULL is empty
+  static size_t bytes(const gsl_vector_char* v)    { return (v == NULL) ? 0 : sizeof(*v) + v->size * sizeof(char); }
+  static size_t bytes(const gsl_vector_short* v)   { return (v == NULL) ? 0 : sizeof(*v) + v->size * sizeof(short); }
+  static size_t bytes(const gsl_vector_float* v)   { return (v == NULL) ? 0 : sizeof(*v) + v->size * sizeof(float); }
+  static size_t bytes(const gsl_vector* v)         { return (v == NULL) ? 0 : sizeof(*v) + v->size * sizeof(double); }
+  static size_t bytes(const gsl_vector_complex* v) { return (v == NULL) ? 0 : sizeof(*v) + v->size * 2 * sizeof(double); }
+  static size_t bytes(const gsl_matrix_float* m)   { return (m == NULL) ? 0 : sizeof(*m) + m->size1 * m->size2 * sizeof(float); }
+  static size_t bytes(const gsl_matrix* m)         { return (m == NULL) ? 0 : sizeof(*m) + m->size1 * m->size2 * sizeof(double); }
+  static size_t bytes(const gsl_matrix_complex* m) { return (m == NULL) ? 0 : sizeof(*m) + m->size1 * m->size2 * 2 * sizeof(double); }
+
+ private:
+  struct Buffer_ {
+    String					name;
+    size_t					current;
+    size_t					peak;
+  };
+
+  const Buffer_& buffer_(unsigned bufferX) const;
+  Buffer_& buffer_for_(const String& buffer);
+
+  std::vector<Buffer_>				buffers_;
+  std::map<String, unsigned>			index_;
+  size_t					current_;
+  size_t					peak_;
+};
+
+#endif
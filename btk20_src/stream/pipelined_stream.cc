@@ -0,0 +1,195 @@
+/**
+ * @file pipelined_stream.cc
+ * @brief Stage-pipelined execution of a stream graph across threads.
+ */
+
+#include <gsl/gsl_vector.h>
+#include "common/jexception.h"
+#include "stream/pipelined_stream.h"
+
+
+// ----- helpers for the frame buffers -----
+//
+static gsl_vector_float*   alloc_frame_(gsl_vector_float*, unsigned sz)   { return gsl_vector_float_calloc(sz); }
+static gsl_vector*         alloc_frame_(gsl_vector*, unsigned sz)         { return gsl_vector_calloc(sz); }
+static gsl_vector_complex* alloc_frame_(gsl_vector_complex*, unsigned sz) { return gsl_vector_complex_calloc(sz); }
+
+static void free_frame_(gsl_vector_float* v)   { gsl_vector_float_free(v); }
+static void free_frame_(gsl_vector* v)         { gsl_vector_free(v); }
+static void free_frame_(gsl_vector_complex* v) { gsl_vector_complex_free(v); }
+
+static void copy_frame_(gsl_vector_float* dest, const gsl_vector_float* src)     { gsl_vector_float_memcpy(dest, src); }
+static void copy_frame_(gsl_vector* dest, const gsl_vector* src)                 { gsl_vector_memcpy(dest, src); }
+static void copy_frame_(gsl_vector_complex* dest, const gsl_vector_complex* src) { gsl_vector_complex_memcpy(dest, src); }
+
+
+// ----- methods for class template `PipelineStage' -----
+//
+template <typename Type, typename item_type>
+PipelineStage<Type, item_type>::PipelineStage(const StreamPtr_& src, unsigned depth, const String& nm)
+  : StreamType_(src->size(), nm), src_(src), depth_(depth), slots_(depth, (Type*) NULL), own_(this->vector_),
+    running_(false), stop_requested_(false), finished_(false), holding_(false),
+    readX_(0), writeX_(0), filledN_(0), errorCode_(JERROR), producerStalls_(0), consumerStalls_(0)
+{
+  if (depth_ < 2)
+    throw jparameter_error("Pipeline stage '%s' needs at least two frame buffers (%d).", nm.c_str(), depth_);
+
+  for (unsigned slotX = 0; slotX < depth_; slotX++)
+    slots_[slotX] = alloc_frame_((Type*) NULL, this->size_);
+
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&notEmpty_, NULL);
+  pthread_cond_init(&notFull_, NULL);
+}
+
+template <typename Type, typename item_type>
+PipelineStage<Type, item_type>::~PipelineStage()
+{
+  stop_();
+
+  this->vector_ = own_;
+  for (unsigned slotX = 0; slotX < depth_; slotX++)
+    free_frame_(slots_[slotX]);
+
+  pthread_cond_destroy(&notFull_);
+  pthread_cond_destroy(&notEmpty_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+template <typename Type, typename item_type>
+void* PipelineStage<Type, item_type>::worker_(void* arg)
+{
+  ((PipelineStage<Type, item_type>*) arg)->work_();
+  return NULL;
+}
+
+template <typename Type, typename item_type>
+void PipelineStage<Type, item_type>::work_()
+{
+  // 'frame_no_' cannot change before the first frame is published
+  for (int frameX = this->frame_no_ + 1; ; frameX++) {
+    pthread_mutex_lock(&mutex_);
+    if (filledN_ == depth_ && stop_requested_ == false) {
+      producerStalls_++;
+      while (filledN_ == depth_ && stop_requested_ == false)
+	pthread_cond_wait(&notFull_, &mutex_);
+    }
+    bool     stop  = stop_requested_;
+    unsigned slotX = writeX_;
+    pthread_mutex_unlock(&mutex_);
+    if (stop) return;
+
+    // the slot is free until it is published below
+    String     error;
+    error_type code = JERROR;
+    try {
+      copy_frame_(slots_[slotX], src_->next(frameX));
+    } catch (j_error& e) {
+      error = e.what();  code = e.getCode();
+      if (error == "") error = "error without message";
+    } catch (std::exception& e) {
+      error = e.what();
+    }
+
+    pthread_mutex_lock(&mutex_);
+    if (error != "") {
+      finished_  = true;
+      errorCode_ = code;
+      error_     = error;
+    } else {
+      writeX_ = (writeX_ + 1) % depth_;
+      filledN_++;
+    }
+    pthread_cond_signal(&notEmpty_);
+    pthread_mutex_unlock(&mutex_);
+    if (error != "") return;
+  }
+}
+
+template <typename Type, typename item_type>
+void PipelineStage<Type, item_type>::start_()
+{
+  stop_requested_ = false;
+  if (pthread_create(&thread_, NULL, worker_, this) != 0)
+    throw jallocation_error("Could not create the thread of pipeline stage '%s'.", this->name().c_str());
+  running_ = true;
+}
+
+template <typename Type, typename item_type>
+void PipelineStage<Type, item_type>::stop_()
+{
+  if (running_ == false) return;
+
+  pthread_mutex_lock(&mutex_);
+  stop_requested_ = true;
+  pthread_cond_broadcast(&notFull_);
+  pthread_mutex_unlock(&mutex_);
+
+  pthread_join(thread_, NULL);
+  running_ = false;
+}
+
+template <typename Type, typename item_type>
+const Type* PipelineStage<Type, item_type>::next(int frame_no)
+{
+  if (frame_no == this->frame_no_) return this->vector_;
+
+  if (frame_no >= 0 && frame_no != this->frame_no_ + 1)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", this->name().c_str(), frame_no - 1, this->frame_no_);
+
+  if (running_ == false && finished_ == false) start_();
+
+  pthread_mutex_lock(&mutex_);
+  // recycle the buffer returned by the previous call
+  if (holding_) {
+    readX_ = (readX_ + 1) % depth_;
+    filledN_--;
+    holding_ = false;
+    pthread_cond_signal(&notFull_);
+  }
+  if (filledN_ == 0 && finished_ == false) {
+    consumerStalls_++;
+    while (filledN_ == 0 && finished_ == false)
+      pthread_cond_wait(&notEmpty_, &mutex_);
+  }
+  if (filledN_ == 0) {
+    error_type code  = errorCode_;
+    String     error = error_;
+    pthread_mutex_unlock(&mutex_);
+
+    if (code == JITERATOR) {
+      this->is_end_ = true;
+      throw jiterator_error("end of samples!");
+    }
+    throw jconsistency_error("Pipeline stage '%s' failed: %s", this->name().c_str(), error.c_str());
+  }
+  holding_      = true;
+  this->vector_ = slots_[readX_];
+  pthread_mutex_unlock(&mutex_);
+
+  this->increment_();
+  return this->vector_;
+}
+
+template <typename Type, typename item_type>
+void PipelineStage<Type, item_type>::reset()
+{
+  stop_();
+  src_->reset();
+
+  readX_  = writeX_ = filledN_ = 0;
+  holding_  = false;
+  finished_ = false;
+  errorCode_ = JERROR;
+  error_     = "";
+  this->vector_ = own_;
+
+  StreamType_::reset();
+}
+
+
+// ----- explicit instantiations -----
+//
+template class PipelineStage<gsl_vector_float, float>;
+template class PipelineStage<gsl_vector, double>;
+template class PipelineStage<gsl_vector_complex, gsl_complex>;
@@ -0,0 +1,98 @@
+/**
+ * @file pipelined_stream.h
+ * @brief Stage-pipelined execution of a stream graph across threads.
+ */
+
+#ifndef PIPELINED_STREAM_H
+#define PIPELINED_STREAM_H
+
+#include <pthread.h>
+#include <vector>
+#include "stream/stream.h"
+
+/**
+* \defgroup PipelineStage Pipeline Stage
+* Cuts a stream graph into stages that run on their own threads. A stage
+* pulls its upstream subgraph frame by frame on a worker thread and hands
+* the frames to the downstream side through a bounded single-producer,
+* single-consumer queue of preallocated frame buffers. The buffers are
+* recycled, so that no memory is allocated per frame, and the frames are
+* delivered in order. With every expensive block behind its own stage,
+* the throughput of the whole graph approaches that of the slowest stage.
+*
+* 'reset()' stops the worker, resets the upstream subgraph and discards
+* the queued frames; the worker restarts with the next call of 'next()'.
+* The end of the upstream stream and any other error raised on the worker
+* are passed on in order after the frames queued before them.
+*
+* @note The reference counts of the streams are not atomic. The upstream
+* subgraph of a stage must therefore only be referenced from that stage,
+* and its pointers may neither be copied nor released while the worker runs.
+*/
+/*@{*/
+
+// ----- definition for class template `PipelineStage' -----
+//
+template <typename Type, typename item_type>
+class PipelineStage : public FeatureStream<Type, item_type> {
+  typedef FeatureStream<Type, item_type>		StreamType_;
+  typedef refcountable_ptr<StreamType_>			StreamPtr_;
+
+ public:
+  /**
+     @brief wrap 'src' so that it runs on its own thread
+     @param const StreamPtr_& src[in] upstream subgraph
+     @param unsigned depth[in] number of frame buffers in the queue; at least two
+   */
+  PipelineStage(const StreamPtr_& src, unsigned depth = 8, const String& nm = "Pipeline Stage");
+  virtual ~PipelineStage();
+
+  virtual const Type* next(int frame_no = -5);
+  virtual void reset();
+
+  unsigned depth() const { return depth_; }
+
+  // number of times since construction the worker waited for a free buffer, i.e., the downstream side was the bottleneck
+  unsigned producer_stalls() const { return producerStalls_; }
+  // number of times since construction the downstream side waited for a frame, i.e., the upstream side was the bottleneck
+  unsigned consumer_stalls() const { return consumerStalls_; }
+
+ private:
+  static void* worker_(void* arg);
+  void work_();
+  void start_();
+  void stop_();
+
+  StreamPtr_					src_;
+  const unsigned				depth_;
+  std::vector<Type*>				slots_;
+  Type*						own_;		// 'vector_' as allocated by 'FeatureStream'
+
+  pthread_t					thread_;
+  pthread_mutex_t				mutex_;
+  pthread_cond_t				notEmpty_;
+  pthread_cond_t				notFull_;
+  bool						running_;
+  bool						stop_requested_;
+  bool						finished_;	// no more frames after the queued ones
+  bool						holding_;	// slot 'readX_' is the current output
+  unsigned					readX_;
+  unsigned					writeX_;
+  unsigned					filledN_;
+  error_type					errorCode_;
+  String					error_;
+  unsigned					producerStalls_;
+  unsigned					consumerStalls_;
+};
+
+typedef PipelineStage<gsl_vector_float, float>			VectorFloatPipelineStage;
+typedef PipelineStage<gsl_vector, double>			VectorPipelineStage;
+typedef PipelineStage<gsl_vector_complex, gsl_complex>		VectorComplexPipelineStage;
+
+typedef Inherit<VectorFloatPipelineStage, VectorFloatFeatureStreamPtr>		VectorFloatPipelineStagePtr;
+typedef Inherit<VectorPipelineStage, VectorFeatureStreamPtr>			VectorPipelineStagePtr;
+typedef Inherit<VectorComplexPipelineStage, VectorComplexFeatureStreamPtr>	VectorComplexPipelineStagePtr;
+
+/*@}*/
+
+#endif
@@ -0,0 +1,382 @@
+/**
+ * @file shm_stream.cc
+ * @brief Transport of feature frames between processes through a shared memory ring.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <gsl/gsl_vector.h>
+#include "common/jexception.h"
+#include "stream/shm_stream.h"
+
+
+// ----- layout of the segment -----
+//
+// The header is followed by 'slotsN' slots of 'slotBytes' bytes each. A slot
+// starts with the sequence number of its frame; the frame follows at offset
+// 'Align_'. The producer marks a slot as 'Open' while writing it.
+//
+static const uint32_t Magic_ = 0x42544b52;	// "BTKR"
+static const size_t   Align_ = 64;
+
+static size_t align_(size_t bytes) { return (bytes + Align_ - 1) / Align_ * Align_; }
+
+struct SharedMemoryRing::Header_ {
+  uint32_t					magic_;
+  uint32_t					itemBytes_;
+  uint32_t					size_;
+  uint32_t					slotsN_;
+  uint64_t					slotBytes_;
+  uint64_t					published_;
+  uint64_t					end_;
+};
+
+const uint64_t SharedMemoryRing::Open = ~uint64_t(0);
+
+
+// ----- methods for class `SharedMemoryRing' -----
+//
+String SharedMemoryRing::shm_name_(const String& name)
+{
+  if (name.size() == 0)
+    throw jparameter_error("The name of a shared memory segment must not be empty.");
+  if (name[0] == '/') return name;
+  return String("/") + name;
+}
+
+SharedMemoryRing::SharedMemoryRing(const String& name, unsigned itemBytes, unsigned size, unsigned slotsN, bool unlink)
+  : name_(shm_name_(name)), isProducer_(true), unlink_(unlink), bytes_(0), base_(NULL), header_(NULL)
+{
+  if (slotsN < 2)
+    throw jparameter_error("Shared memory ring '%s' must hold at least two frames (%d).", name_.c_str(), slotsN);
+
+  size_t slotBytes = Align_ + align_(size_t(itemBytes) * size);
+  bytes_ = align_(sizeof(Header_)) + slotsN * slotBytes;
+
+  shm_unlink(name_.c_str());
+  int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+    throw jio_error("Could not create shared memory segment '%s': %s", name_.c_str(), strerror(errno));
+  if (ftruncate(fd, bytes_) != 0) {
+    ::close(fd);  shm_unlink(name_.c_str());
+    throw jio_error("Could not size shared memory segment '%s': %s", name_.c_str(), strerror(errno));
+  }
+  base_ = mmap(NULL, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base_ == MAP_FAILED) {
+    shm_unlink(name_.c_str());
+    throw jio_error("Could not map shared memory segment '%s': %s", name_.c_str(), strerror(errno));
+  }
+
+  header_ = (Header_*) base_;
+  header_->itemBytes_ = itemBytes;
+  header_->size_      = size;
+  header_->slotsN_    = slotsN;
+  header_->slotBytes_ = slotBytes;
+  header_->published_ = 0;
+  header_->end_       = Open;
+  for (unsigned slotX = 0; slotX < slotsN; slotX++)
+    *slot_(slotX) = Open;
+
+  // consumers accept the segment once the magic number is visible
+  __atomic_store_n(&header_->magic_, Magic_, __ATOMIC_RELEASE);
+}
+
+SharedMemoryRing::SharedMemoryRing(const String& name)
+  : name_(shm_name_(name)), isProducer_(false), unlink_(false), bytes_(0), base_(NULL), header_(NULL)
+{
+  int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    throw jio_error("Could not open shared memory segment '%s': %s", name_.c_str(), strerror(errno));
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header_)) {
+    ::close(fd);
+    throw jio_error("Shared memory segment '%s' is not a frame ring.", name_.c_str());
+  }
+  bytes_ = st.st_size;
+  base_  = mmap(NULL, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base_ == MAP_FAILED)
+    throw jio_error("Could not map shared memory segment '%s': %s", name_.c_str(), strerror(errno));
+
+  header_ = (Header_*) base_;
+  if (__atomic_load_n(&header_->magic_, __ATOMIC_ACQUIRE) != Magic_ ||
+      align_(sizeof(Header_)) + header_->slotsN_ * header_->slotBytes_ > bytes_) {
+    munmap(base_, bytes_);
+    throw jio_error("Shared memory segment '%s' is not a frame ring.", name_.c_str());
+  }
+}
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+  if (isProducer_) {
+    close();
+    if (unlink_) shm_unlink(name_.c_str());
+  }
+  munmap(base_, bytes_);
+}
+
+unsigned SharedMemoryRing::item_bytes() const { return header_->itemBytes_; }
+unsigned SharedMemoryRing::size() const { return header_->size_; }
+unsigned SharedMemoryRing::slotsN() const { return header_->slotsN_; }
+
+uint64_t* SharedMemoryRing::slot_(uint64_t seq) const
+{
+  return (uint64_t*) ((char*) base_ + align_(sizeof(Header_)) + (seq % header_->slotsN_) * header_->slotBytes_);
+}
+
+void SharedMemoryRing::publish(const void* frame)
+{
+  if (isProducer_ == false)
+    throw jconsistency_error("Only the producer may write to shared memory ring '%s'.", name_.c_str());
+
+  uint64_t  seq  = header_->published_;
+  uint64_t* slot = slot_(seq);
+
+  __atomic_store_n(slot, Open, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy((char*) slot + Align_, frame, size_t(header_->itemBytes_) * header_->size_);
+  __atomic_store_n(slot, seq, __ATOMIC_RELEASE);
+  __atomic_store_n(&header_->published_, seq + 1, __ATOMIC_RELEASE);
+}
+
+void SharedMemoryRing::close()
+{
+  if (isProducer_ == false) return;
+  __atomic_store_n(&header_->end_, header_->published_, __ATOMIC_RELEASE);
+}
+
+void SharedMemoryRing::reopen()
+{
+  if (isProducer_ == false) return;
+  __atomic_store_n(&header_->end_, Open, __ATOMIC_RELEASE);
+}
+
+uint64_t SharedMemoryRing::published() const { return __atomic_load_n(&header_->published_, __ATOMIC_ACQUIRE); }
+uint64_t SharedMemoryRing::end() const { return __atomic_load_n(&header_->end_, __ATOMIC_ACQUIRE); }
+uint64_t SharedMemoryRing::sequence(uint64_t seq) const { return __atomic_load_n(slot_(seq), __ATOMIC_ACQUIRE); }
+const void* SharedMemoryRing::frame(uint64_t seq) const { return (const char*) slot_(seq) + Align_; }
+
+unsigned SharedMemoryRing::frame_size(const String& name)
+{
+  SharedMemoryRing ring(name);
+  return ring.size();
+}
+
+
+// ----- helpers for the frame views -----
+//
+static void set_view_(gsl_vector_float* v, const void* data, size_t n)
+{
+  v->size = n;  v->stride = 1;  v->data = (float*) data;  v->block = NULL;  v->owner = 0;
+}
+
+static void set_view_(gsl_vector* v, const void* data, size_t n)
+{
+  v->size = n;  v->stride = 1;  v->data = (double*) data;  v->block = NULL;  v->owner = 0;
+}
+
+static void set_view_(gsl_vector_complex* v, const void* data, size_t n)
+{
+  v->size = n;  v->stride = 1;  v->data = (double*) data;  v->block = NULL;  v->owner = 0;
+}
+
+static void sleep_(double sec)
+{
+  struct timespec ts;
+  ts.tv_sec  = time_t(sec);
+  ts.tv_nsec = long((sec - ts.tv_sec) * 1.0E+09);
+  nanosleep(&ts, NULL);
+}
+
+static double now_()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1.0E-09 * ts.tv_nsec;
+}
+
+
+// ----- methods for class template `SharedMemoryFeatureSink' -----
+//
+template <typename Type, typename item_type>
+SharedMemoryFeatureSink<Type, item_type>::
+SharedMemoryFeatureSink(const StreamPtr_& src, const String& shmName, unsigned slotsN, bool unlink, const String& nm)
+  : StreamType_(src->size(), nm), src_(src),
+    ring_(new SharedMemoryRing(shmName, sizeof(item_type), src->size(), slotsN, unlink)), own_(this->vector_) { }
+
+template <typename Type, typename item_type>
+SharedMemoryFeatureSink<Type, item_type>::~SharedMemoryFeatureSink()
+{
+  this->vector_ = own_;
+}
+
+template <typename Type, typename item_type>
+const Type* SharedMemoryFeatureSink<Type, item_type>::next(int frame_no)
+{
+  if (frame_no == this->frame_no_) return this->vector_;
+
+  if (frame_no >= 0 && frame_no != this->frame_no_ + 1)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", this->name().c_str(), frame_no - 1, this->frame_no_);
+
+  const Type* frame;
+  try {
+    frame = src_->next(this->frame_no_ + 1);
+  } catch (j_error& e) {
+    if (e.getCode() == JITERATOR) {
+      ring_->close();  this->is_end_ = true;
+    }
+    throw;
+  }
+  if (frame->stride != 1)
+    throw jdimension_error("'%s' can only publish contiguous frames.", this->name().c_str());
+
+  ring_->publish(frame->data);
+  this->vector_ = (Type*) frame;
+  this->increment_();
+  return this->vector_;
+}
+
+template <typename Type, typename item_type>
+void SharedMemoryFeatureSink<Type, item_type>::reset()
+{
+  src_->reset();
+  ring_->reopen();
+  this->vector_ = own_;
+  StreamType_::reset();
+}
+
+template <typename Type, typename item_type>
+unsigned SharedMemoryFeatureSink<Type, item_type>::run()
+{
+  unsigned frameN = 0;
+  try {
+    while (true) {
+      next();  frameN++;
+    }
+  } catch (j_error& e) {
+    if (e.getCode() != JITERATOR) throw;
+  }
+  return frameN;
+}
+
+
+// ----- methods for class template `SharedMemoryFeatureSource' -----
+//
+template <typename Type, typename item_type>
+SharedMemoryFeatureSource<Type, item_type>::
+SharedMemoryFeatureSource(const String& shmName, bool fromOldest, bool resync, bool copy,
+			  double timeout, double pollInterval, const String& nm)
+  : StreamType_(SharedMemoryRing::frame_size(shmName), nm), ring_(new SharedMemoryRing(shmName)),
+    fromOldest_(fromOldest), resync_(resync), copy_(copy), timeout_(timeout), pollInterval_(pollInterval),
+    own_(this->vector_), seq_(0), started_(false), dropped_(0)
+{
+  if (ring_->item_bytes() != sizeof(item_type) || ring_->size() != this->size())
+    throw jtype_error("Ring '%s' holds %d items of %d bytes; '%s' expects %d-byte items.",
+		      ring_->name().c_str(), ring_->size(), ring_->item_bytes(), nm.c_str(), int(sizeof(item_type)));
+
+  set_view_(&view_, NULL, this->size());
+}
+
+template <typename Type, typename item_type>
+SharedMemoryFeatureSource<Type, item_type>::~SharedMemoryFeatureSource()
+{
+  this->vector_ = own_;
+}
+
+template <typename Type, typename item_type>
+void SharedMemoryFeatureSource<Type, item_type>::wait_(uint64_t seq)
+{
+  double start = now_();
+  while (ring_->published() <= seq) {
+    if (ring_->end() <= seq) {
+      this->is_end_ = true;
+      throw jiterator_error("end of samples!");
+    }
+    if (timeout_ >= 0.0 && now_() - start > timeout_)
+      throw jio_error("No frame from shared memory ring '%s' within %g sec.", ring_->name().c_str(), timeout_);
+    sleep_(pollInterval_);
+  }
+}
+
+template <typename Type, typename item_type>
+const Type* SharedMemoryFeatureSource<Type, item_type>::next(int frame_no)
+{
+  if (frame_no == this->frame_no_) return this->vector_;
+
+  if (frame_no >= 0 && frame_no != this->frame_no_ + 1)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", this->name().c_str(), frame_no - 1, this->frame_no_);
+
+  uint64_t seq;
+  if (started_ == false) {
+    uint64_t published = ring_->published();
+    if (fromOldest_)
+      seq = (published > ring_->slotsN() - 1) ? published - (ring_->slotsN() - 1) : 0;
+    else
+      seq = (published > 0) ? published - 1 : 0;
+  } else
+    seq = seq_ + 1;
+
+  while (true) {
+    wait_(seq);
+
+    // the slot of 'seq' is being, or has been, overwritten by a later frame
+    uint64_t newest = ring_->published() - 1;
+    if (newest - seq < ring_->slotsN() - 1 && ring_->sequence(seq) == seq) {
+      if (copy_ == false) {
+	set_view_(&view_, ring_->frame(seq), this->size());
+	this->vector_ = &view_;
+	break;
+      }
+      memcpy(own_->data, ring_->frame(seq), sizeof(item_type) * this->size());
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (ring_->sequence(seq) == seq) {
+	this->vector_ = own_;
+	break;
+      }
+    }
+
+    if (resync_ == false)
+      throw jindex_error("'%s' fell behind shared memory ring '%s' at frame %llu; at most %d frames are kept.",
+			 this->name().c_str(), ring_->name().c_str(), (unsigned long long) seq, ring_->slotsN());
+    newest = ring_->published() - 1;
+    dropped_ += newest - seq;
+    seq = newest;
+  }
+
+  seq_ = seq;  started_ = true;
+  this->increment_();
+  return this->vector_;
+}
+
+template <typename Type, typename item_type>
+void SharedMemoryFeatureSource<Type, item_type>::reset()
+{
+  this->vector_ = own_;
+  started_ = false;
+  StreamType_::reset();
+}
+
+template <typename Type, typename item_type>
+bool SharedMemoryFeatureSource<Type, item_type>::is_valid() const
+{
+  if (started_ == false) return false;
+  if (copy_) return true;
+
+  return (ring_->published() - seq_ < ring_->slotsN()) && (ring_->sequence(seq_) == seq_);
+}
+
+
+// ----- explicit instantiations -----
+//
+template class SharedMemoryFeatureSink<gsl_vector_float, float>;
+template class SharedMemoryFeatureSink<gsl_vector, double>;
+template class SharedMemoryFeatureSink<gsl_vector_complex, gsl_complex>;
+template class SharedMemoryFeatureSource<gsl_vector_float, float>;
+template class SharedMemoryFeatureSource<gsl_vector, double>;
+template class SharedMemoryFeatureSource<gsl_vector_complex, gsl_complex>;
@@ -0,0 +1,191 @@
+/**
+ * @file shm_stream.h
+ * @brief Transport of feature frames between processes through a shared memory ring.
+ */
+
+#ifndef SHM_STREAM_H
+#define SHM_STREAM_H
+
+#include <stdint.h>
+#include "stream/stream.h"
+
+/**
+* \defgroup SharedMemoryStream Shared Memory Stream
+* Passes the frames of a stream from one process to any number of others on
+* the same host without encoding them, e.g. the subband frames of an
+* enhancement process to a feature extraction process.
+*
+* The producer wraps its stream in a 'SharedMemoryFeatureSink', which copies
+* every frame it pulls into a ring of 'slotsN' frames in the POSIX shared
+* memory segment 'shmName' and passes the frame on. A consumer reads the ring
+* through a 'SharedMemoryFeatureSource', an ordinary stream whose frames are
+* views of the slots, so that they are not copied again.
+*
+* The ring is lock-free with a single producer: the producer never waits
+* for the consumers, and every frame carries its sequence number. A consumer
+* starts with the newest frame, or the oldest one still in the ring, and
+* waits for the producer by polling. The frame returned by the source stays
+* valid until the producer has written 'slotsN' - 1 further frames, which
+* 'is_valid()' checks; with 'copy' set, the source copies each frame and
+* verifies that it was not overwritten meanwhile. A consumer that falls
+* behind by more than the ring either skips to the newest frame and counts
+* the frames it lost in 'dropped()', or raises 'jindex_error'.
+*
+* The end of the producer stream, and the destruction of the sink, end the
+* streams of the consumers with 'jiterator_error'.
+*/
+/*@{*/
+
+// ----- definition for class `SharedMemoryRing' -----
+//
+class SharedMemoryRing {
+ public:
+  static const uint64_t				Open;
+
+  // create the segment 'name' as the producer; an existing segment of that name is unlinked first
+  SharedMemoryRing(const String& name, unsigned itemBytes, unsigned size, unsigned slotsN, bool unlink = true);
+  // attach to the segment 'name' as a consumer
+  SharedMemoryRing(const String& name);
+  ~SharedMemoryRing();
+
+  const String& name() const { return name_; }
+  bool is_producer() const { return isProducer_; }
+  unsigned item_bytes() const;
+  unsigned size() const;
+  unsigned slotsN() const;
+
+  // producer: write frame 'published()' into its slot
+  void publish(const void* frame);
+  // producer: no frames after the published ones, until 'reopen()'
+  void close();
+  void reopen();
+
+  // number of frames published so far
+  uint64_t published() const;
+  // sequence number past the last frame; 'Open' while the producer is writing
+  uint64_t end() const;
+  // sequence number of the frame in the slot of 'seq'; 'Open' while it is being written
+  uint64_t sequence(uint64_t seq) const;
+  const void* frame(uint64_t seq) const;
+
+  // number of items in a frame of the segment 'name'
+  static unsigned frame_size(const String& name);
+
+ private:
+  struct Header_;
+
+  static String shm_name_(const String& name);
+  uint64_t* slot_(uint64_t seq) const;
+
+  const String					name_;
+  const bool					isProducer_;
+  const bool					unlink_;
+  size_t					bytes_;
+  void*						base_;
+  Header_*					header_;
+};
+
+typedef refcount_ptr<SharedMemoryRing> SharedMemoryRingPtr;
+
+
+// ----- definition for class template `SharedMemoryFeatureSink' -----
+//
+template <typename Type, typename item_type>
+class SharedMemoryFeatureSink : public FeatureStream<Type, item_type> {
+  typedef FeatureStream<Type, item_type>		StreamType_;
+  typedef refcountable_ptr<StreamType_>			StreamPtr_;
+
+ public:
+  /**
+     @param const StreamPtr_& src[in] stream to publish
+     @param const String& shmName[in] name of the shared memory segment
+     @param unsigned slotsN[in] number of frames in the ring
+     @param bool unlink[in] remove the segment name on destruction; consumers already attached keep it
+   */
+  SharedMemoryFeatureSink(const StreamPtr_& src, const String& shmName, unsigned slotsN = 16, bool unlink = true,
+			  const String& nm = "Shared Memory Feature Sink");
+  virtual ~SharedMemoryFeatureSink();
+
+  // publish and pass on the frame of 'src'
+  virtual const Type* next(int frame_no = -5);
+  virtual void reset();
+
+  // publish all remaining frames; returns their number
+  unsigned run();
+
+  const String& shm_name() const { return ring_->name(); }
+  unsigned slotsN() const { return ring_->slotsN(); }
+  uint64_t published() const { return ring_->published(); }
+
+ private:
+  StreamPtr_					src_;
+  SharedMemoryRingPtr				ring_;
+  Type*						own_;		// 'vector_' as allocated by 'FeatureStream'
+};
+
+
+// ----- definition for class template `SharedMemoryFeatureSource' -----
+//
+template <typename Type, typename item_type>
+class SharedMemoryFeatureSource : public FeatureStream<Type, item_type> {
+  typedef FeatureStream<Type, item_type>		StreamType_;
+
+ public:
+  /**
+     @param const String& shmName[in] name of the shared memory segment
+     @param bool fromOldest[in] start with the oldest frame in the ring rather than the newest
+     @param bool resync[in] skip to the newest frame after an overrun rather than raising 'jindex_error'
+     @param bool copy[in] copy the frames out of the ring
+     @param double timeout[in] seconds to wait for a frame before raising 'jio_error'; no limit if negative
+     @param double pollInterval[in] seconds between two checks for a new frame
+   */
+  SharedMemoryFeatureSource(const String& shmName, bool fromOldest = false, bool resync = true, bool copy = false,
+			    double timeout = 10.0, double pollInterval = 0.0005,
+			    const String& nm = "Shared Memory Feature Source");
+  virtual ~SharedMemoryFeatureSource();
+
+  virtual const Type* next(int frame_no = -5);
+  virtual void reset();
+
+  // sequence number of the current frame in the producer stream
+  uint64_t sequence() const { return seq_; }
+  // frames skipped after overruns
+  uint64_t dropped() const { return dropped_; }
+  // false once the producer has started to overwrite the current frame
+  bool is_valid() const;
+
+ private:
+  void wait_(uint64_t seq);
+
+  SharedMemoryRingPtr				ring_;
+  const bool					fromOldest_;
+  const bool					resync_;
+  const bool					copy_;
+  const double					timeout_;
+  const double					pollInterval_;
+  Type*						own_;		// 'vector_' as allocated by 'FeatureStream'
+  Type						view_;
+  uint64_t					seq_;
+  bool						started_;
+  uint64_t					dropped_;
+};
+
+typedef SharedMemoryFeatureSink<gsl_vector_float, float>		VectorFloatSharedMemorySink;
+typedef SharedMemoryFeatureSink<gsl_vector, double>			VectorSharedMemorySink;
+typedef SharedMemoryFeatureSink<gsl_vector_complex, gsl_complex>	VectorComplexSharedMemorySink;
+
+typedef Inherit<VectorFloatSharedMemorySink, VectorFloatFeatureStreamPtr>	VectorFloatSharedMemorySinkPtr;
+typedef Inherit<VectorSharedMemorySink, VectorFeatureStreamPtr>			VectorSharedMemorySinkPtr;
+typedef Inherit<VectorComplexSharedMemorySink, VectorComplexFeatureStreamPtr>	VectorComplexSharedMemorySinkPtr;
+
+typedef SharedMemoryFeatureSource<gsl_vector_float, float>		VectorFloatSharedMemorySource;
+typedef SharedMemoryFeatureSource<gsl_vector, double>			VectorSharedMemorySource;
+typedef SharedMemoryFeatureSource<gsl_vector_complex, gsl_complex>	VectorComplexSharedMemorySource;
+
+typedef Inherit<VectorFloatSharedMemorySource, VectorFloatFeatureStreamPtr>	VectorFloatSharedMemorySourcePtr;
+typedef Inherit<VectorSharedMemorySource, VectorFeatureStreamPtr>		VectorSharedMemorySourcePtr;
+typedef Inherit<VectorComplexSharedMemorySource, VectorComplexFeatureStreamPtr>	VectorComplexSharedMemorySourcePtr;
+
+/*@}*/
+
+#endif
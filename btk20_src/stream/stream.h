@@ -7,9 +7,29 @@
 #ifndef STREAM_H
 #define STREAM_H
 
+#include <vector>
+#include <utility>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_complex.h>
 #include "common/refcount.h"
+#include "stream/memory_usage.h"
+
+// ----- definition for struct `StreamInfo' -----
+//
+// What a feature stream reports about itself to 'StreamGraph' (feature/stream_graph.h).
+struct StreamInfo {
+  StreamInfo() : flops(0.0), bytes(0), lockstep(true), identity(false) { }
+
+  std::vector<Countable*>			sources;	// streams read from, in order
+  String					signature;	// parameters that, with the class and the sources, determine
+								// the output; empty if the stream must never be shared
+  std::vector<std::pair<const void*, size_t> >	data;		// (start, bytes) of parameters too large for 'signature', or
+								// only hashed there; shared only if these bytes are equal too
+  double					flops;		// floating-point operations per frame
+  size_t					bytes;		// memory held besides the output vector
+  bool						lockstep;	// reads frame k of each source for its own frame k
+  bool						identity;	// the output equals that of source 0
+};
 
 // ----- interface class for 'FeatureStream' -----
 //
@@ -38,10 +58,24 @@ class FeatureStream : public Countable {
   virtual int frame_no() const { return frame_no_; }
   size_t itemsize() { return sizeof(item_type); };
 
+  // graph introspection; a stream that does not describe itself is an opaque leaf
+  virtual void describe(StreamInfo& info) const { }
+  // read source 'srcX' from 'src', a stream of the same type and size
+  virtual void set_source(unsigned srcX, Countable* src) {
+    throw jtype_error("Stream '%s' cannot be rewired.", name_.c_str());
+  }
+
+  // bytes held by the internal buffers, now and at most over the calls of this method
+  const MemoryUsage& memory_usage() const {
+    memory_.begin();  memory_buffers_(memory_);  return memory_;
+  }
+
  protected:
   FeatureStream(unsigned sz, const String& nm);
   void gsl_vector_set_(Type *vector, int index, item_type value);
   void increment_() { frame_no_++; }
+  // add the bytes of each internal buffer to 'usage'; overrides call the method of the base class first
+  virtual void memory_buffers_(MemoryUsage& usage) const { usage.add("vector", MemoryUsage::bytes(vector_)); }
 
   const int					frame_reset_no_;
   const unsigned				size_;
@@ -51,6 +85,7 @@ class FeatureStream : public Countable {
 
  private:
   const String					name_;
+  mutable MemoryUsage				memory_;
 };
 
 
@@ -85,4 +120,17 @@ typedef refcountable_ptr<VectorFloatFeatureStream>	VectorFloatFeatureStreamPtr;
 typedef refcountable_ptr<VectorFeatureStream>		VectorFeatureStreamPtr;
 typedef refcountable_ptr<VectorComplexFeatureStream>	VectorComplexFeatureStreamPtr;
 
+
+// point the source 'src' of a stream at 'newSrc' after checking its type and size; for 'set_source()'
+template <class StreamType>
+void rewire_source(refcountable_ptr<StreamType>& src, Countable* newSrc)
+{
+  StreamType* stream = dynamic_cast<StreamType*>(newSrc);
+  if (stream == NULL)
+    throw jtype_error("New source has a different type.");
+  if (src.is_null() == false && stream->size() != src->size())
+    throw jdimension_error("New source has size %d instead of %d.", stream->size(), src->size());
+  src = stream;
+}
+
 #endif
@@ -8,8 +8,15 @@
 
 %{
 #include "stream/stream.h"
+#include "stream/memory_usage.h"
 #include "stream/pyStream.h"
 #include "stream/file_stream.h"
+#include "stream/pipelined_stream.h"
+#include "stream/tee_stream.h"
+#include "stream/subband_range.h"
+#include "stream/adaptation_scheduler.h"
+#include "stream/deadline_scheduler.h"
+#include "stream/shm_stream.h"
 %}
 
 typedef int size_t;
@@ -21,6 +28,25 @@ typedef int size_t;
 %include vector.i
 %include typedefs.i
 
+// ----- definition for class `MemoryUsage' -----
+//
+class MemoryUsage {
+  %feature("kwargs") buffer_name;
+  %feature("kwargs") buffer_current;
+  %feature("kwargs") buffer_peak;
+ public:
+  MemoryUsage();
+
+  size_t current() const;
+  size_t peak() const;
+  unsigned bufferN() const;
+  const String& buffer_name(unsigned bufferX) const;
+  size_t buffer_current(unsigned bufferX) const;
+  size_t buffer_peak(unsigned bufferX) const;
+  String report() const;
+};
+
+
 // ----- definition for class `VectorCharFeatureStream' -----
 //
 %ignore VectorCharFeatureStream;
@@ -33,6 +59,7 @@ class VectorCharFeatureStream {
 
   virtual const gsl_vector_char* next(int frameX = -5) const;
   virtual void reset();
+  const MemoryUsage& memory_usage() const;
 };
 
 class VectorCharFeatureStreamPtr {
@@ -59,6 +86,7 @@ class VectorShortFeatureStream {
 
   virtual const gsl_vector_short* next(int frameX = -5) const;
   virtual void reset();
+  const MemoryUsage& memory_usage() const;
 };
 
 class VectorShortFeatureStreamPtr {
@@ -86,6 +114,7 @@ class VectorFloatFeatureStream {
   virtual const gsl_vector_float* next(int frameX = -5);
   const gsl_vector_float* current();
   virtual void reset();
+  const MemoryUsage& memory_usage() const;
 };
 
 class VectorFloatFeatureStreamPtr {
@@ -113,6 +142,7 @@ class VectorFeatureStream {
   virtual const gsl_vector* next(int frameX = -5);
   const gsl_vector* current();
   virtual void reset();
+  const MemoryUsage& memory_usage() const;
 };
 
 class VectorFeatureStreamPtr {
@@ -140,6 +170,7 @@ class VectorComplexFeatureStream {
   virtual const gsl_vector_complex* next(int frameX = -5);
   const gsl_vector_complex* current();
   virtual void reset();
+  const MemoryUsage& memory_usage() const;
 };
 
 class VectorComplexFeatureStreamPtr {
@@ -267,3 +298,428 @@ class FileHandlerPtr {
 
   FileHandler* operator->();
 };
+
+
+// ----- definition for class `VectorFloatPipelineStage' -----
+//
+%ignore VectorFloatPipelineStage;
+class VectorFloatPipelineStage : public VectorFloatFeatureStream {
+ public:
+  VectorFloatPipelineStage(const VectorFloatFeatureStreamPtr& src, unsigned depth = 8, const String& nm = "Pipeline Stage");
+  ~VectorFloatPipelineStage();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+  unsigned depth() const;
+  unsigned producer_stalls() const;
+  unsigned consumer_stalls() const;
+};
+
+class VectorFloatPipelineStagePtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") VectorFloatPipelineStagePtr;
+ public:
+  %extend {
+    VectorFloatPipelineStagePtr(const VectorFloatFeatureStreamPtr& src, unsigned depth = 8, const String& nm = "Pipeline Stage") {
+      return new VectorFloatPipelineStagePtr(new VectorFloatPipelineStage(src, depth, nm));
+    }
+
+    VectorFloatPipelineStagePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VectorFloatPipelineStage* operator->();
+};
+
+
+// ----- definition for class `VectorComplexPipelineStage' -----
+//
+%ignore VectorComplexPipelineStage;
+class VectorComplexPipelineStage : public VectorComplexFeatureStream {
+ public:
+  VectorComplexPipelineStage(const VectorComplexFeatureStreamPtr& src, unsigned depth = 8, const String& nm = "Pipeline Stage");
+  ~VectorComplexPipelineStage();
+
+  virtual const gsl_vector_complex* next(int frame_no = -5);
+  virtual void reset();
+  unsigned depth() const;
+  unsigned producer_stalls() const;
+  unsigned consumer_stalls() const;
+};
+
+class VectorComplexPipelineStagePtr : public VectorComplexFeatureStreamPtr {
+  %feature("kwargs") VectorComplexPipelineStagePtr;
+ public:
+  %extend {
+    VectorComplexPipelineStagePtr(const VectorComplexFeatureStreamPtr& src, unsigned depth = 8, const String& nm = "Pipeline Stage") {
+      return new VectorComplexPipelineStagePtr(new VectorComplexPipelineStage(src, depth, nm));
+    }
+
+    VectorComplexPipelineStagePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VectorComplexPipelineStage* operator->();
+};
+
+
+// ----- definition for class `VectorFloatFeatureTee' -----
+//
+%ignore VectorFloatFeatureTee;
+class VectorFloatFeatureTee {
+ public:
+  VectorFloatFeatureTee(const VectorFloatFeatureStreamPtr& src, unsigned lag = 4, const String& nm = "Feature Tee");
+  ~VectorFloatFeatureTee();
+
+  const String& name() const;
+  unsigned size() const;
+  unsigned lag() const;
+  unsigned branchesN() const;
+  int newest() const;
+};
+
+class VectorFloatFeatureTeePtr {
+  %feature("kwargs") VectorFloatFeatureTeePtr;
+ public:
+  %extend {
+    VectorFloatFeatureTeePtr(const VectorFloatFeatureStreamPtr& src, unsigned lag = 4, const String& nm = "Feature Tee") {
+      return new VectorFloatFeatureTeePtr(new VectorFloatFeatureTee(src, lag, nm));
+    }
+  }
+
+  VectorFloatFeatureTee* operator->();
+};
+
+
+// ----- definition for class `VectorFloatFeatureTeeBranch' -----
+//
+%ignore VectorFloatFeatureTeeBranch;
+class VectorFloatFeatureTeeBranch : public VectorFloatFeatureStream {
+ public:
+  VectorFloatFeatureTeeBranch(const VectorFloatFeatureTeePtr& tee, const String& nm = "Feature Tee Branch");
+  ~VectorFloatFeatureTeeBranch();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+};
+
+class VectorFloatFeatureTeeBranchPtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") VectorFloatFeatureTeeBranchPtr;
+ public:
+  %extend {
+    VectorFloatFeatureTeeBranchPtr(const VectorFloatFeatureTeePtr& tee, const String& nm = "Feature Tee Branch") {
+      return new VectorFloatFeatureTeeBranchPtr(new VectorFloatFeatureTeeBranch(tee, nm));
+    }
+
+    VectorFloatFeatureTeeBranchPtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VectorFloatFeatureTeeBranch* operator->();
+};
+
+
+// ----- definition for class `VectorComplexFeatureTee' -----
+//
+%ignore VectorComplexFeatureTee;
+class VectorComplexFeatureTee {
+ public:
+  VectorComplexFeatureTee(const VectorComplexFeatureStreamPtr& src, unsigned lag = 4, const String& nm = "Feature Tee");
+  ~VectorComplexFeatureTee();
+
+  const String& name() const;
+  unsigned size() const;
+  unsigned lag() const;
+  unsigned branchesN() const;
+  int newest() const;
+};
+
+class VectorComplexFeatureTeePtr {
+  %feature("kwargs") VectorComplexFeatureTeePtr;
+ public:
+  %extend {
+    VectorComplexFeatureTeePtr(const VectorComplexFeatureStreamPtr& src, unsigned lag = 4, const String& nm = "Feature Tee") {
+      return new VectorComplexFeatureTeePtr(new VectorComplexFeatureTee(src, lag, nm));
+    }
+  }
+
+  VectorComplexFeatureTee* operator->();
+};
+
+
+// ----- definition for class `VectorComplexFeatureTeeBranch' -----
+//
+%ignore VectorComplexFeatureTeeBranch;
+class VectorComplexFeatureTeeBranch : public VectorComplexFeatureStream {
+ public:
+  VectorComplexFeatureTeeBranch(const VectorComplexFeatureTeePtr& tee, const String& nm = "Feature Tee Branch");
+  ~VectorComplexFeatureTeeBranch();
+
+  virtual const gsl_vector_complex* next(int frame_no = -5);
+  virtual void reset();
+};
+
+class VectorComplexFeatureTeeBranchPtr : public VectorComplexFeatureStreamPtr {
+  %feature("kwargs") VectorComplexFeatureTeeBranchPtr;
+ public:
+  %extend {
+    VectorComplexFeatureTeeBranchPtr(const VectorComplexFeatureTeePtr& tee, const String& nm = "Feature Tee Branch") {
+      return new VectorComplexFeatureTeeBranchPtr(new VectorComplexFeatureTeeBranch(tee, nm));
+    }
+
+    VectorComplexFeatureTeeBranchPtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VectorComplexFeatureTeeBranch* operator->();
+};
+
+// handling of the bins outside of the range set with 'set_bin_range()'
+typedef enum {
+  PASS_OUT_OF_BAND = 0x00,
+  ZERO_OUT_OF_BAND = 0x01,
+  DS_OUT_OF_BAND   = 0x02
+} OutOfBandType;
+
+// schedules of 'AdaptationScheduler'
+typedef enum {
+  ADAPT_ALWAYS    = 0x00,
+  ADAPT_GATED     = 0x01,
+  ADAPT_DECIMATED = 0x02,
+  ADAPT_BATCHED   = 0x03
+} AdaptationType;
+
+// ----- definition for class `AdaptationScheduler' -----
+//
+%ignore AdaptationScheduler;
+class AdaptationScheduler {
+  %feature("kwargs") set_control;
+  %feature("kwargs") set_active;
+ public:
+  AdaptationScheduler(int mode = ADAPT_GATED, unsigned period = 1, double threshold = 0.5, bool onActive = true,
+		      const String& nm = "AdaptationScheduler");
+
+  const String& name() const;
+  void set_control(const VectorFloatFeatureStreamPtr& control);
+  void clear_control();
+  void set_active(bool active);
+
+  unsigned frameN() const;
+  unsigned adaptedN() const;
+  unsigned binN() const;
+  unsigned adapted_binN() const;
+  double adapted_fraction() const;
+  double adapted_bin_fraction() const;
+  double elapsed() const;
+  double update_cost() const;
+  double saved_time() const;
+  double saved_fraction() const;
+
+  void reset();
+  void reset_statistics();
+};
+
+class AdaptationSchedulerPtr {
+  %feature("kwargs") AdaptationSchedulerPtr;
+ public:
+  %extend {
+    AdaptationSchedulerPtr(int mode = ADAPT_GATED, unsigned period = 1, double threshold = 0.5, bool onActive = true,
+			   const String& nm = "AdaptationScheduler") {
+      return new AdaptationSchedulerPtr(new AdaptationScheduler(mode, period, threshold, onActive, nm));
+    }
+  }
+
+  AdaptationScheduler* operator->();
+};
+
+// ----- definition for class `DeadlineScheduler' -----
+//
+%ignore DeadlineScheduler;
+class DeadlineScheduler {
+  %feature("kwargs") add_stage;
+ public:
+  DeadlineScheduler(double deadline, double margin = 0.8, double forgetFact = 0.9, const String& nm = "DeadlineScheduler");
+
+  const String& name() const;
+  double deadline() const;
+  unsigned add_stage(const String& name, unsigned maxFallbacks = 0);
+
+  void begin_frame();
+  void end_frame();
+  bool fallback(unsigned stageX);
+  void done(unsigned stageX);
+
+  unsigned stageN() const;
+  const String& stage_name(unsigned stageX) const;
+  unsigned fullN(unsigned stageX) const;
+  unsigned fallbackN(unsigned stageX) const;
+  unsigned forcedN(unsigned stageX) const;
+  double fallback_rate(unsigned stageX) const;
+  double stage_cost(unsigned stageX) const;
+
+  unsigned frameN() const;
+  unsigned missN() const;
+  double miss_rate() const;
+  double mean_latency() const;
+  double max_latency() const;
+
+  void report() const;
+  void reset_statistics();
+};
+
+class DeadlineSchedulerPtr {
+  %feature("kwargs") DeadlineSchedulerPtr;
+ public:
+  %extend {
+    DeadlineSchedulerPtr(double deadline, double margin = 0.8, double forgetFact = 0.9, const String& nm = "DeadlineScheduler") {
+      return new DeadlineSchedulerPtr(new DeadlineScheduler(deadline, margin, forgetFact, nm));
+    }
+  }
+
+  DeadlineScheduler* operator->();
+};
+
+
+// ----- definition for class `VectorFloatSharedMemorySink' -----
+//
+%ignore VectorFloatSharedMemorySink;
+class VectorFloatSharedMemorySink : public VectorFloatFeatureStream {
+ public:
+  VectorFloatSharedMemorySink(const VectorFloatFeatureStreamPtr& src, const String& shmName, unsigned slotsN = 16, bool unlink = true,
+			      const String& nm = "Shared Memory Feature Sink");
+  ~VectorFloatSharedMemorySink();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+  unsigned run();
+
+  const String& shm_name() const;
+  unsigned slotsN() const;
+  unsigned long published() const;
+};
+
+class VectorFloatSharedMemorySinkPtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") VectorFloatSharedMemorySinkPtr;
+ public:
+  %extend {
+    VectorFloatSharedMemorySinkPtr(const VectorFloatFeatureStreamPtr& src, const String& shmName, unsigned slotsN = 16, bool unlink = true,
+				   const String& nm = "Shared Memory Feature Sink") {
+      return new VectorFloatSharedMemorySinkPtr(new VectorFloatSharedMemorySink(src, shmName, slotsN, unlink, nm));
+    }
+
+    VectorFloatSharedMemorySinkPtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VectorFloatSharedMemorySink* operator->();
+};
+
+
+// ----- definition for class `VectorFloatSharedMemorySource' -----
+//
+%ignore VectorFloatSharedMemorySource;
+class VectorFloatSharedMemorySource : public VectorFloatFeatureStream {
+ public:
+  VectorFloatSharedMemorySource(const String& shmName, bool fromOldest = false, bool resync = true, bool copy = false,
+				double timeout = 10.0, double pollInterval = 0.0005, const String& nm = "Shared Memory Feature Source");
+  ~VectorFloatSharedMemorySource();
+
+  virtual const gsl_vector_float* next(int frame_no = -5);
+  virtual void reset();
+
+  unsigned long sequence() const;
+  unsigned long dropped() const;
+  bool is_valid() const;
+};
+
+class VectorFloatSharedMemorySourcePtr : public VectorFloatFeatureStreamPtr {
+  %feature("kwargs") VectorFloatSharedMemorySourcePtr;
+ public:
+  %extend {
+    VectorFloatSharedMemorySourcePtr(const String& shmName, bool fromOldest = false, bool resync = true, bool copy = false,
+				     double timeout = 10.0, double pollInterval = 0.0005, const String& nm = "Shared Memory Feature Source") {
+      return new VectorFloatSharedMemorySourcePtr(new VectorFloatSharedMemorySource(shmName, fromOldest, resync, copy, timeout, pollInterval, nm));
+    }
+
+    VectorFloatSharedMemorySourcePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VectorFloatSharedMemorySource* operator->();
+};
+
+
+// ----- definition for class `VectorComplexSharedMemorySink' -----
+//
+%ignore VectorComplexSharedMemorySink;
+class VectorComplexSharedMemorySink : public VectorComplexFeatureStream {
+ public:
+  VectorComplexSharedMemorySink(const VectorComplexFeatureStreamPtr& src, const String& shmName, unsigned slotsN = 16, bool unlink = true,
+				const String& nm = "Shared Memory Feature Sink");
+  ~VectorComplexSharedMemorySink();
+
+  virtual const gsl_vector_complex* next(int frame_no = -5);
+  virtual void reset();
+  unsigned run();
+
+  const String& shm_name() const;
+  unsigned slotsN() const;
+  unsigned long published() const;
+};
+
+class VectorComplexSharedMemorySinkPtr : public VectorComplexFeatureStreamPtr {
+  %feature("kwargs") VectorComplexSharedMemorySinkPtr;
+ public:
+  %extend {
+    VectorComplexSharedMemorySinkPtr(const VectorComplexFeatureStreamPtr& src, const String& shmName, unsigned slotsN = 16, bool unlink = true,
+				     const String& nm = "Shared Memory Feature Sink") {
+      return new VectorComplexSharedMemorySinkPtr(new VectorComplexSharedMemorySink(src, shmName, slotsN, unlink, nm));
+    }
+
+    VectorComplexSharedMemorySinkPtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VectorComplexSharedMemorySink* operator->();
+};
+
+
+// ----- definition for class `VectorComplexSharedMemorySource' -----
+//
+%ignore VectorComplexSharedMemorySource;
+class VectorComplexSharedMemorySource : public VectorComplexFeatureStream {
+ public:
+  VectorComplexSharedMemorySource(const String& shmName, bool fromOldest = false, bool resync = true, bool copy = false,
+				  double timeout = 10.0, double pollInterval = 0.0005, const String& nm = "Shared Memory Feature Source");
+  ~VectorComplexSharedMemorySource();
+
+  virtual const gsl_vector_complex* next(int frame_no = -5);
+  virtual void reset();
+
+  unsigned long sequence() const;
+  unsigned long dropped() const;
+  bool is_valid() const;
+};
+
+class VectorComplexSharedMemorySourcePtr : public VectorComplexFeatureStreamPtr {
+  %feature("kwargs") VectorComplexSharedMemorySourcePtr;
+ public:
+  %extend {
+    VectorComplexSharedMemorySourcePtr(const String& shmName, bool fromOldest = false, bool resync = true, bool copy = false,
+				       double timeout = 10.0, double pollInterval = 0.0005, const String& nm = "Shared Memory Feature Source") {
+      return new VectorComplexSharedMemorySourcePtr(new VectorComplexSharedMemorySource(shmName, fromOldest, resync, copy, timeout, pollInterval, nm));
+    }
+
+    VectorComplexSharedMemorySourcePtr __iter__() {
+      (*self)->reset();  return *self;
+    }
+  }
+
+  VectorComplexSharedMemorySource* operator->();
+};
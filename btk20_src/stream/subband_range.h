@@ -0,0 +1,117 @@
+/**
+ * @file subband_range.h
+ * @brief Restriction of subband processing to a range of frequency bins.
+ */
+
+#ifndef SUBBAND_RANGE_H
+#define SUBBAND_RANGE_H
+
+#include <vector>
+#include <gsl/gsl_vector.h>
+#include "common/jexception.h"
+
+/**
+* \defgroup SubbandRange Subband Range
+* Beamformers, post-filters, AEC and WPE process every bin 0..fftLen/2, although
+* an ASR front end typically only uses 100 Hz to 7 kHz. A 'SubbandRange' selects
+* the bins that are fully processed, as a range [lower, upper] of bins in the
+* lower half of the spectrum and optionally a mask over those bins. The other
+* bins are handled according to 'OutOfBandType'; the upper half follows from
+* the symmetry of the spectrum.
+*/
+/*@{*/
+
+typedef enum {
+  PASS_OUT_OF_BAND = 0x00,	// pass the input (the reference channel for beamformers) through
+  ZERO_OUT_OF_BAND = 0x01,	// set the output to zero
+  DS_OUT_OF_BAND   = 0x02	// delay-and-sum with the quiescent weights; beamformers only, otherwise as PASS_OUT_OF_BAND
+} OutOfBandType;
+
+// ----- definition for class `SubbandRange' -----
+//
+class SubbandRange {
+ public:
+  SubbandRange(unsigned fftLen)
+    : fftLen_(fftLen), fftLen2_(fftLen / 2), lower_(0), upper_(fftLen / 2), mode_(PASS_OUT_OF_BAND), full_(true) { }
+
+  /**
+     @brief process only the bins lower..upper
+     @param int mode[in] handling of the other bins, see 'OutOfBandType'
+   */
+  void set_range(unsigned lower, unsigned upper, int mode = PASS_OUT_OF_BAND)
+  {
+    if (lower > upper || upper > fftLen2_)
+      throw jparameter_error("Invalid bin range [%d, %d]; the bins must lie within [0, %d].", lower, upper, fftLen2_);
+    if (mode < PASS_OUT_OF_BAND || mode > DS_OUT_OF_BAND)
+      throw jparameter_error("Invalid out-of-band processing type %d.", mode);
+    lower_ = lower;  upper_ = upper;  mode_ = (OutOfBandType) mode;
+    update_();
+  }
+
+  // the range in Hz
+  void set_frequency_range(double lowHz, double highHz, double sampleRate, int mode = PASS_OUT_OF_BAND)
+  {
+    double binHz = sampleRate / fftLen_;
+    unsigned lower = (lowHz <= 0.0) ? 0 : unsigned(lowHz / binHz + 0.5);
+    unsigned upper = (highHz >= sampleRate / 2.0) ? fftLen2_ : unsigned(highHz / binHz + 0.5);
+    set_range(lower, (upper > fftLen2_) ? fftLen2_ : upper, mode);
+  }
+
+  // additionally restrict the processing to the bins whose entry in 'mask' (fftLen/2 + 1) is non-zero; NULL clears the mask
+  void set_mask(const gsl_vector* mask)
+  {
+    mask_.clear();
+    if (mask != NULL) {
+      if (mask->size != fftLen2_ + 1)
+	throw jdimension_error("Bin mask has %d entries; expected %d.", mask->size, fftLen2_ + 1);
+      mask_.resize(fftLen2_ + 1);
+      for (unsigned fbinX = 0; fbinX <= fftLen2_; fbinX++)
+	mask_[fbinX] = (gsl_vector_get(mask, fbinX) != 0.0);
+    }
+    update_();
+  }
+
+  void clear() { lower_ = 0;  upper_ = fftLen2_;  mode_ = PASS_OUT_OF_BAND;  mask_.clear();  full_ = true; }
+
+  // 'fbinX' may lie in the upper half of the spectrum
+  bool in_band(unsigned fbinX) const
+  {
+    if (full_) return true;
+    if (fbinX > fftLen2_) fbinX = fftLen_ - fbinX;
+    return (fbinX >= lower_ && fbinX <= upper_ && (mask_.size() == 0 || mask_[fbinX]));
+  }
+
+  bool is_full() const { return full_; }
+  unsigned lower() const { return lower_; }
+  unsigned upper() const { return upper_; }
+  OutOfBandType mode() const { return mode_; }
+
+  // number of fully processed bins in 0..fftLen/2
+  unsigned bandN() const
+  {
+    unsigned n = 0;
+    for (unsigned fbinX = 0; fbinX <= fftLen2_; fbinX++)
+      if (in_band(fbinX)) n++;
+    return n;
+  }
+
+ private:
+  void update_()
+  {
+    full_ = (lower_ == 0 && upper_ == fftLen2_);
+    for (unsigned fbinX = 0; full_ && fbinX < mask_.size(); fbinX++)
+      if (mask_[fbinX] == false) full_ = false;
+  }
+
+  const unsigned				fftLen_;
+  const unsigned				fftLen2_;
+  unsigned					lower_;
+  unsigned					upper_;
+  OutOfBandType					mode_;
+  std::vector<bool>				mask_;
+  bool						full_;
+};
+
+/*@}*/
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * @file tee_stream.cc
+ * @brief Fan-out of one feature stream to several consumers.
+ */
+
+#include <algorithm>
+#include <gsl/gsl_vector.h>
+#include "common/jexception.h"
+#include "stream/tee_stream.h"
+
+
+// ----- helpers for the frame ring -----
+//
+static gsl_vector_float*   alloc_frame_(gsl_vector_float*, unsigned sz)   { return gsl_vector_float_calloc(sz); }
+static gsl_vector*         alloc_frame_(gsl_vector*, unsigned sz)         { return gsl_vector_calloc(sz); }
+static gsl_vector_complex* alloc_frame_(gsl_vector_complex*, unsigned sz) { return gsl_vector_complex_calloc(sz); }
+
+static void free_frame_(gsl_vector_float* v)   { gsl_vector_float_free(v); }
+static void free_frame_(gsl_vector* v)         { gsl_vector_free(v); }
+static void free_frame_(gsl_vector_complex* v) { gsl_vector_complex_free(v); }
+
+static void copy_frame_(gsl_vector_float* dest, const gsl_vector_float* src)     { gsl_vector_float_memcpy(dest, src); }
+static void copy_frame_(gsl_vector* dest, const gsl_vector* src)                 { gsl_vector_memcpy(dest, src); }
+static void copy_frame_(gsl_vector_complex* dest, const gsl_vector_complex* src) { gsl_vector_complex_memcpy(dest, src); }
+
+
+// ----- methods for class template `FeatureTee' -----
+//
+template <typename Type, typename item_type>
+FeatureTee<Type, item_type>::FeatureTee(const StreamPtr_& src, unsigned lag, const String& nm)
+  : src_(src), lag_(lag), name_(nm), ring_(lag, (Type*) NULL), newestX_(-1), endX_(-1)
+{
+  if (lag_ < 2)
+    throw jparameter_error("Tee '%s' must keep at least two frames (%d).", nm.c_str(), lag_);
+
+  for (unsigned slotX = 0; slotX < lag_; slotX++)
+    ring_[slotX] = alloc_frame_((Type*) NULL, src_->size());
+}
+
+template <typename Type, typename item_type>
+FeatureTee<Type, item_type>::~FeatureTee()
+{
+  for (unsigned slotX = 0; slotX < lag_; slotX++)
+    free_frame_(ring_[slotX]);
+}
+
+template <typename Type, typename item_type>
+void FeatureTee<Type, item_type>::detach_(BranchType_* branch)
+{
+  typename std::vector<BranchType_*>::iterator itr = std::find(branches_.begin(), branches_.end(), branch);
+  if (itr != branches_.end()) branches_.erase(itr);
+}
+
+template <typename Type, typename item_type>
+const Type* FeatureTee<Type, item_type>::frame_(int frameX)
+{
+  while (newestX_ < frameX) {
+    int nextX = newestX_ + 1;
+    if (endX_ >= 0 && nextX >= endX_)
+      throw jiterator_error("end of samples!");
+
+    // the slot of 'nextX' holds frame 'nextX - lag_'; no branch may still be positioned on it
+    for (unsigned branchX = 0; branchX < branches_.size(); branchX++) {
+      int cursor = branches_[branchX]->frame_no_;
+      if (cursor >= 0 && cursor <= nextX - int(lag_))
+	throw jindex_error("Frame %d of tee '%s' would evict frame %d of branch '%s'.",
+			   nextX, name_.c_str(), cursor, branches_[branchX]->name().c_str());
+    }
+
+    const Type* src;
+    try {
+      src = src_->next(nextX);
+    } catch (j_error& e) {
+      if (e.getCode() == JITERATOR) endX_ = nextX;
+      throw;
+    }
+    copy_frame_(ring_[nextX % lag_], src);
+    newestX_ = nextX;
+  }
+
+  if (frameX < 0 || frameX <= newestX_ - int(lag_))
+    throw jindex_error("Frame %d of tee '%s' is no longer available; the newest is %d.", frameX, name_.c_str(), newestX_);
+
+  return ring_[frameX % lag_];
+}
+
+template <typename Type, typename item_type>
+void FeatureTee<Type, item_type>::reset_()
+{
+  if (newestX_ < 0 && endX_ < 0) return;
+
+  src_->reset();
+  newestX_ = -1;
+  endX_    = -1;
+}
+
+
+// ----- methods for class template `FeatureTeeBranch' -----
+//
+template <typename Type, typename item_type>
+FeatureTeeBranch<Type, item_type>::FeatureTeeBranch(const TeePtr_& tee, const String& nm)
+  : StreamType_(tee->size(), nm), tee_(tee), own_(this->vector_)
+{
+  tee_->attach_(this);
+}
+
+template <typename Type, typename item_type>
+FeatureTeeBranch<Type, item_type>::~FeatureTeeBranch()
+{
+  tee_->detach_(this);
+  this->vector_ = own_;
+}
+
+template <typename Type, typename item_type>
+const Type* FeatureTeeBranch<Type, item_type>::next(int frame_no)
+{
+  if (frame_no == this->frame_no_) return this->vector_;
+
+  if (frame_no >= 0 && frame_no != this->frame_no_ + 1)
+    throw jindex_error("Problem in Feature %s: %d != %d\n", this->name().c_str(), frame_no - 1, this->frame_no_);
+
+  try {
+    this->vector_ = (Type*) tee_->frame_(this->frame_no_ + 1);
+  } catch (j_error& e) {
+    if (e.getCode() == JITERATOR) this->is_end_ = true;
+    throw;
+  }
+
+  this->increment_();
+  return this->vector_;
+}
+
+template <typename Type, typename item_type>
+void FeatureTeeBranch<Type, item_type>::reset()
+{
+  tee_->reset_();
+  this->vector_ = own_;
+  StreamType_::reset();
+}
+
+
+// ----- explicit instantiations -----
+//
+template class FeatureTee<gsl_vector_float, float>;
+template class FeatureTee<gsl_vector, double>;
+template class FeatureTee<gsl_vector_complex, gsl_complex>;
+template class FeatureTeeBranch<gsl_vector_float, float>;
+template class FeatureTeeBranch<gsl_vector, double>;
+template class FeatureTeeBranch<gsl_vector_complex, gsl_complex>;
@@ -0,0 +1,117 @@
+/**
+ * @file tee_stream.h
+ * @brief Fan-out of one feature stream to several consumers.
+ */
+
+#ifndef TEE_STREAM_H
+#define TEE_STREAM_H
+
+#include <vector>
+#include "stream/stream.h"
+
+/**
+* \defgroup FeatureTee Feature Tee
+* 'FeatureStream::next()' caches only the most recent frame, so two
+* consumers pulling the same stream at different frame indices collide.
+* A 'FeatureTee' pulls its source once per frame and keeps the last 'lag'
+* frames in a ring; every consumer reads through its own 'FeatureTeeBranch',
+* which is an ordinary stream with its own frame cursor.
+*
+* The branches may drift apart by up to 'lag' - 1 frames. The 'next()' of
+* a branch that would evict the current frame of a slower branch raises
+* 'jindex_error' instead and leaves the faster branch on its frame; the
+* slower branch keeps its data, and the faster one may pull again once the
+* slower one has caught up. A branch that has not pulled a frame since
+* 'reset()' does not hold the others back.
+*
+* The first branch reset after frames were pulled resets the source; the
+* remaining branches should be reset before any of them pulls again, as
+* happens when the reset cascades from a common sink.
+*/
+/*@{*/
+
+template <typename Type, typename item_type> class FeatureTeeBranch;
+
+// ----- definition for class template `FeatureTee' -----
+//
+template <typename Type, typename item_type>
+class FeatureTee {
+  friend class FeatureTeeBranch<Type, item_type>;
+
+  typedef FeatureStream<Type, item_type>		StreamType_;
+  typedef refcountable_ptr<StreamType_>			StreamPtr_;
+  typedef FeatureTeeBranch<Type, item_type>		BranchType_;
+
+ public:
+  /**
+     @param const StreamPtr_& src[in] shared source
+     @param unsigned lag[in] number of recent frames kept for the branches
+   */
+  FeatureTee(const StreamPtr_& src, unsigned lag = 4, const String& nm = "Feature Tee");
+  ~FeatureTee();
+
+  const String& name() const { return name_; }
+  unsigned size() const { return src_->size(); }
+  unsigned lag() const { return lag_; }
+  unsigned branchesN() const { return branches_.size(); }
+
+  // index of the newest frame pulled from the source; -1 after reset
+  int newest() const { return newestX_; }
+
+ private:
+  const Type* frame_(int frameX);
+  void reset_();
+  void attach_(BranchType_* branch) { branches_.push_back(branch); }
+  void detach_(BranchType_* branch);
+
+  StreamPtr_					src_;
+  const unsigned				lag_;
+  const String					name_;
+  std::vector<Type*>				ring_;
+  std::vector<BranchType_*>			branches_;
+  int						newestX_;
+  int						endX_;		// first frame past the end of the source; -1 if not reached
+};
+
+
+// ----- definition for class template `FeatureTeeBranch' -----
+//
+template <typename Type, typename item_type>
+class FeatureTeeBranch : public FeatureStream<Type, item_type> {
+  friend class FeatureTee<Type, item_type>;
+
+  typedef FeatureStream<Type, item_type>		StreamType_;
+  typedef refcount_ptr<FeatureTee<Type, item_type> >	TeePtr_;
+
+ public:
+  FeatureTeeBranch(const TeePtr_& tee, const String& nm = "Feature Tee Branch");
+  virtual ~FeatureTeeBranch();
+
+  // the returned frame lives in the ring of the tee and stays valid for 'lag' - 1 further source frames
+  virtual const Type* next(int frame_no = -5);
+  virtual void reset();
+
+ private:
+  TeePtr_					tee_;
+  Type*						own_;		// 'vector_' as allocated by 'FeatureStream'
+};
+
+typedef FeatureTee<gsl_vector_float, float>			VectorFloatFeatureTee;
+typedef FeatureTee<gsl_vector, double>				VectorFeatureTee;
+typedef FeatureTee<gsl_vector_complex, gsl_complex>		VectorComplexFeatureTee;
+
+typedef refcount_ptr<VectorFloatFeatureTee>			VectorFloatFeatureTeePtr;
+typedef refcount_ptr<VectorFeatureTee>				VectorFeatureTeePtr;
+typedef refcount_ptr<VectorComplexFeatureTee>			VectorComplexFeatureTeePtr;
+
+typedef FeatureTeeBranch<gsl_vector_float, float>		VectorFloatFeatureTeeBranch;
+typedef FeatureTeeBranch<gsl_vector, double>			VectorFeatureTeeBranch;
+typedef FeatureTeeBranch<gsl_vector_complex, gsl_complex>	VectorComplexFeatureTeeBranch;
+
+typedef Inherit<VectorFloatFeatureTeeBranch, VectorFloatFeatureStreamPtr>	VectorFloatFeatureTeeBranchPtr;
+typedef Inherit<VectorFeatureTeeBranch, VectorFeatureStreamPtr>			VectorFeatureTeeBranchPtr;
+typedef Inherit<VectorComplexFeatureTeeBranch, VectorComplexFeatureStreamPtr>	VectorComplexFeatureTeeBranchPtr;
+
+/*@}*/
+
+#endif
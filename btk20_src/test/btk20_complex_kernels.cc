@@ -0,0 +1,54 @@
+/**
+ * @file btk20_complex_kernels.cc
+ * @brief Agreement of the vectorized complex kernels with the scalar ones.
+ *
+ * usage: btk20_complex_kernels isa
+ *
+ * Runs 'ComplexKernels::check_agreement()' for the kernel set 'isa'
+ * ("scalar", "sse2", "avx2", "avx512" or "neon"). The element-wise kernels
+ * must agree bit for bit, and the relative deviation of 'dotc()', whose sum
+ * is reordered, must stay within a few ulps per term of the longest vector
+ * checked. The exit status is 0 on success, 1 on a failed check and 77,
+ * which ctest counts as skipped, if the processor lacks 'isa'.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+
+#include "common/jexception.h"
+#include "matrix/complex_kernels.h"
+
+static const int ExitSkipped = 77;
+
+// 'check_agreement()' sums at most 1031 products; the deviation is relative to sum |x_k| |y_k|
+static const double DotcBound = 4.0 * 1031 * DBL_EPSILON;
+
+int main(int argc, char** argv)
+{
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s scalar|sse2|avx2|avx512|neon\n", argv[0]);
+    return 1;
+  }
+
+  static const ComplexKernels::Isa isas[] = { ComplexKernels::Scalar, ComplexKernels::SSE2, ComplexKernels::AVX2,
+					      ComplexKernels::AVX512, ComplexKernels::NEON };
+  for (unsigned i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+    if (strcmp(argv[1], ComplexKernels::isa_name(isas[i])) != 0) continue;
+
+    if (ComplexKernels::supported(isas[i]) == false) {
+      printf("%s: not supported by this processor\n", argv[1]);
+      return ExitSkipped;
+    }
+    try {
+      double deviation = ComplexKernels::check_agreement(isas[i]);
+      printf("%s: dotc deviation %g (bound %g)\n", argv[1], deviation, DotcBound);
+      return (deviation <= DotcBound) ? 0 : 1;
+    } catch (j_error& e) {
+      fprintf(stderr, "%s: %s\n", argv[1], e.what());
+      return 1;
+    }
+  }
+
+  fprintf(stderr, "unknown kernel set '%s'\n", argv[1]);
+  return 1;
+}
@@ -0,0 +1,621 @@
+/**
+ * @file btk20_regression.cc
+ * @brief Golden-output regression and determinism checks of the canonical pipelines.
+ *
+ * Every case builds a pipeline from a configuration of unit_test/confs and
+ * runs it on synthetic plane waves arriving at the microphones of that
+ * configuration. The output of each stage is recorded: all samples of the
+ * time-domain stages and the bins 0, ..., M/2 of every 'SubbandStride'-th
+ * frame of the subband stages. The checks are
+ *
+ *   -m determinism: a second run gives bit-identical stages, and so does a
+ *                   run with each input chain behind its own 'PipelineStage'
+ *                   thread ('-t depth');
+ *   -m golden:      every stage is within the SNR and maximum absolute error
+ *                   thresholds of its case against the golden file.
+ *
+ * '-u' writes the golden files instead. The exit status is 0 on success, 1
+ * on a failed check and 77, which ctest counts as skipped, if a golden file
+ * is missing; with '-r' a missing golden file is a failed check. Everything
+ * runs offline from the files under unit_test/.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include "common/jexception.h"
+#include "stream/pipelined_stream.h"
+#include "feature/feature.h"
+#include "modulated/modulated.h"
+#include "beamformer/fractional_delay.h"
+#include "dereverberation/dereverberation.h"
+#include "aec/aec.h"
+#include "pipeline/json.h"
+#include "pipeline/online_beamforming.h"
+
+static const unsigned SampleRate    = 16000;
+static const unsigned SubbandsM     = 256;
+static const unsigned FilterLengthM = 4;
+static const unsigned DecimationR   = 1;
+static const unsigned ShiftD        = SubbandsM >> DecimationR;
+static const unsigned FramesN       = 96;
+static const unsigned SubbandStride = 8;	// record every 8th frame of the subband stages
+
+static const int ExitSkipped = 77;
+
+
+// ----- synthetic signals -----
+//
+// Analytic waveforms, so that the fractional delays of a plane wave are
+// exact; the noise comes from a fixed LCG rather than rand(), so that the
+// signals are the same with every C library.
+//
+static double waveform_(unsigned kind, double t)
+{
+  double val = 0.0;
+  switch (kind) {
+  case 0: {	// voiced target: harmonics of a vibrating 140 Hz fundamental under a syllabic envelope
+    double phase = 2.0 * M_PI * (140.0 * t - 140.0 * 0.05 / (2.0 * M_PI * 2.0) * cos(2.0 * M_PI * 2.0 * t));
+    for (unsigned h = 1; h <= 12; h++)
+      val += sin(h * phase + 0.3 * h) / h;
+    val *= 0.6 + 0.4 * sin(2.0 * M_PI * 4.0 * t);
+    break;
+  }
+  case 1:	// interference: inharmonic tones
+    val = 0.5 * sin(2.0 * M_PI * 523.0 * t) + 0.3 * sin(2.0 * M_PI * 1250.0 * t + 1.0) + 0.2 * sin(2.0 * M_PI * 2900.0 * t + 2.0);
+    break;
+  default:	// far end of the echo canceller: 210 Hz harmonics, gated on and off every 0.25 s
+    for (unsigned h = 1; h <= 8; h++)
+      val += sin(2.0 * M_PI * 210.0 * h * t + h) / h;
+    val *= (fmod(t, 0.5) < 0.25) ? 1.0 : 0.05;
+    break;
+  }
+  return 3000.0 * val;
+}
+
+class PlaneWaveArray_ {
+ public:
+  PlaneWaveArray_(const gsl_matrix* micPositions, const String& arrayType, unsigned samplesN, unsigned seed)
+    : micPositions_(micPositions), arrayType_(arrayType), samplesN_(samplesN), seed_(seed),
+      channels_(micPositions->size1, std::vector<double>(samplesN, 0.0)) { }
+
+  /**
+     @brief add a plane wave from 'position', as for 'calc_array_delays()'
+     @param double gain[in] gain of the direct wave
+     @param const double* echoes[in] NULL or pairs (delay in seconds, gain) of reflections from the same
+                                     direction, terminated by a negative delay
+  */
+  void add_source(const double* position, unsigned kind, double gain, const double* echoes = NULL)
+  {
+    gsl_vector* delays = calc_array_delays(arrayType_, micPositions_, position);
+    for (unsigned chanX = 0; chanX < channels_.size(); chanX++) {
+      double delay = gsl_vector_get(delays, chanX);
+      for (unsigned n = 0; n < samplesN_; n++) {
+	double t   = double(n) / SampleRate - delay;
+	double val = (gain == 0.0) ? 0.0 : gain * waveform_(kind, t);
+	for (const double* echo = echoes; echo != NULL && echo[0] >= 0.0; echo += 2)
+	  val += echo[1] * waveform_(kind, t - echo[0]);
+	channels_[chanX][n] += val;
+      }
+    }
+    gsl_vector_free(delays);
+  }
+
+  // uniform white noise in [-level, level), independent in every channel
+  void add_noise(double level)
+  {
+    unsigned state = seed_;
+    for (unsigned chanX = 0; chanX < channels_.size(); chanX++)
+      for (unsigned n = 0; n < samplesN_; n++) {
+	state = state * 1664525u + 1013904223u;
+	channels_[chanX][n] += level * (2.0 * (state >> 8) / double(1 << 24) - 1.0);
+      }
+  }
+
+  VectorFloatFeatureStreamPtr sample_feature(unsigned chanX) const
+  {
+    gsl_vector* samples = gsl_vector_alloc(samplesN_);
+    for (unsigned n = 0; n < samplesN_; n++)
+      gsl_vector_set(samples, n, channels_[chanX][n]);
+    SampleFeaturePtr samp(new SampleFeature("", ShiftD, ShiftD, /* padZeros= */ true));
+    samp->setSamples(samples, SampleRate);
+    gsl_vector_free(samples);
+    return samp;
+  }
+
+  std::vector<VectorFloatFeatureStreamPtr> sample_features() const
+  {
+    std::vector<VectorFloatFeatureStreamPtr> samps;
+    for (unsigned chanX = 0; chanX < channels_.size(); chanX++)
+      samps.push_back(sample_feature(chanX));
+    return samps;
+  }
+
+ private:
+  const gsl_matrix*				micPositions_;
+  const String					arrayType_;
+  const unsigned				samplesN_;
+  const unsigned				seed_;
+  std::vector<std::vector<double> >		channels_;
+};
+
+// enough samples for the frames and the delay of the filter banks
+static const unsigned SignalN = (FramesN + 2 * FilterLengthM + 4) * ShiftD;
+
+static gsl_matrix* mic_positions_(const JsonValue& conf)
+{
+  const JsonValue& mpos = conf["microphone_positions"];
+  gsl_matrix* pos = gsl_matrix_calloc(mpos.size(), 3);
+  for (unsigned chanX = 0; chanX < mpos.size(); chanX++)
+    for (unsigned i = 0; i < mpos[chanX].size() && i < 3; i++)
+      gsl_matrix_set(pos, chanX, i, mpos[chanX][i].number());
+  return pos;
+}
+
+// the first position of a source in 'conf'
+static void position_(const JsonValue& source, double* position)
+{
+  const JsonValue& pos = source["positions"][0][1];
+  position[0] = position[1] = position[2] = 0.0;
+  for (unsigned i = 0; i < pos.size() && i < 3; i++)
+    if (pos[i].is_null() == false) position[i] = pos[i].number();
+}
+
+// the target of 'conf', an interference from its first noise position or from 0.6 rad, and sensor noise
+static PlaneWaveArray_* scene_(const JsonValue& conf, const gsl_matrix* micPositions, const double* echoes = NULL)
+{
+  PlaneWaveArray_* array = new PlaneWaveArray_(micPositions, conf["array_type"].text(), SignalN, 1);
+  double position[3];
+  position_(conf["target"], position);
+  array->add_source(position, 0, 1.0, echoes);
+
+  double interference[3] = { 0.6, M_PI / 2.0, 0.0 };
+  if (conf.has("noises")) position_(conf["noises"][0], interference);
+  array->add_source(interference, 1, 0.3);
+  array->add_noise(30.0);
+  return array;
+}
+
+
+// ----- stage records -----
+//
+struct Stage_ {
+  Stage_(const String& nm) : name(nm) { }
+
+  void add(const gsl_vector_float* block)
+  {
+    for (unsigned n = 0; n < block->size; n++)
+      values.push_back(gsl_vector_float_get(block, n));
+  }
+  void add(const gsl_vector_complex* bins)
+  {
+    for (unsigned k = 0; k <= bins->size / 2; k++) {
+      gsl_complex val = gsl_vector_complex_get(bins, k);
+      values.push_back(GSL_REAL(val));
+      values.push_back(GSL_IMAG(val));
+    }
+  }
+
+  String					name;
+  std::vector<double>				values;
+};
+
+typedef std::vector<Stage_> Run_;
+
+struct Env_ {
+  String					confDir;
+  gsl_vector*					h;
+  gsl_vector*					g;
+};
+
+static VectorComplexFeatureStreamPtr analysis_(VectorFloatFeatureStreamPtr samp, const Env_& env, unsigned depth)
+{
+  VectorComplexFeatureStreamPtr bank(new OverSampledDFTAnalysisBank(samp, env.h, SubbandsM, FilterLengthM, DecimationR, 2));
+  if (depth > 0)
+    bank = VectorComplexPipelineStagePtr(new VectorComplexPipelineStage(bank, depth));
+  return bank;
+}
+
+static VectorFloatFeatureStreamPtr synthesis_(VectorComplexFeatureStreamPtr subbands, const Env_& env)
+{
+  return new OverSampledDFTSynthesisBank(subbands, env.g, SubbandsM, FilterLengthM, DecimationR, 2);
+}
+
+
+// ----- pipelines -----
+//
+// 'depth' > 0 puts every input chain behind a 'PipelineStage' of that depth.
+//
+typedef enum { Beamforming, TimeDomain, WPE, AEC } Kind_;
+
+struct Case_ {
+  const char*		name;
+  const char*		conf;		// file in unit_test/confs
+  const char*		geometry;	// file with the array geometry, if 'conf' has none
+  Kind_			kind;
+  bool			adaptive;	// adaptive or nonlinear stages amplify rounding differences
+};
+
+static const Case_ Cases[] = {
+  { "ds",                  "ds.json",                  NULL,      Beamforming, false },
+  { "sd",                  "sd.json",                  NULL,      Beamforming, false },
+  { "ds_and_zelinski",     "ds_and_zelinski.json",     NULL,      Beamforming, true  },
+  { "sd_and_zelinski",     "sd_and_zelinski.json",     NULL,      Beamforming, true  },
+  { "sd_and_mccowan",      "sd_and_mccowan.json",      NULL,      Beamforming, true  },
+  { "sd_and_lefkimmiatis", "sd_and_lefkimmiatis.json", NULL,      Beamforming, true  },
+  { "lcmv_and_zelinski",   "lcmv_and_zelinski.json",   NULL,      Beamforming, true  },
+  { "gscrls",              "gscrls.json",              NULL,      Beamforming, true  },
+  { "timedomain_ds",       "ds.json",                  NULL,      TimeDomain,  false },
+  { "wpe",                 "wpe.json",                 "ds.json", WPE,         true  },
+  { "nlms_aec",            "nlms_aec.json",            NULL,      AEC,         true  },
+};
+
+// 'OnlineBeamformingPipeline', as 'btk20_online_beamforming'
+static void run_beamforming_(const JsonValue& conf, const Env_& env, unsigned depth, Run_& run)
+{
+  gsl_matrix*      micPositions = mic_positions_(conf);
+  PlaneWaveArray_* array        = scene_(conf, micPositions);
+  std::vector<VectorFloatFeatureStreamPtr> inputs(array->sample_features());
+  delete array;  gsl_matrix_free(micPositions);
+
+  OnlineBeamformingPipeline pipeline(conf, env.h, env.g, SubbandsM, FilterLengthM, DecimationR, inputs, SampleRate, depth);
+  // the input chains belong to the stages now
+  inputs.clear();
+
+  run.push_back(Stage_("analysis"));  run.push_back(Stage_("spatial filter"));  run.push_back(Stage_("output"));
+  for (unsigned frameX = 0; frameX < FramesN; frameX++) {
+    pipeline.update(frameX);
+    run[2].add(pipeline.output()->next(frameX));
+    if (frameX % SubbandStride != 0) continue;
+    run[0].add(pipeline.analysis(0)->current());
+    run[1].add(pipeline.spatial_filter()->current());
+  }
+}
+
+// 'TimeDomainDS' steered at the target
+static void run_time_domain_(const JsonValue& conf, const Env_& env, unsigned depth, Run_& run)
+{
+  gsl_matrix*      micPositions = mic_positions_(conf);
+  PlaneWaveArray_* array        = scene_(conf, micPositions);
+  TimeDomainDSPtr  ds(new TimeDomainDS(ShiftD));
+  for (unsigned chanX = 0; chanX < micPositions->size1; chanX++) {
+    VectorFloatFeatureStreamPtr samp(array->sample_feature(chanX));
+    if (depth > 0)
+      samp = VectorFloatPipelineStagePtr(new VectorFloatPipelineStage(samp, depth));
+    ds->set_channel(samp);
+  }
+  double position[3];
+  position_(conf["target"], position);
+  gsl_vector* delays = calc_array_delays(conf["array_type"].text(), micPositions, position);
+  ds->set_delays(SampleRate, delays);
+  gsl_vector_free(delays);  delete array;  gsl_matrix_free(micPositions);
+
+  run.push_back(Stage_("output"));
+  for (unsigned frameX = 0; frameX < FramesN; frameX++)
+    run[0].add(ds->next(frameX));
+}
+
+// 'MultiChannelWPEDereverberation' on the target with three reflections, as test_subband_dereverberator.py
+static void run_wpe_(const JsonValue& conf, const JsonValue& geometry, const Env_& env, unsigned depth, Run_& run)
+{
+  static const double Echoes[] = { 0.021, 0.5, 0.037, -0.35, 0.052, 0.25, -1.0, 0.0 };
+  gsl_matrix*      micPositions = mic_positions_(geometry);
+  PlaneWaveArray_* array        = scene_(geometry, micPositions, Echoes);
+  unsigned         chanN        = micPositions->size1;
+
+  MultiChannelWPEDereverberationPtr wpe(new MultiChannelWPEDereverberation(SubbandsM, chanN, conf.get("lower_num", 0), conf.get("upper_num", 32),
+									  conf.get("iterations_num", 2), conf.get("load_db", -20.0),
+									  conf.get("band_width", 0.0), conf.get("diagonal_bias", 0.001), SampleRate));
+  VectorComplexFeatureStreamPtr analysis0;
+  for (unsigned chanX = 0; chanX < chanN; chanX++) {
+    VectorComplexFeatureStreamPtr analysis(analysis_(array->sample_feature(chanX), env, depth));
+    wpe->set_input(analysis);
+    if (chanX == 0) analysis0 = analysis;
+  }
+  delete array;  gsl_matrix_free(micPositions);
+
+  // estimates from the frames that are processed, then rewinds the inputs
+  wpe->estimate_filter(0, FramesN);
+  VectorComplexFeatureStreamPtr dereverb(new MultiChannelWPEDereverberationFeature(wpe, 0));
+  VectorFloatFeatureStreamPtr   synthesis(synthesis_(dereverb, env));
+
+  run.push_back(Stage_("analysis"));  run.push_back(Stage_("dereverberation"));  run.push_back(Stage_("output"));
+  for (unsigned frameX = 0; frameX < FramesN; frameX++) {
+    run[2].add(synthesis->next(frameX));
+    if (frameX % SubbandStride != 0) continue;
+    run[0].add(analysis0->current());
+    run[1].add(dereverb->current());
+  }
+}
+
+// 'NLMSAcousticEchoCancellationFeature' on the far end and its echo with a weak near-end talker, as test_subband_aec.py
+static void run_aec_(const JsonValue& conf, const Env_& env, unsigned depth, Run_& run)
+{
+  static const double EchoPath[] = { 0.003, 0.6, 0.007, 0.3, 0.012, -0.15, -1.0, 0.0 };
+  gsl_matrix* micPositions = gsl_matrix_calloc(1, 3);
+  double      front[3]     = { M_PI / 2.0, 0.0, 0.0 };
+
+  PlaneWaveArray_ played(micPositions, "linear", SignalN, 1);
+  played.add_source(front, 2, 1.0);
+  PlaneWaveArray_ recorded(micPositions, "linear", SignalN, 2);
+  recorded.add_source(front, 2, 0.0, EchoPath);
+  recorded.add_source(front, 0, 0.1);
+  recorded.add_noise(30.0);
+  gsl_matrix_free(micPositions);
+
+  VectorComplexFeatureStreamPtr playedBank(analysis_(played.sample_feature(0), env, depth));
+  VectorComplexFeatureStreamPtr recordedBank(analysis_(recorded.sample_feature(0), env, depth));
+  VectorComplexFeatureStreamPtr aec(new NLMSAcousticEchoCancellationFeature(playedBank, recordedBank, conf.get("delta", 100.0),
+									    conf.get("epsilon", 1.0E-04), conf.get("energy_threshold", 100.0)));
+  VectorFloatFeatureStreamPtr   synthesis(synthesis_(aec, env));
+
+  run.push_back(Stage_("echo cancellation"));  run.push_back(Stage_("output"));
+  for (unsigned frameX = 0; frameX < FramesN; frameX++) {
+    run[1].add(synthesis->next(frameX));
+    if (frameX % SubbandStride == 0)
+      run[0].add(aec->current());
+  }
+}
+
+static Run_ run_case_(const Case_& c, const Env_& env, unsigned depth)
+{
+  JsonValue conf = JsonValue::load(env.confDir + "/" + c.conf);
+  Run_      run;
+  switch (c.kind) {
+  case Beamforming: run_beamforming_(conf, env, depth, run);  break;
+  case TimeDomain:  run_time_domain_(conf, env, depth, run);  break;
+  case WPE:         run_wpe_(conf, JsonValue::load(env.confDir + "/" + c.geometry), env, depth, run);  break;
+  case AEC:         run_aec_(conf, env, depth, run);  break;
+  }
+  return run;
+}
+
+
+// ----- checks -----
+//
+static bool identical_(const Run_& a, const Run_& b, const char* what)
+{
+  bool same = true;
+  for (unsigned stageX = 0; stageX < a.size(); stageX++) {
+    const std::vector<double>& x(a[stageX].values);
+    const std::vector<double>& y(b[stageX].values);
+    unsigned diffX = 0;
+    while (diffX < x.size() && diffX < y.size() && memcmp(&x[diffX], &y[diffX], sizeof(double)) == 0) diffX++;
+    if (x.size() == y.size() && diffX == x.size()) continue;
+
+    printf("  %s: stage '%s' differs from value %u on (%.9g != %.9g)\n", what, a[stageX].name.c_str(), diffX,
+	   (diffX < x.size()) ? x[diffX] : 0.0, (diffX < y.size()) ? y[diffX] : 0.0);
+    same = false;
+  }
+  return same;
+}
+
+static bool check_determinism_(const Case_& c, const Env_& env, unsigned depth)
+{
+  Run_ first(run_case_(c, env, 0));
+  bool ok = identical_(first, run_case_(c, env, 0), "repeated run");
+  if (depth > 0)
+    ok = identical_(first, run_case_(c, env, depth), "threaded run") && ok;
+  return ok;
+}
+
+/*
+  The golden file is text: a header line, then for each stage a line
+  "stage <values> <name>" followed by one value per line.
+*/
+static const char* GoldenMagic = "btk20-golden 1";
+
+static String golden_path_(const String& goldenDir, const Case_& c)
+{
+  return goldenDir + "/" + c.name + ".golden";
+}
+
+static void write_golden_(const String& path, const Case_& c, const Run_& run)
+{
+  FILE* fp = fopen(path.c_str(), "w");
+  if (fp == NULL)
+    throw jio_error("Could not open file %s.", path.c_str());
+  fprintf(fp, "%s\ncase %s frames %u\n", GoldenMagic, c.name, FramesN);
+  for (unsigned stageX = 0; stageX < run.size(); stageX++) {
+    fprintf(fp, "stage %u %s\n", (unsigned) run[stageX].values.size(), run[stageX].name.c_str());
+    for (unsigned i = 0; i < run[stageX].values.size(); i++)
+      fprintf(fp, "%.9g\n", run[stageX].values[i]);
+  }
+  fclose(fp);
+}
+
+// false if there is no golden file
+static bool read_golden_(const String& path, Run_& run)
+{
+  FILE* fp = fopen(path.c_str(), "r");
+  if (fp == NULL) return false;
+
+  char line[256];
+  if (fgets(line, sizeof(line), fp) == NULL || strncmp(line, GoldenMagic, strlen(GoldenMagic)) != 0 ||
+      fgets(line, sizeof(line), fp) == NULL) {
+    fclose(fp);
+    throw jparse_error("%s: not a golden file", path.c_str());
+  }
+  unsigned valuesN;
+  while (fscanf(fp, "stage %u ", &valuesN) == 1 && fgets(line, sizeof(line), fp) != NULL) {
+    line[strcspn(line, "\n")] = '\0';
+    run.push_back(Stage_(line));
+    run.back().values.resize(valuesN);
+    for (unsigned i = 0; i < valuesN; i++)
+      if (fscanf(fp, "%lf ", &run.back().values[i]) != 1) {
+	fclose(fp);
+	throw jparse_error("%s: stage '%s' is truncated", path.c_str(), line);
+      }
+  }
+  fclose(fp);
+  return true;
+}
+
+/*
+  Thresholds per stage: the values are on the scale of 16-bit samples.
+  Adaptive and nonlinear stages (post-filters, RLS, WPE, AEC) amplify the
+  rounding differences between compilers and instruction sets.
+*/
+struct Tolerance_ {
+  double					snrDb;		// at least
+  double					maxAbs;		// at most
+};
+
+static Tolerance_ tolerance_(const Case_& c, const String& stage)
+{
+  Tolerance_ tol = { 100.0, 0.05 };
+  if (stage == "analysis") return tol;
+  if (c.adaptive) {
+    tol.snrDb  = 60.0;
+    tol.maxAbs = 5.0;
+  }
+  return tol;
+}
+
+// ExitSkipped if there is no golden file and 'required' is false
+static int check_golden_(const Case_& c, const Env_& env, const String& goldenDir, bool required)
+{
+  Run_ golden;
+  if (read_golden_(golden_path_(goldenDir, c), golden) == false) {
+    printf("  no golden file %s; create it with '-u'\n", golden_path_(goldenDir, c).c_str());
+    return required ? 1 : ExitSkipped;
+  }
+
+  Run_ run(run_case_(c, env, 0));
+  if (run.size() != golden.size()) {
+    printf("  %u stages instead of %u\n", (unsigned) run.size(), (unsigned) golden.size());
+    return 1;
+  }
+
+  int status = 0;
+  for (unsigned stageX = 0; stageX < run.size(); stageX++) {
+    const std::vector<double>& y(run[stageX].values);
+    const std::vector<double>& g(golden[stageX].values);
+    if (run[stageX].name != golden[stageX].name || y.size() != g.size()) {
+      printf("  stage '%s' (%u values) does not match golden stage '%s' (%u values)\n",
+	     run[stageX].name.c_str(), (unsigned) y.size(), golden[stageX].name.c_str(), (unsigned) g.size());
+      status = 1;
+      continue;
+    }
+
+    double signal = 0.0, error = 0.0, maxAbs = 0.0;
+    for (unsigned i = 0; i < y.size(); i++) {
+      double diff = y[i] - g[i];
+      signal += g[i] * g[i];
+      error  += diff * diff;
+      if (fabs(diff) > maxAbs || diff != diff) maxAbs = fabs(diff);
+    }
+    double     snrDb = (error == 0.0) ? HUGE_VAL : 10.0 * log10(signal / error);
+    Tolerance_ tol   = tolerance_(c, run[stageX].name);
+    bool       ok    = (snrDb >= tol.snrDb && maxAbs <= tol.maxAbs);
+    printf("  %-20s snr %7.1f dB (>= %.0f)  max abs %10.3g (<= %g)  %s\n", run[stageX].name.c_str(),
+	   (snrDb > 999.9) ? 999.9 : snrDb, tol.snrDb, maxAbs, tol.maxAbs, ok ? "ok" : "FAILED");
+    if (ok == false) status = 1;
+  }
+  return status;
+}
+
+
+// ----- main -----
+//
+static void usage_(const char* prog)
+{
+  fprintf(stderr,
+	  "usage: %s [-d unit-test-dir] [-g golden-dir] [-m golden|determinism|all] [-t depth] [-u] [-r] [-l] [case ...]\n"
+	  "  defaults: -d unit_test -g <unit-test-dir>/golden -m all -t 4, all cases\n"
+	  "  -u writes the golden files of the cases instead of checking them\n"
+	  "  -r fails rather than skips a case without a golden file\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+  String   unitTestDir = "unit_test", goldenDir = "", mode = "all";
+  unsigned depth  = 4;
+  bool     update = false, required = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:g:m:t:urlh")) != -1) {
+    switch (opt) {
+    case 'd': unitTestDir = optarg; break;
+    case 'g': goldenDir   = optarg; break;
+    case 'm': mode        = optarg; break;
+    case 't': depth       = atoi(optarg); break;
+    case 'u': update      = true; break;
+    case 'r': required    = true; break;
+    case 'l':
+      for (unsigned i = 0; i < sizeof(Cases) / sizeof(Cases[0]); i++)
+	printf("%s\n", Cases[i].name);
+      return 0;
+    default:
+      usage_(argv[0]);
+      return 1;
+    }
+  }
+  if (mode != "golden" && mode != "determinism" && mode != "all") {
+    usage_(argv[0]);
+    return 1;
+  }
+  if (goldenDir == "") goldenDir = unitTestDir + "/golden";
+
+  std::vector<const Case_*> cases;
+  for (unsigned i = 0; i < sizeof(Cases) / sizeof(Cases[0]); i++) {
+    bool selected = (optind == argc);
+    for (int argX = optind; argX < argc; argX++)
+      if (String(argv[argX]) == Cases[i].name) selected = true;
+    if (selected) cases.push_back(&Cases[i]);
+  }
+  if (cases.size() == 0 || int(cases.size()) < argc - optind) {
+    fprintf(stderr, "unknown case; '-l' lists them\n");
+    return 1;
+  }
+
+  Env_ env;
+  env.confDir = unitTestDir + "/confs";
+  int status  = 0;
+  bool skipped = false;
+  try {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/prototype.ny/h-M%u-m%u-r%u.pickle", unitTestDir.c_str(), SubbandsM, FilterLengthM, DecimationR);
+    env.h = load_filter_prototype(path);
+    snprintf(path, sizeof(path), "%s/prototype.ny/g-M%u-m%u-r%u.pickle", unitTestDir.c_str(), SubbandsM, FilterLengthM, DecimationR);
+    env.g = load_filter_prototype(path);
+  } catch (j_error& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  if (update && mkdir(goldenDir.c_str(), 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Could not create directory %s.\n", goldenDir.c_str());
+    return 1;
+  }
+
+  for (unsigned caseX = 0; caseX < cases.size(); caseX++) {
+    const Case_& c = *cases[caseX];
+    printf("%s\n", c.name);
+    try {
+      if (update) {
+	write_golden_(golden_path_(goldenDir, c), c, run_case_(c, env, 0));
+	printf("  wrote %s\n", golden_path_(goldenDir, c).c_str());
+	continue;
+      }
+      if (mode != "golden" && check_determinism_(c, env, depth) == false)
+	status = 1;
+      if (mode != "determinism") {
+	int golden = check_golden_(c, env, goldenDir, required);
+	if (golden == ExitSkipped) skipped = true;
+	else if (golden != 0) status = 1;
+      }
+    } catch (j_error& e) {
+      printf("  error: %s\n", e.what());
+      status = 1;
+    }
+  }
+  gsl_vector_free(env.h);  gsl_vector_free(env.g);
+
+  if (status == 0 && skipped) return ExitSkipped;
+  return status;
+}
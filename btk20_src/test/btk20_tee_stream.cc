@@ -0,0 +1,82 @@
+/**
+ * @file btk20_tee_stream.cc
+ * @brief Overrun of the frame ring of a feature tee.
+ *
+ * usage: btk20_tee_stream
+ *
+ * Pulls two branches of a 'VectorFloatFeatureTee' until the faster one
+ * would evict the current frame of the slower one. The faster branch must
+ * raise 'jindex_error' and stay on its frame, the slower one must still read
+ * its frames, and the faster one must continue once the slower one has
+ * caught up. The exit status is 0 on success and 1 on a failed check.
+ */
+#include <stdio.h>
+
+#include "common/jexception.h"
+#include "stream/tee_stream.h"
+
+static const unsigned FrameLen = 4;
+static const unsigned Lag      = 3;
+
+// frame 'n' holds n, n + 1, ...
+class CountingStream_ : public VectorFloatFeatureStream {
+ public:
+  CountingStream_() : VectorFloatFeatureStream(FrameLen, "Counting Stream") { }
+
+  virtual const gsl_vector_float* next(int frame_no = -5)
+  {
+    if (frame_no == frame_no_) return vector_;
+
+    increment_();
+    for (unsigned i = 0; i < FrameLen; i++)
+      gsl_vector_float_set(vector_, i, frame_no_ + i);
+    return vector_;
+  }
+};
+
+static int check_frame_(const char* branch, const gsl_vector_float* frame, int frameX)
+{
+  if (gsl_vector_float_get(frame, 0) == frameX) return 0;
+
+  printf("branch %s: frame %d holds %g\n", branch, frameX, gsl_vector_float_get(frame, 0));
+  return 1;
+}
+
+int main()
+{
+  VectorFloatFeatureTeePtr tee(new VectorFloatFeatureTee(VectorFloatFeatureStreamPtr(new CountingStream_()), Lag));
+  VectorFloatFeatureTeeBranchPtr fast(new VectorFloatFeatureTeeBranch(tee, "fast"));
+  VectorFloatFeatureTeeBranchPtr slow(new VectorFloatFeatureTeeBranch(tee, "slow"));
+
+  int failed = 0;
+  failed += check_frame_("slow", slow->next(), 0);
+
+  // the ring holds frames 0 .. Lag - 1; frame Lag would evict frame 0 of 'slow'
+  for (unsigned frameX = 0; frameX < Lag; frameX++)
+    failed += check_frame_("fast", fast->next(), frameX);
+
+  bool raised = false;
+  try {
+    fast->next();
+  } catch (jindex_error& e) {
+    printf("overrun: %s\n", e.what());
+    raised = true;
+  }
+  if (raised == false) {
+    printf("branch fast: no jindex_error on an overrun\n");
+    failed++;
+  }
+  if (fast->frame_no() != int(Lag) - 1) {
+    printf("branch fast: moved to frame %d on an overrun\n", fast->frame_no());
+    failed++;
+  }
+  failed += check_frame_("fast", fast->current(), Lag - 1);
+  failed += check_frame_("slow", slow->current(), 0);
+
+  // once 'slow' has moved on, 'fast' continues
+  failed += check_frame_("slow", slow->next(), 1);
+  failed += check_frame_("fast", fast->next(), Lag);
+  failed += check_frame_("slow", slow->next(), 2);
+
+  return (failed == 0) ? 0 : 1;
+}
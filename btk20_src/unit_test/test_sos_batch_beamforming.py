@@ -55,7 +55,8 @@ def load_tfmasks(ap_conf):
     Load TF mask files for the target and noise sources.
     The TF mask file should contain a sequence of numpy vectors whose element
     indicates activity of each sound source at each frequnecy bin.
-    It is saved as the Python pickle format.
+    It is saved either as the Python pickle format or as the binary format
+    written by TFMaskWriterPtr.
 
     :param ap_conf: contains the TF mask file paths
     :type : Python dictionary
@@ -63,6 +64,11 @@ def load_tfmasks(ap_conf):
              where no. rows and no. columns correspond to no. frames and no. bands, respectively.
     """
     def load_tfmask(tfmask_path):
+        with open(tfmask_path, 'rb') as rfp:
+            is_binary = (rfp.read(8) == b'BTKTFMSK')
+        if is_binary:
+            return numpy.array(TFMaskFeaturePtr(tfmask_path).load())
+
         tfmask = []
         with open(tfmask_path, 'rb') as rfp:
             while True: